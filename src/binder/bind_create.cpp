@@ -129,7 +129,9 @@ auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<
     }
   }
 
-  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols));
+  std::string index_type = stmt->accessMethod != nullptr ? stmt->accessMethod : "";
+  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols), std::move(index_type),
+                                          stmt->unique);
 }
 
 }  // namespace bustub
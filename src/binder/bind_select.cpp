@@ -833,6 +833,9 @@ auto Binder::BindExplain(duckdb_libpgquery::PGExplainStmt *stmt) -> std::unique_
       if (strcmp(temp->defname, "schema") == 0 || strcmp(temp->defname, "s") == 0) {
         explain_options |= ExplainOptions::SCHEMA;
       }
+      if (strcmp(temp->defname, "analyze") == 0 || strcmp(temp->defname, "a") == 0) {
+        explain_options |= ExplainOptions::ANALYZE;
+      }
     }
   }
   return std::make_unique<ExplainStatement>(BindStatement(stmt->query), explain_options);
@@ -33,7 +33,17 @@ BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager
   }
 }
 
-BufferPoolManager::~BufferPoolManager() { delete[] pages_; }
+BufferPoolManager::~BufferPoolManager() {
+  {
+    std::scoped_lock lock(prefetch_latch_);
+    stop_prefetch_ = true;
+  }
+  prefetch_cv_.notify_all();
+  if (prefetcher_.joinable()) {
+    prefetcher_.join();
+  }
+  delete[] pages_;
+}
 
 auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
   latch_.lock();
@@ -47,8 +57,9 @@ auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
     page_id_t x = AllocatePage();
     if (pages_[id].is_dirty_) {
       disk_scheduler_->WritePage(pages_[id].page_id_, pages_[id].data_);
-      pages_[id].ResetMemory();
     }
+    // 新页必须是全 0 的，干净的被淘汰页也要清
+    pages_[id].ResetMemory();
     page_table_.erase(pages_[id].page_id_);
     replacer_->RecordAccess(id, AccessType::Unknown);
     pages_[id].page_id_ = x;
@@ -74,6 +85,8 @@ auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
 
 auto BufferPoolManager::FetchPage(page_id_t page_id, [[maybe_unused]] AccessType access_type) -> Page * {
   latch_.lock();
+  // 预读线程正在读这一页或写回它的旧内容时，等它做完
+  io_cv_.wait(latch_, [&] { return io_pages_.count(page_id) == 0U; });
   if (page_table_.count(page_id) == 0U) {
     if (free_list_.empty()) {
       frame_id_t id;
@@ -116,6 +129,83 @@ auto BufferPoolManager::FetchPage(page_id_t page_id, [[maybe_unused]] AccessType
   return &pages_[id];
 }
 
+void BufferPoolManager::PrefetchPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  {
+    std::scoped_lock lock(prefetch_latch_);
+    if (prefetch_queue_.size() >= PREFETCH_QUEUE_SIZE) {
+      return;
+    }
+    prefetch_queue_.push_back(page_id);
+    if (!prefetcher_.joinable()) {
+      prefetcher_ = std::thread([this] { PrefetchWorker(); });
+    }
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::PrefetchWorker() {
+  std::unique_lock lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this] { return stop_prefetch_ || !prefetch_queue_.empty(); });
+    if (stop_prefetch_) {
+      return;
+    }
+    page_id_t page_id = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    lock.unlock();
+    LoadPage(page_id);
+    lock.lock();
+  }
+}
+
+void BufferPoolManager::LoadPage(page_id_t page_id) {
+  latch_.lock();
+  if (page_table_.count(page_id) != 0U || io_pages_.count(page_id) != 0U) {
+    latch_.unlock();
+    return;
+  }
+  frame_id_t id;
+  page_id_t victim = INVALID_PAGE_ID;
+  if (!free_list_.empty()) {
+    id = free_list_.front();
+    free_list_.pop_front();
+  } else {
+    if (!replacer_->Evict(&id)) {
+      latch_.unlock();
+      return;
+    }
+    page_table_.erase(pages_[id].page_id_);
+    if (pages_[id].is_dirty_) {
+      victim = pages_[id].page_id_;
+      io_pages_.insert(victim);
+    }
+  }
+  // 帧已经不在页表、空闲链表和 replacer 里，别人拿不到它，读写盘时不用拿着 latch_
+  io_pages_.insert(page_id);
+  latch_.unlock();
+
+  if (victim != INVALID_PAGE_ID) {
+    disk_scheduler_->WritePage(victim, pages_[id].data_);
+  }
+  disk_scheduler_->ReadPage(page_id, pages_[id].data_);
+
+  latch_.lock();
+  // 预读的页不 pin，不挡 DeletePage，也随时可以被换出
+  replacer_->RecordAccess(id, AccessType::Scan);
+  replacer_->SetEvictable(id, true);
+  pages_[id].page_id_ = page_id;
+  pages_[id].is_dirty_ = false;
+  pages_[id].pin_count_ = 0;
+  page_table_[page_id] = id;
+  io_pages_.erase(page_id);
+  io_pages_.erase(victim);
+  latch_.unlock();
+  io_cv_.notify_all();
+}
+
 auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty, [[maybe_unused]] AccessType access_type) -> bool {
   latch_.lock();
   if (page_table_.count(page_id) == 0U) {
@@ -153,9 +243,11 @@ auto BufferPoolManager::FlushPage(page_id_t page_id) -> bool {
 
 void BufferPoolManager::FlushAllPages() {
   latch_.lock();
+  // 已经拿着 latch_，直接写盘，不能再调 FlushPage
   for (auto &[x, y] : page_table_) {
     if (pages_[y].IsDirty()) {
-      FlushPage(x);
+      disk_scheduler_->WritePage(x, pages_[y].data_);
+      pages_[y].is_dirty_ = false;
     }
   }
   latch_.unlock();
@@ -163,6 +255,7 @@ void BufferPoolManager::FlushAllPages() {
 
 auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
   latch_.lock();
+  io_cv_.wait(latch_, [&] { return io_pages_.count(page_id) == 0U; });
   if (page_table_.count(page_id) == 0U) {
     latch_.unlock();
     return true;
@@ -185,6 +278,13 @@ auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
 
 auto BufferPoolManager::AllocatePage() -> page_id_t { return next_page_id_++; }
 
+void BufferPoolManager::ReservePages(page_id_t next_page_id) {
+  page_id_t cur = next_page_id_.load();
+  while (cur < next_page_id && !next_page_id_.compare_exchange_weak(cur, next_page_id)) {
+    // 失败时 cur 已刷新成最新值，重试
+  }
+}
+
 auto BufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard {
   return BasicPageGuard{this, FetchPage(page_id)};
 }
@@ -0,0 +1,306 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// catalog.cpp
+//
+// Identification: src/catalog/catalog.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "common/exception.h"
+#include "fmt/format.h"
+#include "storage/page/catalog_page.h"
+
+namespace bustub {
+
+namespace {
+
+/** "BTCT", the first bytes of a serialized catalog */
+constexpr uint32_t CATALOG_MAGIC = 0x42544354;
+/** Bumped whenever the format of the catalog or of an index page changes; 2 added hash bucket overflow chains */
+constexpr uint32_t CATALOG_VERSION = 2;
+
+class CatalogWriter {
+ public:
+  template <typename T>
+  void Put(T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    data_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void PutString(const std::string &str) {
+    Put<uint32_t>(str.size());
+    data_.append(str);
+  }
+
+  auto Data() const -> const std::string & { return data_; }
+
+ private:
+  std::string data_;
+};
+
+class CatalogReader {
+ public:
+  explicit CatalogReader(const std::string &data) : data_(data) {}
+
+  template <typename T>
+  auto Get() -> T {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Check(sizeof(T));
+    T value;
+    memcpy(&value, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  auto GetString() -> std::string {
+    auto size = Get<uint32_t>();
+    Check(size);
+    std::string str = data_.substr(pos_, size);
+    pos_ += size;
+    return str;
+  }
+
+ private:
+  void Check(size_t size) {
+    if (pos_ + size > data_.size()) {
+      throw Exception("the catalog of the database file is truncated");
+    }
+  }
+
+  const std::string &data_;
+  size_t pos_{0};
+};
+
+/** Call fn with std::integral_constant<size_t, N> for the GenericKey<N> that holds keys of key_size bytes. */
+template <typename Fn>
+auto DispatchKeySize(size_t key_size, Fn &&fn) {
+  switch (key_size) {
+    case 4:
+      return fn(std::integral_constant<size_t, 4>{});
+    case 8:
+      return fn(std::integral_constant<size_t, 8>{});
+    case 16:
+      return fn(std::integral_constant<size_t, 16>{});
+    case 32:
+      return fn(std::integral_constant<size_t, 32>{});
+    case 64:
+      return fn(std::integral_constant<size_t, 64>{});
+    default:
+      throw NotImplementedException(fmt::format("unsupported index key size {}", key_size));
+  }
+}
+
+}  // namespace
+
+void Catalog::Open(page_id_t disk_pages) {
+  std::scoped_lock lock(persist_latch_);
+  BUSTUB_ASSERT(catalog_pages_.empty(), "the catalog is already open");
+
+  if (disk_pages == 0) {
+    page_id_t page_id;
+    {
+      auto guard = bpm_->NewPageGuarded(&page_id);
+      guard.AsMut<CatalogPage>()->SetNextPageId(INVALID_PAGE_ID);
+    }
+    BUSTUB_ENSURE(page_id == HEADER_PAGE_ID, "the catalog must be the first page of a database file");
+    catalog_pages_.push_back(page_id);
+    return;
+  }
+
+  std::string data;
+  for (page_id_t page_id = HEADER_PAGE_ID; page_id != INVALID_PAGE_ID;) {
+    // 坏文件里的链可能指到文件外面或者绕成环
+    if (page_id < 0 || page_id >= disk_pages || catalog_pages_.size() >= static_cast<size_t>(disk_pages)) {
+      catalog_pages_.clear();
+      throw Exception("not a BusTub database file");
+    }
+    auto guard = bpm_->FetchPageRead(page_id);
+    auto page = guard.As<CatalogPage>();
+    if (page->GetSize() > CATALOG_PAGE_DATA_SIZE) {
+      catalog_pages_.clear();
+      throw Exception("not a BusTub database file");
+    }
+    data.append(page->GetData(), page->GetSize());
+    catalog_pages_.push_back(page_id);
+    page_id = page->GetNextPageId();
+  }
+
+  CatalogReader in(data);
+  if (in.Get<uint32_t>() != CATALOG_MAGIC || in.Get<uint32_t>() != CATALOG_VERSION) {
+    catalog_pages_.clear();
+    throw Exception("not a BusTub database file");
+  }
+  // 页号从文件里已有的页之后接着分配，catalog 记下的分配点可能更靠后（分配了还没写盘）
+  bpm_->ReservePages(std::max(in.Get<page_id_t>(), disk_pages));
+  bpm_->ReservePages(*std::max_element(catalog_pages_.begin(), catalog_pages_.end()) + 1);
+  next_table_oid_ = in.Get<table_oid_t>();
+  next_index_oid_ = in.Get<index_oid_t>();
+
+  auto table_count = in.Get<uint32_t>();
+  for (uint32_t i = 0; i < table_count; i++) {
+    auto oid = in.Get<table_oid_t>();
+    auto name = in.GetString();
+    auto first_page_id = in.Get<page_id_t>();
+    auto last_page_id = in.Get<page_id_t>();
+    auto column_count = in.Get<uint32_t>();
+    std::vector<Column> columns;
+    columns.reserve(column_count);
+    for (uint32_t j = 0; j < column_count; j++) {
+      auto column_name = in.GetString();
+      auto type = in.Get<TypeId>();
+      auto length = in.Get<uint32_t>();
+      if (type == TypeId::VARCHAR) {
+        columns.emplace_back(column_name, type, length);
+      } else {
+        columns.emplace_back(column_name, type);
+      }
+    }
+    auto table = std::make_unique<TableHeap>(bpm_, first_page_id, last_page_id);
+    tables_.emplace(oid, std::make_unique<TableInfo>(Schema(columns), name, std::move(table), oid));
+    table_names_.emplace(name, oid);
+    index_names_.emplace(name, std::unordered_map<std::string, index_oid_t>{});
+  }
+
+  auto index_count = in.Get<uint32_t>();
+  for (uint32_t i = 0; i < index_count; i++) {
+    auto oid = in.Get<index_oid_t>();
+    auto name = in.GetString();
+    auto table_name = in.GetString();
+    auto key_size = static_cast<size_t>(in.Get<uint32_t>());
+    auto index_type = in.Get<IndexType>();
+    auto is_unique = in.Get<bool>();
+    auto root_page_id = in.Get<page_id_t>();
+    auto attr_count = in.Get<uint32_t>();
+    std::vector<uint32_t> key_attrs(attr_count);
+    for (auto &attr : key_attrs) {
+      attr = in.Get<uint32_t>();
+    }
+
+    const auto &schema = GetTable(table_name)->schema_;
+    auto key_schema = Schema::CopySchema(&schema, key_attrs);
+    auto meta = std::make_unique<IndexMetadata>(name, table_name, &schema, key_attrs);
+    // 只挂到原来的页上，不扫表也不重建
+    auto index = DispatchKeySize(key_size, [&](auto n) -> std::unique_ptr<Index> {
+      constexpr size_t N = decltype(n)::value;
+      if (index_type == IndexType::HashTableIndex) {
+        HashFunction<GenericKey<N>> hash_fn(key_schema.IsInlined() ? key_schema.GetLength() : 0);
+        return std::make_unique<ExtendibleHashTableIndex<GenericKey<N>, RID, GenericComparator<N>>>(
+            std::move(meta), bpm_, hash_fn, root_page_id);
+      }
+      return std::make_unique<BPlusTreeIndex<GenericKey<N>, RID, GenericComparator<N>>>(std::move(meta), bpm_,
+                                                                                        is_unique, root_page_id);
+    });
+    indexes_.emplace(oid, std::make_unique<IndexInfo>(key_schema, name, std::move(index), oid, table_name, key_size,
+                                                      index_type));
+    index_names_[table_name].emplace(name, oid);
+  }
+}
+
+void Catalog::Persist() {
+  std::scoped_lock lock(persist_latch_);
+  if (catalog_pages_.empty()) {
+    return;
+  }
+
+  CatalogWriter out;
+  out.Put(CATALOG_MAGIC);
+  out.Put(CATALOG_VERSION);
+  out.Put(bpm_->GetNextPageId());
+  out.Put(next_table_oid_.load());
+  out.Put(next_index_oid_.load());
+
+  // mock 表没有 table heap，每次启动重新生成，不落盘
+  std::vector<TableInfo *> tables;
+  for (const auto &[oid, info] : tables_) {
+    if (info->table_ != nullptr) {
+      tables.push_back(info.get());
+    }
+  }
+  out.Put<uint32_t>(tables.size());
+  for (auto *info : tables) {
+    out.Put(info->oid_);
+    out.PutString(info->name_);
+    out.Put(info->table_->GetFirstPageId());
+    out.Put(info->table_->GetLastPageId());
+    out.Put<uint32_t>(info->schema_.GetColumnCount());
+    for (const auto &column : info->schema_.GetColumns()) {
+      out.PutString(column.GetName());
+      out.Put(column.GetType());
+      out.Put(column.GetVariableLength());
+    }
+  }
+
+  // 还在建的索引不落盘，重启后就当没建过
+  std::shared_lock index_lock(index_latch_);
+  std::vector<std::tuple<IndexInfo *, page_id_t, bool>> indexes;
+  for (const auto &[oid, info] : indexes_) {
+    if (info->IsBuilding()) {
+      continue;
+    }
+    bool is_unique = true;
+    auto root_page_id = DispatchKeySize(info->key_size_, [&](auto n) -> page_id_t {
+      constexpr size_t N = decltype(n)::value;
+      if (info->index_type_ == IndexType::HashTableIndex) {
+        auto *index =
+            dynamic_cast<ExtendibleHashTableIndex<GenericKey<N>, RID, GenericComparator<N>> *>(info->index_.get());
+        return index == nullptr ? INVALID_PAGE_ID : index->GetDirectoryPageId();
+      }
+      auto *index = dynamic_cast<BPlusTreeIndex<GenericKey<N>, RID, GenericComparator<N>> *>(info->index_.get());
+      if (index == nullptr) {
+        return INVALID_PAGE_ID;
+      }
+      is_unique = index->IsUnique();
+      return index->GetHeaderPageId();
+    });
+    if (root_page_id != INVALID_PAGE_ID) {
+      indexes.emplace_back(info.get(), root_page_id, is_unique);
+    }
+  }
+  out.Put<uint32_t>(indexes.size());
+  for (auto [info, root_page_id, is_unique] : indexes) {
+    out.Put(info->index_oid_);
+    out.PutString(info->name_);
+    out.PutString(info->table_name_);
+    out.Put<uint32_t>(info->key_size_);
+    out.Put(info->index_type_);
+    out.Put(is_unique);
+    out.Put(root_page_id);
+    const auto &key_attrs = info->index_->GetKeyAttrs();
+    out.Put<uint32_t>(key_attrs.size());
+    for (auto attr : key_attrs) {
+      out.Put(attr);
+    }
+  }
+  index_lock.unlock();
+
+  const auto &data = out.Data();
+  size_t page_count = std::max<size_t>(1, (data.size() + CATALOG_PAGE_DATA_SIZE - 1) / CATALOG_PAGE_DATA_SIZE);
+  while (catalog_pages_.size() < page_count) {
+    page_id_t page_id;
+    auto guard = bpm_->NewPageGuarded(&page_id);
+    catalog_pages_.push_back(page_id);
+  }
+  // 链变短时多出来的页留着，下次变长再用
+  for (size_t i = 0; i < page_count; i++) {
+    auto guard = bpm_->FetchPageWrite(catalog_pages_[i]);
+    auto page = guard.AsMut<CatalogPage>();
+    size_t offset = i * CATALOG_PAGE_DATA_SIZE;
+    page->SetData(data.data() + offset, std::min<size_t>(CATALOG_PAGE_DATA_SIZE, data.size() - offset));
+    page->SetNextPageId(i + 1 < page_count ? catalog_pages_[i + 1] : INVALID_PAGE_ID);
+  }
+}
+
+}  // namespace bustub
@@ -171,6 +171,10 @@ void TableGenerator::GenerateTestTables() {
   };
 
   for (auto &table_meta : insert_meta) {
+    // 重新打开的数据库文件里已经有这些表了
+    if (exec_ctx_->GetCatalog()->GetTable(table_meta.name_) != Catalog::NULL_TABLE_INFO) {
+      continue;
+    }
     // Create Schema
     std::vector<Column> cols{};
     cols.reserve(table_meta.col_meta_.size());
@@ -43,6 +43,9 @@ namespace bustub {
 void BustubInstance::HandleCreateStatement(Transaction *txn, const CreateStatement &stmt, ResultWriter &writer) {
   std::unique_lock<std::shared_mutex> l(catalog_lock_);
   auto info = catalog_->CreateTable(txn, stmt.table_, Schema(stmt.columns_));
+  if (info != nullptr) {
+    catalog_->Persist();
+  }
   l.unlock();
 
   if (info == nullptr) {
@@ -71,15 +74,34 @@ void BustubInstance::HandleIndexStatement(Transaction *txn, const IndexStatement
     throw NotImplementedException("only support creating index with exactly one or two columns");
   }
 
+  // 不写 USING 时 parser 给的是 "art"，按 B+ 树处理
+  IndexType index_type;
+  if (stmt.index_type_ == "hash") {
+    index_type = IndexType::HashTableIndex;
+  } else if (stmt.index_type_.empty() || stmt.index_type_ == "art" || stmt.index_type_ == "btree" ||
+             stmt.index_type_ == "bplustree") {
+    index_type = IndexType::BPlusTreeIndex;
+  } else {
+    throw NotImplementedException(fmt::format("unsupported index type {}", stmt.index_type_));
+  }
+
+  // 只哈希 key 里真正用到的字节，后面的补零不参与
+  IntegerHashFunctionType hash_fn(key_schema.IsInlined() ? key_schema.GetLength() : 0);
+
+  // 只有登记索引时独占 catalog，填数据时表照常读写
   std::unique_lock<std::shared_mutex> l(catalog_lock_);
-  auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
+  auto info = catalog_->BeginCreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
       txn, stmt.index_name_, stmt.table_->table_, stmt.table_->schema_, key_schema, col_ids, TWO_INTEGER_SIZE,
-      IntegerHashFunctionType{});
+      hash_fn, index_type, stmt.is_unique_);
   l.unlock();
 
   if (info == nullptr) {
     throw bustub::Exception("Failed to create index");
   }
+  catalog_->BuildIndex(txn, info);
+  l.lock();
+  catalog_->Persist();
+  l.unlock();
   WriteOneCell(fmt::format("Index created with id = {}", info->index_oid_), writer);
 }
 
@@ -110,7 +132,7 @@ void BustubInstance::HandleExplainStatement(Transaction *txn, const ExplainState
   }
 
   // Print optimizer result.
-  bustub::Optimizer optimizer(*catalog_, IsForceStarterRule());
+  bustub::Optimizer optimizer(*catalog_, IsForceStarterRule(), GetParallelism());
   auto optimized_plan = optimizer.Optimize(planner.plan_);
 
   l.unlock();
@@ -122,6 +144,23 @@ void BustubInstance::HandleExplainStatement(Transaction *txn, const ExplainState
     output += "\n";
   }
 
+  // Run the query, then print the plan with what each operator reported.
+  if ((stmt.options_ & ExplainOptions::ANALYZE) != 0) {
+    bool is_delete = stmt.statement_->type_ == StatementType::DELETE_STATEMENT ||
+                     stmt.statement_->type_ == StatementType::UPDATE_STATEMENT;
+    auto exec_ctx = MakeExecutorContext(txn, is_delete);
+    std::vector<Tuple> result_set{};
+    execution_engine_->Execute(optimized_plan, &result_set, txn, exec_ctx.get(), GetScanParallelism());
+    output += "=== ANALYZE ===";
+    output += "\n";
+    output += fmt::format("rows={}\n", result_set.size());
+    output += optimized_plan->ToString([&exec_ctx](const AbstractPlanNode &plan) -> std::string {
+      const auto *stats = exec_ctx->FindOperatorStats(&plan);
+      return stats == nullptr ? "" : stats->ToString();
+    });
+    output += "\n";
+  }
+
   WriteOneCell(output, writer);
 }
 
@@ -1,6 +1,7 @@
 #include <optional>
 #include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
 #include <tuple>
 
 #include "binder/binder.h"
@@ -26,8 +27,10 @@
 #include "execution/executors/mock_scan_executor.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
+#include "execution/task_scheduler.h"
 #include "fmt/core.h"
 #include "fmt/format.h"
+#include "fmt/ranges.h"
 #include "optimizer/optimizer.h"
 #include "planner/planner.h"
 #include "recovery/checkpoint_manager.h"
@@ -39,7 +42,11 @@
 namespace bustub {
 
 auto BustubInstance::MakeExecutorContext(Transaction *txn, bool is_modify) -> std::unique_ptr<ExecutorContext> {
-  return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_, is_modify);
+  auto exec_ctx =
+      std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_, is_modify);
+  exec_ctx->SetTaskScheduler(task_scheduler_);
+  exec_ctx->SetMemoryBudget(GetMemoryBudget());
+  return exec_ctx;
 }
 
 BustubInstance::BustubInstance(const std::string &db_file_name) {
@@ -75,11 +82,17 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   // Checkpoint related.
   checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_);
 
-  // Catalog.
+  // Catalog. It owns the first page of the file, tables and indexes of an existing file are attached, not rebuilt.
   catalog_ = new Catalog(buffer_pool_manager_, lock_manager_, log_manager_);
+  if (buffer_pool_manager_ != nullptr) {
+    catalog_->Open(disk_manager_->GetNumPages());
+  }
 
   // Execution engine.
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
+
+  // Worker threads of parallel pipelines, started by the first parallel query.
+  task_scheduler_ = new TaskScheduler(std::thread::hardware_concurrency());
 }
 
 BustubInstance::BustubInstance() {
@@ -120,6 +133,9 @@ BustubInstance::BustubInstance() {
 
   // Execution engine.
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
+
+  // Worker threads of parallel pipelines, started by the first parallel query.
+  task_scheduler_ = new TaskScheduler(std::thread::hardware_concurrency());
 }
 
 void BustubInstance::CmdDisplayTables(ResultWriter &writer) {
@@ -163,6 +179,46 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayIndexStats(ResultWriter &writer) {
+  auto table_names = catalog_->GetTableNames();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("table_name");
+  writer.WriteHeaderCell("index_name");
+  writer.WriteHeaderCell("height");
+  writer.WriteHeaderCell("internal_pages");
+  writer.WriteHeaderCell("leaf_pages");
+  writer.WriteHeaderCell("posting_pages");
+  writer.WriteHeaderCell("keys");
+  writer.WriteHeaderCell("values");
+  writer.WriteHeaderCell("level_fill");
+  writer.WriteHeaderCell("fragmentation");
+  writer.EndHeader();
+  for (const auto &table_name : table_names) {
+    for (const auto *index_info : catalog_->GetTableIndexes(table_name)) {
+      // 只有 B+ 树有页布局可看
+      auto *tree = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info->index_.get());
+      if (tree == nullptr) {
+        continue;
+      }
+      auto stats = tree->GetStats();
+      writer.BeginRow();
+      writer.WriteCell(table_name);
+      writer.WriteCell(index_info->name_);
+      writer.WriteCell(fmt::format("{}", stats.height_));
+      writer.WriteCell(fmt::format("{}", stats.internal_pages_));
+      writer.WriteCell(fmt::format("{}", stats.leaf_pages_));
+      writer.WriteCell(fmt::format("{}", stats.posting_pages_));
+      writer.WriteCell(fmt::format("{}", stats.key_count_));
+      writer.WriteCell(fmt::format("{}", stats.value_count_));
+      writer.WriteCell(fmt::format("{:.2f}", fmt::join(stats.level_fill_, "/")));
+      writer.WriteCell(fmt::format("{:.2f}", stats.fragmentation_));
+      writer.EndRow();
+    }
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -176,6 +232,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\indexstats: show the page layout of all B+ tree indices
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -194,7 +251,12 @@ auto BustubInstance::ExecuteSql(const std::string &sql, ResultWriter &writer,
   auto txn = txn_manager_->Begin();
   try {
     auto result = ExecuteSqlTxn(sql, writer, txn, std::move(check_options));
-    txn_manager_->Commit(txn);
+    // 执行失败的语句可能已经改了一半，比如表里插进了 tuple 而唯一索引拒绝了键，整个事务回滚
+    if (result) {
+      txn_manager_->Commit(txn);
+    } else {
+      txn_manager_->Abort(txn);
+    }
     delete txn;
     return result;
   } catch (bustub::Exception &ex) {
@@ -216,6 +278,10 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\indexstats") {
+      CmdDisplayIndexStats(writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
@@ -275,7 +341,7 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
     planner.PlanQuery(*statement);
 
     // Optimize the query.
-    bustub::Optimizer optimizer(*catalog_, IsForceStarterRule());
+    bustub::Optimizer optimizer(*catalog_, IsForceStarterRule(), GetParallelism());
     auto optimized_plan = optimizer.Optimize(planner.plan_);
 
     l.unlock();
@@ -286,7 +352,7 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       exec_ctx->InitCheckOptions(std::move(check_options));
     }
     std::vector<Tuple> result_set{};
-    is_successful &= execution_engine_->Execute(optimized_plan, &result_set, txn, exec_ctx.get());
+    is_successful &= execution_engine_->Execute(optimized_plan, &result_set, txn, exec_ctx.get(), GetScanParallelism());
 
     // Return the result set as a vector of string.
     auto schema = planner.plan_->OutputSchema();
@@ -354,6 +420,11 @@ BustubInstance::~BustubInstance() {
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
+  if (catalog_->IsPersistent()) {
+    catalog_->Persist();
+    buffer_pool_manager_->FlushAllPages();
+  }
+  delete task_scheduler_;
   delete execution_engine_;
   delete catalog_;
   delete checkpoint_manager_;
@@ -11,7 +11,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "concurrency/lock_manager.h"
+#include <algorithm>
 #include <stack>
+#include <unordered_set>
 
 #include "common/config.h"
 #include "concurrency/transaction.h"
@@ -366,6 +368,30 @@ auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool
   return true;
 }
 
+auto LockManager::WaitForTableWriters(const table_oid_t &oid, txn_id_t txn_id) -> void {
+  row_lock_map_latch_.lock();
+  if (table_lock_map_.count(oid) == 0) {
+    row_lock_map_latch_.unlock();
+    return;
+  }
+  auto tmp = table_lock_map_[oid];
+  row_lock_map_latch_.unlock();
+  // 只等现在已经拿到写锁的事务，之后来的写者不用等
+  std::unique_lock<std::mutex> lock(tmp->latch_);
+  std::unordered_set<txn_id_t> writers;
+  for (auto &res : tmp->request_queue_) {
+    if (res->granted_ && res->txn_id_ != txn_id &&
+        (res->lock_mode_ == LockMode::INTENTION_EXCLUSIVE || res->lock_mode_ == LockMode::SHARED_INTENTION_EXCLUSIVE ||
+         res->lock_mode_ == LockMode::EXCLUSIVE)) {
+      writers.insert(res->txn_id_);
+    }
+  }
+  tmp->cv_.wait(lock, [&] {
+    return std::none_of(tmp->request_queue_.begin(), tmp->request_queue_.end(),
+                        [&](const auto &res) { return writers.count(res->txn_id_) > 0; });
+  });
+}
+
 auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid) -> bool {
   // 判断此时事务的请求是否合法
   if (txn->GetState() == TransactionState::COMMITTED || txn->GetState() == TransactionState::ABORTED) {
@@ -44,42 +44,26 @@ void TransactionManager::Abort(Transaction *txn) {
         meta.is_deleted_ = false;
         record.table_heap_->UpdateTupleMeta(meta, record.rid_);
       } break;
-      default: {                                                       // UPDATE
-        TupleMeta old_meta = {INVALID_TXN_ID, INVALID_TXN_ID, false};  // 更新不会删除，更新也不会用来处理被删除的tuple
-        bool success{false};
-        for (auto &index_record : *txn->GetIndexWriteSet()) {
-          if (index_record.table_oid_ == record.tid_ && index_record.rid_ == record.rid_) {
-            record.table_heap_->UpdateTupleInPlaceUnsafe(old_meta, index_record.old_tuple_, record.rid_);
-            success = true;
-            break;
-          }
-        }
-        if (!success) {
-          BUSTUB_ENSURE(1 == 2, "revert update failed");
-        }
-      } break;
+      case WType::UPDATE:
+        UNREACHABLE("an update is written as a delete and an insert");
     }
     txn->GetWriteSet()->pop_back();
   }
+  // 执行器记下的 tuple_ 已经是索引键
   while (!txn->GetIndexWriteSet()->empty()) {
     auto record = txn->GetIndexWriteSet()->back();
     auto index = record.catalog_->GetIndex(record.index_oid_);
-    auto tbl_info = record.catalog_->GetTable(record.table_oid_);
-    auto key = record.tuple_.KeyFromTuple(tbl_info->schema_, index->key_schema_, index->index_->GetKeyAttrs());
     switch (record.wtype_) {
       case WType::INSERT: {
-        index->index_->DeleteEntry(key, record.rid_, txn);
+        index->DeleteEntry(record.tuple_, record.rid_, txn);
       } break;
       case WType::DELETE: {
-        index->index_->InsertEntry(key, record.rid_, txn);
-      } break;
-      default: {  // UPDATE
-        index->index_->DeleteEntry(key, record.rid_, txn);
-        auto old_key =
-            record.old_tuple_.KeyFromTuple(tbl_info->schema_, index->key_schema_, index->index_->GetKeyAttrs());
-        index->index_->InsertEntry(old_key, record.rid_, txn);
+        index->InsertEntry(record.tuple_, record.rid_, txn);
       } break;
+      case WType::UPDATE:
+        UNREACHABLE("an update is written as a delete and an insert");
     }
+    txn->GetIndexWriteSet()->pop_back();
   }
   ReleaseLocks(txn);
   txn->SetState(TransactionState::ABORTED);
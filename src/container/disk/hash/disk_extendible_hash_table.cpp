@@ -4,7 +4,7 @@
 //
 // disk_extendible_hash_table.cpp
 //
-// Identification: src/container/hash/extendible_hash_table.cpp
+// Identification: src/container/disk/hash/disk_extendible_hash_table.cpp
 //
 // Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
@@ -17,6 +17,7 @@
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
 #include "common/rid.h"
 #include "container/disk/hash/disk_extendible_hash_table.h"
 
@@ -24,9 +25,29 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::DiskExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                         const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
+                                         const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                         page_id_t directory_page_id)
+    : directory_page_id_(directory_page_id),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)) {
+  if (directory_page_id_ != INVALID_PAGE_ID) {
+    return;
+  }
+  // 一个 directory 页 + 一个 local depth 为 0 的 bucket 页
+  page_id_t bucket_page_id;
+  Page *dir = buffer_pool_manager_->NewPage(&directory_page_id_);
+  Page *bucket = buffer_pool_manager_->NewPage(&bucket_page_id);
+  if (dir == nullptr || bucket == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate pages for hash table " + name);
+  }
+  reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData())->Init();
+  auto *dir_page = reinterpret_cast<HashTableDirectoryPage *>(dir->GetData());
+  dir_page->SetPageId(directory_page_id_);
+  dir_page->SetBucketPageId(0, bucket_page_id);
+  dir_page->SetLocalDepth(0, 0);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
 }
 
 /*****************************************************************************
@@ -46,22 +67,129 @@ auto HASH_TABLE_TYPE::Hash(KeyType key) -> uint32_t {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t {
-  return 0;
+  return Hash(key) & dir_page->GetGlobalDepthMask();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t {
-  return 0;
+  return dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
-  return nullptr;
+  Page *page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table directory page");
+  }
+  return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE * {
-  return nullptr;
+  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(FetchBucket(bucket_page_id)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::FetchBucket(page_id_t bucket_page_id) -> Page * {
+  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table bucket page");
+  }
+  return page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::ChainInsert(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key, const ValueType &value,
+                                  bool *full) -> bool {
+  *full = false;
+  if (bucket->GetOverflowPageId() == INVALID_PAGE_ID && !bucket->IsFull()) {
+    return bucket->Insert(key, value, comparator_);
+  }
+  // 链上任何一页有这一对都算重复，否则插到第一个有空位的页
+  if (bucket->Contains(key, value, comparator_)) {
+    return false;
+  }
+  page_id_t room_page_id = INVALID_PAGE_ID;
+  for (page_id_t page_id = bucket->GetOverflowPageId(); page_id != INVALID_PAGE_ID;) {
+    HASH_TABLE_BUCKET_TYPE *overflow = FetchBucketPage(page_id);
+    bool duplicate = overflow->Contains(key, value, comparator_);
+    if (room_page_id == INVALID_PAGE_ID && !overflow->IsFull()) {
+      room_page_id = page_id;
+    }
+    page_id_t next_page_id = overflow->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (duplicate) {
+      return false;
+    }
+    page_id = next_page_id;
+  }
+  if (!bucket->IsFull()) {
+    return bucket->Insert(key, value, comparator_);
+  }
+  if (room_page_id == INVALID_PAGE_ID) {
+    *full = true;
+    return false;
+  }
+  HASH_TABLE_BUCKET_TYPE *overflow = FetchBucketPage(room_page_id);
+  bool inserted = overflow->Insert(key, value, comparator_);
+  buffer_pool_manager_->UnpinPage(room_page_id, inserted);
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::ChainRemove(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key, const ValueType &value) -> bool {
+  if (bucket->Remove(key, value, comparator_)) {
+    return true;
+  }
+  // 删空的 overflow 页从链上摘下来还给 buffer pool
+  HASH_TABLE_BUCKET_TYPE *prev = bucket;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  bool removed = false;
+  for (page_id_t page_id = bucket->GetOverflowPageId(); page_id != INVALID_PAGE_ID;) {
+    HASH_TABLE_BUCKET_TYPE *overflow = FetchBucketPage(page_id);
+    page_id_t next_page_id = overflow->GetOverflowPageId();
+    removed = overflow->Remove(key, value, comparator_);
+    if (removed) {
+      bool empty = overflow->IsEmpty();
+      if (empty) {
+        prev->SetOverflowPageId(next_page_id);
+      }
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      if (empty) {
+        buffer_pool_manager_->DeletePage(page_id);
+      }
+      break;
+    }
+    if (prev_page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(prev_page_id, false);
+    }
+    prev = overflow;
+    prev_page_id = page_id;
+    page_id = next_page_id;
+  }
+  if (prev_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->UnpinPage(prev_page_id, removed);
+  }
+  return removed;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::CanSplit(page_id_t bucket_page_id, uint32_t local_depth, const KeyType &key) -> bool {
+  // 只有 local depth 到 directory 最大深度之间有某一位不同，分裂才能把这些对分开
+  uint32_t hash = Hash(key);
+  uint32_t diff = 0;
+  for (page_id_t page_id = bucket_page_id; page_id != INVALID_PAGE_ID;) {
+    HASH_TABLE_BUCKET_TYPE *bucket = FetchBucketPage(page_id);
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE && bucket->IsOccupied(i); i++) {
+      if (bucket->IsReadable(i)) {
+        diff |= Hash(bucket->KeyAt(i)) ^ hash;
+      }
+    }
+    page_id_t next_page_id = bucket->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return ((diff & (DIRECTORY_ARRAY_SIZE - 1)) >> local_depth) != 0;
 }
 
 /*****************************************************************************
@@ -69,7 +197,27 @@ auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BU
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  return false;
+  // 读：directory 读锁 + 单个 bucket 的页读锁
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *page = FetchBucket(bucket_page_id);
+  page->RLatch();
+  auto *bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  bool found = bucket->GetValue(key, comparator_, result);
+  // overflow 页由链头的页锁保护
+  for (page_id_t page_id = bucket->GetOverflowPageId(); page_id != INVALID_PAGE_ID;) {
+    HASH_TABLE_BUCKET_TYPE *overflow = FetchBucketPage(page_id);
+    found = overflow->GetValue(key, comparator_, result) || found;
+    page_id_t next_page_id = overflow->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  return found;
 }
 
 /*****************************************************************************
@@ -77,12 +225,158 @@ auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  // 乐观：directory 读锁 + bucket 写锁，bucket 满了才去拿 directory 写锁分裂
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *page = FetchBucket(bucket_page_id);
+  page->WLatch();
+  auto *bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  bool full;
+  bool inserted = ChainInsert(bucket, key, value, &full);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (!full) {
+    return inserted;
+  }
+  return SplitInsert(transaction, key, value);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  // directory 写锁下没有其他线程能拿到任何 bucket，bucket 页不用再加页锁
+  table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  bool dir_dirty = false;
+  bool inserted = false;
+  while (true) {
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    HASH_TABLE_BUCKET_TYPE *bucket = FetchBucketPage(bucket_page_id);
+    // 等锁的时候别的线程可能已经分裂过了
+    bool full;
+    inserted = ChainInsert(bucket, key, value, &full);
+    if (!full) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+      break;
+    }
+    uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    if (!CanSplit(bucket_page_id, local_depth, key)) {
+      // 同一个 hash（或者 directory 已经到最大深度）分不开，挂一个 overflow 页到链尾
+      inserted = AppendOverflowPage(bucket, bucket_page_id, key, value);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+      break;
+    }
+
+    page_id_t image_page_id;
+    Page *image_page = buffer_pool_manager_->NewPage(&image_page_id);
+    if (image_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    auto *image = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(image_page->GetData());
+    image->Init();
+    if (local_depth == dir_page->GetGlobalDepth()) {
+      dir_page->IncrGlobalDepth();
+    }
+    uint32_t high_bit = 1U << local_depth;
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      if (dir_page->GetBucketPageId(i) == bucket_page_id) {
+        dir_page->SetLocalDepth(i, local_depth + 1);
+        if ((i & high_bit) != 0) {
+          dir_page->SetBucketPageId(i, image_page_id);
+        }
+      }
+    }
+    dir_dirty = true;
+    Redistribute(bucket, bucket_page_id, image, image_page_id, high_bit);
+    buffer_pool_manager_->UnpinPage(image_page_id, true);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, dir_dirty);
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::AppendOverflowPage(HASH_TABLE_BUCKET_TYPE *bucket, page_id_t bucket_page_id, const KeyType &key,
+                                         const ValueType &value) -> bool {
+  page_id_t overflow_page_id;
+  Page *page = buffer_pool_manager_->NewPage(&overflow_page_id);
+  if (page == nullptr) {
+    return false;
+  }
+  auto *overflow = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  overflow->Init();
+  overflow->Insert(key, value, comparator_);
+  buffer_pool_manager_->UnpinPage(overflow_page_id, true);
+
+  HASH_TABLE_BUCKET_TYPE *tail = bucket;
+  page_id_t tail_page_id = bucket_page_id;
+  while (tail->GetOverflowPageId() != INVALID_PAGE_ID) {
+    page_id_t next_page_id = tail->GetOverflowPageId();
+    if (tail_page_id != bucket_page_id) {
+      buffer_pool_manager_->UnpinPage(tail_page_id, false);
+    }
+    tail = FetchBucketPage(next_page_id);
+    tail_page_id = next_page_id;
+  }
+  tail->SetOverflowPageId(overflow_page_id);
+  if (tail_page_id != bucket_page_id) {
+    buffer_pool_manager_->UnpinPage(tail_page_id, true);
+  }
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::Redistribute(HASH_TABLE_BUCKET_TYPE *bucket, page_id_t bucket_page_id,
+                                   HASH_TABLE_BUCKET_TYPE *image, page_id_t image_page_id, uint32_t high_bit) {
+  // 整条链读出来清空，再按 high_bit 分到两条链上。链是满的，原来的 overflow 页加上新的 image 页一定放得下
+  std::vector<MappingType> pairs;
+  std::vector<page_id_t> spare_page_ids;
+  for (page_id_t page_id = bucket_page_id; page_id != INVALID_PAGE_ID;) {
+    HASH_TABLE_BUCKET_TYPE *page = page_id == bucket_page_id ? bucket : FetchBucketPage(page_id);
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE && page->IsOccupied(i); i++) {
+      if (page->IsReadable(i)) {
+        pairs.emplace_back(page->KeyAt(i), page->ValueAt(i));
+      }
+    }
+    page_id_t next_page_id = page->GetOverflowPageId();
+    page->Init();
+    if (page_id != bucket_page_id) {
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      spare_page_ids.push_back(page_id);
+    }
+    page_id = next_page_id;
+  }
+
+  HASH_TABLE_BUCKET_TYPE *tails[2] = {bucket, image};
+  page_id_t tail_page_ids[2] = {bucket_page_id, image_page_id};
+  for (const auto &[key, value] : pairs) {
+    int side = (Hash(key) & high_bit) != 0 ? 1 : 0;
+    if (tails[side]->IsFull()) {
+      BUSTUB_ASSERT(!spare_page_ids.empty(), "a split bucket chain needs no more pages than it had");
+      page_id_t next_page_id = spare_page_ids.back();
+      spare_page_ids.pop_back();
+      tails[side]->SetOverflowPageId(next_page_id);
+      if (tail_page_ids[side] != bucket_page_id) {
+        buffer_pool_manager_->UnpinPage(tail_page_ids[side], true);
+      }
+      tails[side] = FetchBucketPage(next_page_id);
+      tail_page_ids[side] = next_page_id;
+    }
+    tails[side]->Insert(key, value, comparator_);
+  }
+  for (page_id_t tail_page_id : tail_page_ids) {
+    if (tail_page_id != bucket_page_id) {
+      buffer_pool_manager_->UnpinPage(tail_page_id, true);
+    }
+  }
+  for (page_id_t page_id : spare_page_ids) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
 }
 
 /*****************************************************************************
@@ -90,14 +384,70 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *page = FetchBucket(bucket_page_id);
+  page->WLatch();
+  auto *bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  bool removed = ChainRemove(bucket, key, value);
+  bool empty = removed && bucket->IsEmpty() && bucket->GetOverflowPageId() == INVALID_PAGE_ID;
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, removed);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (empty) {
+    Merge(transaction, key, value);
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  bool dir_dirty = false;
+  // 合并后的 bucket 还可能和它新的 split image 继续合并，一直合到不能合为止
+  while (true) {
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    uint32_t image_idx = dir_page->GetSplitImageIndex(bucket_idx);
+    if (local_depth == 0 || dir_page->GetLocalDepth(image_idx) != local_depth) {
+      break;
+    }
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    page_id_t image_page_id = dir_page->GetBucketPageId(image_idx);
+    HASH_TABLE_BUCKET_TYPE *bucket = FetchBucketPage(bucket_page_id);
+    HASH_TABLE_BUCKET_TYPE *image = FetchBucketPage(image_page_id);
+    bool bucket_empty = bucket->IsEmpty() && bucket->GetOverflowPageId() == INVALID_PAGE_ID;
+    bool image_empty = image->IsEmpty() && image->GetOverflowPageId() == INVALID_PAGE_ID;
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    buffer_pool_manager_->UnpinPage(image_page_id, false);
+    if (!bucket_empty && !image_empty) {
+      break;
+    }
+
+    page_id_t keep_page_id = bucket_empty ? image_page_id : bucket_page_id;
+    page_id_t drop_page_id = bucket_empty ? bucket_page_id : image_page_id;
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      page_id_t page_id = dir_page->GetBucketPageId(i);
+      if (page_id == bucket_page_id || page_id == image_page_id) {
+        dir_page->SetBucketPageId(i, keep_page_id);
+        dir_page->DecrLocalDepth(i);
+      }
+    }
+    buffer_pool_manager_->DeletePage(drop_page_id);
+    while (dir_page->CanShrink()) {
+      dir_page->DecrGlobalDepth();
+    }
+    dir_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, dir_dirty);
+  table_latch_.WUnlock();
+}
 
 /*****************************************************************************
  * GETGLOBALDEPTH - DO NOT TOUCH
@@ -4,13 +4,15 @@
 //
 // linear_probe_hash_table.cpp
 //
-// Identification: src/container/hash/linear_probe_hash_table.cpp
+// Identification: src/container/disk/hash/linear_probe_hash_table.cpp
 //
 // Copyright (c) 2015-2019, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -23,46 +25,447 @@
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                      const KeyComparator &comparator, size_t num_buckets,
-                                      HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+LINEAR_PROBE_HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                   const KeyComparator &comparator, size_t num_buckets,
+                                                   HashFunction<KeyType> hash_fn)
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  size_t num_blocks = std::max<size_t>(1, (num_buckets + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE);
+  if (num_blocks > HashTableHeaderPage::MaxBlocks()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "too many buckets for hash table " + name);
+  }
+  current_ = CreateGeneration(num_blocks);
+}
 
 /*****************************************************************************
- * SEARCH
+ * HELPERS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetHeaderPage(page_id_t header_page_id) -> HashTableHeaderPage * {
+  Page *page = buffer_pool_manager_->FetchPage(header_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table header page");
+  }
+  return reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetBlockPage(page_id_t block_page_id) -> Page * {
+  Page *page = buffer_pool_manager_->FetchPage(block_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table block page");
+  }
+  return page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::CreateGeneration(size_t num_blocks) -> Generation {
+  Generation generation;
+  Page *header = buffer_pool_manager_->NewPage(&generation.header_page_id_);
+  if (header == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate hash table header page");
+  }
+  auto *header_page = reinterpret_cast<HashTableHeaderPage *>(header->GetData());
+  header_page->SetPageId(generation.header_page_id_);
+  for (size_t i = 0; i < num_blocks; i++) {
+    page_id_t block_page_id;
+    if (buffer_pool_manager_->NewPage(&block_page_id) == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate hash table block page");
+    }
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+    header_page->AddBlockPageId(block_page_id);
+    generation.blocks_.push_back(block_page_id);
+  }
+  generation.size_ = num_blocks * BLOCK_ARRAY_SIZE;
+  header_page->SetSize(generation.size_);
+  buffer_pool_manager_->UnpinPage(generation.header_page_id_, true);
+  return generation;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::DeleteBlockPages(const Generation &generation) {
+  for (page_id_t block_page_id : generation.blocks_) {
+    buffer_pool_manager_->DeletePage(block_page_id);
+  }
+  buffer_pool_manager_->DeletePage(generation.header_page_id_);
+}
+
+/*****************************************************************************
+ * PROBING
+ *
+ * A probe starts at hash(key) % size and stops at the first slot that was never
+ * occupied. Within a block it loads 64 occupied/readable flags at a time, so a
+ * run of tombstones or non-matching keys costs a few word operations instead of
+ * one bitmap test per slot. Lookups and removes hold one block latch at a time.
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetValueIn(const Generation &generation, const KeyType &key,
+                                              std::vector<ValueType> *result) -> bool {
+  size_t num_blocks = generation.blocks_.size();
+  size_t slot = hash_fn_.GetHash(key) % generation.size_;
+  size_t block_idx = slot / BLOCK_ARRAY_SIZE;
+  size_t offset = slot % BLOCK_ARRAY_SIZE;
+  size_t scanned = 0;
+  bool found = false;
+  bool stop = false;
+  while (!stop && scanned < generation.size_) {
+    Page *page = GetBlockPage(generation.blocks_[block_idx]);
+    page->RLatch();
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    while (offset < BLOCK_ARRAY_SIZE && scanned < generation.size_) {
+      size_t bit = offset % 64;
+      size_t n = std::min({static_cast<size_t>(64) - bit, BLOCK_ARRAY_SIZE - offset, generation.size_ - scanned});
+      uint64_t window = n == 64 ? ~0ULL : (1ULL << n) - 1;
+      uint64_t never_used = ~(block->OccupiedWord(offset / 64) >> bit) & window;
+      if (never_used != 0) {
+        n = __builtin_ctzll(never_used);
+        window = (1ULL << n) - 1;
+        stop = true;
+      }
+      uint64_t live = (block->ReadableWord(offset / 64) >> bit) & window;
+      while (live != 0) {
+        size_t i = offset + __builtin_ctzll(live);
+        live &= live - 1;
+        if (comparator_(block->KeyAt(i), key) == 0) {
+          result->push_back(block->ValueAt(i));
+          found = true;
+        }
+      }
+      offset += n;
+      scanned += n;
+      if (stop) {
+        break;
+      }
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(generation.blocks_[block_idx], false);
+    block_idx = (block_idx + 1) % num_blocks;
+    offset = 0;
+  }
+  return found;
+}
+
+/*
+ * An insert write-latches every block its probe touches, taken in ascending
+ * block order, and only writes once it has seen the whole probe under those
+ * latches. Two inserters of the same pair therefore cannot both miss each
+ * other and take different free slots. The probe usually ends in its first
+ * block; if it runs past the latched blocks, the latches are dropped and the
+ * probe is redone over twice as many.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::InsertIn(const Generation &generation, const KeyType &key, const ValueType &value)
+    -> InsertResult {
+  size_t num_blocks = generation.blocks_.size();
+  size_t slot = hash_fn_.GetHash(key) % generation.size_;
+  size_t first_block = slot / BLOCK_ARRAY_SIZE;
+  for (size_t span = 1;; span = std::min(span * 2, num_blocks)) {
+    // 按 block 下标从小到大加锁，和别的插入者、搬迁时对新表加锁的顺序一致
+    std::vector<size_t> order;
+    for (size_t j = 0; j < span; j++) {
+      order.push_back((first_block + j) % num_blocks);
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<Page *> pages(num_blocks, nullptr);
+    for (size_t block_idx : order) {
+      pages[block_idx] = GetBlockPage(generation.blocks_[block_idx]);
+      pages[block_idx]->WLatch();
+    }
+    auto release = [&](size_t dirty_block) {
+      for (size_t block_idx : order) {
+        pages[block_idx]->WUnlatch();
+        buffer_pool_manager_->UnpinPage(generation.blocks_[block_idx], block_idx == dirty_block);
+      }
+    };
+
+    // 第一个可写的槽位（墓碑或没用过的），要一直查到没用过的槽位才能确定没有重复
+    std::optional<std::pair<size_t, size_t>> free_slot;
+    size_t offset = slot % BLOCK_ARRAY_SIZE;
+    size_t scanned = 0;
+    bool stop = false;
+    // 锁住了全部 block 时，探测绕回第一个 block 的开头，把起点前面的槽位也查完
+    size_t visits = span == num_blocks ? span + 1 : span;
+    for (size_t j = 0; j < visits && !stop && scanned < generation.size_; j++, offset = 0) {
+      size_t block_idx = (first_block + j) % num_blocks;
+      auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(pages[block_idx]->GetData());
+      while (offset < BLOCK_ARRAY_SIZE && scanned < generation.size_) {
+        size_t bit = offset % 64;
+        size_t n = std::min({static_cast<size_t>(64) - bit, BLOCK_ARRAY_SIZE - offset, generation.size_ - scanned});
+        uint64_t window = n == 64 ? ~0ULL : (1ULL << n) - 1;
+        uint64_t never_used = ~(block->OccupiedWord(offset / 64) >> bit) & window;
+        if (never_used != 0) {
+          n = __builtin_ctzll(never_used) + 1;
+          window = n == 64 ? ~0ULL : (1ULL << n) - 1;
+          stop = true;
+        }
+        uint64_t live = (block->ReadableWord(offset / 64) >> bit) & window;
+        if (!free_slot.has_value() && (~live & window) != 0) {
+          free_slot = std::make_pair(block_idx, offset + __builtin_ctzll(~live & window));
+        }
+        while (live != 0) {
+          size_t i = offset + __builtin_ctzll(live);
+          live &= live - 1;
+          if (comparator_(block->KeyAt(i), key) == 0 && block->ValueAt(i) == value) {
+            release(num_blocks);
+            return InsertResult::DUPLICATE;
+          }
+        }
+        offset += n;
+        scanned += n;
+        if (stop) {
+          break;
+        }
+      }
+    }
+    if (!stop && scanned < generation.size_) {
+      // 探测跑出了锁住的 block，多锁一些重来
+      release(num_blocks);
+      continue;
+    }
+    if (!free_slot.has_value()) {
+      release(num_blocks);
+      return InsertResult::FULL;
+    }
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(pages[free_slot->first]->GetData());
+    bool inserted = block->Insert(free_slot->second, key, value);
+    BUSTUB_ASSERT(inserted, "free slot taken while its block was latched");
+    release(free_slot->first);
+    return InsertResult::INSERTED;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::RemoveIn(const Generation &generation, const KeyType &key, const ValueType &value)
+    -> bool {
+  size_t num_blocks = generation.blocks_.size();
+  size_t slot = hash_fn_.GetHash(key) % generation.size_;
+  size_t block_idx = slot / BLOCK_ARRAY_SIZE;
+  size_t offset = slot % BLOCK_ARRAY_SIZE;
+  size_t scanned = 0;
+  bool stop = false;
+  while (!stop && scanned < generation.size_) {
+    Page *page = GetBlockPage(generation.blocks_[block_idx]);
+    page->WLatch();
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    while (offset < BLOCK_ARRAY_SIZE && scanned < generation.size_) {
+      size_t bit = offset % 64;
+      size_t n = std::min({static_cast<size_t>(64) - bit, BLOCK_ARRAY_SIZE - offset, generation.size_ - scanned});
+      uint64_t window = n == 64 ? ~0ULL : (1ULL << n) - 1;
+      uint64_t never_used = ~(block->OccupiedWord(offset / 64) >> bit) & window;
+      if (never_used != 0) {
+        n = __builtin_ctzll(never_used);
+        window = (1ULL << n) - 1;
+        stop = true;
+      }
+      uint64_t live = (block->ReadableWord(offset / 64) >> bit) & window;
+      while (live != 0) {
+        size_t i = offset + __builtin_ctzll(live);
+        live &= live - 1;
+        if (comparator_(block->KeyAt(i), key) == 0 && block->ValueAt(i) == value) {
+          block->Remove(i);
+          page->WUnlatch();
+          buffer_pool_manager_->UnpinPage(generation.blocks_[block_idx], true);
+          return true;
+        }
+      }
+      offset += n;
+      scanned += n;
+      if (stop) {
+        break;
+      }
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(generation.blocks_[block_idx], false);
+    block_idx = (block_idx + 1) % num_blocks;
+    offset = 0;
+  }
   return false;
 }
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                            std::vector<ValueType> *result) -> bool {
+  table_latch_.RLock();
+  if (!resizing_) {
+    bool found = GetValueIn(current_, key, result);
+    table_latch_.RUnlock();
+    return found;
+  }
+  // 搬迁是先插入新表再在旧表留墓碑，所以先查旧表再查新表不会漏，只可能重复
+  size_t from_old = result->size();
+  GetValueIn(old_, key, result);
+  size_t from_new = result->size();
+  GetValueIn(current_, key, result);
+  table_latch_.RUnlock();
+  auto old_end = result->begin() + from_new;
+  auto last = std::remove_if(old_end, result->end(), [&](const ValueType &value) {
+    return std::find(result->begin() + from_old, old_end, value) != old_end;
+  });
+  result->erase(last, result->end());
+  return result->size() > from_old;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value)
+    -> bool {
+  while (true) {
+    table_latch_.RLock();
+    InsertResult result = InsertResult::DUPLICATE;
+    if (resizing_) {
+      std::vector<ValueType> values;
+      GetValueIn(old_, key, &values);
+      if (std::find(values.begin(), values.end(), value) == values.end()) {
+        result = InsertIn(current_, key, value);
+      }
+      MigrateStep();
+    } else {
+      result = InsertIn(current_, key, value);
+    }
+    size_t size = current_.size_;
+    bool resizing = resizing_;
+    table_latch_.RUnlock();
+
+    if (result == InsertResult::INSERTED) {
+      // 活跃条目超过 3/4 就开始扩容，之后每次操作搬一个 block
+      if (++num_entries_ * 4 > size * 3 && !resizing) {
+        Grow(size * 2);
+      }
+      FinishResize();
+      return true;
+    }
+    FinishResize();
+    if (result == InsertResult::DUPLICATE) {
+      return false;
+    }
+    if (!Grow(size * 2)) {
+      return false;
+    }
+  }
 }
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value)
+    -> bool {
+  table_latch_.RLock();
+  bool removed;
+  if (resizing_) {
+    removed = RemoveIn(old_, key, value) || RemoveIn(current_, key, value);
+    MigrateStep();
+  } else {
+    removed = RemoveIn(current_, key, value);
+  }
+  table_latch_.RUnlock();
+  if (removed) {
+    num_entries_--;
+  }
+  FinishResize();
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void LINEAR_PROBE_HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  Grow(initial_size * 2);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::MigrateStep() {
+  size_t block_idx = migrate_next_.fetch_add(1);
+  if (block_idx >= old_.blocks_.size()) {
+    return;
+  }
+  // 持有旧 block 的写锁再去拿新表的 block 锁；只有搬迁会同时持有两个锁，且顺序固定，不会死锁
+  Page *page = GetBlockPage(old_.blocks_[block_idx]);
+  page->WLatch();
+  auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+  bool dirty = false;
+  for (size_t w = 0; w * 64 < BLOCK_ARRAY_SIZE; w++) {
+    uint64_t live = block->ReadableWord(w);
+    while (live != 0) {
+      size_t i = w * 64 + __builtin_ctzll(live);
+      live &= live - 1;
+      // 新表是旧表的两倍，装载率触发扩容时不可能放不下
+      auto result = InsertIn(current_, block->KeyAt(i), block->ValueAt(i));
+      BUSTUB_ASSERT(result != InsertResult::FULL, "hash table resize target is full");
+      block->Remove(i);
+      dirty = true;
+    }
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(old_.blocks_[block_idx], dirty);
+  migrate_done_++;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::FinishResize() {
+  if (!resizing_) {
+    return;
+  }
+  table_latch_.RLock();
+  bool drained = resizing_ && migrate_done_ == old_.blocks_.size();
+  table_latch_.RUnlock();
+  if (!drained) {
+    return;
+  }
+  table_latch_.WLock();
+  if (resizing_ && migrate_done_ == old_.blocks_.size()) {
+    DeleteBlockPages(old_);
+    old_ = Generation();
+    resizing_ = false;
+  }
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Grow(size_t min_slots) -> bool {
+  table_latch_.WLock();
+  if (resizing_) {
+    // 上一次扩容还没搬完，写锁下直接搬完
+    while (migrate_done_ < old_.blocks_.size()) {
+      migrate_next_ = migrate_done_.load();
+      MigrateStep();
+    }
+    DeleteBlockPages(old_);
+    old_ = Generation();
+    resizing_ = false;
+  }
+  if (current_.size_ >= min_slots) {
+    table_latch_.WUnlock();
+    return true;
+  }
+  size_t num_blocks = (min_slots + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE;
+  if (num_blocks > HashTableHeaderPage::MaxBlocks()) {
+    table_latch_.WUnlock();
+    return false;
+  }
+  old_ = std::move(current_);
+  current_ = CreateGeneration(num_blocks);
+  migrate_next_ = 0;
+  migrate_done_ = 0;
+  resizing_ = true;
+  table_latch_.WUnlock();
+  return true;
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::GetSize() -> size_t {
-  return 0;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetSize() -> size_t {
+  table_latch_.RLock();
+  size_t size = current_.size_;
+  table_latch_.RUnlock();
+  return size;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
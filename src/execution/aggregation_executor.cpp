@@ -9,55 +9,277 @@
 // Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "execution/executors/aggregation_executor.h"
+#include "execution/task_scheduler.h"
 
 namespace bustub {
 
 AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
                                          std::unique_ptr<AbstractExecutor> &&child)
-    : AbstractExecutor(exec_ctx),
-      plan_(plan),
-      child_(std::move(child)),
-      aht_(plan->aggregates_, plan->agg_types_),
-      aht_iterator_(aht_.Begin()) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)) {
+  for (const auto &expr : plan_->GetGroupBys()) {
+    key_types_.push_back(expr->GetReturnType());
+  }
+  for (const auto &expr : plan_->GetAggregates()) {
+    input_types_.push_back(expr->GetReturnType());
+  }
+}
 
 void AggregationExecutor::Init() {
-  aht_.Clear();
+  tables_.clear();
+  idle_tables_.clear();
+  spill_files_.clear();
+  tasks_.clear();
+  aht_.reset();
+  partition_ = 0;
+  group_ = 0;
+  loaded_ = false;
   child_->Init();
+  if (child_->SupportsBatch()) {
+    batch_ = std::make_unique<TupleBatch>(&child_->GetOutputSchema());
+  }
+
+  // 主线程读一波 chunk，每个 chunk 交给一个 worker 预聚合到它手上的局部表里
+  auto *scheduler = exec_ctx_->GetTaskScheduler();
+  size_t wave_size = scheduler == nullptr ? 1 : scheduler->NumWorkers() + 1;
+  std::vector<Chunk> wave(wave_size);
+  size_t num_rows = 0;
+  bool exhausted = false;
+  while (!exhausted) {
+    size_t chunks = 0;
+    while (chunks < wave_size && NextChunk(&wave[chunks])) {
+      num_rows += wave[chunks].rows_;
+      chunks++;
+    }
+    exhausted = chunks < wave_size;
+    TaskGroup workers(scheduler);
+    for (size_t c = 0; c < chunks; c++) {
+      workers.Spawn([this, chunk = &wave[c]] {
+        auto *table = AcquireTable();
+        for (size_t row = 0; row < chunk->rows_; row++) {
+          table->Insert(chunk->keys_, chunk->inputs_, row);
+        }
+        ReleaseTable(table);
+      });
+    }
+    workers.Wait();
+    workers.RethrowError();
+
+    size_t bytes = 0;
+    for (const auto &table : tables_) {
+      bytes += table->MemoryUsage();
+    }
+    if (bytes > exec_ctx_->GetMemoryBudget()) {
+      SpillTables(scheduler);
+    }
+  }
+  batch_.reset();
+  emit_initial_ = num_rows == 0 && plan_->GetGroupBys().empty();
+  QueuePartitions();
+}
+
+auto AggregationExecutor::NextChunk(Chunk *chunk) -> bool {
+  const auto &group_bys = plan_->GetGroupBys();
+  const auto &aggregates = plan_->GetAggregates();
+  chunk->keys_.resize(group_bys.size());
+  chunk->inputs_.resize(aggregates.size());
+  chunk->rows_ = 0;
+  if (batch_ != nullptr) {
+    // group by 和聚合表达式整批求值
+    if (!child_->NextBatch(batch_.get())) {
+      return false;
+    }
+    for (size_t k = 0; k < group_bys.size(); k++) {
+      group_bys[k]->EvaluateBatch(*batch_, &chunk->keys_[k]);
+    }
+    for (size_t i = 0; i < aggregates.size(); i++) {
+      aggregates[i]->EvaluateBatch(*batch_, &chunk->inputs_[i]);
+    }
+    chunk->rows_ = batch_->Size();
+    return true;
+  }
+  for (auto &column : chunk->keys_) {
+    column.clear();
+  }
+  for (auto &column : chunk->inputs_) {
+    column.clear();
+  }
+  const auto &schema = child_->GetOutputSchema();
   Tuple tuple;
   RID rid;
-  num_of_tuples_ = 0;
-  while (child_->Next(&tuple, &rid)) {
-    aht_.InsertCombine(MakeAggregateKey(&tuple), MakeAggregateValue(&tuple));
-    num_of_tuples_++;
+  while (chunk->rows_ < static_cast<size_t>(BUSTUB_BATCH_SIZE) && child_->Next(&tuple, &rid)) {
+    for (size_t k = 0; k < group_bys.size(); k++) {
+      chunk->keys_[k].push_back(group_bys[k]->Evaluate(&tuple, schema));
+    }
+    for (size_t i = 0; i < aggregates.size(); i++) {
+      chunk->inputs_[i].push_back(aggregates[i]->Evaluate(&tuple, schema));
+    }
+    chunk->rows_++;
   }
-  aht_iterator_ = aht_.Begin();
+  return chunk->rows_ > 0;
 }
 
-auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (num_of_tuples_ == 0 && plan_->group_bys_.empty()) {  // empty table
-    Tuple output_tuple(aht_.GenerateInitialAggregateValue().aggregates_, &plan_->OutputSchema());
-    *tuple = output_tuple;
-    *rid = output_tuple.GetRid();
-    --num_of_tuples_;
+auto AggregationExecutor::AcquireTable() -> AggregationHashTable * {
+  std::scoped_lock lock(tables_mutex_);
+  if (idle_tables_.empty()) {
+    tables_.push_back(std::make_unique<AggregationHashTable>(plan_->GetAggregateTypes(), key_types_, input_types_));
+    return tables_.back().get();
+  }
+  auto *table = idle_tables_.back();
+  idle_tables_.pop_back();
+  return table;
+}
+
+void AggregationExecutor::ReleaseTable(AggregationHashTable *table) {
+  std::scoped_lock lock(tables_mutex_);
+  idle_tables_.push_back(table);
+}
+
+void AggregationExecutor::SpillTables(TaskScheduler *scheduler) {
+  if (spill_files_.empty()) {
+    for (size_t p = 0; p < AggregationHashTable::NUM_PARTITIONS; p++) {
+      spill_files_.push_back(std::make_unique<SpillFile>(exec_ctx_->GetBufferPoolManager()));
+    }
+  }
+  // 每个分区的文件只由一个任务来写
+  TaskGroup spilling(scheduler);
+  for (size_t p = 0; p < AggregationHashTable::NUM_PARTITIONS; p++) {
+    spilling.Spawn([this, p] {
+      for (const auto &table : tables_) {
+        table->SpillPartition(p, spill_files_[p].get());
+      }
+    });
+  }
+  spilling.Wait();
+  spilling.RethrowError();
+  for (auto &table : tables_) {
+    table->Clear();
+  }
+}
+
+void AggregationExecutor::QueuePartitions() {
+  if (spill_files_.empty() && tables_.size() <= 1) {
+    // 只有一张表且没溢出时，分区直接从它输出
+    aht_ = tables_.empty() ? std::make_unique<AggregationHashTable>(plan_->GetAggregateTypes(), key_types_,
+                                                                     input_types_)
+                           : std::move(tables_[0]);
+    tables_.clear();
+    idle_tables_.clear();
+  } else {
+    aht_ = std::make_unique<AggregationHashTable>(plan_->GetAggregateTypes(), key_types_, input_types_);
+  }
+  if (!spill_files_.empty()) {
+    RecordSpill(spill_files_, 0);
+  }
+  for (size_t p = AggregationHashTable::NUM_PARTITIONS; p-- > 0;) {
+    tasks_.push_back({p, spill_files_.empty() ? nullptr : std::move(spill_files_[p]), 0});
+  }
+  spill_files_.clear();
+}
+
+auto AggregationExecutor::LoadPartition() -> bool {
+  if (loaded_) {
+    aht_->ClearPartition(partition_);
+    loaded_ = false;
+  }
+  while (!tasks_.empty()) {
+    auto task = std::move(tasks_.back());
+    tasks_.pop_back();
+    // 局部表的这个分区并进来就释放，只在第一层有
+    for (auto &table : tables_) {
+      aht_->MergePartition(task.partition_, *table);
+      table->ClearPartition(task.partition_);
+    }
+    bool fits = true;
+    std::unique_ptr<SpillFile::Reader> reader;
+    if (task.file_ != nullptr) {
+      reader = std::make_unique<SpillFile::Reader>(task.file_.get());
+      // 到了最深一层还装不下就只能硬装
+      auto budget = task.level_ + 1 < MAX_SPILL_DEPTH ? exec_ctx_->GetMemoryBudget() : SIZE_MAX;
+      fits = aht_->MergeSpilled(task.partition_, reader.get(), budget);
+    }
+    if (!fits) {
+      // 已并好的组和文件里剩下的行按 hash 的下几位一起拆开，拆出来的小块排到最前面
+      auto level = task.level_ + 1;
+      std::vector<std::unique_ptr<SpillFile>> files;
+      for (size_t i = 0; i < (size_t{1} << SPILL_PARTITION_BITS); i++) {
+        files.push_back(std::make_unique<SpillFile>(exec_ctx_->GetBufferPoolManager()));
+      }
+      aht_->SplitPartition(task.partition_, level, files);
+      aht_->ClearPartition(task.partition_);
+      aht_->SplitSpilled(reader.get(), level, files);
+      RecordSpill(files, level);
+      for (size_t i = files.size(); i-- > 0;) {
+        if (files[i]->Rows() > 0) {
+          tasks_.push_back({task.partition_, std::move(files[i]), level});
+        }
+      }
+      continue;
+    }
+    if (aht_->NumGroups(task.partition_) == 0) {
+      continue;
+    }
+    partition_ = task.partition_;
+    group_ = 0;
+    loaded_ = true;
+    return true;
+  }
+  tables_.clear();
+  idle_tables_.clear();
+  return false;
+}
+
+void AggregationExecutor::RecordSpill(const std::vector<std::unique_ptr<SpillFile>> &files, size_t level) {
+  auto *stats = exec_ctx_->GetOperatorStats(plan_);
+  for (const auto &file : files) {
+    file->Finish();
+    if (file->Rows() > 0) {
+      stats->spilled_bytes_ += file->Bytes();
+      stats->spilled_rows_ += file->Rows();
+      stats->spill_partitions_++;
+    }
+  }
+  stats->RecordSpillDepth(level + 1);
+}
+
+auto AggregationExecutor::NextGroup(std::vector<Value> *values) -> bool {
+  if (emit_initial_) {
+    emit_initial_ = false;
+    *values = aht_->InitialAggregates();
     return true;
   }
-  if (aht_iterator_ == aht_.End()) {
+  while (!loaded_ || group_ == aht_->NumGroups(partition_)) {
+    if (!LoadPartition()) {
+      return false;
+    }
+  }
+  *values = aht_->GetGroup(partition_, group_++);
+  return true;
+}
+
+auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  std::vector<Value> values;
+  if (!NextGroup(&values)) {
     return false;
   }
-  std::vector<Value> values = aht_iterator_.Key().group_bys_;
-  values.insert(values.end(), aht_iterator_.Val().aggregates_.begin(), aht_iterator_.Val().aggregates_.end());
-  Tuple out_tuple(values, &GetOutputSchema());
-  RID ridd = out_tuple.GetRid();
-  *tuple = out_tuple;
-  *rid = ridd;
-  ++aht_iterator_;
+  *tuple = Tuple(values, &GetOutputSchema());
+  *rid = tuple->GetRid();
   return true;
 }
 
+auto AggregationExecutor::NextBatch(TupleBatch *batch) -> bool {
+  batch->Reset();
+  std::vector<Value> values;
+  while (!batch->IsFull() && NextGroup(&values)) {
+    batch->Append(std::move(values));
+  }
+  return batch->Size() > 0;
+}
+
 auto AggregationExecutor::GetChildExecutor() const -> const AbstractExecutor * { return child_.get(); }
 
 }  // namespace bustub
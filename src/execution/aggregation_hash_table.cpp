@@ -0,0 +1,400 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_hash_table.cpp
+//
+// Identification: src/execution/aggregation_hash_table.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/aggregation_hash_table.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** Fibonacci hashing constant, spreads the hash bits into the top bits of the slot index */
+constexpr uint64_t SLOT_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+template <typename KeyAt>
+auto HashKeys(size_t num_keys, KeyAt key_at) -> hash_t {
+  hash_t hash = 0;
+  for (size_t k = 0; k < num_keys; k++) {
+    const Value &key = key_at(k);
+    if (!key.IsNull()) {
+      hash = HashUtil::CombineHashes(hash, HashUtil::HashValue(&key));
+    }
+  }
+  return hash;
+}
+
+/** NULL group-by values are equal to each other here, unlike in comparisons */
+auto KeyEquals(const Value &a, const Value &b) -> bool {
+  if (a.IsNull() || b.IsNull()) {
+    return a.IsNull() && b.IsNull();
+  }
+  return a.CompareEquals(b) == CmpBool::CmpTrue;
+}
+
+auto IsIntegral(TypeId type) -> bool { return type == TypeId::INTEGER || type == TypeId::BIGINT; }
+
+auto AsInt64(const Value &value) -> int64_t {
+  return value.GetTypeId() == TypeId::INTEGER ? value.GetAs<int32_t>() : value.GetAs<int64_t>();
+}
+
+void CheckedAdd(int64_t *acc, int64_t value) {
+  // LLONG_MIN 是 BIGINT 的 NULL，和溢出一样当作越界
+  if (__builtin_add_overflow(*acc, value, acc) || *acc < BUSTUB_INT64_MIN) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+  }
+}
+
+auto MakeInteger(int64_t value) -> Value {
+  if (value < BUSTUB_INT32_MIN || value > BUSTUB_INT32_MAX) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+  }
+  return ValueFactory::GetIntegerValue(static_cast<int32_t>(value));
+}
+
+auto MakeColumn(const std::string &name, TypeId type) -> Column {
+  if (type == TypeId::VARCHAR) {
+    return {name, type, BUSTUB_PAGE_SIZE};
+  }
+  return {name, type};
+}
+
+auto MakePartialSchema(const std::vector<TypeId> &key_types, const std::vector<bool> &typed,
+                       const std::vector<TypeId> &input_types) -> Schema {
+  std::vector<Column> columns;
+  for (size_t k = 0; k < key_types.size(); k++) {
+    columns.push_back(MakeColumn("key" + std::to_string(k), key_types[k]));
+  }
+  for (size_t i = 0; i < typed.size(); i++) {
+    columns.push_back(MakeColumn("agg" + std::to_string(i), typed[i] ? TypeId::BIGINT : input_types[i]));
+  }
+  return Schema(columns);
+}
+
+auto TypedOf(const std::vector<AggregationType> &agg_types, const std::vector<TypeId> &input_types)
+    -> std::vector<bool> {
+  std::vector<bool> typed;
+  for (size_t i = 0; i < agg_types.size(); i++) {
+    typed.push_back(agg_types[i] == AggregationType::CountStarAggregate ||
+                    agg_types[i] == AggregationType::CountAggregate || IsIntegral(input_types[i]));
+  }
+  return typed;
+}
+
+}  // namespace
+
+AggregationHashTable::AggregationHashTable(const std::vector<AggregationType> &agg_types,
+                                           const std::vector<TypeId> &key_types,
+                                           const std::vector<TypeId> &input_types)
+    : agg_types_(agg_types),
+      input_types_(input_types),
+      num_keys_(key_types.size()),
+      typed_(TypedOf(agg_types, input_types)),
+      partial_schema_(MakePartialSchema(key_types, typed_, input_types)),
+      partitions_(NUM_PARTITIONS) {
+  for (bool typed : typed_) {
+    slot_of_.push_back(typed ? num_typed_++ : num_values_++);
+  }
+}
+
+template <typename KeyAt>
+auto AggregationHashTable::FindOrCreate(Partition *partition, hash_t hash, KeyAt key_at) -> size_t {
+  auto &p = *partition;
+  if ((p.hashes_.size() + 1) * 2 > p.slots_.size()) {
+    Grow(partition);
+  }
+  auto mask = p.slots_.size() - 1;
+  auto shift = 64 - __builtin_ctzll(p.slots_.size());
+  for (auto slot = (hash * SLOT_MULTIPLIER) >> shift;; slot = (slot + 1) & mask) {
+    auto entry = p.slots_[slot];
+    if (entry == 0) {
+      size_t group = p.hashes_.size();
+      p.slots_[slot] = static_cast<uint32_t>(group + 1);
+      p.hashes_.push_back(hash);
+      for (size_t k = 0; k < num_keys_; k++) {
+        const Value &key = key_at(k);
+        p.bytes_ += key.GetTypeId() == TypeId::VARCHAR ? key.GetLength() : 0;
+        p.keys_.push_back(key);
+      }
+      p.typed_.resize(p.typed_.size() + num_typed_, 0);
+      for (size_t i = 0; i < agg_types_.size(); i++) {
+        if (typed_[i]) {
+          p.valid_.push_back(agg_types_[i] == AggregationType::CountStarAggregate ? 1 : 0);
+        } else {
+          p.values_.push_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+        }
+      }
+      // 键、hash、两种累加器，再加上大约两个槽
+      p.bytes_ += sizeof(hash_t) + num_keys_ * sizeof(Value) + num_typed_ * (sizeof(int64_t) + 1) +
+                  num_values_ * sizeof(Value) + 2 * sizeof(uint32_t);
+      return group;
+    }
+    size_t group = entry - 1;
+    if (p.hashes_[group] != hash) {
+      continue;
+    }
+    bool equal = true;
+    for (size_t k = 0; k < num_keys_ && equal; k++) {
+      equal = KeyEquals(p.keys_[group * num_keys_ + k], key_at(k));
+    }
+    if (equal) {
+      return group;
+    }
+  }
+}
+
+void AggregationHashTable::Grow(Partition *partition) {
+  auto &p = *partition;
+  BUSTUB_ASSERT(p.hashes_.size() < std::numeric_limits<uint32_t>::max(), "too many groups for 32-bit slots");
+  p.slots_.assign(std::max<size_t>(16, p.slots_.size() * 2), 0);
+  auto mask = p.slots_.size() - 1;
+  auto shift = 64 - __builtin_ctzll(p.slots_.size());
+  for (size_t group = 0; group < p.hashes_.size(); group++) {
+    auto slot = (p.hashes_[group] * SLOT_MULTIPLIER) >> shift;
+    while (p.slots_[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    p.slots_[slot] = static_cast<uint32_t>(group + 1);
+  }
+}
+
+void AggregationHashTable::Insert(const std::vector<std::vector<Value>> &keys,
+                                  const std::vector<std::vector<Value>> &inputs, size_t row) {
+  auto key_at = [&](size_t k) -> const Value & { return keys[k][row]; };
+  auto hash = HashKeys(num_keys_, key_at);
+  auto *partition = &partitions_[PartitionOf(hash)];
+  auto group = FindOrCreate(partition, hash, key_at);
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    Update(partition, group, i, inputs[i][row]);
+  }
+}
+
+void AggregationHashTable::Update(Partition *partition, size_t group, size_t i, const Value &input) {
+  if (!typed_[i]) {
+    MergeValue(partition, group, i, input);
+    return;
+  }
+  switch (agg_types_[i]) {
+    case AggregationType::CountStarAggregate:
+      MergeTyped(partition, group, i, 1, true);
+      break;
+    case AggregationType::CountAggregate:
+      MergeTyped(partition, group, i, 1, !input.IsNull());
+      break;
+    default:
+      if (!input.IsNull()) {
+        MergeTyped(partition, group, i, AsInt64(input), true);
+      }
+      break;
+  }
+}
+
+void AggregationHashTable::MergeTyped(Partition *partition, size_t group, size_t i, int64_t value, bool valid) {
+  if (!valid) {
+    return;
+  }
+  auto index = group * num_typed_ + slot_of_[i];
+  auto &acc = partition->typed_[index];
+  auto &has_value = partition->valid_[index];
+  if (has_value == 0) {
+    acc = value;
+    has_value = 1;
+    return;
+  }
+  switch (agg_types_[i]) {
+    case AggregationType::CountStarAggregate:
+    case AggregationType::CountAggregate:
+    case AggregationType::SumAggregate:
+      CheckedAdd(&acc, value);
+      break;
+    case AggregationType::MinAggregate:
+      acc = std::min(acc, value);
+      break;
+    case AggregationType::MaxAggregate:
+      acc = std::max(acc, value);
+      break;
+  }
+}
+
+void AggregationHashTable::MergeValue(Partition *partition, size_t group, size_t i, const Value &value) {
+  if (value.IsNull()) {
+    return;
+  }
+  Value &cur = partition->values_[group * num_values_ + slot_of_[i]];
+  if (cur.IsNull()) {
+    cur = value;
+    return;
+  }
+  switch (agg_types_[i]) {
+    case AggregationType::SumAggregate:
+      cur = cur.Add(value);
+      break;
+    case AggregationType::MinAggregate:
+      cur = cur.Min(value);
+      break;
+    case AggregationType::MaxAggregate:
+      cur = cur.Max(value);
+      break;
+    default:
+      UNREACHABLE("counts always run on typed accumulators");
+  }
+}
+
+void AggregationHashTable::MergePartition(size_t partition, const AggregationHashTable &other) {
+  auto *target = &partitions_[partition];
+  const auto &source = other.partitions_[partition];
+  for (size_t group = 0; group < source.hashes_.size(); group++) {
+    auto merged = FindOrCreate(target, source.hashes_[group],
+                               [&](size_t k) -> const Value & { return source.keys_[group * num_keys_ + k]; });
+    for (size_t i = 0; i < agg_types_.size(); i++) {
+      if (typed_[i]) {
+        auto index = group * num_typed_ + slot_of_[i];
+        MergeTyped(target, merged, i, source.typed_[index], source.valid_[index] != 0);
+      } else {
+        MergeValue(target, merged, i, source.values_[group * num_values_ + slot_of_[i]]);
+      }
+    }
+  }
+}
+
+auto AggregationHashTable::PartialGroup(const Partition &partition, size_t group) const -> Tuple {
+  std::vector<Value> values;
+  // NULL 按列的类型重新生成，Tuple 按列类型序列化
+  for (size_t k = 0; k < num_keys_; k++) {
+    const auto &key = partition.keys_[group * num_keys_ + k];
+    auto type = partial_schema_.GetColumn(k).GetType();
+    values.push_back(key.IsNull() ? ValueFactory::GetNullValueByType(type) : key);
+  }
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    if (typed_[i]) {
+      auto index = group * num_typed_ + slot_of_[i];
+      values.push_back(partition.valid_[index] != 0 ? ValueFactory::GetBigIntValue(partition.typed_[index])
+                                                    : ValueFactory::GetNullValueByType(TypeId::BIGINT));
+    } else {
+      const auto &value = partition.values_[group * num_values_ + slot_of_[i]];
+      values.push_back(value.IsNull() ? ValueFactory::GetNullValueByType(input_types_[i]) : value);
+    }
+  }
+  return {values, &partial_schema_};
+}
+
+auto AggregationHashTable::ReadPartial(const Tuple &tuple, std::vector<Value> *values) const -> hash_t {
+  values->resize(partial_schema_.GetColumnCount());
+  for (size_t c = 0; c < values->size(); c++) {
+    (*values)[c] = tuple.GetValue(&partial_schema_, c);
+  }
+  return HashKeys(num_keys_, [&](size_t k) -> const Value & { return (*values)[k]; });
+}
+
+void AggregationHashTable::SpillPartition(size_t partition, SpillFile *file) const {
+  const auto &source = partitions_[partition];
+  for (size_t group = 0; group < source.hashes_.size(); group++) {
+    file->Append(PartialGroup(source, group));
+  }
+}
+
+void AggregationHashTable::SplitPartition(size_t partition, size_t level,
+                                          const std::vector<std::unique_ptr<SpillFile>> &files) const {
+  const auto &source = partitions_[partition];
+  for (size_t group = 0; group < source.hashes_.size(); group++) {
+    files[SpillPartitionOf(source.hashes_[group], level)]->Append(PartialGroup(source, group));
+  }
+}
+
+void AggregationHashTable::SplitSpilled(SpillFile::Reader *reader, size_t level,
+                                        const std::vector<std::unique_ptr<SpillFile>> &files) const {
+  Tuple tuple;
+  std::vector<Value> values;
+  while (reader->Next(&tuple)) {
+    files[SpillPartitionOf(ReadPartial(tuple, &values), level)]->Append(tuple);
+  }
+}
+
+auto AggregationHashTable::MergeSpilled(size_t partition, SpillFile::Reader *reader, size_t budget) -> bool {
+  auto *target = &partitions_[partition];
+  Tuple tuple;
+  std::vector<Value> values;
+  while (target->bytes_ <= budget) {
+    if (!reader->Next(&tuple)) {
+      return true;
+    }
+    auto hash = ReadPartial(tuple, &values);
+    auto group = FindOrCreate(target, hash, [&](size_t k) -> const Value & { return values[k]; });
+    for (size_t i = 0; i < agg_types_.size(); i++) {
+      const auto &value = values[num_keys_ + i];
+      if (typed_[i]) {
+        MergeTyped(target, group, i, value.IsNull() ? 0 : value.GetAs<int64_t>(), !value.IsNull());
+      } else {
+        MergeValue(target, group, i, value);
+      }
+    }
+  }
+  return false;
+}
+
+void AggregationHashTable::Clear() {
+  for (auto &partition : partitions_) {
+    partition = Partition{};
+  }
+}
+
+auto AggregationHashTable::MemoryUsage() const -> size_t {
+  size_t bytes = 0;
+  for (const auto &partition : partitions_) {
+    bytes += partition.bytes_;
+  }
+  return bytes;
+}
+
+auto AggregationHashTable::Finalize(const Partition &partition, size_t group, size_t i) const -> Value {
+  if (!typed_[i]) {
+    return partition.values_[group * num_values_ + slot_of_[i]];
+  }
+  auto index = group * num_typed_ + slot_of_[i];
+  if (partition.valid_[index] == 0) {
+    return ValueFactory::GetNullValueByType(TypeId::INTEGER);
+  }
+  auto acc = partition.typed_[index];
+  if (agg_types_[i] == AggregationType::CountStarAggregate || agg_types_[i] == AggregationType::CountAggregate ||
+      input_types_[i] == TypeId::INTEGER) {
+    return MakeInteger(acc);
+  }
+  return ValueFactory::GetBigIntValue(acc);
+}
+
+auto AggregationHashTable::GetGroup(size_t partition, size_t group) const -> std::vector<Value> {
+  const auto &source = partitions_[partition];
+  std::vector<Value> values(source.keys_.begin() + group * num_keys_, source.keys_.begin() + (group + 1) * num_keys_);
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    values.push_back(Finalize(source, group, i));
+  }
+  return values;
+}
+
+auto AggregationHashTable::InitialAggregates() const -> std::vector<Value> {
+  std::vector<Value> values;
+  for (auto agg_type : agg_types_) {
+    values.push_back(agg_type == AggregationType::CountStarAggregate
+                         ? ValueFactory::GetIntegerValue(0)
+                         : ValueFactory::GetNullValueByType(TypeId::INTEGER));
+  }
+  return values;
+}
+
+}  // namespace bustub
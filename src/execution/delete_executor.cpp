@@ -28,9 +28,10 @@ void DeleteExecutor::Init() {
   auto table_oid = plan_->TableOid();
   table_info_ = catalog->GetTable(table_oid);
   auto table_name = table_info_->name_;
-  index_infos_ = catalog->GetTableIndexes(table_name);
   has_out_ = false;
+  // 子节点 Init 时拿表锁，之后再取索引列表，在线建的索引也要维护
   child_executor_->Init();
+  index_infos_ = catalog->GetTableIndexes(table_name, true);
 }
 
 auto DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
@@ -53,7 +54,7 @@ auto DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
     for (auto &x : index_infos_) {
       Tuple partial_tuple =
           tuple->KeyFromTuple(table_info_->schema_, *(x->index_->GetKeySchema()), x->index_->GetKeyAttrs());
-      x->index_->DeleteEntry(partial_tuple, *rid, exec_ctx_->GetTransaction());
+      x->DeleteEntry(partial_tuple, *rid, exec_ctx_->GetTransaction());
 
       auto iwr = IndexWriteRecord{*rid,          table_info_->oid_, WType::DELETE,
                                   partial_tuple, x->index_oid_,     exec_ctx_->GetCatalog()};
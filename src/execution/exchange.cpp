@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// exchange.cpp
+//
+// Identification: src/execution/exchange.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/exchange.h"
+
+namespace bustub {
+
+TupleExchange::TupleExchange(size_t producers, size_t max_chunks)
+    : max_chunks_(max_chunks), running_producers_(producers) {}
+
+auto TupleExchange::Push(Chunk &&chunk) -> bool {
+  std::unique_lock lock(latch_);
+  not_full_.wait(lock, [&] { return closed_ || chunks_.size() < max_chunks_; });
+  if (closed_) {
+    return false;
+  }
+  chunks_.emplace_back(std::move(chunk));
+  not_empty_.notify_one();
+  return true;
+}
+
+void TupleExchange::ProducerDone(std::exception_ptr error) {
+  std::scoped_lock lock(latch_);
+  if (error != nullptr && error_ == nullptr) {
+    error_ = std::move(error);
+  }
+  running_producers_--;
+  not_empty_.notify_one();
+}
+
+auto TupleExchange::Pop(Chunk *chunk) -> bool {
+  std::unique_lock lock(latch_);
+  // 出错时不必等其他生产者收尾，直接抛给消费者
+  not_empty_.wait(lock, [&] { return !chunks_.empty() || running_producers_ == 0 || error_ != nullptr; });
+  if (error_ != nullptr) {
+    std::rethrow_exception(error_);
+  }
+  if (chunks_.empty()) {
+    return false;
+  }
+  *chunk = std::move(chunks_.front());
+  chunks_.pop_front();
+  not_full_.notify_one();
+  return true;
+}
+
+void TupleExchange::Close() {
+  std::scoped_lock lock(latch_);
+  closed_ = true;
+  chunks_.clear();
+  not_full_.notify_all();
+}
+
+PartitionedExchange::PartitionedExchange(size_t num_partitions) {
+  for (size_t i = 0; i < num_partitions; i++) {
+    partitions_.emplace_back(std::make_unique<Partition>());
+  }
+}
+
+void PartitionedExchange::Push(size_t partition, std::vector<Tuple> *tuples) {
+  auto &target = *partitions_[partition];
+  std::scoped_lock lock(target.latch_);
+  for (auto &tuple : *tuples) {
+    target.tuples_.emplace_back(std::move(tuple));
+  }
+  tuples->clear();
+}
+
+auto PartitionedExchange::NextPartition(std::vector<Tuple> *tuples) -> bool {
+  auto partition = next_partition_++;
+  if (partition >= partitions_.size()) {
+    return false;
+  }
+  auto &source = *partitions_[partition];
+  std::scoped_lock lock(source.latch_);
+  *tuples = std::move(source.tuples_);
+  source.tuples_.clear();
+  return true;
+}
+
+}  // namespace bustub
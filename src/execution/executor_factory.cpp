@@ -19,15 +19,18 @@
 #include "execution/executors/aggregation_executor.h"
 #include "execution/executors/delete_executor.h"
 #include "execution/executors/filter_executor.h"
+#include "execution/executors/gather_executor.h"
 #include "execution/executors/hash_join_executor.h"
 #include "execution/executors/index_scan_executor.h"
 #include "execution/executors/init_check_executor.h"
 #include "execution/executors/insert_executor.h"
 #include "execution/executors/limit_executor.h"
+#include "execution/executors/merge_join_executor.h"
 #include "execution/executors/mock_scan_executor.h"
 #include "execution/executors/nested_index_join_executor.h"
 #include "execution/executors/nested_loop_join_executor.h"
 #include "execution/executors/projection_executor.h"
+#include "execution/executors/repartition_executor.h"
 #include "execution/executors/seq_scan_executor.h"
 #include "execution/executors/sort_executor.h"
 #include "execution/executors/topn_check_executor.h"
@@ -35,8 +38,10 @@
 #include "execution/executors/update_executor.h"
 #include "execution/executors/values_executor.h"
 #include "execution/plans/filter_plan.h"
+#include "execution/plans/gather_plan.h"
 #include "execution/plans/mock_scan_plan.h"
 #include "execution/plans/projection_plan.h"
+#include "execution/plans/repartition_plan.h"
 #include "execution/plans/sort_plan.h"
 #include "execution/plans/topn_plan.h"
 #include "execution/plans/values_plan.h"
@@ -126,6 +131,14 @@ auto ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx, const AbstractPl
       return std::make_unique<HashJoinExecutor>(exec_ctx, hash_join_plan, std::move(left), std::move(right));
     }
 
+    // Create a new merge join executor
+    case PlanType::MergeJoin: {
+      auto merge_join_plan = dynamic_cast<const MergeJoinPlanNode *>(plan.get());
+      auto left = ExecutorFactory::CreateExecutor(exec_ctx, merge_join_plan->GetLeftPlan());
+      auto right = ExecutorFactory::CreateExecutor(exec_ctx, merge_join_plan->GetRightPlan());
+      return std::make_unique<MergeJoinExecutor>(exec_ctx, merge_join_plan, std::move(left), std::move(right));
+    }
+
     // Create a new mock scan executor
     case PlanType::MockScan: {
       const auto *mock_scan_plan = dynamic_cast<const MockScanPlanNode *>(plan.get());
@@ -172,6 +185,22 @@ auto ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx, const AbstractPl
       return std::make_unique<TopNExecutor>(exec_ctx, topn_plan, std::move(child));
     }
 
+      // Create a new gather executor, it creates the copies of its pipeline itself
+    case PlanType::Gather: {
+      const auto *gather_plan = dynamic_cast<const GatherPlanNode *>(plan.get());
+      return std::make_unique<GatherExecutor>(exec_ctx, gather_plan);
+    }
+
+      // Create a new repartition executor, the child runs in an earlier stage when a gather fills the partitions
+    case PlanType::Repartition: {
+      const auto *repartition_plan = dynamic_cast<const RepartitionPlanNode *>(plan.get());
+      std::unique_ptr<AbstractExecutor> child;
+      if (exec_ctx->GetSharedState<PartitionedExchange>(repartition_plan) == nullptr) {
+        child = ExecutorFactory::CreateExecutor(exec_ctx, repartition_plan->GetChildPlan());
+      }
+      return std::make_unique<RepartitionExecutor>(exec_ctx, repartition_plan, std::move(child));
+    }
+
     default:
       UNREACHABLE("Unsupported plan type.");
   }
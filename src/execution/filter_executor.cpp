@@ -31,4 +31,25 @@ auto FilterExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   }
 }
 
+auto FilterExecutor::NextBatch(TupleBatch *batch) -> bool {
+  auto filter_expr = plan_->GetPredicate();
+  std::vector<Value> values;
+  while (child_executor_->NextBatch(batch)) {
+    filter_expr->EvaluateBatch(*batch, &values);
+    // 只收缩选择向量，列数据原地不动
+    auto &sel = batch->GetSelection();
+    size_t kept = 0;
+    for (size_t i = 0; i < sel.size(); i++) {
+      if (!values[i].IsNull() && values[i].GetAs<bool>()) {
+        sel[kept++] = sel[i];
+      }
+    }
+    sel.resize(kept);
+    if (kept > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace bustub
@@ -7,9 +7,12 @@
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
 #include "execution/plans/aggregation_plan.h"
+#include "execution/plans/gather_plan.h"
 #include "execution/plans/hash_join_plan.h"
 #include "execution/plans/limit_plan.h"
+#include "execution/plans/merge_join_plan.h"
 #include "execution/plans/projection_plan.h"
+#include "execution/plans/repartition_plan.h"
 #include "execution/plans/sort_plan.h"
 #include "execution/plans/topn_plan.h"
 
@@ -32,6 +35,20 @@ auto AbstractPlanNode::ChildrenToString(int indent, bool with_schema) const -> s
   return fmt::format("\n{}", fmt::join(children_str, "\n"));
 }
 
+auto AbstractPlanNode::ToString(const std::function<std::string(const AbstractPlanNode &)> &annotate) const
+    -> std::string {
+  std::vector<std::string> lines;
+  auto note = annotate(*this);
+  lines.push_back(note.empty() ? PlanNodeToString() : fmt::format("{} | {}", PlanNodeToString(), note));
+  auto indent_str = StringUtil::Indent(2);
+  for (const auto &child : children_) {
+    for (auto &line : StringUtil::Split(child->ToString(annotate), '\n')) {
+      lines.push_back(fmt::format("{}{}", indent_str, line));
+    }
+  }
+  return fmt::format("{}", fmt::join(lines, "\n"));
+}
+
 auto AggregationPlanNode::PlanNodeToString() const -> std::string {
   return fmt::format("Agg {{ types={}, aggregates={}, group_by={} }}", agg_types_, aggregates_, group_bys_);
 }
@@ -41,6 +58,11 @@ auto HashJoinPlanNode::PlanNodeToString() const -> std::string {
                      right_key_expressions_);
 }
 
+auto MergeJoinPlanNode::PlanNodeToString() const -> std::string {
+  return fmt::format("MergeJoin {{ type={}, left_key={}, right_key={} }}", join_type_, left_key_expressions_,
+                     right_key_expressions_);
+}
+
 auto ProjectionPlanNode::PlanNodeToString() const -> std::string {
   return fmt::format("Projection {{ exprs={} }}", expressions_);
 }
@@ -59,4 +81,12 @@ auto TopNPlanNode::PlanNodeToString() const -> std::string {
   return fmt::format("TopN {{ n={}, order_bys={}}}", n_, order_bys_);
 }
 
+auto GatherPlanNode::PlanNodeToString() const -> std::string {
+  return fmt::format("Gather {{ parallelism={} }}", parallelism_);
+}
+
+auto RepartitionPlanNode::PlanNodeToString() const -> std::string {
+  return fmt::format("Repartition {{ keys={}, partitions={} }}", keys_, num_partitions_);
+}
+
 }  // namespace bustub
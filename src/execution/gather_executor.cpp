@@ -0,0 +1,228 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// gather_executor.cpp
+//
+// Identification: src/execution/gather_executor.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/gather_executor.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "common/util/hash_util.h"
+#include "execution/executor_factory.h"
+#include "execution/executors/hash_join_executor.h"
+#include "execution/executors/mock_scan_executor.h"
+#include "execution/morsel.h"
+#include "execution/plans/mock_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Pull every row of an executor, a batch at a time when it supports batches.
+ * @param sink called with each row, returns `false` to stop early
+ */
+template <typename Sink>
+void Drain(AbstractExecutor *executor, Sink &&sink) {
+  if (executor->SupportsBatch()) {
+    TupleBatch batch(&executor->GetOutputSchema());
+    while (executor->NextBatch(&batch)) {
+      for (size_t i = 0; i < batch.Size(); i++) {
+        auto row = batch.SelectedRow(i);
+        if (!sink(batch.MaterializeTuple(row), batch.GetRid(row))) {
+          return;
+        }
+      }
+    }
+    return;
+  }
+  Tuple tuple;
+  RID rid;
+  while (executor->Next(&tuple, &rid)) {
+    if (!sink(std::move(tuple), rid)) {
+      return;
+    }
+  }
+}
+
+/** @return the partition of a row, by the hash of the repartition keys */
+auto PartitionOf(const RepartitionPlanNode *plan, const Tuple &tuple, size_t num_partitions) -> size_t {
+  size_t hash = 0;
+  for (const auto &key : plan->GetKeys()) {
+    auto value = key->Evaluate(&tuple, plan->GetChildPlan()->OutputSchema());
+    if (!value.IsNull()) {
+      hash = HashUtil::CombineHashes(hash, HashUtil::HashValue(&value));
+    }
+  }
+  return hash % num_partitions;
+}
+
+}  // namespace
+
+GatherExecutor::GatherExecutor(ExecutorContext *exec_ctx, const GatherPlanNode *plan)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      parallelism_(exec_ctx->GetTaskScheduler() == nullptr ? 1 : std::max<size_t>(plan->GetParallelism(), 1)) {}
+
+GatherExecutor::~GatherExecutor() { StopOutputStage(); }
+
+void GatherExecutor::Init() {
+  StopOutputStage();
+  PublishSharedState();
+  // 副本要在共享状态发布之后再建，Repartition 据此决定要不要建自己的子节点
+  if (output_copies_.empty()) {
+    for (const auto *breaker : breakers_) {
+      auto &copies = stage_copies_.emplace_back();
+      for (size_t i = 0; i < parallelism_; i++) {
+        copies.emplace_back(ExecutorFactory::CreateExecutor(exec_ctx_, breaker->GetChildPlan()));
+      }
+    }
+    for (size_t i = 0; i < parallelism_; i++) {
+      output_copies_.emplace_back(ExecutorFactory::CreateExecutor(exec_ctx_, plan_->GetChildPlan()));
+    }
+  }
+  for (size_t stage = 0; stage < breakers_.size(); stage++) {
+    RunBreakerStage(stage);
+  }
+  if (exec_ctx_->GetTaskScheduler() == nullptr) {
+    output_copies_[0]->Init();
+    return;
+  }
+  StartOutputStage();
+}
+
+auto GatherExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (exchange_ == nullptr) {
+    return output_copies_[0]->Next(tuple, rid);
+  }
+  while (chunk_pos_ >= chunk_.size()) {
+    chunk_.clear();
+    chunk_pos_ = 0;
+    if (!exchange_->Pop(&chunk_)) {
+      return false;
+    }
+  }
+  auto &[next_tuple, next_rid] = chunk_[chunk_pos_++];
+  *tuple = std::move(next_tuple);
+  *rid = next_rid;
+  return true;
+}
+
+void GatherExecutor::PublishSharedState() {
+  breakers_.clear();
+  // 只有沿左边一路下去的节点被切成副本，hash join 的建表侧在某一个副本里整体执行
+  for (const AbstractPlanNode *node = plan_->GetChildPlan().get();; node = node->GetChildAt(0).get()) {
+    switch (node->GetType()) {
+      case PlanType::SeqScan: {
+        const auto *scan = dynamic_cast<const SeqScanPlanNode *>(node);
+        auto *table = exec_ctx_->GetCatalog()->GetTable(scan->GetTableOid())->table_.get();
+        exec_ctx_->SetSharedState(node,
+                                  std::make_shared<TableMorselCursor>(exec_ctx_->GetBufferPoolManager(), table));
+      } break;
+      case PlanType::MockScan: {
+        const auto *scan = dynamic_cast<const MockScanPlanNode *>(node);
+        exec_ctx_->SetSharedState(node, std::make_shared<RowMorselCursor>(GetSizeOf(scan)));
+      } break;
+      case PlanType::HashJoin:
+        exec_ctx_->SetSharedState(node, std::make_shared<HashJoinBuildState>());
+        break;
+      case PlanType::Repartition: {
+        const auto *repartition = dynamic_cast<const RepartitionPlanNode *>(node);
+        exec_ctx_->SetSharedState(node, std::make_shared<PartitionedExchange>(repartition->GetNumPartitions()));
+        breakers_.push_back(repartition);
+      } break;
+      default:
+        break;
+    }
+    if (node->GetChildren().empty()) {
+      break;
+    }
+  }
+  std::reverse(breakers_.begin(), breakers_.end());
+}
+
+void GatherExecutor::RunBreakerStage(size_t stage) {
+  const auto *breaker = breakers_[stage];
+  auto exchange = exec_ctx_->GetSharedState<PartitionedExchange>(breaker);
+  TaskGroup tasks(exec_ctx_->GetTaskScheduler());
+  for (auto &copy : stage_copies_[stage]) {
+    tasks.Spawn([breaker, &exchange, copy = copy.get()] {
+      // 先攒在本地，每个分区攒够一批再加锁交出去
+      auto num_partitions = exchange->NumPartitions();
+      std::vector<std::vector<Tuple>> local(num_partitions);
+      copy->Init();
+      Drain(copy, [&](Tuple &&tuple, RID rid) {
+        auto partition = PartitionOf(breaker, tuple, num_partitions);
+        local[partition].emplace_back(std::move(tuple));
+        if (local[partition].size() >= static_cast<size_t>(BUSTUB_BATCH_SIZE)) {
+          exchange->Push(partition, &local[partition]);
+        }
+        return true;
+      });
+      for (size_t partition = 0; partition < num_partitions; partition++) {
+        exchange->Push(partition, &local[partition]);
+      }
+    });
+  }
+  tasks.Wait();
+  tasks.RethrowError();
+}
+
+void GatherExecutor::StartOutputStage() {
+  cancelled_ = false;
+  chunk_.clear();
+  chunk_pos_ = 0;
+  exchange_ = std::make_unique<TupleExchange>(parallelism_, parallelism_ * 2);
+  output_tasks_ = std::make_unique<TaskGroup>(exec_ctx_->GetTaskScheduler());
+  for (auto &copy : output_copies_) {
+    output_tasks_->Spawn([this, copy = copy.get()] { OutputWorker(copy); });
+  }
+}
+
+void GatherExecutor::StopOutputStage() {
+  if (exchange_ == nullptr) {
+    return;
+  }
+  // 上层提前结束（比如 LIMIT）时，还没开始的副本直接退出，正在跑的在下一次 Push 时退出
+  cancelled_ = true;
+  exchange_->Close();
+  output_tasks_->Wait();
+  output_tasks_.reset();
+  exchange_.reset();
+}
+
+void GatherExecutor::OutputWorker(AbstractExecutor *copy) {
+  std::exception_ptr error;
+  try {
+    if (!cancelled_) {
+      copy->Init();
+      TupleExchange::Chunk chunk;
+      Drain(copy, [&](Tuple &&tuple, RID rid) {
+        chunk.emplace_back(std::move(tuple), rid);
+        if (chunk.size() < static_cast<size_t>(BUSTUB_BATCH_SIZE)) {
+          return true;
+        }
+        bool open = exchange_->Push(std::move(chunk));
+        chunk = {};
+        return open;
+      });
+      if (!chunk.empty()) {
+        exchange_->Push(std::move(chunk));
+      }
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+  exchange_->ProducerDone(error);
+}
+
+}  // namespace bustub
@@ -30,50 +30,346 @@ HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlan
 }
 
 void HashJoinExecutor::Init() {
-  flag_ = false;
-  ma_.clear();
+  probe_reader_.reset();
+  spill_tasks_.clear();
+  spill_files_.clear();
+  spill_table_.Clear();
+  probe_partitioned_ = false;
+  // 并行流水线里只有一个副本建表，其余的等它建完直接探测
+  if (auto shared = exec_ctx_->GetSharedState<HashJoinBuildState>(plan_); shared != nullptr) {
+    ht_ = &shared->table_;
+    spilled_ = &shared->spilled_;
+    filter_ = &shared->filter_;
+    std::call_once(shared->built_, [this] { BuildHashTable(); });
+  } else {
+    ht_ = &own_table_;
+    spilled_ = &own_spilled_;
+    filter_ = &own_filter_;
+    ht_->Clear();
+    spilled_->clear();
+    BuildHashTable();
+  }
+  // 左连接的每一行都要输出，只有内连接能把过滤器交给左孩子
+  if (plan_->GetJoinType() == JoinType::INNER && left_executor_->PushDownJoinFilter(filter_)) {
+    filter_->stats_->bloom_filter_bytes_ = filter_->bloom_.MemoryUsage();
+  }
+  left_executor_->Init();
+  has_left_ = false;
+
+  if (left_batch_ == nullptr) {
+    left_batch_ = std::make_unique<TupleBatch>(&left_executor_->GetOutputSchema());
+  }
+  left_batch_->Reset();
+  left_keys_.assign(plan_->LeftJoinKeyExpressions().size(), {});
+  left_pos_ = 0;
+  probed_ = false;
+  pending_ = nullptr;
+}
+
+void HashJoinExecutor::BuildHashTable() {
+  const auto &exprs = plan_->RightJoinKeyExpressions();
+  // 溢出以后表里不再有行，内连接的过滤器要的 hash 另外记下来
+  bool fill_filter = plan_->GetJoinType() == JoinType::INNER;
+  std::vector<hash_t> spilled_hashes;
+  auto insert = [this, fill_filter, &spilled_hashes](std::vector<Value> &&key, Tuple &&tuple) {
+    if (!spilled_->empty()) {
+      auto hash = JoinHashTable::HashKeys(key);
+      if (fill_filter) {
+        spilled_hashes.push_back(hash);
+      }
+      (*spilled_)[JoinHashTable::SpillPartitionOf(hash, 0)]->Append(tuple);
+      return;
+    }
+    ht_->Insert(std::move(key), std::move(tuple));
+    if (ht_->MemoryUsage() > exec_ctx_->GetMemoryBudget()) {
+      // 超出内存预算：表里已有的行连同之后的行都按 hash 写进溢出分区
+      MakeSpillFiles(spilled_);
+      for (size_t i = 0; i < ht_->Size(); i++) {
+        if (fill_filter) {
+          spilled_hashes.push_back(ht_->GetHash(i));
+        }
+        (*spilled_)[JoinHashTable::SpillPartitionOf(ht_->GetHash(i), 0)]->Append(ht_->GetRow(i));
+      }
+      ht_->Clear();
+    }
+  };
+
   right_executor_->Init();
+  if (right_executor_->SupportsBatch()) {
+    // 建表侧整批算 key
+    TupleBatch right_batch(&right_executor_->GetOutputSchema());
+    std::vector<std::vector<Value>> keys(exprs.size());
+    while (right_executor_->NextBatch(&right_batch)) {
+      for (size_t k = 0; k < exprs.size(); k++) {
+        exprs[k]->EvaluateBatch(right_batch, &keys[k]);
+      }
+      for (size_t i = 0; i < right_batch.Size(); i++) {
+        std::vector<Value> key;
+        key.reserve(keys.size());
+        for (auto &column : keys) {
+          key.emplace_back(column[i]);
+        }
+        insert(std::move(key), right_batch.MaterializeTuple(right_batch.SelectedRow(i)));
+      }
+    }
+  } else {
+    Tuple tuple;
+    RID rid;
+    const auto &schema = right_executor_->GetOutputSchema();
+    while (right_executor_->Next(&tuple, &rid)) {
+      insert(JoinKey(exprs, tuple, schema), std::move(tuple));
+    }
+  }
+  if (fill_filter) {
+    filter_->keys_ = &plan_->LeftJoinKeyExpressions();
+    filter_->stats_ = exec_ctx_->GetOperatorStats(plan_);
+    if (spilled_->empty()) {
+      filter_->bloom_.Reset(ht_->Size());
+      for (size_t i = 0; i < ht_->Size(); i++) {
+        filter_->bloom_.Insert(ht_->GetHash(i));
+      }
+    } else {
+      filter_->bloom_.Reset(spilled_hashes.size());
+      for (auto hash : spilled_hashes) {
+        filter_->bloom_.Insert(hash);
+      }
+    }
+  }
+  if (!spilled_->empty()) {
+    RecordSpill(*spilled_, 0, true);
+    return;
+  }
+  // 按分区并行建表，工作线程里调用时 TaskGroup 会自己帮着跑
+  ht_->Build(exec_ctx_->GetTaskScheduler());
+}
+
+auto HashJoinExecutor::NextLeft(Tuple *tuple) -> bool {
+  if (spilled_->empty()) {
+    RID rid;
+    return left_executor_->Next(tuple, &rid);
+  }
+  if (!probe_partitioned_) {
+    PartitionProbeSide();
+  }
+  while (probe_reader_ == nullptr || !probe_reader_->Next(tuple)) {
+    if (!LoadSpillPartition()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void HashJoinExecutor::PartitionProbeSide() {
+  const auto &exprs = plan_->LeftJoinKeyExpressions();
+  const auto &schema = left_executor_->GetOutputSchema();
+  std::vector<std::unique_ptr<SpillFile>> probe;
+  MakeSpillFiles(&probe);
   Tuple tuple;
   RID rid;
-  while (right_executor_->Next(&tuple, &rid)) {
-    auto key = GetHashKey(plan_, plan_->RightJoinKeyExpressions(), tuple);
-    InsertMap(key, tuple);
+  while (left_executor_->Next(&tuple, &rid)) {
+    probe[JoinHashTable::SpillPartitionOf(JoinHashTable::HashKeys(JoinKey(exprs, tuple, schema)), 0)]->Append(tuple);
   }
-  left_executor_->Init();
+  RecordSpill(probe, 0, false);
+  for (size_t i = 0; i < probe.size(); i++) {
+    // 没有探测行的分区不用做；内连接时建表侧为空的分区也不用做
+    if (probe[i]->Rows() > 0 && ((*spilled_)[i]->Rows() > 0 || plan_->GetJoinType() == JoinType::LEFT)) {
+      spill_tasks_.push_back({(*spilled_)[i].get(), probe[i].get(), 0});
+    }
+    spill_files_.push_back(std::move(probe[i]));
+  }
+  probe_partitioned_ = true;
+}
+
+auto HashJoinExecutor::LoadSpillPartition() -> bool {
+  probe_reader_.reset();
+  const auto &exprs = plan_->RightJoinKeyExpressions();
+  const auto &schema = right_executor_->GetOutputSchema();
+  while (!spill_tasks_.empty()) {
+    auto task = spill_tasks_.back();
+    spill_tasks_.pop_back();
+    spill_table_.Clear();
+    bool fits = true;
+    {
+      SpillFile::Reader reader(task.build_);
+      Tuple tuple;
+      while (reader.Next(&tuple)) {
+        spill_table_.Insert(JoinKey(exprs, tuple, schema), std::move(tuple));
+        // 到了最深一层还装不下，多半是同一个键的倾斜，只能硬装
+        if (spill_table_.MemoryUsage() > exec_ctx_->GetMemoryBudget() && task.level_ + 1 < MAX_SPILL_DEPTH) {
+          fits = false;
+          break;
+        }
+      }
+    }
+    if (!fits) {
+      spill_table_.Clear();
+      Repartition(task);
+      continue;
+    }
+    spill_table_.Build(exec_ctx_->GetTaskScheduler());
+    ht_ = &spill_table_;
+    probe_reader_ = std::make_unique<SpillFile::Reader>(task.probe_);
+    return true;
+  }
+  return false;
+}
+
+void HashJoinExecutor::Repartition(const SpillTask &task) {
+  std::vector<std::unique_ptr<SpillFile>> build;
+  std::vector<std::unique_ptr<SpillFile>> probe;
+  MakeSpillFiles(&build);
+  MakeSpillFiles(&probe);
+  auto split = [level = task.level_ + 1](const SpillFile *from, std::vector<std::unique_ptr<SpillFile>> *to,
+                                         const std::vector<AbstractExpressionRef> &exprs, const Schema &schema) {
+    SpillFile::Reader reader(from);
+    Tuple tuple;
+    while (reader.Next(&tuple)) {
+      (*to)[JoinHashTable::SpillPartitionOf(JoinHashTable::HashKeys(JoinKey(exprs, tuple, schema)), level)]->Append(
+          tuple);
+    }
+  };
+  split(task.build_, &build, plan_->RightJoinKeyExpressions(), right_executor_->GetOutputSchema());
+  split(task.probe_, &probe, plan_->LeftJoinKeyExpressions(), left_executor_->GetOutputSchema());
+  RecordSpill(build, task.level_ + 1, true);
+  RecordSpill(probe, task.level_ + 1, false);
+  for (size_t i = 0; i < build.size(); i++) {
+    if (probe[i]->Rows() > 0 && (build[i]->Rows() > 0 || plan_->GetJoinType() == JoinType::LEFT)) {
+      spill_tasks_.push_back({build[i].get(), probe[i].get(), task.level_ + 1});
+    }
+    spill_files_.push_back(std::move(build[i]));
+    spill_files_.push_back(std::move(probe[i]));
+  }
+}
+
+void HashJoinExecutor::MakeSpillFiles(std::vector<std::unique_ptr<SpillFile>> *files) {
+  files->clear();
+  for (size_t i = 0; i < (size_t{1} << SPILL_PARTITION_BITS); i++) {
+    files->push_back(std::make_unique<SpillFile>(exec_ctx_->GetBufferPoolManager()));
+  }
+}
+
+void HashJoinExecutor::RecordSpill(const std::vector<std::unique_ptr<SpillFile>> &files, size_t level,
+                                   bool build_side) {
+  auto *stats = exec_ctx_->GetOperatorStats(plan_);
+  for (const auto &file : files) {
+    file->Finish();
+    stats->spilled_bytes_ += file->Bytes();
+    stats->spilled_rows_ += file->Rows();
+  }
+  if (build_side) {
+    stats->spill_partitions_ += files.size();
+  }
+  stats->RecordSpillDepth(level + 1);
+}
+
+auto HashJoinExecutor::JoinKey(const std::vector<AbstractExpressionRef> &exprs, const Tuple &tuple,
+                               const Schema &schema) -> std::vector<Value> {
+  std::vector<Value> key;
+  key.reserve(exprs.size());
+  for (const auto &expr : exprs) {
+    key.emplace_back(expr->Evaluate(&tuple, schema));
+  }
+  return key;
 }
 
 auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  auto &left_table_schema = plan_->GetLeftPlan()->OutputSchema();
-  auto &right_table_schema = plan_->GetRightPlan()->OutputSchema();
-  Tuple right;
-  RID ridd;
+  const auto &left_table_schema = plan_->GetLeftPlan()->OutputSchema();
+  const auto &right_table_schema = plan_->GetRightPlan()->OutputSchema();
   while (true) {
-    if (tmp_.has_value() && cur_size_ < static_cast<int>(tmp_.value().size())) {
-      right = tmp_.value()[cur_size_];
-      cur_size_++;
-      OutputTuple(left_table_schema, right_table_schema, &left_, &right, tuple, true);
-      return true;
-    }
-    if (plan_->GetJoinType() == JoinType::LEFT && cur_size_ == 0 && flag_) {
-      OutputTuple(left_table_schema, right_table_schema, &left_, &right, tuple, false);
-      flag_ = false;
-      return true;
-    }
-    cur_size_ = 0;
-    auto res = left_executor_->Next(&left_, &ridd);
-    if (!res) {
+    if (has_left_) {
+      // 匹配行直接从表里读，不拷贝整个桶
+      if (const auto *right = matches_.Next(); right != nullptr) {
+        left_matched_ = true;
+        OutputTuple(left_table_schema, right_table_schema, &left_, right, tuple, true);
+        return true;
+      }
+      has_left_ = false;
+      if (plan_->GetJoinType() == JoinType::LEFT && !left_matched_) {
+        OutputTuple(left_table_schema, right_table_schema, &left_, nullptr, tuple, false);
+        return true;
+      }
+    }
+    if (!NextLeft(&left_)) {
       return false;
     }
-    auto key = GetHashKey(plan_, plan_->LeftJoinKeyExpressions(), left_);
-    tmp_ = FindHash(key);
-    flag_ = true;
+    left_key_ = JoinKey(plan_->LeftJoinKeyExpressions(), left_, left_table_schema);
+    matches_ = ht_->Find(left_key_);
+    has_left_ = true;
+    left_matched_ = false;
   }
 }
+
+auto HashJoinExecutor::NextBatch(TupleBatch *batch) -> bool {
+  const auto &right_table_schema = plan_->GetRightPlan()->OutputSchema();
+  const auto &left_exprs = plan_->LeftJoinKeyExpressions();
+  batch->Reset();
+  if (!spilled_->empty()) {
+    // 溢出以后按分区逐个探测，一行一行地装进批里
+    Tuple tuple;
+    RID rid;
+    while (!batch->IsFull() && Next(&tuple, &rid)) {
+      batch->AppendTuple(tuple, rid);
+    }
+    return batch->Size() > 0;
+  }
+  while (!batch->IsFull()) {
+    if (left_pos_ >= left_batch_->Size()) {
+      if (!left_executor_->NextBatch(left_batch_.get())) {
+        break;
+      }
+      for (size_t k = 0; k < left_exprs.size(); k++) {
+        left_exprs[k]->EvaluateBatch(*left_batch_, &left_keys_[k]);
+      }
+      left_pos_ = 0;
+      probed_ = false;
+      continue;
+    }
+    if (!probed_) {
+      left_key_.clear();
+      for (auto &column : left_keys_) {
+        left_key_.emplace_back(column[left_pos_]);
+      }
+      matches_ = ht_->Find(left_key_);
+      pending_ = matches_.Next();
+      left_matched_ = false;
+      probed_ = true;
+    }
+
+    auto row = left_batch_->SelectedRow(left_pos_);
+    if (pending_ == nullptr && !left_matched_) {
+      if (plan_->GetJoinType() == JoinType::LEFT) {
+        auto values = left_batch_->GetRow(row);
+        for (uint32_t i = 0; i < right_table_schema.GetColumnCount(); ++i) {
+          values.emplace_back(ValueFactory::GetNullValueByType(right_table_schema.GetColumn(i).GetType()));
+        }
+        batch->Append(std::move(values));
+      }
+    } else {
+      // 批满了就停在这一行，下次从 pending_ 接着输出
+      while (pending_ != nullptr && !batch->IsFull()) {
+        auto values = left_batch_->GetRow(row);
+        for (uint32_t i = 0; i < right_table_schema.GetColumnCount(); ++i) {
+          values.emplace_back(pending_->GetValue(&right_table_schema, i));
+        }
+        batch->Append(std::move(values));
+        left_matched_ = true;
+        pending_ = matches_.Next();
+      }
+      if (pending_ != nullptr) {
+        break;
+      }
+    }
+    left_pos_++;
+    probed_ = false;
+  }
+  return batch->Size() > 0;
+}
+
 void HashJoinExecutor::OutputTuple(const Schema &left_table_schema, const Schema &right_table_schema,
-                                   Tuple *left_tuple_, Tuple *right_tuple_, Tuple *tuple, bool matched) {
+                                   const Tuple *left_tuple, const Tuple *right_tuple, Tuple *tuple, bool matched) {
   std::vector<Value> new_tuple_values;
   for (uint32_t i = 0; i < left_table_schema.GetColumnCount(); ++i) {
-    new_tuple_values.emplace_back(left_tuple_->GetValue(&left_table_schema, i));
+    new_tuple_values.emplace_back(left_tuple->GetValue(&left_table_schema, i));
   }
 
   if (!matched) {
@@ -83,7 +379,7 @@ void HashJoinExecutor::OutputTuple(const Schema &left_table_schema, const Schema
     }
   } else {
     for (uint32_t i = 0; i < right_table_schema.GetColumnCount(); ++i) {
-      new_tuple_values.emplace_back(right_tuple_->GetValue(&right_table_schema, i));
+      new_tuple_values.emplace_back(right_tuple->GetValue(&right_table_schema, i));
     }
   }
 
@@ -10,6 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
+#include "concurrency/lock_manager.h"
+#include "type/type.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
@@ -20,26 +23,205 @@ void IndexScanExecutor::Init() {
   index_info_ = catalog->GetIndex(plan_->GetIndexOid());
   table_info_ = catalog->GetTable(index_info_->table_name_);
   auto *b_plus_tree_index = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info_->index_.get());
+  rids_.clear();
+  rid_pos_ = 0;
+  key_col_of_.clear();
+  if (plan_->index_only_) {
+    key_col_of_.assign(table_info_->schema_.GetColumnCount(), -1);
+    const auto &key_attrs = index_info_->index_->GetKeyAttrs();
+    for (size_t i = 0; i < key_attrs.size(); i++) {
+      key_col_of_[key_attrs[i]] = static_cast<int>(i);
+    }
+  }
+
+  point_lookup_ = plan_->lower_.has_value() && plan_->upper_.has_value() && plan_->lower_inclusive_ &&
+                  plan_->upper_inclusive_ && plan_->lower_->CompareEquals(*plan_->upper_) == CmpBool::CmpTrue &&
+                  index_info_->key_schema_.GetColumnCount() == 1;
+  LockTable();
+  if (point_lookup_) {
+    // 单列索引上的等值查询直接点查（可以命中 lookup cache），结果在这里一次取完
+    Tuple key({*plan_->lower_}, &index_info_->key_schema_);
+    index_info_->index_->ScanKey(key, &rids_, exec_ctx_->GetTransaction());
+    return;
+  }
+
+  if (b_plus_tree_index == nullptr) {
+    throw ExecutionException("range scans need a B+ tree index");
+  }
+  std::optional<IntegerKeyType> lower;
+  std::optional<IntegerKeyType> upper;
+  if (plan_->lower_.has_value()) {
+    lower = MakeBoundKey(*plan_->lower_, !plan_->lower_inclusive_);
+  }
+  if (plan_->upper_.has_value()) {
+    upper = MakeBoundKey(*plan_->upper_, plan_->upper_inclusive_);
+  }
+  tree_iter_ = b_plus_tree_index->ScanRange(lower, plan_->lower_inclusive_, upper, plan_->upper_inclusive_,
+                                            plan_->descending_);
+}
+
+void IndexScanExecutor::LockTable() {
+  auto *txn = exec_ctx_->GetTransaction();
+  if (exec_ctx_->IsDelete()) {
+    // update/delete 下和 seq scan 一样先拿表上的 IX 锁，后面逐行拿 X 锁
+    try {
+      exec_ctx_->GetLockManager()->LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, table_info_->oid_);
+    } catch (TransactionAbortException &e) {
+      throw ExecutionException(e.GetInfo());
+    }
+    return;
+  }
+  if (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED) {
+    return;
+  }
+  // 读的时候和 seq scan 一样拿 IS 锁，已经持有这张表上的任何锁就不再加
+  std::scoped_lock latch(exec_ctx_->GetTableLockLatch());
+  txn->LockTxn();
+  bool locked = txn->IsTableIntentionExclusiveLocked(table_info_->oid_) ||
+                txn->IsTableExclusiveLocked(table_info_->oid_) ||
+                txn->IsTableIntentionSharedLocked(table_info_->oid_) || txn->IsTableSharedLocked(table_info_->oid_) ||
+                txn->IsTableSharedIntentionExclusiveLocked(table_info_->oid_);
+  txn->UnlockTxn();
+  if (!locked) {
+    try {
+      exec_ctx_->GetLockManager()->LockTable(txn, LockManager::LockMode::INTENTION_SHARED, table_info_->oid_);
+    } catch (TransactionAbortException &e) {
+      throw ExecutionException(e.GetInfo());
+    }
+  }
+}
+
+auto IndexScanExecutor::LockRow(RID rid) -> bool {
+  auto *txn = exec_ctx_->GetTransaction();
+  if (!exec_ctx_->IsDelete() && txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED) {
+    return false;
+  }
+  txn->LockTxn();
+  bool held = txn->IsRowExclusiveLocked(table_info_->oid_, rid) ||
+              (!exec_ctx_->IsDelete() && txn->IsRowSharedLocked(table_info_->oid_, rid));
+  txn->UnlockTxn();
+  if (held) {
+    return false;
+  }
+  auto lock_mode = exec_ctx_->IsDelete() ? LockManager::LockMode::EXCLUSIVE : LockManager::LockMode::SHARED;
+  try {
+    exec_ctx_->GetLockManager()->LockRow(txn, lock_mode, table_info_->oid_, rid);
+  } catch (TransactionAbortException &e) {
+    throw ExecutionException(e.GetInfo());
+  }
+  return true;
+}
+
+void IndexScanExecutor::UnlockRow(RID rid, bool force) {
+  try {
+    exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), table_info_->oid_, rid, force);
+  } catch (TransactionAbortException &e) {
+    throw ExecutionException(e.GetInfo());
+  }
+}
+
+auto IndexScanExecutor::MakeBoundKey(const Value &value, bool pad_max) const -> IntegerKeyType {
+  const auto &key_schema = index_info_->key_schema_;
+  std::vector<Value> values{value};
+  for (uint32_t i = 1; i < key_schema.GetColumnCount(); i++) {
+    auto type = key_schema.GetColumn(i).GetType();
+    values.push_back(pad_max ? Type::GetMaxValue(type) : Type::GetMinValue(type));
+  }
+  IntegerKeyType key;
+  key.SetFromKey(Tuple(values, &key_schema), key_schema);
+  // memcmp 比较的前缀里 NULL 也有编码（比如 int 的 NULL 全是 0 字节，timestamp 的全是 0xff），
+  // 所以这些列直接填最小/最大的字节，保证边界不会把带 NULL 的 key 排除在外
+  bool normalized = key_schema.GetColumn(0).IsInlined() && IsNormalizedKeyType(key_schema.GetColumn(0).GetType());
+  for (uint32_t i = 1; normalized && i < key_schema.GetColumnCount(); i++) {
+    const auto &col = key_schema.GetColumn(i);
+    normalized = col.IsInlined() && IsNormalizedKeyType(col.GetType()) &&
+                 col.GetOffset() + col.GetFixedLength() <= sizeof(key.data_);
+    if (normalized) {
+      memset(key.data_ + col.GetOffset(), pad_max ? 0xff : 0, col.GetFixedLength());
+    }
+  }
+  return key;
+}
 
-  tree_iter_ = b_plus_tree_index->GetBeginIterator();
-  tree_end_iter_ = b_plus_tree_index->GetEndIterator();
+auto IndexScanExecutor::MakeIndexOnlyTuple() const -> Tuple {
+  const auto &schema = table_info_->schema_;
+  std::vector<Value> values;
+  values.reserve(schema.GetColumnCount());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    if (key_col_of_[i] < 0) {
+      values.push_back(ValueFactory::GetNullValueByType(schema.GetColumn(i).GetType()));
+    } else if (point_lookup_) {
+      // 点查只在单列索引上做，key 就是查询的常量
+      values.push_back(*plan_->lower_);
+    } else {
+      values.push_back(leaf_[rid_pos_ - 1].first.ToValue(&index_info_->key_schema_, key_col_of_[i]));
+    }
+  }
+  return {values, &schema};
 }
 
 auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   while (true) {
-    if (tree_iter_ == tree_end_iter_) {
-      return false;
+    if (rid_pos_ == rids_.size()) {
+      if (point_lookup_) {
+        return false;
+      }
+      // 一次取完一整个叶子，叶子内的条目不再逐个访问缓冲池
+      rids_.clear();
+      rid_pos_ = 0;
+      leaf_.clear();
+      if (tree_iter_.NextBatch(&leaf_) == 0) {
+        return false;
+      }
+      for (const auto &entry : leaf_) {
+        rids_.push_back(entry.second);
+      }
     }
 
-    *rid = (*tree_iter_).second;
-    std::pair<TupleMeta, Tuple> &&tuple_pair = table_info_->table_->GetTuple(*rid);
-    if (!tuple_pair.first.is_deleted_) {
-      *tuple = std::move(tuple_pair.second);
-      ++tree_iter_;
+    *rid = rids_[rid_pos_++];
+    bool locked_here = LockRow(*rid);
+    if (ReadRow(*rid, tuple)) {
+      // 读已提交读完即放 S 锁
+      if (locked_here && !exec_ctx_->IsDelete() &&
+          exec_ctx_->GetTransaction()->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
+        UnlockRow(*rid, false);
+      }
       return true;
     }
+    // 和 seq scan 一样，不往上送的行立刻强制解锁，不然要一直锁到提交，挡住无关的写
+    if (locked_here) {
+      UnlockRow(*rid, true);
+    }
+  }
+}
 
-    ++tree_iter_;
+auto IndexScanExecutor::ReadRow(RID rid, Tuple *tuple) -> bool {
+  if (plan_->index_only_) {
+    // 插入和更新在提交前就写了索引项，回滚时才撤掉，所以索引项不一定对应已提交的元组。
+    // RU 本来就能读到未提交的数据，不用回表；其它隔离级别已经拿了行锁，还要看一眼元组头是否已删（不读元组本身）
+    if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED &&
+        table_info_->table_->GetTupleMeta(rid).is_deleted_) {
+      return false;
+    }
+    Tuple key_tuple = MakeIndexOnlyTuple();
+    if (plan_->predicate_ != nullptr) {
+      auto value = plan_->predicate_->Evaluate(&key_tuple, table_info_->schema_);
+      if (value.IsNull() || !value.GetAs<bool>()) {
+        return false;
+      }
+    }
+    *tuple = std::move(key_tuple);
+    return true;
+  }
+  std::pair<TupleMeta, Tuple> &&tuple_pair = table_info_->table_->GetTuple(rid);
+  bool matched = !tuple_pair.first.is_deleted_;
+  if (matched && plan_->predicate_ != nullptr) {  // 范围扫描只保证第一关键字，剩下的条件在这里过滤
+    auto value = plan_->predicate_->Evaluate(&tuple_pair.second, table_info_->schema_);
+    matched = !value.IsNull() && value.GetAs<bool>();
+  }
+  if (matched) {
+    *tuple = std::move(tuple_pair.second);
   }
+  return matched;
 }
 }  // namespace bustub
@@ -41,7 +41,8 @@ void InsertExecutor::Init() {
 
   table_info_ = catalog->GetTable(table_oid);
   auto table_name = table_info_->name_;
-  index_infos_ = catalog->GetTableIndexes(table_name);
+  // 表锁之后再取索引列表，在线建的索引也要维护
+  index_infos_ = catalog->GetTableIndexes(table_name, true);
   has_out_ = false;
   child_executor_->Init();
 }
@@ -69,7 +70,11 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
       for (auto &x : index_infos_) {
         Tuple partial_tuple =
             tuple->KeyFromTuple(table_info_->schema_, *(x->index_->GetKeySchema()), x->index_->GetKeyAttrs());
-        x->index_->InsertEntry(partial_tuple, *rid, exec_ctx_->GetTransaction());
+        if (!x->InsertEntry(partial_tuple, *rid, exec_ctx_->GetTransaction())) {
+          // 事务标记为中止，ExecuteSql 看到语句失败会 Abort，按写集撤掉已经插进去的 tuple 和前面几个索引的项
+          exec_ctx_->GetTransaction()->SetState(TransactionState::ABORTED);
+          throw ExecutionException("Insert into index " + x->name_ + " failed");
+        }
 
         auto iwr = IndexWriteRecord{*rid,          table_info_->oid_, WType::INSERT,
                                     partial_tuple, x->index_oid_,     exec_ctx_->GetCatalog()};
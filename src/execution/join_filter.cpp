@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_filter.cpp
+//
+// Identification: src/execution/join_filter.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/join_filter.h"
+
+#include "common/config.h"
+#include "execution/join_hash_table.h"
+
+namespace bustub {
+
+void BloomFilter::Reset(size_t num_keys) {
+  size_t bits_per_block = WORDS_PER_BLOCK * 32;
+  size_t wanted = (num_keys * BLOOM_FILTER_BITS_PER_KEY + bits_per_block - 1) / bits_per_block;
+  size_t num_blocks = 1;
+  while (num_blocks < wanted) {
+    num_blocks <<= 1;
+  }
+  blocks_.assign(num_blocks, Block{});
+  block_mask_ = num_blocks - 1;
+}
+
+auto JoinFilter::Pass(const Tuple &tuple, const Schema &schema, size_t *eliminated) const -> bool {
+  std::vector<Value> key;
+  key.reserve(keys_->size());
+  for (const auto &expr : *keys_) {
+    key.emplace_back(expr->Evaluate(&tuple, schema));
+    // 建表侧不收 NULL 键，探测行带 NULL 键一定匹配不上
+    if (key.back().IsNull()) {
+      (*eliminated)++;
+      return false;
+    }
+  }
+  if (!bloom_.MayContain(JoinHashTable::HashKeys(key))) {
+    (*eliminated)++;
+    return false;
+  }
+  return true;
+}
+
+void JoinFilter::PassBatch(TupleBatch *batch, size_t *eliminated) const {
+  std::vector<std::vector<Value>> key_columns(keys_->size());
+  for (size_t k = 0; k < keys_->size(); k++) {
+    (*keys_)[k]->EvaluateBatch(*batch, &key_columns[k]);
+  }
+  auto &sel = batch->GetSelection();
+  std::vector<Value> key(keys_->size());
+  size_t kept = 0;
+  for (size_t i = 0; i < sel.size(); i++) {
+    bool pass = true;
+    for (size_t k = 0; k < key_columns.size() && pass; k++) {
+      key[k] = key_columns[k][i];
+      pass = !key[k].IsNull();
+    }
+    if (pass && bloom_.MayContain(JoinHashTable::HashKeys(key))) {
+      sel[kept++] = sel[i];
+    }
+  }
+  *eliminated += sel.size() - kept;
+  sel.resize(kept);
+}
+
+}  // namespace bustub
@@ -0,0 +1,172 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table.cpp
+//
+// Identification: src/execution/join_hash_table.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/join_hash_table.h"
+
+#include <limits>
+#include <utility>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "execution/task_scheduler.h"
+
+namespace bustub {
+
+namespace {
+/** At most 2^10 partitions, beyond that the scatter pass itself stops being cache friendly */
+constexpr int MAX_PARTITION_BITS = 10;
+}  // namespace
+
+auto JoinHashTable::HashKeys(const std::vector<Value> &keys) -> hash_t {
+  hash_t hash = 0;
+  for (const auto &key : keys) {
+    if (!key.IsNull()) {
+      hash = HashUtil::CombineHashes(hash, HashUtil::HashValue(&key));
+    }
+  }
+  return hash;
+}
+
+void JoinHashTable::Insert(std::vector<Value> &&keys, Tuple &&tuple) {
+  for (const auto &key : keys) {
+    if (key.IsNull()) {
+      return;
+    }
+  }
+  num_keys_ = keys.size();
+  // 行本身、键、hash，再加上建表后大约两个槽
+  bytes_ += sizeof(Tuple) + tuple.GetLength() + num_keys_ * sizeof(Value) + sizeof(hash_t) + 2 * sizeof(uint32_t);
+  hashes_.push_back(HashKeys(keys));
+  for (auto &key : keys) {
+    keys_.emplace_back(std::move(key));
+  }
+  rows_.emplace_back(std::move(tuple));
+}
+
+void JoinHashTable::Build(TaskScheduler *scheduler) {
+  BUSTUB_ASSERT(rows_.size() < std::numeric_limits<uint32_t>::max(), "too many build rows for 32-bit slots");
+  partition_bits_ = 0;
+  while (partition_bits_ < MAX_PARTITION_BITS &&
+         (rows_.size() >> partition_bits_) > static_cast<size_t>(HASH_JOIN_PARTITION_ROWS)) {
+    partition_bits_++;
+  }
+  size_t num_partitions = size_t{1} << partition_bits_;
+
+  // 按 hash 高位做一遍基数分散：先数每个分区多少行，再把行号排到各自的区间里
+  std::vector<size_t> offsets(num_partitions + 1, 0);
+  for (auto hash : hashes_) {
+    offsets[PartitionOf(hash) + 1]++;
+  }
+  for (size_t i = 0; i < num_partitions; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<uint32_t> order(rows_.size());
+  std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+  for (size_t row = 0; row < rows_.size(); row++) {
+    order[cursor[PartitionOf(hashes_[row])]++] = row;
+  }
+
+  partitions_.clear();
+  partitions_.resize(num_partitions);
+  TaskGroup tasks(num_partitions > 1 ? scheduler : nullptr);
+  for (size_t partition = 0; partition < num_partitions; partition++) {
+    tasks.Spawn([this, partition, &order, &offsets] {
+      BuildPartition(partition, order, offsets[partition], offsets[partition + 1]);
+    });
+  }
+  tasks.Wait();
+  tasks.RethrowError();
+}
+
+void JoinHashTable::BuildPartition(size_t partition, const std::vector<uint32_t> &order, size_t begin, size_t end) {
+  // 装载率不超过一半，线性探测总能碰到空槽
+  size_t capacity = 1;
+  while (capacity < (end - begin) * 2) {
+    capacity <<= 1;
+  }
+  auto &slots = partitions_[partition].slots_;
+  slots.assign(capacity, 0);
+  size_t mask = capacity - 1;
+  for (size_t i = begin; i < end; i++) {
+    auto row = order[i];
+    size_t slot = hashes_[row] & mask;
+    while (slots[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = row + 1;
+  }
+}
+
+void JoinHashTable::Clear() {
+  rows_.clear();
+  keys_.clear();
+  hashes_.clear();
+  partitions_.clear();
+  num_keys_ = 0;
+  partition_bits_ = 0;
+  bytes_ = 0;
+}
+
+auto JoinHashTable::Find(const std::vector<Value> &keys) const -> Matches {
+  if (rows_.empty() || partitions_.empty()) {
+    return {};
+  }
+  for (const auto &key : keys) {
+    if (key.IsNull()) {
+      return {};
+    }
+  }
+  auto hash = HashKeys(keys);
+  return {this, &keys, hash, PartitionOf(hash)};
+}
+
+JoinHashTable::Matches::Matches(const JoinHashTable *table, const std::vector<Value> *keys, hash_t hash,
+                                uint32_t partition)
+    : table_(table),
+      keys_(keys),
+      hash_(hash),
+      partition_(partition),
+      slot_(hash & (table->partitions_[partition].slots_.size() - 1)) {}
+
+auto JoinHashTable::Matches::Next() -> const Tuple * {
+  if (table_ == nullptr) {
+    return nullptr;
+  }
+  const auto &slots = table_->partitions_[partition_].slots_;
+  size_t mask = slots.size() - 1;
+  while (true) {
+    auto entry = slots[slot_];
+    if (entry == 0) {
+      table_ = nullptr;
+      return nullptr;
+    }
+    slot_ = (slot_ + 1) & mask;
+    auto row = entry - 1;
+    // 先比 hash，相同的才去比 Value
+    if (table_->hashes_[row] != hash_) {
+      continue;
+    }
+    const auto *row_keys = &table_->keys_[row * table_->num_keys_];
+    bool equal = true;
+    for (size_t k = 0; k < table_->num_keys_; k++) {
+      if (row_keys[k].CompareEquals((*keys_)[k]) != CmpBool::CmpTrue) {
+        equal = false;
+        break;
+      }
+    }
+    if (equal) {
+      return &table_->rows_[row];
+    }
+  }
+}
+
+}  // namespace bustub
@@ -31,4 +31,18 @@ auto LimitExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   return false;
 }
 
+auto LimitExecutor::NextBatch(TupleBatch *batch) -> bool {
+  // 够数了就不再向下拉
+  if (t_ >= plan_->GetLimit() || !child_->NextBatch(batch)) {
+    batch->Reset();
+    return false;
+  }
+  auto &sel = batch->GetSelection();
+  if (sel.size() > plan_->GetLimit() - t_) {
+    sel.resize(plan_->GetLimit() - t_);
+  }
+  t_ += sel.size();
+  return true;
+}
+
 }  // namespace bustub
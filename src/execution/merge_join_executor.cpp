@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_executor.cpp
+//
+// Identification: src/execution/merge_join_executor.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/merge_join_executor.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+MergeJoinExecutor::MergeJoinExecutor(ExecutorContext *exec_ctx, const MergeJoinPlanNode *plan,
+                                     std::unique_ptr<AbstractExecutor> &&left_child,
+                                     std::unique_ptr<AbstractExecutor> &&right_child)
+    : AbstractExecutor(exec_ctx), plan_(plan), left_child_(std::move(left_child)), right_child_(std::move(right_child)) {
+  if (!(plan->GetJoinType() == JoinType::LEFT || plan->GetJoinType() == JoinType::INNER)) {
+    throw bustub::NotImplementedException(fmt::format("join type {} not supported", plan->GetJoinType()));
+  }
+}
+
+void MergeJoinExecutor::Init() {
+  left_child_->Init();
+  right_child_->Init();
+  has_left_ = false;
+  joining_ = false;
+  group_pos_ = 0;
+  group_.clear();
+  group_keys_.clear();
+  AdvanceRight();
+}
+
+auto MergeJoinExecutor::MakeKeys(const Tuple &tuple, const Schema &schema,
+                                 const std::vector<AbstractExpressionRef> &exprs, std::vector<Value> *keys) -> bool {
+  keys->clear();
+  for (const auto &expr : exprs) {
+    keys->push_back(expr->Evaluate(&tuple, schema));
+    if (keys->back().IsNull()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto MergeJoinExecutor::CompareKeys(const std::vector<Value> &a, const std::vector<Value> &b) -> int {
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].CompareLessThan(b[i]) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (a[i].CompareGreaterThan(b[i]) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void MergeJoinExecutor::AdvanceRight() {
+  RID rid;
+  // NULL 的键和谁都不相等，直接跳过
+  while ((has_right_ = right_child_->Next(&right_, &rid))) {
+    if (MakeKeys(right_, right_child_->GetOutputSchema(), plan_->RightJoinKeyExpressions(), &right_keys_)) {
+      return;
+    }
+  }
+}
+
+auto MergeJoinExecutor::LoadGroup() -> bool {
+  group_.clear();
+  if (!has_right_) {
+    return false;
+  }
+  group_keys_ = right_keys_;
+  while (has_right_ && CompareKeys(right_keys_, group_keys_) == 0) {
+    group_.push_back(std::move(right_));
+    AdvanceRight();
+  }
+  return true;
+}
+
+auto MergeJoinExecutor::MakeOutput(const Tuple &left, const Tuple *right) const -> Tuple {
+  const auto &left_schema = left_child_->GetOutputSchema();
+  const auto &right_schema = right_child_->GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema().GetColumnCount());
+  for (uint32_t i = 0; i < left_schema.GetColumnCount(); i++) {
+    values.push_back(left.GetValue(&left_schema, i));
+  }
+  for (uint32_t i = 0; i < right_schema.GetColumnCount(); i++) {
+    values.push_back(right != nullptr ? right->GetValue(&right_schema, i)
+                                      : ValueFactory::GetNullValueByType(right_schema.GetColumn(i).GetType()));
+  }
+  return {values, &GetOutputSchema()};
+}
+
+auto MergeJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (true) {
+    if (joining_) {
+      if (group_pos_ < group_.size()) {
+        *tuple = MakeOutput(left_, &group_[group_pos_++]);
+        *rid = tuple->GetRid();
+        return true;
+      }
+      // 下一个左侧行的键可能还是这一组，组留着不动
+      joining_ = false;
+      has_left_ = false;
+    }
+
+    if (!has_left_) {
+      RID left_rid;
+      if (!left_child_->Next(&left_, &left_rid)) {
+        return false;
+      }
+      has_left_ = true;
+    }
+
+    if (MakeKeys(left_, left_child_->GetOutputSchema(), plan_->LeftJoinKeyExpressions(), &left_keys_)) {
+      // 右侧往前走到第一个键不小于左侧键的组
+      while (group_.empty() || CompareKeys(group_keys_, left_keys_) < 0) {
+        if (!LoadGroup()) {
+          break;
+        }
+      }
+      if (!group_.empty() && CompareKeys(group_keys_, left_keys_) == 0) {
+        joining_ = true;
+        group_pos_ = 0;
+        continue;
+      }
+    }
+
+    has_left_ = false;
+    if (plan_->GetJoinType() == JoinType::LEFT) {
+      *tuple = MakeOutput(left_, nullptr);
+      *rid = tuple->GetRid();
+      return true;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -412,9 +412,21 @@ MockScanExecutor::MockScanExecutor(ExecutorContext *exec_ctx, const MockScanPlan
 void MockScanExecutor::Init() {
   // Reset the cursor
   cursor_ = 0;
+  shared_cursor_ = exec_ctx_->GetSharedState<RowMorselCursor>(plan_);
+  morsel_end_ = 0;
 }
 
 auto MockScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (shared_cursor_ != nullptr) {
+    // 各副本的打乱顺序不同，按行号分 morsel 时不打乱
+    if (cursor_ == morsel_end_ && !shared_cursor_->Next(&cursor_, &morsel_end_)) {
+      return EXECUTOR_EXHAUSTED;
+    }
+    *tuple = func_(cursor_);
+    ++cursor_;
+    *rid = MakeDummyRID();
+    return EXECUTOR_ACTIVE;
+  }
   if (cursor_ == size_) {
     // Scan complete
     return EXECUTOR_EXHAUSTED;
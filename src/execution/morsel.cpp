@@ -0,0 +1,50 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// morsel.cpp
+//
+// Identification: src/execution/morsel.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/morsel.h"
+
+#include "storage/page/table_page.h"
+
+namespace bustub {
+
+TableMorselCursor::TableMorselCursor(BufferPoolManager *bpm, TableHeap *table)
+    : bpm_(bpm), next_page_id_(table->GetFirstPageId()), stop_page_id_(table->GetLastPageId()) {
+  // 只扫开始时已有的元组，和 TableHeap::MakeIterator 一样，免得扫到本查询自己插入的行
+  auto guard = bpm_->FetchPageRead(stop_page_id_);
+  stop_slot_ = guard.As<TablePage>()->GetNumTuples();
+}
+
+auto TableMorselCursor::Next(std::vector<page_id_t> *pages) -> bool {
+  std::scoped_lock lock(latch_);
+  pages->clear();
+  while (next_page_id_ != INVALID_PAGE_ID && pages->size() < static_cast<size_t>(SCAN_MORSEL_PAGES)) {
+    auto page_id = next_page_id_;
+    pages->push_back(page_id);
+    if (page_id == stop_page_id_) {
+      next_page_id_ = INVALID_PAGE_ID;
+      break;
+    }
+    auto guard = bpm_->FetchPageRead(page_id);
+    next_page_id_ = guard.As<TablePage>()->GetNextPageId();
+  }
+  return !pages->empty();
+}
+
+auto TableMorselCursor::NumSlots(page_id_t page_id) -> uint32_t {
+  if (page_id == stop_page_id_) {
+    return stop_slot_;
+  }
+  auto guard = bpm_->FetchPageRead(page_id);
+  return guard.As<TablePage>()->GetNumTuples();
+}
+
+}  // namespace bustub
@@ -11,20 +11,165 @@
 //===----------------------------------------------------------------------===//
 
 #include "execution/executors/nested_index_join_executor.h"
+#include "concurrency/lock_manager.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
 NestIndexJoinExecutor::NestIndexJoinExecutor(ExecutorContext *exec_ctx, const NestedIndexJoinPlanNode *plan,
                                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {
   if (!(plan->GetJoinType() == JoinType::LEFT || plan->GetJoinType() == JoinType::INNER)) {
     // Note for 2023 Spring: You ONLY need to implement left join and inner join.
     throw bustub::NotImplementedException(fmt::format("join type {} not supported", plan->GetJoinType()));
   }
 }
 
-void NestIndexJoinExecutor::Init() { throw NotImplementedException("NestIndexJoinExecutor is not implemented"); }
+void NestIndexJoinExecutor::Init() {
+  child_executor_->Init();
+  auto *catalog = exec_ctx_->GetCatalog();
+  index_info_ = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(plan_->GetInnerTableOid());
+  LockInnerTable();
+  outer_.clear();
+  matches_.clear();
+  outer_pos_ = 0;
+  match_pos_ = 0;
+  matched_ = false;
+}
+
+void NestIndexJoinExecutor::LockInnerTable() {
+  auto *txn = exec_ctx_->GetTransaction();
+  if (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED) {
+    return;
+  }
+  // 内表原来由 seq scan 读，这里照它的规矩拿 IS 锁，已经持有这张表上的任何锁就不再加
+  std::scoped_lock latch(exec_ctx_->GetTableLockLatch());
+  txn->LockTxn();
+  bool locked = txn->IsTableIntentionExclusiveLocked(table_info_->oid_) ||
+                txn->IsTableExclusiveLocked(table_info_->oid_) ||
+                txn->IsTableIntentionSharedLocked(table_info_->oid_) || txn->IsTableSharedLocked(table_info_->oid_) ||
+                txn->IsTableSharedIntentionExclusiveLocked(table_info_->oid_);
+  txn->UnlockTxn();
+  if (!locked) {
+    try {
+      exec_ctx_->GetLockManager()->LockTable(txn, LockManager::LockMode::INTENTION_SHARED, table_info_->oid_);
+    } catch (TransactionAbortException &e) {
+      throw ExecutionException(e.GetInfo());
+    }
+  }
+}
+
+auto NestIndexJoinExecutor::ReadInner(RID rid, Tuple *inner) -> bool {
+  auto *txn = exec_ctx_->GetTransaction();
+  auto isolation_level = txn->GetIsolationLevel();
+  bool locked_here = false;
+  if (isolation_level != IsolationLevel::READ_UNCOMMITTED) {
+    txn->LockTxn();
+    bool held = txn->IsRowExclusiveLocked(table_info_->oid_, rid) || txn->IsRowSharedLocked(table_info_->oid_, rid);
+    txn->UnlockTxn();
+    if (!held) {
+      try {
+        exec_ctx_->GetLockManager()->LockRow(txn, LockManager::LockMode::SHARED, table_info_->oid_, rid);
+      } catch (TransactionAbortException &e) {
+        throw ExecutionException(e.GetInfo());
+      }
+      locked_here = true;
+    }
+  }
+  auto [meta, tuple] = table_info_->table_->GetTuple(rid);
+  // 已删除的行强制解锁，读已提交读完即解锁，和 seq scan 一样
+  if (locked_here && (meta.is_deleted_ || isolation_level == IsolationLevel::READ_COMMITTED)) {
+    try {
+      exec_ctx_->GetLockManager()->UnlockRow(txn, table_info_->oid_, rid, meta.is_deleted_);
+    } catch (TransactionAbortException &e) {
+      throw ExecutionException(e.GetInfo());
+    }
+  }
+  if (meta.is_deleted_) {
+    return false;
+  }
+  *inner = std::move(tuple);
+  return true;
+}
 
-auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+auto NestIndexJoinExecutor::ProbeBatch() -> bool {
+  outer_.clear();
+  matches_.clear();
+  outer_pos_ = 0;
+  match_pos_ = 0;
+  matched_ = false;
+  Tuple tuple;
+  RID rid;
+  while (outer_.size() < static_cast<size_t>(BUSTUB_BATCH_SIZE) && child_executor_->Next(&tuple, &rid)) {
+    outer_.emplace_back(std::move(tuple));
+  }
+  if (outer_.empty()) {
+    return false;
+  }
+
+  // NULL 的键不和任何行相等，不去查索引
+  const auto &key_schema = index_info_->key_schema_;
+  std::vector<Tuple> keys;
+  std::vector<size_t> probed;
+  for (size_t i = 0; i < outer_.size(); i++) {
+    auto key = plan_->KeyPredicate()->Evaluate(&outer_[i], child_executor_->GetOutputSchema());
+    if (!key.IsNull()) {
+      keys.emplace_back(std::vector<Value>{key}, &key_schema);
+      probed.push_back(i);
+    }
+  }
+  std::vector<std::vector<RID>> found;
+  index_info_->index_->ScanKeys(keys, &found, exec_ctx_->GetTransaction());
+  matches_.resize(outer_.size());
+  for (size_t i = 0; i < probed.size(); i++) {
+    matches_[probed[i]] = std::move(found[i]);
+  }
+  return true;
+}
+
+auto NestIndexJoinExecutor::MakeOutput(const Tuple &outer, const Tuple *inner) const -> Tuple {
+  const auto &outer_schema = child_executor_->GetOutputSchema();
+  const auto &inner_schema = plan_->InnerTableSchema();
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema().GetColumnCount());
+  for (uint32_t i = 0; i < outer_schema.GetColumnCount(); i++) {
+    values.push_back(outer.GetValue(&outer_schema, i));
+  }
+  for (uint32_t i = 0; i < inner_schema.GetColumnCount(); i++) {
+    values.push_back(inner != nullptr ? inner->GetValue(&inner_schema, i)
+                                      : ValueFactory::GetNullValueByType(inner_schema.GetColumn(i).GetType()));
+  }
+  return {values, &GetOutputSchema()};
+}
+
+auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (true) {
+    if (outer_pos_ == outer_.size() && !ProbeBatch()) {
+      return false;
+    }
+    const auto &outer = outer_[outer_pos_];
+    auto &matches = matches_[outer_pos_];
+    while (match_pos_ < matches.size()) {
+      Tuple inner;
+      if (!ReadInner(matches[match_pos_++], &inner)) {
+        continue;
+      }
+      matched_ = true;
+      *tuple = MakeOutput(outer, &inner);
+      *rid = tuple->GetRid();
+      return true;
+    }
+    bool emit_null = !matched_ && plan_->GetJoinType() == JoinType::LEFT;
+    outer_pos_++;
+    match_pos_ = 0;
+    matched_ = false;
+    if (emit_null) {
+      *tuple = MakeOutput(outer, nullptr);
+      *rid = tuple->GetRid();
+      return true;
+    }
+  }
+}
 
 }  // namespace bustub
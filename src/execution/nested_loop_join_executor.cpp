@@ -37,7 +37,14 @@ void NestedLoopJoinExecutor::Init() {
   right_tuple_ = new Tuple();
 
   RID rid;
-  left_executor_->Next(left_tuple_, &rid);
+  // 左表为空（比如并行流水线里分不到 morsel 的副本）时直接结束
+  if (!left_executor_->Next(left_tuple_, &rid)) {
+    delete left_tuple_;
+    left_tuple_ = nullptr;
+
+    delete right_tuple_;
+    right_tuple_ = nullptr;
+  }
   joined_ = false;
 }
 
@@ -45,6 +52,9 @@ auto NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   auto &predicate = plan_->Predicate();
   auto &left_table_schema = plan_->GetLeftPlan()->OutputSchema();  // smaller table
   auto &right_table_schema = plan_->GetRightPlan()->OutputSchema();
+  if (left_tuple_ == nullptr) {
+    return false;
+  }
   while (true) {
     while (right_executor_->Next(right_tuple_, rid)) {
       Value check_equal = predicate->EvaluateJoin(left_tuple_, left_table_schema, right_tuple_, right_table_schema);
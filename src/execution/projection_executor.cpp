@@ -10,6 +10,9 @@ ProjectionExecutor::ProjectionExecutor(ExecutorContext *exec_ctx, const Projecti
 void ProjectionExecutor::Init() {
   // Initialize the child executor
   child_executor_->Init();
+  if (child_batch_ == nullptr) {
+    child_batch_ = std::make_unique<TupleBatch>(&child_executor_->GetOutputSchema());
+  }
 }
 
 auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
@@ -33,4 +36,25 @@ auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
 
   return true;
 }
+
+auto ProjectionExecutor::NextBatch(TupleBatch *batch) -> bool {
+  batch->Reset();
+  if (!child_executor_->NextBatch(child_batch_.get())) {
+    return false;
+  }
+
+  // 一个表达式算完一整列，输出批次里的行按选择顺序紧凑排列
+  const auto &exprs = plan_->GetExpressions();
+  std::vector<std::vector<Value>> columns(exprs.size());
+  for (size_t i = 0; i < exprs.size(); i++) {
+    exprs[i]->EvaluateBatch(*child_batch_, &columns[i]);
+  }
+  std::vector<RID> rids;
+  rids.reserve(child_batch_->Size());
+  for (size_t i = 0; i < child_batch_->Size(); i++) {
+    rids.push_back(child_batch_->GetRid(child_batch_->SelectedRow(i)));
+  }
+  batch->SetColumns(std::move(columns), std::move(rids));
+  return true;
+}
 }  // namespace bustub
@@ -0,0 +1,48 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// repartition_executor.cpp
+//
+// Identification: src/execution/repartition_executor.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/repartition_executor.h"
+
+namespace bustub {
+
+RepartitionExecutor::RepartitionExecutor(ExecutorContext *exec_ctx, const RepartitionPlanNode *plan,
+                                         std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void RepartitionExecutor::Init() {
+  exchange_ = exec_ctx_->GetSharedState<PartitionedExchange>(plan_);
+  tuples_.clear();
+  pos_ = 0;
+  if (exchange_ == nullptr) {
+    BUSTUB_ASSERT(child_executor_ != nullptr, "a repartition without an exchange needs its child");
+    child_executor_->Init();
+  }
+}
+
+auto RepartitionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (exchange_ == nullptr) {
+    return child_executor_->Next(tuple, rid);
+  }
+  // 一次认领一整个分区，同一个 key 的行只会落到一个副本里
+  while (pos_ >= tuples_.size()) {
+    tuples_.clear();
+    pos_ = 0;
+    if (!exchange_->NextPartition(&tuples_)) {
+      return false;
+    }
+  }
+  *tuple = std::move(tuples_[pos_++]);
+  *rid = tuple->GetRid();
+  return true;
+}
+
+}  // namespace bustub
@@ -11,9 +11,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "execution/executors/seq_scan_executor.h"
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "catalog/schema.h"
 #include "concurrency/lock_manager.h"
+#include "execution/join_filter.h"
+#include "storage/page/table_page.h"
 
 namespace bustub {
 
@@ -29,86 +33,378 @@ void SeqScanExecutor::Init() {
     case IsolationLevel::REPEATABLE_READ:
     case IsolationLevel::READ_COMMITTED: {
       // 事务禁止降锁，但LockTable处throw是针对于异常情况的，这里防止即可不必throw，都达到禁止降锁目的、不冲突
-      if (!(exec_ctx_->GetTransaction()->IsTableIntentionExclusiveLocked(tbl_info_->oid_) ||
-            exec_ctx_->GetTransaction()->IsTableExclusiveLocked(tbl_info_->oid_) ||
-            exec_ctx_->GetTransaction()->IsTableIntentionExclusiveLocked(tbl_info_->oid_) ||
-            exec_ctx_->GetTransaction()->IsTableSharedLocked(tbl_info_->oid_))) {
-        exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(), lock_mode, tbl_info_->oid_);
+      // 并行流水线的各个副本共用一个事务，查锁和加锁要连着做
+      std::scoped_lock latch(exec_ctx_->GetTableLockLatch());
+      auto *txn = exec_ctx_->GetTransaction();
+      txn->LockTxn();
+      bool locked = txn->IsTableIntentionExclusiveLocked(tbl_info_->oid_) ||
+                    txn->IsTableExclusiveLocked(tbl_info_->oid_) ||
+                    txn->IsTableIntentionSharedLocked(tbl_info_->oid_) || txn->IsTableSharedLocked(tbl_info_->oid_);
+      txn->UnlockTxn();
+      if (!locked) {
+        exec_ctx_->GetLockManager()->LockTable(txn, lock_mode, tbl_info_->oid_);
       }
     } break;
     case IsolationLevel::READ_UNCOMMITTED:
       break;
   }
+  StopWorkers();
+  RecordEliminated();
+  shared_cursor_ = exec_ctx_->GetSharedState<TableMorselCursor>(plan_);
+  if (shared_cursor_ != nullptr) {
+    morsel_pages_.clear();
+    morsel_page_idx_ = 0;
+    morsel_slot_ = 0;
+    morsel_num_slots_ = 0;
+    return;
+  }
+  // delete/update 的扫描要和上层的删除交替进行，始终单线程
+  auto scan_parallelism = exec_ctx_->GetScanParallelism();
+  if (scan_parallelism > 1 && !exec_ctx_->IsDelete()) {
+    StartWorkers(scan_parallelism);
+    return;
+  }
   tbl_it_ = std::make_unique<TableIterator>(tbl_info_->table_->MakeEagerIterator());
+  batch_rid_ = tbl_it_->GetRID();
+}
+
+SeqScanExecutor::~SeqScanExecutor() {
+  StopWorkers();
+  RecordEliminated();
+}
+
+auto SeqScanExecutor::PushDownJoinFilter(const JoinFilter *filter) -> bool {
+  join_filter_ = filter;
+  join_filter_stats_ = filter->stats_;
+  return true;
+}
+
+void SeqScanExecutor::RecordEliminated() {
+  if (eliminated_ > 0) {
+    join_filter_stats_->bloom_filtered_rows_ += eliminated_;
+    eliminated_ = 0;
+  }
 }
 
 auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (shared_cursor_ != nullptr) {
+    return MorselNext(tuple, rid);
+  }
+  if (exchange_ == nullptr) {
+    return ScanNext(tuple, rid);
+  }
+  while (chunk_pos_ >= chunk_.size()) {
+    chunk_.clear();
+    chunk_pos_ = 0;
+    if (!exchange_->Pop(&chunk_)) {
+      return false;
+    }
+  }
+  auto &[next_tuple, next_rid] = chunk_[chunk_pos_++];
+  *tuple = std::move(next_tuple);
+  *rid = next_rid;
+  return true;
+}
+
+auto SeqScanExecutor::NextBatch(TupleBatch *batch) -> bool {
+  // 并行扫描的行已经在 worker 里物化成 Tuple，delete/update 要逐行加 X 锁，这两种仍走逐行路径
+  if (exchange_ != nullptr || exec_ctx_->IsDelete()) {
+    batch->Reset();
+    Tuple tuple{};
+    RID rid{};
+    while (!batch->IsFull() && SeqScanExecutor::Next(&tuple, &rid)) {
+      batch->AppendTuple(tuple, rid);
+    }
+    return batch->Size() > 0;
+  }
+  auto *bpm = exec_ctx_->GetBufferPoolManager();
+  while (true) {
+    batch->Reset();
+    bool end = false;
+    while (!batch->IsFull() && !end) {
+      auto room = static_cast<uint32_t>(batch->Capacity() - batch->NumRows());
+      if (shared_cursor_ != nullptr) {
+        if (morsel_slot_ < morsel_num_slots_) {
+          uint32_t stop = std::min(morsel_num_slots_, morsel_slot_ + room);
+          AppendPageRun(morsel_pages_[morsel_page_idx_], morsel_slot_, stop, batch);
+          morsel_slot_ = stop;
+        } else {
+          end = !NextMorselPage();
+        }
+        continue;
+      }
+      if (batch_rid_.GetPageId() == INVALID_PAGE_ID) {
+        end = true;
+        continue;
+      }
+      // 和 eager 迭代器一样，每次都重新看页上的行数，扫描途中追加到页尾的行也能读到
+      uint32_t num_tuples;
+      page_id_t next_page_id;
+      {
+        auto guard = bpm->FetchPageRead(batch_rid_.GetPageId());
+        num_tuples = guard.As<TablePage>()->GetNumTuples();
+        next_page_id = guard.As<TablePage>()->GetNextPageId();
+      }
+      uint32_t slot = batch_rid_.GetSlotNum();
+      if (slot < num_tuples) {
+        uint32_t stop = std::min(num_tuples, slot + room);
+        AppendPageRun(batch_rid_.GetPageId(), slot, stop, batch);
+        batch_rid_ = RID{batch_rid_.GetPageId(), stop};
+      } else {
+        batch_rid_ = RID{next_page_id, 0};
+      }
+    }
+    SelectBatch(batch);
+    if (batch->Size() > 0) {
+      return true;
+    }
+    if (end) {
+      RecordEliminated();
+      return false;
+    }
+  }
+}
+
+void SeqScanExecutor::AppendPageRun(page_id_t page_id, uint32_t begin, uint32_t end, TupleBatch *batch) {
+  for (uint32_t slot = begin; slot < end; slot++) {
+    LockRowForRead(RID{page_id, slot});
+  }
+  // 整段只取一次页，行直接从页上拆进列里，不再经过 GetTuple 拷出的 Tuple
+  std::vector<RID> deleted;
+  {
+    auto guard = exec_ctx_->GetBufferPoolManager()->FetchPageRead(page_id);
+    const auto *page = guard.As<TablePage>();
+    for (uint32_t slot = begin; slot < end; slot++) {
+      RID rid{page_id, slot};
+      auto [meta, data] = page->GetTupleData(rid);
+      if (meta.is_deleted_) {
+        deleted.push_back(rid);
+      } else {
+        batch->AppendTuple(data, rid);
+      }
+    }
+  }
+  if (exec_ctx_->GetTransaction()->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
+    for (const auto &rid : deleted) {
+      exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), tbl_info_->oid_, rid, true);
+    }
+  }
+}
+
+void SeqScanExecutor::SelectBatch(TupleBatch *batch) {
+  auto &sel = batch->GetSelection();
+  if (plan_->filter_predicate_ != nullptr && !sel.empty()) {
+    std::vector<Value> values;
+    plan_->filter_predicate_->EvaluateBatch(*batch, &values);
+    size_t kept = 0;
+    for (size_t i = 0; i < sel.size(); i++) {
+      if (!values[i].IsNull() && values[i].GetAs<bool>()) {
+        sel[kept++] = sel[i];
+      }
+    }
+    sel.resize(kept);
+  }
+  if (join_filter_ != nullptr && !sel.empty()) {
+    join_filter_->PassBatch(batch, &eliminated_);
+  }
+  auto isolation_level = exec_ctx_->GetTransaction()->GetIsolationLevel();
+  if (isolation_level == IsolationLevel::READ_UNCOMMITTED) {
+    return;
+  }
+  // 被谓词或过滤器筛掉的行强制解锁，留下的行在读已提交下读完即解锁；选择向量保持行序
+  auto *txn = exec_ctx_->GetTransaction();
+  size_t next = 0;
+  for (uint32_t row = 0; row < batch->NumRows(); row++) {
+    bool selected = next < sel.size() && sel[next] == row;
+    if (selected) {
+      next++;
+      if (isolation_level == IsolationLevel::READ_COMMITTED) {
+        exec_ctx_->GetLockManager()->UnlockRow(txn, tbl_info_->oid_, batch->GetRid(row), false);
+      }
+      continue;
+    }
+    try {
+      exec_ctx_->GetLockManager()->UnlockRow(txn, tbl_info_->oid_, batch->GetRid(row), true);
+    } catch (TransactionAbortException &e) {
+      throw ExecutionException(e.GetInfo());
+    }
+  }
+}
+
+auto SeqScanExecutor::ScanNext(Tuple *tuple, RID *rid) -> bool {
   /** Get the current position of the table iterator. */
   while (!tbl_it_->IsEnd()) {
     *rid = tbl_it_->GetRID();
-    /** Lock the tuple as needed for the isolation level. */
-    LockManager::LockMode lock_mode = LockManager::LockMode::SHARED;
-    switch (exec_ctx_->GetTransaction()->GetIsolationLevel()) {
-      case IsolationLevel::REPEATABLE_READ:
-      case IsolationLevel::READ_COMMITTED: {
-        if (!exec_ctx_->GetTransaction()->IsRowExclusiveLocked(tbl_info_->oid_, *rid)) {
-          exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), lock_mode, tbl_info_->oid_, *rid);
-        }
-      } break;
-      case IsolationLevel::READ_UNCOMMITTED:
-        break;
-    }
-    /** If the current operation is delete, should take X locks on the table and tuple
-     *  which will be set to true for DELETE and UPDATE), you should assume all tuples scanned will be deleted */
-    if (exec_ctx_->IsDelete()) {
-      lock_mode = LockManager::LockMode::EXCLUSIVE;
+    bool visible = ReadRow(*rid, tuple, &eliminated_);
+    ++(*tbl_it_);
+    if (visible) {
+      return true;
+    }
+  }
+  RecordEliminated();
+  return false;
+}
+
+auto SeqScanExecutor::MorselNext(Tuple *tuple, RID *rid) -> bool {
+  while (true) {
+    if (morsel_slot_ < morsel_num_slots_) {
+      RID next_rid{morsel_pages_[morsel_page_idx_], morsel_slot_++};
+      if (ReadRow(next_rid, tuple, &eliminated_)) {
+        *rid = next_rid;
+        return true;
+      }
+      continue;
+    }
+    if (!NextMorselPage()) {
+      RecordEliminated();
+      return false;
+    }
+  }
+}
+
+auto SeqScanExecutor::NextMorselPage() -> bool {
+  if (morsel_page_idx_ + 1 < morsel_pages_.size()) {
+    morsel_page_idx_++;
+  } else if (shared_cursor_->Next(&morsel_pages_)) {
+    morsel_page_idx_ = 0;
+  } else {
+    return false;
+  }
+  morsel_slot_ = 0;
+  morsel_num_slots_ = shared_cursor_->NumSlots(morsel_pages_[morsel_page_idx_]);
+  return true;
+}
+
+void SeqScanExecutor::LockRowForRead(RID rid) {
+  switch (exec_ctx_->GetTransaction()->GetIsolationLevel()) {
+    case IsolationLevel::REPEATABLE_READ:
+    case IsolationLevel::READ_COMMITTED: {
+      // 并行扫描时别的线程可能正往事务的锁集合里插入，读之前先锁住事务
+      auto *txn = exec_ctx_->GetTransaction();
+      txn->LockTxn();
+      bool exclusive_locked = txn->IsRowExclusiveLocked(tbl_info_->oid_, rid);
+      txn->UnlockTxn();
+      if (!exclusive_locked) {
+        exec_ctx_->GetLockManager()->LockRow(txn, LockManager::LockMode::SHARED, tbl_info_->oid_, rid);
+      }
+    } break;
+    case IsolationLevel::READ_UNCOMMITTED:
+      break;
+  }
+}
+
+auto SeqScanExecutor::ReadRow(RID rid, Tuple *tuple, size_t *eliminated) -> bool {
+  /** Lock the tuple as needed for the isolation level. */
+  LockRowForRead(rid);
+  /** If the current operation is delete, should take X locks on the table and tuple
+   *  which will be set to true for DELETE and UPDATE), you should assume all tuples scanned will be deleted */
+  if (exec_ctx_->IsDelete()) {
+    LockManager::LockMode lock_mode = LockManager::LockMode::EXCLUSIVE;
+    try {
+      exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(), LockManager::LockMode::INTENTION_EXCLUSIVE,
+                                             tbl_info_->oid_);
+      exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), lock_mode, tbl_info_->oid_, rid);
+    } catch (TransactionAbortException &e) {
+      // std::cout << e.GetInfo() << "<<<<<<<<<<<<<<<<<<<IsDelete<<<<<<<>>>>>>>>>>>>>>>>>>>>>>>>>" << std::endl;
+      throw ExecutionException(e.GetInfo());
+    }
+  }
+  /** Fetch the tuple. Check tuple meta, and if you have implemented filter pushdown to scan, check the predicate. */
+  auto [meta, new_tuple] = tbl_info_->table_->GetTuple(rid);
+  if (!meta.is_deleted_) {
+    bool pass = true;
+    if (plan_->filter_predicate_ != nullptr) {  // 处理优化器将filter下推到seq_scan的情况
+      auto value = plan_->filter_predicate_->Evaluate(&new_tuple, GetOutputSchema());
+      pass = !value.IsNull() && value.GetAs<bool>();
+    }
+    // 上面 hash join 的 Bloom 过滤器在谓词之后查，注定匹配不上的行不再往上送
+    if (pass && join_filter_ != nullptr) {
+      pass = join_filter_->Pass(new_tuple, GetOutputSchema(), eliminated);
+    }
+    if (!pass) {
+      /** If the tuple should not be read by this transaction, force unlock the row. */
       try {
-        exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(), LockManager::LockMode::INTENTION_EXCLUSIVE,
-                                               tbl_info_->oid_);
-        exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), lock_mode, tbl_info_->oid_, *rid);
+        exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), tbl_info_->oid_, rid, true);
       } catch (TransactionAbortException &e) {
-        // std::cout << e.GetInfo() << "<<<<<<<<<<<<<<<<<<<IsDelete<<<<<<<>>>>>>>>>>>>>>>>>>>>>>>>>" << std::endl;
         throw ExecutionException(e.GetInfo());
       }
+      return false;
     }
-    /** Fetch the tuple. Check tuple meta, and if you have implemented filter pushdown to scan, check the predicate. */
-    auto [meta, new_tuple] = tbl_it_->GetTuple();
-    ++(*tbl_it_);
-    if (!meta.is_deleted_) {
-      if (plan_->filter_predicate_ != nullptr) {  // 处理优化器将filter下推到seq_scan的情况
-        auto value = plan_->filter_predicate_->Evaluate(&new_tuple, GetOutputSchema());
-        if (value.IsNull() || !value.GetAs<bool>()) {
-          /** If the tuple should not be read by this transaction, force unlock the row. */
-          try {
-            exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), tbl_info_->oid_, *rid, true);
-          } catch (TransactionAbortException &e) {
-            throw ExecutionException(e.GetInfo());
+    /** Otherwise, unlock the row as needed for the isolation level. */
+    if (!exec_ctx_->IsDelete()) {
+      switch (exec_ctx_->GetTransaction()->GetIsolationLevel()) {
+        case IsolationLevel::REPEATABLE_READ:
+          break;
+        case IsolationLevel::READ_COMMITTED: {
+          exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), tbl_info_->oid_, rid, false);
+        } break;
+        case IsolationLevel::READ_UNCOMMITTED:
+          break;
+      }
+    }
+    *tuple = std::move(new_tuple);
+    return true;
+  }
+  /** If the tuple should not be read by this transaction, force unlock the row. */
+  if (exec_ctx_->GetTransaction()->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
+    exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), tbl_info_->oid_, rid, true);
+  }
+  return false;
+}
+
+void SeqScanExecutor::StartWorkers(size_t scan_parallelism) {
+  cursor_ = std::make_unique<TableMorselCursor>(exec_ctx_->GetBufferPoolManager(), tbl_info_->table_.get());
+  chunk_.clear();
+  chunk_pos_ = 0;
+  exchange_ = std::make_unique<TupleExchange>(scan_parallelism, scan_parallelism * 2);
+  for (size_t i = 0; i < scan_parallelism; i++) {
+    workers_.emplace_back([this] { ScanWorker(); });
+  }
+}
+
+void SeqScanExecutor::StopWorkers() {
+  if (exchange_ != nullptr) {
+    exchange_->Close();
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+  exchange_.reset();
+}
+
+void SeqScanExecutor::ScanWorker() {
+  std::exception_ptr error;
+  try {
+    std::vector<page_id_t> pages;
+    TupleExchange::Chunk chunk;
+    size_t eliminated = 0;
+    bool closed = false;
+    while (!closed && cursor_->Next(&pages)) {
+      for (auto page_id : pages) {
+        uint32_t num_tuples = cursor_->NumSlots(page_id);
+        for (uint32_t slot = 0; slot < num_tuples; slot++) {
+          RID rid{page_id, slot};
+          Tuple tuple;
+          if (ReadRow(rid, &tuple, &eliminated)) {
+            chunk.emplace_back(std::move(tuple), rid);
           }
-          continue;
         }
       }
-      /** Otherwise, unlock the row as needed for the isolation level. */
-      if (!exec_ctx_->IsDelete()) {
-        switch (exec_ctx_->GetTransaction()->GetIsolationLevel()) {
-          case IsolationLevel::REPEATABLE_READ:
-            break;
-          case IsolationLevel::READ_COMMITTED: {
-            exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), tbl_info_->oid_, *rid, false);
-          } break;
-          case IsolationLevel::READ_UNCOMMITTED:
-            break;
-        }
+      if (eliminated > 0) {
+        join_filter_stats_->bloom_filtered_rows_ += eliminated;
+        eliminated = 0;
+      }
+      // 一个 morsel 交一次，消费者提前关掉就不再往下扫
+      if (!chunk.empty()) {
+        closed = !exchange_->Push(std::move(chunk));
+        chunk = {};
       }
-      *tuple = new_tuple;
-      return true;
-    }
-    /** If the tuple should not be read by this transaction, force unlock the row. */
-    if (exec_ctx_->GetTransaction()->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
-      exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), tbl_info_->oid_, *rid, true);
     }
+  } catch (...) {
+    error = std::current_exception();
   }
-
-  return false;
+  exchange_->ProducerDone(error);
 }
 
 }  // namespace bustub
@@ -1,5 +1,7 @@
 #include "execution/executors/sort_executor.h"
 #include <algorithm>
+#include "execution/sort_key.h"
+#include "execution/task_scheduler.h"
 namespace bustub {
 
 SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
@@ -7,40 +9,165 @@ SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
     : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child_executor)) {}
 
 void SortExecutor::Init() {
+  tree_.reset();
+  sources_.clear();
+  runs_.clear();
+  run_.clear();
+  cur_ = 0;
   child_->Init();
+
+  // 一个 run 在后台排序写盘，另一个在读，所以每个 run 只占一半预算
+  auto run_budget = exec_ctx_->GetMemoryBudget() / 2;
+  OperatorStats *stats = nullptr;
+  TaskGroup sorting(exec_ctx_->GetTaskScheduler());
+  size_t run_bytes = 0;
   Tuple tuple;
   RID rid;
-  cur_ = 0;
   while (child_->Next(&tuple, &rid)) {
-    ve_.emplace_back(tuple, rid);
+    auto key = MakeKey(tuple);
+    run_bytes += sizeof(SortEntry) + key.size() + tuple.GetLength();
+    run_.push_back({std::move(key), std::move(tuple), rid});
+    if (run_bytes <= run_budget) {
+      continue;
+    }
+    sorting.Wait();
+    sorting.RethrowError();
+    if (stats == nullptr) {
+      stats = exec_ctx_->GetOperatorStats(plan_);
+    }
+    runs_.push_back(std::make_unique<SpillFile>(exec_ctx_->GetBufferPoolManager()));
+    auto full = std::make_shared<std::vector<SortEntry>>(std::move(run_));
+    sorting.Spawn([full, file = runs_.back().get(), stats] {
+      SortRun(full.get());
+      for (const auto &entry : *full) {
+        file->Append(entry.tuple_);
+      }
+      file->Finish();
+      stats->spilled_bytes_ += file->Bytes();
+      stats->spilled_rows_ += file->Rows();
+    });
+    run_.clear();
+    run_bytes = 0;
+  }
+  SortRun(&run_);
+  sorting.Wait();
+  sorting.RethrowError();
+
+  if (runs_.empty()) {
+    return;
+  }
+  stats->spill_partitions_ += runs_.size();
+  size_t depth = 1;
+  ReduceRuns(&depth);
+  stats->RecordSpillDepth(depth);
+  OpenMerge(0, runs_.size(), true);
+}
+
+auto SortExecutor::MakeKey(const Tuple &tuple) const -> std::string {
+  std::string key;
+  const auto &schema = child_->GetOutputSchema();
+  for (const auto &[type, expr] : plan_->GetOrderBy()) {
+    AppendSortKey(&key, expr->Evaluate(&tuple, schema), type == OrderByType::DESC);
   }
-  auto &order_bys = plan_->GetOrderBy();
-  auto &schema = child_->GetOutputSchema();
-  auto sort_by = [&order_bys, &schema](std::pair<Tuple, RID> &t1, std::pair<Tuple, RID> &t2) -> bool {
-    for (const auto &order_by : order_bys) {
-      Value val1 = order_by.second->Evaluate(&t1.first, schema);
-      Value val2 = order_by.second->Evaluate(&t2.first, schema);
+  return key;
+}
+
+void SortExecutor::SortRun(std::vector<SortEntry> *run) {
+  // 键相等时保持输入顺序，合并时也按 run 的先后决胜负，整体是稳定排序
+  std::stable_sort(run->begin(), run->end(), [](const SortEntry &a, const SortEntry &b) {
+    return CompareSortKeys(a.key_, b.key_) < 0;
+  });
+}
 
-      if (val1.CompareEquals(val2) == CmpBool::CmpTrue) {  // continue if they equal in this val
-        continue;
+void SortExecutor::ReduceRuns(size_t *depth) {
+  while (runs_.size() >= static_cast<size_t>(SORT_MERGE_FAN_IN)) {
+    // 相邻的 run 合成一个，保持 run 之间的先后顺序
+    std::vector<std::unique_ptr<SpillFile>> merged;
+    for (size_t begin = 0; begin < runs_.size(); begin += SORT_MERGE_FAN_IN) {
+      auto end = std::min(begin + SORT_MERGE_FAN_IN, runs_.size());
+      merged.push_back(std::make_unique<SpillFile>(exec_ctx_->GetBufferPoolManager()));
+      OpenMerge(begin, end, false);
+      while (true) {
+        auto winner = tree_->Top();
+        auto &top = sources_[winner];
+        if (top.done_) {
+          break;
+        }
+        merged.back()->Append(top.head_.tuple_);
+        Advance(&top);
+        tree_->Replay(winner);
       }
+      merged.back()->Finish();
+      auto *stats = exec_ctx_->GetOperatorStats(plan_);
+      stats->spilled_bytes_ += merged.back()->Bytes();
+      stats->spilled_rows_ += merged.back()->Rows();
+    }
+    tree_.reset();
+    sources_.clear();
+    runs_ = std::move(merged);
+    (*depth)++;
+  }
+}
+
+void SortExecutor::OpenMerge(size_t begin, size_t end, bool with_memory_run) {
+  tree_.reset();
+  sources_.clear();
+  sources_.resize(end - begin + (with_memory_run ? 1 : 0));
+  for (size_t i = begin; i < end; i++) {
+    sources_[i - begin].reader_ = std::make_unique<SpillFile::Reader>(runs_[i].get());
+  }
+  for (auto &source : sources_) {
+    Advance(&source);
+  }
+  tree_ = std::make_unique<LoserTree<SourceLess>>(sources_.size(), SourceLess{&sources_});
+}
 
-      return order_by.first == OrderByType::DEFAULT || order_by.first == OrderByType::ASC
-                 ? val1.CompareLessThan(val2) == CmpBool::CmpTrue
-                 : val1.CompareGreaterThan(val2) == CmpBool::CmpTrue;
+void SortExecutor::Advance(MergeSource *source) {
+  if (source->reader_ == nullptr) {
+    if (source->pos_ == run_.size()) {
+      source->done_ = true;
+      return;
     }
-    return false;  // return false if they equal in every val (namely themself)
-  };
-  std::sort(ve_.begin(), ve_.end(), sort_by);
+    source->head_ = std::move(run_[source->pos_++]);
+    return;
+  }
+  // 溢出的行在读回时重新算一次键
+  if (!source->reader_->Next(&source->head_.tuple_)) {
+    source->done_ = true;
+    return;
+  }
+  source->head_.key_ = MakeKey(source->head_.tuple_);
+  source->head_.rid_ = RID{};
+}
+
+auto SortExecutor::SourceLess::operator()(size_t a, size_t b) const -> bool {
+  const auto &lhs = (*sources_)[a];
+  const auto &rhs = (*sources_)[b];
+  if (lhs.done_ || rhs.done_) {
+    return !lhs.done_;
+  }
+  return CompareSortKeys(lhs.head_.key_, rhs.head_.key_) < 0;
 }
 
 auto SortExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (cur_ == static_cast<int>(ve_.size())) {
+  if (tree_ == nullptr) {
+    if (cur_ == run_.size()) {
+      return false;
+    }
+    *tuple = std::move(run_[cur_].tuple_);
+    *rid = run_[cur_].rid_;
+    cur_++;
+    return true;
+  }
+  auto winner = tree_->Top();
+  auto &top = sources_[winner];
+  if (top.done_) {
     return false;
   }
-  *tuple = ve_[cur_].first;
-  *rid = ve_[cur_].second;
-  cur_++;
+  *tuple = std::move(top.head_.tuple_);
+  *rid = top.head_.rid_;
+  Advance(&top);
+  tree_->Replay(winner);
   return true;
 }
 
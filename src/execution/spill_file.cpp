@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// spill_file.cpp
+//
+// Identification: src/execution/spill_file.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/spill_file.h"
+
+#include "common/exception.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+SpillFile::~SpillFile() {
+  Finish();
+  for (auto page_id : pages_) {
+    bpm_->DeletePage(page_id);
+  }
+}
+
+void SpillFile::Append(const Tuple &tuple) {
+  TmpTuple out{INVALID_PAGE_ID, 0};
+  if (tail_ != nullptr && tail_->Insert(tuple, &out)) {
+    rows_++;
+    bytes_ += sizeof(uint32_t) + tuple.GetLength();
+    return;
+  }
+  if (tail_ != nullptr) {
+    bpm_->UnpinPage(tail_->GetTablePageId(), true);
+    tail_ = nullptr;
+  }
+  page_id_t page_id;
+  auto *page = bpm_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame in the buffer pool to spill to");
+  }
+  tail_ = reinterpret_cast<TmpTuplePage *>(page);
+  tail_->Init(page_id, BUSTUB_PAGE_SIZE);
+  pages_.push_back(page_id);
+  if (!tail_->Insert(tuple, &out)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE,
+                    fmt::format("a tuple of {} bytes does not fit in a spill page", tuple.GetLength()));
+  }
+  rows_++;
+  bytes_ += sizeof(uint32_t) + tuple.GetLength();
+}
+
+void SpillFile::Finish() {
+  if (tail_ != nullptr) {
+    bpm_->UnpinPage(tail_->GetTablePageId(), true);
+    tail_ = nullptr;
+  }
+}
+
+SpillFile::Reader::~Reader() {
+  if (page_ != nullptr) {
+    file_->bpm_->UnpinPage(page_->GetTablePageId(), false);
+  }
+}
+
+auto SpillFile::Reader::Next(Tuple *tuple) -> bool {
+  while (offsets_.empty()) {
+    if (page_ != nullptr) {
+      file_->bpm_->UnpinPage(page_->GetTablePageId(), false);
+      page_ = nullptr;
+    }
+    if (next_page_ == file_->pages_.size()) {
+      return false;
+    }
+    auto *page = file_->bpm_->FetchPage(file_->pages_[next_page_++]);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame in the buffer pool to read a spill page");
+    }
+    page_ = reinterpret_cast<TmpTuplePage *>(page);
+    // 页内的元组从页尾往前长，从空闲指针往后走是倒序的
+    for (size_t offset = page_->GetFreeSpacePointer(); offset < BUSTUB_PAGE_SIZE; offset = page_->NextOffset(offset)) {
+      offsets_.push_back(offset);
+    }
+  }
+  page_->Get(offsets_.back(), tuple);
+  offsets_.pop_back();
+  return true;
+}
+
+}  // namespace bustub
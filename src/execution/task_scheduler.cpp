@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// task_scheduler.cpp
+//
+// Identification: src/execution/task_scheduler.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/task_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bustub {
+
+namespace {
+/** The scheduler and deque of the worker running on this thread, if any */
+thread_local TaskScheduler *current_scheduler = nullptr;
+thread_local size_t current_worker = 0;
+}  // namespace
+
+TaskScheduler::TaskScheduler(size_t num_workers) {
+  for (size_t i = 0; i < std::max<size_t>(num_workers, 1); i++) {
+    queues_.emplace_back(std::make_unique<WorkerQueue>());
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    std::scoped_lock lock(sleep_latch_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void TaskScheduler::Submit(Task task) {
+  std::call_once(start_flag_, [this] {
+    for (size_t i = 0; i < queues_.size(); i++) {
+      workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+  });
+  // 工作线程派生的任务放进自己的队列，外面来的轮流分
+  size_t index = current_scheduler == this ? current_worker : next_queue_++ % queues_.size();
+  {
+    std::scoped_lock lock(queues_[index]->latch_);
+    queues_[index]->tasks_.emplace_back(std::move(task));
+  }
+  {
+    std::scoped_lock lock(sleep_latch_);
+    pending_++;
+  }
+  wake_.notify_one();
+}
+
+void TaskScheduler::WorkerLoop(size_t index) {
+  current_scheduler = this;
+  current_worker = index;
+  while (true) {
+    {
+      std::unique_lock lock(sleep_latch_);
+      wake_.wait(lock, [&] { return stop_ || pending_ > 0; });
+      if (pending_ == 0) {
+        return;
+      }
+      // 先占一个名额，队列里的任务数不会少于占了名额的线程数，下面一定取得到
+      pending_--;
+    }
+    Task task;
+    while (!TakeTask(index, &task)) {
+      std::this_thread::yield();
+    }
+    task();
+  }
+}
+
+auto TaskScheduler::TakeTask(size_t index, Task *task) -> bool {
+  {
+    auto &own = *queues_[index];
+    std::scoped_lock lock(own.latch_);
+    if (!own.tasks_.empty()) {
+      *task = std::move(own.tasks_.back());
+      own.tasks_.pop_back();
+      return true;
+    }
+  }
+  for (size_t i = 1; i < queues_.size(); i++) {
+    auto &victim = *queues_[(index + i) % queues_.size()];
+    std::scoped_lock lock(victim.latch_);
+    if (!victim.tasks_.empty()) {
+      *task = std::move(victim.tasks_.front());
+      victim.tasks_.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void TaskGroup::Spawn(std::function<void()> task) {
+  {
+    std::scoped_lock lock(state_->latch_);
+    state_->running_++;
+    state_->queued_.emplace_back(std::move(task));
+  }
+  if (scheduler_ == nullptr) {
+    RunQueued(state_.get());
+    return;
+  }
+  // 工作线程取到的只是一个跑腿的，任务可能已经被等待者自己跑掉了
+  scheduler_->Submit([state = state_] { RunQueued(state.get()); });
+}
+
+auto TaskGroup::RunQueued(State *state) -> bool {
+  std::function<void()> task;
+  {
+    std::scoped_lock lock(state->latch_);
+    if (state->queued_.empty()) {
+      return false;
+    }
+    task = std::move(state->queued_.front());
+    state->queued_.pop_front();
+  }
+  std::exception_ptr error;
+  try {
+    task();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // 在锁里通知，等待者醒来析构 TaskGroup 时这个任务已经不再碰它
+  std::scoped_lock lock(state->latch_);
+  if (error != nullptr && state->error_ == nullptr) {
+    state->error_ = std::move(error);
+  }
+  state->running_--;
+  state->done_.notify_all();
+  return true;
+}
+
+void TaskGroup::Wait() {
+  // 先把还没开始的任务自己跑掉，在工作线程里等子任务也不会把线程池占死
+  while (RunQueued(state_.get())) {
+  }
+  std::unique_lock lock(state_->latch_);
+  state_->done_.wait(lock, [&] { return state_->running_ == 0; });
+}
+
+void TaskGroup::RethrowError() {
+  std::scoped_lock lock(state_->latch_);
+  if (state_->error_ != nullptr) {
+    std::rethrow_exception(state_->error_);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_batch.cpp
+//
+// Identification: src/execution/tuple_batch.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/tuple_batch.h"
+
+#include <numeric>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+TupleBatch::TupleBatch(const Schema *schema, size_t capacity)
+    : schema_(schema), capacity_(capacity), columns_(schema->GetColumnCount()) {
+  for (auto &column : columns_) {
+    column.reserve(capacity_);
+  }
+  rids_.reserve(capacity_);
+  sel_.reserve(capacity_);
+}
+
+void TupleBatch::Reset() {
+  for (auto &column : columns_) {
+    column.clear();
+  }
+  rids_.clear();
+  sel_.clear();
+}
+
+void TupleBatch::Append(std::vector<Value> values, RID rid) {
+  BUSTUB_ASSERT(values.size() == columns_.size(), "row does not match the batch schema");
+  sel_.push_back(rids_.size());
+  for (size_t i = 0; i < columns_.size(); i++) {
+    columns_[i].emplace_back(std::move(values[i]));
+  }
+  rids_.push_back(rid);
+}
+
+void TupleBatch::AppendTuple(const Tuple &tuple, RID rid) {
+  sel_.push_back(rids_.size());
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    columns_[i].emplace_back(tuple.GetValue(schema_, i));
+  }
+  rids_.push_back(rid);
+}
+
+void TupleBatch::AppendTuple(const char *data, RID rid) {
+  sel_.push_back(rids_.size());
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    columns_[i].emplace_back(Tuple::GetValue(data, schema_, i));
+  }
+  rids_.push_back(rid);
+}
+
+void TupleBatch::SetColumns(std::vector<std::vector<Value>> &&columns, std::vector<RID> &&rids) {
+  BUSTUB_ASSERT(columns.size() == columns_.size(), "columns do not match the batch schema");
+  size_t rows = columns.empty() ? rids.size() : columns[0].size();
+  columns_ = std::move(columns);
+  rids_ = std::move(rids);
+  rids_.resize(rows);
+  sel_.resize(rows);
+  std::iota(sel_.begin(), sel_.end(), 0);
+}
+
+auto TupleBatch::GetRow(uint32_t row) const -> std::vector<Value> {
+  std::vector<Value> values;
+  values.reserve(columns_.size());
+  for (const auto &column : columns_) {
+    values.push_back(column[row]);
+  }
+  return values;
+}
+
+auto TupleBatch::MaterializeTuple(uint32_t row) const -> Tuple { return {GetRow(row), schema_}; }
+
+}  // namespace bustub
@@ -24,8 +24,8 @@ UpdateExecutor::UpdateExecutor(ExecutorContext *exec_ctx, const UpdatePlanNode *
 void UpdateExecutor::Init() {
   auto catalog = exec_ctx_->GetCatalog();
   table_info_ = catalog->GetTable(plan_->table_oid_);
-  indexes_info_ = catalog->GetTableIndexes(table_info_->name_);
   child_executor_->Init();
+  indexes_info_ = catalog->GetTableIndexes(table_info_->name_, true);
   outputted_ = false;
 }
 
@@ -37,6 +37,11 @@ auto UpdateExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   while (child_executor_->Next(tuple, rid)) {
     TupleMeta tuple_meta{INVALID_TXN_ID, INVALID_TXN_ID, true};
     table_info_->table_->UpdateTupleMeta(tuple_meta, *rid);
+    auto *txn = exec_ctx_->GetTransaction();
+    // 更新拆成删除加插入，两半都记进写集，事务中止时才能撤回
+    TableWriteRecord delete_record{table_info_->oid_, *rid, table_info_->table_.get()};
+    delete_record.wtype_ = WType::DELETE;
+    txn->GetWriteSet()->push_back(delete_record);
     std::vector<Value> res;
     for (auto &tmp : plan_->target_expressions_) {
       res.emplace_back(tmp->Evaluate(tuple, table_info_->schema_));
@@ -48,15 +53,26 @@ auto UpdateExecutor::Next(Tuple *tuple, RID *rid) -> bool {
     if (!k.has_value()) {
       return false;
     }
+    // 旧索引项指向的是旧 RID，非唯一索引按 RID 删
+    RID old_rid = *rid;
     *rid = k.value();
     nums++;
+    TableWriteRecord insert_record{table_info_->oid_, *rid, table_info_->table_.get()};
+    insert_record.wtype_ = WType::INSERT;
+    txn->GetWriteSet()->push_back(insert_record);
     for (auto tmp : indexes_info_) {
       auto delete_key = tuple->KeyFromTuple(table_info_->schema_, tmp->key_schema_, tmp->index_->GetKeyAttrs());
       auto update_key = ans.KeyFromTuple(table_info_->schema_, tmp->key_schema_, tmp->index_->GetKeyAttrs());
-      tmp->index_->DeleteEntry(delete_key, *rid, exec_ctx_->GetTransaction());
-      if (!tmp->index_->InsertEntry(update_key, *rid, exec_ctx_->GetTransaction())) {
-        return false;
+      tmp->DeleteEntry(delete_key, old_rid, txn);
+      txn->GetIndexWriteSet()->emplace_back(old_rid, table_info_->oid_, WType::DELETE, delete_key, tmp->index_oid_,
+                                            exec_ctx_->GetCatalog());
+      if (!tmp->InsertEntry(update_key, *rid, txn)) {
+        // 旧键已经删掉了，这里必须中止整个事务，由 Abort 把旧键插回去
+        txn->SetState(TransactionState::ABORTED);
+        throw ExecutionException("Insert into index " + tmp->name_ + " failed");
       }
+      txn->GetIndexWriteSet()->emplace_back(*rid, table_info_->oid_, WType::INSERT, update_key, tmp->index_oid_,
+                                            exec_ctx_->GetCatalog());
     }
   }
   std::vector<Value> values{{TypeId::INTEGER, nums}};
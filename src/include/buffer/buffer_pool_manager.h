@@ -12,10 +12,14 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
 
 #include "buffer/lru_k_replacer.h"
 #include "common/config.h"
@@ -121,6 +125,18 @@ class BufferPoolManager {
   auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
   auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
 
+  /**
+   * @brief Hint that a page will be fetched soon.
+   *
+   * The hint is queued for a background thread, started on the first hint, that
+   * reads the page into the pool while the caller keeps working. The call never
+   * takes the pool latch or waits on the disk. The page is left unpinned and
+   * evictable, and the hint is dropped if PREFETCH_QUEUE_SIZE hints are pending.
+   *
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPage(page_id_t page_id);
+
   /**
    * TODO(P1): Add implementation
    *
@@ -172,6 +188,16 @@ class BufferPoolManager {
    */
   auto DeletePage(page_id_t page_id) -> bool;
 
+  /**
+   * @brief Make page allocation continue at next_page_id, the pages below it belong to a reopened database file.
+   * Never moves the allocation point backwards.
+   * @param next_page_id the first page id that is not in use yet
+   */
+  void ReservePages(page_id_t next_page_id);
+
+  /** @brief Return the next page id to be allocated, the catalog records it to reopen the file later. */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_.load(); }
+
  private:
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
@@ -192,6 +218,28 @@ class BufferPoolManager {
   std::list<frame_id_t> free_list_;
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
+  /**
+   * The pages the prefetch thread is reading or writing back with latch_ released, their frame out of the page table,
+   * the free list and the replacer. Fetching or deleting one of them waits on io_cv_ until the I/O is done.
+   */
+  std::unordered_set<page_id_t> io_pages_;
+  std::condition_variable_any io_cv_;
+
+  /** The prefetch thread, the page ids hinted to it and whether it should exit, all guarded by prefetch_latch_ */
+  std::thread prefetcher_;
+  std::deque<page_id_t> prefetch_queue_;
+  bool stop_prefetch_{false};
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+
+  /** The body of the prefetch thread: read the hinted pages until the pool is destroyed. */
+  void PrefetchWorker();
+
+  /**
+   * Read a page into a frame, unpinned and evictable, unless it is resident already or no frame can be freed. The
+   * frame is reserved under latch_, the write-back of its old page and the read happen without it.
+   */
+  void LoadPage(page_id_t page_id);
 
   /**
    * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
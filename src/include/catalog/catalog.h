@@ -12,7 +12,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -58,6 +62,9 @@ struct TableInfo {
   const table_oid_t oid_;
 };
 
+/** The data structure behind an index. */
+enum class IndexType { BPlusTreeIndex, HashTableIndex };
+
 /**
  * The IndexInfo class maintains metadata about a index.
  */
@@ -70,15 +77,29 @@ struct IndexInfo {
    * @param index_oid The unique OID for the index
    * @param table_name The name of the table on which the index is created
    * @param key_size The size of the index key, in bytes
+   * @param index_type The data structure behind the index
    */
   IndexInfo(Schema key_schema, std::string name, std::unique_ptr<Index> &&index, index_oid_t index_oid,
-            std::string table_name, size_t key_size)
+            std::string table_name, size_t key_size, IndexType index_type = IndexType::BPlusTreeIndex)
       : key_schema_{std::move(key_schema)},
         name_{std::move(name)},
         index_{std::move(index)},
         index_oid_{index_oid},
         table_name_{std::move(table_name)},
-        key_size_{key_size} {}
+        key_size_{key_size},
+        index_type_{index_type} {}
+
+  /**
+   * @param cols indexes of table columns
+   * @return true if every column in cols is part of the index key, so a scan can produce them without the table heap
+   */
+  auto CoversColumns(const std::vector<uint32_t> &cols) const -> bool {
+    const auto &key_attrs = index_->GetKeyAttrs();
+    return std::all_of(cols.begin(), cols.end(), [&key_attrs](uint32_t col) {
+      return std::find(key_attrs.begin(), key_attrs.end(), col) != key_attrs.end();
+    });
+  }
+
   /** The schema for the index key */
   Schema key_schema_;
   /** The name of the index */
@@ -91,12 +112,55 @@ struct IndexInfo {
   std::string table_name_;
   /** The size of the index key, in bytes */
   const size_t key_size_;
+  /** The data structure behind the index, hash indexes only answer equality lookups */
+  const IndexType index_type_;
+
+  /**
+   * Add the entry of a table write to the index. While the index is built
+   * online the write goes to the side log instead and Catalog::BuildIndex
+   * replays it once the snapshot scan is done.
+   */
+  auto InsertEntry(const Tuple &key, RID rid, Transaction *txn) -> bool {
+    {
+      std::scoped_lock lock(build_latch_);
+      if (is_building_) {
+        build_log_.emplace_back(rid, 0, WType::INSERT, key, index_oid_, nullptr);
+        return true;
+      }
+    }
+    return index_->InsertEntry(key, rid, txn);
+  }
+
+  /** Remove the entry of a table write from the index, logged while the index is built online. */
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *txn) {
+    {
+      std::scoped_lock lock(build_latch_);
+      if (is_building_) {
+        build_log_.emplace_back(rid, 0, WType::DELETE, key, index_oid_, nullptr);
+        return;
+      }
+    }
+    index_->DeleteEntry(key, rid, txn);
+  }
+
+  /** @return true until the online build has caught up, the optimizer must not use the index before that */
+  auto IsBuilding() const -> bool { return is_building_.load(std::memory_order_acquire); }
+
+ private:
+  friend class Catalog;
+
+  /** Guards is_building_ flipping and build_log_ */
+  std::mutex build_latch_;
+  std::atomic<bool> is_building_{false};
+  /** Writes that arrived during the build; table_oid_ and catalog_ are not filled in */
+  std::vector<IndexWriteRecord> build_log_;
 };
 
 /**
- * The Catalog is a non-persistent catalog that is designed for
- * use by executors within the DBMS execution engine. It handles
- * table creation, table lookup, index creation, and index lookup.
+ * The Catalog is designed for use by executors within the DBMS
+ * execution engine. It handles table creation, table lookup, index
+ * creation, and index lookup. It lives in memory only unless Open()
+ * binds it to the first page of a database file.
  */
 class Catalog {
  public:
@@ -149,6 +213,7 @@ class Catalog {
     // Update the internal tracking mechanisms
     tables_.emplace(table_oid, std::move(meta));
     table_names_.emplace(table_name, table_oid);
+    std::unique_lock lock(index_latch_);
     index_names_.emplace(table_name, std::unordered_map<std::string, index_oid_t>{});
 
     return tmp;
@@ -188,6 +253,7 @@ class Catalog {
 
   /**
    * Create a new index, populate existing data of the table and return its metadata.
+   * Same as BeginCreateIndex() followed by BuildIndex().
    * @param txn The transaction in which the table is being created
    * @param index_name The name of the new index
    * @param table_name The name of the table
@@ -196,17 +262,42 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param index_type The data structure to build the index on
+   * @param is_unique Whether a B+ tree index rejects duplicate keys
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
                    const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
-                   HashFunction<KeyType> hash_function) -> IndexInfo * {
+                   HashFunction<KeyType> hash_function, IndexType index_type = IndexType::BPlusTreeIndex,
+                   bool is_unique = true) -> IndexInfo * {
+    auto *index_info = BeginCreateIndex<KeyType, ValueType, KeyComparator>(
+        txn, index_name, table_name, schema, key_schema, key_attrs, keysize, hash_function, index_type, is_unique);
+    if (index_info != NULL_INDEX_INFO) {
+      BuildIndex(txn, index_info);
+    }
+    return index_info;
+  }
+
+  /**
+   * Register a new, still empty index in the building state. From now on the
+   * write executors log their changes for it (IndexInfo::InsertEntry), while
+   * GetTableIndexes() keeps it away from the optimizer. Call BuildIndex() to
+   * fill and publish it; only the registration needs the catalog to itself.
+   * Parameters are the same as CreateIndex().
+   */
+  template <class KeyType, class ValueType, class KeyComparator>
+  auto BeginCreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                        const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
+                        std::size_t keysize, HashFunction<KeyType> hash_function,
+                        IndexType index_type = IndexType::BPlusTreeIndex, bool is_unique = true) -> IndexInfo * {
     // Reject the creation request for nonexistent table
     if (table_names_.find(table_name) == table_names_.end()) {
       return NULL_INDEX_INFO;
     }
 
+    std::unique_lock lock(index_latch_);
+
     // If the table exists, an entry for the table should already be present in index_names_
     BUSTUB_ASSERT((index_names_.find(table_name) != index_names_.end()), "Broken Invariant");
 
@@ -221,18 +312,12 @@ class Catalog {
     auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
 
     // Construct the index, take ownership of metadata
-    // TODO(Kyle): We should update the API for CreateIndex
-    // to allow specification of the index type itself, not
-    // just the key, value, and comparator types
-
-    // TODO(chi): support both hash index and btree index
-    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
-
-    // Populate the index with all tuples in table heap
-    auto *table_meta = GetTable(table_name);
-    for (auto iter = table_meta->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
-      auto [meta, tuple] = iter.GetTuple();
-      index->InsertEntry(tuple.KeyFromTuple(schema, key_schema, key_attrs), tuple.GetRid(), txn);
+    std::unique_ptr<Index> index;
+    if (index_type == IndexType::HashTableIndex) {
+      index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+                                                                                           hash_function);
+    } else {
+      index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_, is_unique);
     }
 
     // Get the next OID for the new index
@@ -240,7 +325,8 @@ class Catalog {
 
     // Construct index information; IndexInfo takes ownership of the Index itself
     auto index_info =
-        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize, index_type);
+    index_info->is_building_ = true;
     auto *tmp = index_info.get();
 
     // Update internal tracking
@@ -250,6 +336,68 @@ class Catalog {
     return tmp;
   }
 
+  /**
+   * Fill an index registered by BeginCreateIndex() while the table stays
+   * writable, then publish it.
+   *
+   * 1. Wait for the writers that looked up the index list before the index was
+   *    registered, i.e. the other transactions holding a write lock on the
+   *    table (LockManager::WaitForTableWriters). The caller's transaction is
+   *    not touched; a writer blocked on one of its locks would wait forever,
+   *    so build from a transaction that has not written the table.
+   * 2. Insert every live tuple of a table heap scan.
+   * 3. Replay the side log in batches. Replay is idempotent, a logged insert
+   *    may already have been seen by the scan.
+   * 4. Clear the building flag under the log latch once the log is empty.
+   *
+   * Throws if an entry cannot be inserted, e.g. a duplicate key of a unique
+   * index; the index is dropped then.
+   */
+  void BuildIndex(Transaction *txn, IndexInfo *index_info) {
+    auto *table_info = GetTable(index_info->table_name_);
+    auto *index = index_info->index_.get();
+    if (lock_manager_ != nullptr) {
+      lock_manager_->WaitForTableWriters(table_info->oid_, txn == nullptr ? INVALID_TXN_ID : txn->GetTransactionId());
+    }
+
+    for (auto iter = table_info->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
+      auto [meta, tuple] = iter.GetTuple();
+      if (meta.is_deleted_) {
+        continue;
+      }
+      if (!index->InsertEntry(tuple.KeyFromTuple(table_info->schema_, index_info->key_schema_, index->GetKeyAttrs()),
+                              tuple.GetRid(), txn)) {
+        AbandonIndex(index_info);
+        throw Exception("cannot insert " + tuple.GetRid().ToString() + " into index " + index_info->name_);
+      }
+    }
+
+    while (true) {
+      std::vector<IndexWriteRecord> batch;
+      {
+        std::scoped_lock lock(index_info->build_latch_);
+        if (index_info->build_log_.empty()) {
+          index_info->is_building_.store(false, std::memory_order_release);
+          return;
+        }
+        batch.swap(index_info->build_log_);
+      }
+      for (const auto &record : batch) {
+        if (record.wtype_ == WType::DELETE) {
+          index->DeleteEntry(record.tuple_, record.rid_, txn);
+          continue;
+        }
+        std::vector<RID> rids;
+        index->ScanKey(record.tuple_, &rids, txn);
+        if (std::find(rids.begin(), rids.end(), record.rid_) == rids.end() &&
+            !index->InsertEntry(record.tuple_, record.rid_, txn)) {
+          AbandonIndex(index_info);
+          throw Exception("cannot insert " + record.rid_.ToString() + " into index " + index_info->name_);
+        }
+      }
+    }
+  }
+
   /**
    * Get the index `index_name` for table `table_name`.
    * @param index_name The name of the index for which to query
@@ -257,6 +405,7 @@ class Catalog {
    * @return A (non-owning) pointer to the metadata for the index
    */
   auto GetIndex(const std::string &index_name, const std::string &table_name) -> IndexInfo * {
+    std::shared_lock lock(index_latch_);
     auto table = index_names_.find(table_name);
     if (table == index_names_.end()) {
       BUSTUB_ASSERT((table_names_.find(table_name) == table_names_.end()), "Broken Invariant");
@@ -298,7 +447,8 @@ class Catalog {
    * @param index_oid The OID of the index for which to query
    * @return A (non-owning) pointer to the metadata for the index
    */
-  auto GetIndex(index_oid_t index_oid) -> IndexInfo * {
+  auto GetIndex(index_oid_t index_oid) const -> IndexInfo * {
+    std::shared_lock lock(index_latch_);
     auto index = indexes_.find(index_oid);
     if (index == indexes_.end()) {
       return NULL_INDEX_INFO;
@@ -310,15 +460,18 @@ class Catalog {
   /**
    * Get all of the indexes for the table identified by `table_name`.
    * @param table_name The name of the table for which indexes should be retrieved
+   * @param include_building Also return indexes still being built online, for executors that write the table
    * @return A vector of IndexInfo* for each index on the given table, empty vector
    * in the event that the table exists but no indexes have been created for it
    */
-  auto GetTableIndexes(const std::string &table_name) const -> std::vector<IndexInfo *> {
+  auto GetTableIndexes(const std::string &table_name, bool include_building = false) const
+      -> std::vector<IndexInfo *> {
     // Ensure the table exists
     if (table_names_.find(table_name) == table_names_.end()) {
       return std::vector<IndexInfo *>{};
     }
 
+    std::shared_lock lock(index_latch_);
     auto table_indexes = index_names_.find(table_name);
     BUSTUB_ASSERT((table_indexes != index_names_.end()), "Broken Invariant");
 
@@ -327,6 +480,9 @@ class Catalog {
     for (const auto &index_meta : table_indexes->second) {
       auto index = indexes_.find(index_meta.second);
       BUSTUB_ASSERT((index != indexes_.end()), "Broken Invariant");
+      if (!include_building && index->second->IsBuilding()) {
+        continue;
+      }
       indexes.push_back(index->second.get());
     }
 
@@ -341,7 +497,42 @@ class Catalog {
     return result;
   }
 
+  /**
+   * Bind the catalog to a database file. Page HEADER_PAGE_ID holds the
+   * serialized catalog: if the file has one, its tables and indexes are
+   * attached to the pages they already occupy, without scanning or
+   * rebuilding anything; a new file gets that page claimed for the catalog.
+   * Must be called before anything else allocates pages in the file.
+   * @param disk_pages The number of pages the database file already holds
+   */
+  void Open(page_id_t disk_pages);
+
+  /**
+   * Write the metadata of every table and published index to the catalog
+   * pages: names, schemas, OIDs and the first pages the table heaps and
+   * indexes hang off. The pages reach disk with the rest of the buffer pool.
+   * Does nothing unless the catalog was opened on a database file.
+   */
+  void Persist();
+
+  /** @return true if Open() bound the catalog to a database file */
+  auto IsPersistent() const -> bool { return !catalog_pages_.empty(); }
+
  private:
+  /**
+   * Drop an index whose build failed. Only its name goes away: writers that
+   * looked it up before may still hold the IndexInfo, which keeps logging
+   * into the side log and is never published or persisted.
+   */
+  void AbandonIndex(IndexInfo *index_info) {
+    {
+      std::unique_lock lock(index_latch_);
+      index_names_[index_info->table_name_].erase(index_info->name_);
+    }
+    std::scoped_lock lock(index_info->build_latch_);
+    index_info->build_log_.clear();
+  }
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
@@ -371,6 +562,15 @@ class Catalog {
 
   /** The next index identifier to be used. */
   std::atomic<index_oid_t> next_index_oid_{0};
+
+  /** Guards `indexes_` and `index_names_`, write executors look indexes up while an index is being built */
+  mutable std::shared_mutex index_latch_;
+
+  /** The chain of pages holding the serialized catalog, starting at HEADER_PAGE_ID; empty when not persistent. */
+  std::vector<page_id_t> catalog_pages_;
+
+  /** Serializes Open() and Persist() */
+  std::mutex persist_latch_;
 };
 
 }  // namespace bustub
@@ -12,11 +12,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <shared_mutex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -41,6 +43,7 @@ class LogManager;
 class CheckpointManager;
 class Catalog;
 class ExecutionEngine;
+class TaskScheduler;
 
 class CreateStatement;
 class IndexStatement;
@@ -261,6 +264,8 @@ class BustubInstance {
   CheckpointManager *checkpoint_manager_;
   Catalog *catalog_;
   ExecutionEngine *execution_engine_;
+  /** Runs the parallel pipelines of every query of this instance */
+  TaskScheduler *task_scheduler_;
   std::shared_mutex catalog_lock_;
 
   auto GetSessionVariable(const std::string &key) -> std::string {
@@ -275,9 +280,40 @@ class BustubInstance {
     return variable == "1" || variable == "true" || variable == "yes";
   }
 
+  /** @return the number of copies a query pipeline may run as, set by `SET parallelism = n` */
+  auto GetParallelism() -> size_t {
+    auto variable = GetSessionVariable("parallelism");
+    try {
+      return variable.empty() ? 1 : std::clamp(std::stoi(variable), 1, 64);
+    } catch (const std::logic_error &e) {
+      return 1;
+    }
+  }
+
+  /** @return the bytes each operator may hold before spilling, set by `SET memory_budget = n` */
+  auto GetMemoryBudget() -> size_t {
+    auto variable = GetSessionVariable("memory_budget");
+    try {
+      return variable.empty() ? OPERATOR_MEMORY_BUDGET : std::max<size_t>(std::stoull(variable), BUSTUB_PAGE_SIZE);
+    } catch (const std::logic_error &e) {
+      return OPERATOR_MEMORY_BUDGET;
+    }
+  }
+
+  /** @return the number of worker threads a sequential scan may use, set by `SET scan_parallelism = n` */
+  auto GetScanParallelism() -> size_t {
+    auto variable = GetSessionVariable("scan_parallelism");
+    try {
+      return variable.empty() ? 1 : std::clamp(std::stoi(variable), 1, 64);
+    } catch (const std::logic_error &e) {
+      return 1;
+    }
+  }
+
  private:
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
+  void CmdDisplayIndexStats(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
 
@@ -35,7 +35,18 @@ static constexpr int BUSTUB_PAGE_SIZE = 4096;
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
-static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int LRUK_REPLACER_K = 10;                  // lookback window for lru-k replacer
+static constexpr int PREFETCH_QUEUE_SIZE = 16;              // page hints a buffer pool queues for its prefetch thread
+static constexpr int BUSTUB_BATCH_SIZE = 1024;              // rows per TupleBatch in batch-at-a-time execution
+static constexpr int SCAN_MORSEL_PAGES = 16;                // table pages a parallel scan worker claims at a time
+static constexpr int REPARTITION_FANOUT = 4;                // partitions per pipeline copy of a Repartition exchange
+static constexpr int HASH_JOIN_PARTITION_ROWS = 4096;       // build rows per radix partition of a hash join table
+static constexpr size_t OPERATOR_MEMORY_BUDGET = 64 << 20;  // bytes an operator may hold before it spills
+static constexpr int SPILL_PARTITION_BITS = 3;              // an operator spills into 2^3 partitions per level
+static constexpr int MAX_SPILL_DEPTH = 4;                   // levels of repartitioning before skew is kept in memory
+static constexpr int SORT_MERGE_FAN_IN = 16;                // sorted runs an external sort merges in one pass
+static constexpr int AGG_PARTITION_BITS = 4;                // an aggregation hash table is split into 2^4 partitions
+static constexpr int BLOOM_FILTER_BITS_PER_KEY = 16;        // bits a hash join's Bloom filter spends per build key
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -0,0 +1,242 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fast_hash.h
+//
+// Identification: src/include/common/util/fast_hash.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "murmur3/MurmurHash3.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define BUSTUB_X86_CRC32C 1
+#endif
+
+namespace bustub {
+
+namespace fast_hash_detail {
+
+/** @return the byte-at-a-time table of the reflected CRC32C (Castagnoli) polynomial */
+constexpr auto MakeCrcTable() -> std::array<uint32_t, 256> {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int j = 0; j < 8; j++) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? 0x82F63B78U : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+}  // namespace fast_hash_detail
+
+/** Hash families a HashFunction can be built on. */
+enum class HashAlgorithm {
+  /** CRC32C for 4/8-byte keys, Xxh3 for everything else */
+  Auto,
+  /** MurmurHash3_x64_128, the original hash of the hash tables */
+  Murmur3,
+  /** CRC32C over 8-byte words */
+  Crc32c,
+  /** xxHash3-style multiply-fold hash */
+  Xxh3,
+};
+
+/**
+ * Fast non-cryptographic hashes for keys and values.
+ *
+ * CRC32C uses the SSE4.2 instruction when the CPU has it (checked once at
+ * startup, the build does not need -msse4.2) and a table-driven software CRC
+ * otherwise, so every algorithm returns the same value on every machine.
+ * CRC is linear, which is fine for picking buckets but means the upper 32 bits
+ * are only as good as the lower ones; all hash tables in the tree index with
+ * the low bits.
+ */
+class FastHash {
+ public:
+  /** @return the hash of a 4-byte key */
+  static inline auto Hash32(uint32_t key) -> uint64_t {
+    uint32_t lo = Crc32cU32(CRC_SEED, key);
+    uint32_t hi = Crc32cU32(lo, key);
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+  }
+
+  /** @return the hash of an 8-byte key */
+  static inline auto Hash64(uint64_t key) -> uint64_t {
+    // 两条 CRC 分别吃正序和交换了高低半字的 key，64 位输入才不会被压成 32 位
+    uint32_t lo = Crc32cU64(CRC_SEED, key);
+    uint32_t hi = Crc32cU64(CRC_SEED, (key << 32) | (key >> 32));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+  }
+
+  /** @return the hash of len bytes at data with the given algorithm */
+  static inline auto Hash(const void *data, size_t len, HashAlgorithm algorithm = HashAlgorithm::Auto) -> uint64_t {
+    switch (algorithm) {
+      case HashAlgorithm::Auto:
+        if (len == sizeof(uint32_t)) {
+          return Hash32(Read<uint32_t>(data));
+        }
+        if (len == sizeof(uint64_t)) {
+          return Hash64(Read<uint64_t>(data));
+        }
+        return Xxh3(data, len);
+      case HashAlgorithm::Murmur3: {
+        uint64_t hash[2];
+        murmur3::MurmurHash3_x64_128(data, static_cast<int>(len), 0, reinterpret_cast<void *>(&hash));
+        return hash[0];
+      }
+      case HashAlgorithm::Crc32c:
+        return Crc32cBytes(data, len);
+      case HashAlgorithm::Xxh3:
+        return Xxh3(data, len);
+    }
+    return 0;
+  }
+
+  /** @return xxHash3-style hash of len bytes at data */
+  static inline auto Xxh3(const void *data, size_t len, uint64_t seed = 0) -> uint64_t {
+    const auto *p = static_cast<const char *>(data);
+    uint64_t acc = len * PRIME64_1;
+    if (len <= 16) {
+      uint64_t lo;
+      uint64_t hi;
+      if (len >= 8) {
+        lo = Read<uint64_t>(p);
+        hi = Read<uint64_t>(p + len - 8);
+      } else if (len >= 4) {
+        lo = Read<uint32_t>(p);
+        hi = Read<uint32_t>(p + len - 4);
+      } else if (len > 0) {
+        lo = (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) |
+             (static_cast<uint64_t>(static_cast<uint8_t>(p[len >> 1])) << 8) | static_cast<uint8_t>(p[len - 1]);
+        hi = 0;
+      } else {
+        return Avalanche(acc ^ seed ^ SECRET[0]);
+      }
+      return Avalanche(acc + Mul128Fold64(lo ^ (SECRET[0] + seed), hi ^ (SECRET[1] - seed)));
+    }
+    // 每 16 字节一次 64x64->128 乘法再折叠，尾巴用最后 16 字节补（允许和前面重叠）
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+      size_t s = (i >> 3) & 6;
+      acc += Mul128Fold64(Read<uint64_t>(p + i) ^ (SECRET[s] + seed), Read<uint64_t>(p + i + 8) ^ (SECRET[s + 1] - seed));
+    }
+    if (i < len) {
+      acc += Mul128Fold64(Read<uint64_t>(p + len - 16) ^ (SECRET[6] + seed),
+                          Read<uint64_t>(p + len - 8) ^ (SECRET[7] - seed));
+    }
+    return Avalanche(acc);
+  }
+
+  /** @return CRC32C-based hash of len bytes at data, consumed 8 bytes at a time */
+  static inline auto Crc32cBytes(const void *data, size_t len) -> uint64_t {
+    const auto *p = static_cast<const char *>(data);
+    uint32_t lo = CRC_SEED;
+    uint32_t hi = ~CRC_SEED;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+      uint64_t word = Read<uint64_t>(p + i);
+      lo = Crc32cU64(lo, word);
+      hi = Crc32cU64(hi, (word << 32) | (word >> 32));
+    }
+    if (i < len) {
+      uint64_t word = 0;
+      memcpy(&word, p + i, len - i);
+      lo = Crc32cU64(lo, word);
+      hi = Crc32cU64(hi, (word << 32) | (word >> 32));
+    }
+    return ((static_cast<uint64_t>(hi) << 32) | lo) ^ len;
+  }
+
+  /** Mix two hashes into one, order matters. */
+  static inline auto Combine(uint64_t l, uint64_t r) -> uint64_t {
+    return Mul128Fold64(l ^ SECRET[0], r ^ SECRET[1]) ^ (l + r);
+  }
+
+  /** @return CRC32C of crc extended by 4 bytes */
+  static inline auto Crc32cU32(uint32_t crc, uint32_t data) -> uint32_t {
+#ifdef BUSTUB_X86_CRC32C
+    if (HAS_HW_CRC32C) {
+      return HwCrc32cU32(crc, data);
+    }
+#endif
+    return SwCrc32c(crc, data, 4);
+  }
+
+  /** @return CRC32C of crc extended by 8 bytes */
+  static inline auto Crc32cU64(uint32_t crc, uint64_t data) -> uint32_t {
+#ifdef BUSTUB_X86_CRC32C
+    if (HAS_HW_CRC32C) {
+      return HwCrc32cU64(crc, data);
+    }
+#endif
+    return SwCrc32c(crc, data, 8);
+  }
+
+  /** @return the software CRC32C, exposed so tests can check it against the instruction */
+  static inline auto SwCrc32c(uint32_t crc, uint64_t data, int bytes) -> uint32_t {
+    for (int i = 0; i < bytes; i++) {
+      crc = CRC_TABLE[(crc ^ static_cast<uint8_t>(data)) & 0xff] ^ (crc >> 8);
+      data >>= 8;
+    }
+    return crc;
+  }
+
+ private:
+  static constexpr uint32_t CRC_SEED = 0x9E3779B9;
+  static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+  static constexpr uint64_t SECRET[8] = {0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL,
+                                         0x1f67b3b7a4a44072ULL, 0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL,
+                                         0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL};
+
+  static constexpr std::array<uint32_t, 256> CRC_TABLE = fast_hash_detail::MakeCrcTable();
+
+  template <typename T>
+  static inline auto Read(const void *p) -> T {
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return v;
+  }
+
+  static inline auto Mul128Fold64(uint64_t a, uint64_t b) -> uint64_t {
+    __extension__ using uint128_t = unsigned __int128;
+    uint128_t product = static_cast<uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+  }
+
+  static inline auto Avalanche(uint64_t h) -> uint64_t {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+    return h;
+  }
+
+#ifdef BUSTUB_X86_CRC32C
+  __attribute__((target("sse4.2"))) static inline auto HwCrc32cU32(uint32_t crc, uint32_t data) -> uint32_t {
+    return _mm_crc32_u32(crc, data);
+  }
+  __attribute__((target("sse4.2"))) static inline auto HwCrc32cU64(uint32_t crc, uint64_t data) -> uint32_t {
+    return static_cast<uint32_t>(_mm_crc32_u64(crc, data));
+  }
+  static inline auto DetectHwCrc32c() -> bool {
+    // 静态初始化时 cpu 信息可能还没填好，先手动 init
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") != 0;
+  }
+  static inline const bool HAS_HW_CRC32C = DetectHwCrc32c();
+#endif
+};
+
+}  // namespace bustub
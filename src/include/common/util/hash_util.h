@@ -14,10 +14,12 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
 #include "common/macros.h"
+#include "common/util/fast_hash.h"
 #include "type/value.h"
 
 namespace bustub {
@@ -38,12 +40,7 @@ class HashUtil {
     return hash;
   }
 
-  static inline auto CombineHashes(hash_t l, hash_t r) -> hash_t {
-    hash_t both[2] = {};
-    both[0] = l;
-    both[1] = r;
-    return HashBytes(reinterpret_cast<char *>(both), sizeof(hash_t) * 2);
-  }
+  static inline auto CombineHashes(hash_t l, hash_t r) -> hash_t { return FastHash::Combine(l, r); }
 
   static inline auto SumHashes(hash_t l, hash_t r) -> hash_t {
     return (l % PRIME_FACTOR + r % PRIME_FACTOR) % PRIME_FACTOR;
@@ -61,40 +58,28 @@ class HashUtil {
 
   /** @return the hash of the value */
   static inline auto HashValue(const Value *val) -> hash_t {
+    // 定长类型统一扩成 8 字节走 CRC，变长走 xxh3，都不经过 Type 的虚函数
     switch (val->GetTypeId()) {
-      case TypeId::TINYINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int8_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::SMALLINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int16_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::INTEGER: {
-        auto raw = static_cast<int64_t>(val->GetAs<int32_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::BIGINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int64_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::BOOLEAN: {
-        auto raw = val->GetAs<bool>();
-        return Hash<bool>(&raw);
-      }
+      case TypeId::TINYINT:
+        return FastHash::Hash64(static_cast<int64_t>(val->GetAs<int8_t>()));
+      case TypeId::SMALLINT:
+        return FastHash::Hash64(static_cast<int64_t>(val->GetAs<int16_t>()));
+      case TypeId::INTEGER:
+        return FastHash::Hash64(static_cast<int64_t>(val->GetAs<int32_t>()));
+      case TypeId::BIGINT:
+        return FastHash::Hash64(static_cast<int64_t>(val->GetAs<int64_t>()));
+      case TypeId::BOOLEAN:
+        return FastHash::Hash64(static_cast<uint64_t>(val->GetAs<bool>()));
       case TypeId::DECIMAL: {
         auto raw = val->GetAs<double>();
-        return Hash<double>(&raw);
-      }
-      case TypeId::VARCHAR: {
-        auto raw = val->GetData();
-        auto len = val->GetLength();
-        return HashBytes(raw, len);
-      }
-      case TypeId::TIMESTAMP: {
-        auto raw = val->GetAs<uint64_t>();
-        return Hash<uint64_t>(&raw);
+        uint64_t bits;
+        memcpy(&bits, &raw, sizeof(bits));
+        return FastHash::Hash64(bits);
       }
+      case TypeId::VARCHAR:
+        return FastHash::Xxh3(val->value_.varlen_, val->size_.len_);
+      case TypeId::TIMESTAMP:
+        return FastHash::Hash64(val->GetAs<uint64_t>());
       default: {
         UNIMPLEMENTED("Unsupported type.");
       }
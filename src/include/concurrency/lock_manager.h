@@ -129,6 +129,16 @@ class LockManager {
    */
   auto UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool;
 
+  /**
+   * Wait until the transactions that hold an INTENTION_EXCLUSIVE, SHARED_INTENTION_EXCLUSIVE or
+   * EXCLUSIVE lock on the table right now have released every lock on it. No lock is requested, so
+   * the caller's locks and 2PL state are left alone and writers arriving later are not held up.
+   *
+   * @param oid the table_oid_t of the table to drain
+   * @param txn_id a transaction not to wait for, usually the caller's own; INVALID_TXN_ID for none
+   */
+  auto WaitForTableWriters(const table_oid_t &oid, txn_id_t txn_id) -> void;
+
   /**
    * Acquire a lock on rid in the given lock_mode.
    * If the transaction already holds a lock on the row, upgrade the lock
@@ -99,7 +99,7 @@ class IndexWriteRecord {
   table_oid_t table_oid_;
   /** Write type. */
   WType wtype_;
-  /** The tuple is used to construct an index key. */
+  /** The index key written, already projected to the key schema of the index. */
   Tuple tuple_;
   /** The old tuple is only used for the update operation. */
   Tuple old_tuple_;
@@ -29,7 +29,9 @@ namespace bustub {
 /**
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
- * table grows/shrinks dynamically as buckets become full/empty.
+ * table grows/shrinks dynamically as buckets become full/empty. A full bucket
+ * that splitting cannot help, because its keys hash alike or the directory is
+ * at its largest, grows a chain of overflow pages instead.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class DiskExtendibleHashTable {
@@ -40,9 +42,12 @@ class DiskExtendibleHashTable {
    * @param buffer_pool_manager buffer pool manager to be used
    * @param comparator comparator for keys
    * @param hash_fn the hash function
+   * @param directory_page_id directory of a table already in the database file to reopen, INVALID_PAGE_ID makes a
+   * new one
    */
   explicit DiskExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                   const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
+                                   const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                   page_id_t directory_page_id = INVALID_PAGE_ID);
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -74,6 +79,11 @@ class DiskExtendibleHashTable {
    */
   auto GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
 
+  /**
+   * Returns the directory page id, enough to reopen the table
+   */
+  auto GetDirectoryPageId() const -> page_id_t { return directory_page_id_; }
+
   /**
    * Returns the global depth
    */
@@ -136,6 +146,57 @@ class DiskExtendibleHashTable {
    */
   auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
 
+  /**
+   * Fetches a bucket as a raw page, for callers that need to take the page latch.
+   *
+   * @param bucket_page_id the page_id to fetch
+   * @return a pointer to the pinned page
+   */
+  auto FetchBucket(page_id_t bucket_page_id) -> Page *;
+
+  /**
+   * Inserts into a bucket chain: the bucket page and the overflow pages linked from it, all protected by the latch
+   * (or the pin under the table write latch) the caller holds on the bucket page.
+   *
+   * @param bucket the bucket page at the head of the chain
+   * @param key the key to insert
+   * @param value the value to insert
+   * @param[out] full set if the pair is not in the chain but every page of the chain is full
+   * @return true if inserted, false if the pair is already in the chain or the chain is full
+   */
+  auto ChainInsert(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key, const ValueType &value, bool *full) -> bool;
+
+  /**
+   * Removes a pair from a bucket chain, unlinking and deleting an overflow page it leaves empty.
+   *
+   * @param bucket the bucket page at the head of the chain
+   * @param key the key to remove
+   * @param value the value to remove
+   * @return true if removed, false if not found
+   */
+  auto ChainRemove(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key, const ValueType &value) -> bool;
+
+  /**
+   * @return whether splitting the bucket chain would separate its pairs and the key, i.e. their hashes differ in a
+   * bit between the local depth and the deepest directory
+   */
+  auto CanSplit(page_id_t bucket_page_id, uint32_t local_depth, const KeyType &key) -> bool;
+
+  /**
+   * Links a new overflow page holding the pair to the end of a full bucket chain that cannot be split.
+   *
+   * @return false if the buffer pool has no page to spare
+   */
+  auto AppendOverflowPage(HASH_TABLE_BUCKET_TYPE *bucket, page_id_t bucket_page_id, const KeyType &key,
+                          const ValueType &value) -> bool;
+
+  /**
+   * Moves the pairs of a full bucket chain whose hash has high_bit set to the chain of its new split image. The
+   * overflow pages of the chain are reused for both chains, the ones left over are deleted.
+   */
+  void Redistribute(HASH_TABLE_BUCKET_TYPE *bucket, page_id_t bucket_page_id, HASH_TABLE_BUCKET_TYPE *image,
+                    page_id_t image_page_id, uint32_t high_bit);
+
   /**
    * Performs insertion with an optional bucket splitting.
    *
@@ -148,10 +209,11 @@ class DiskExtendibleHashTable {
 
   /**
    * Optionally merges an empty bucket into it's pair.  This is called by Remove,
-   * if Remove makes a bucket empty.
+   * if Remove makes a bucket empty. The merged bucket is merged again with its
+   * new pair for as long as one of the two is empty.
    *
    * There are three conditions under which we skip the merge:
-   * 1. The bucket is no longer empty.
+   * 1. Neither the bucket nor its split image is empty.
    * 2. The bucket has local depth 0.
    * 3. The bucket's local depth doesn't match its split image's local depth.
    *
@@ -166,7 +228,8 @@ class DiskExtendibleHashTable {
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
+  // Readers includes inserts and removes, writers are splits and merges. Readers latch the single bucket page they
+  // touch (shared for lookups, exclusive for inserts/removes); writers own every bucket through this latch.
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
 };
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
@@ -24,12 +25,18 @@
 
 namespace bustub {
 
-#define HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
+#define LINEAR_PROBE_HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
 
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * Probes hold the latch of one block page at a time and walk the block's
+ * occupied/readable bitmaps 64 slots at a time. Growing is incremental: a
+ * resize only allocates a table with twice the blocks, after which every
+ * insert/remove moves one block of the old table into the new one. Until the
+ * old table is drained, lookups and removes check it before the new table.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable {
@@ -73,31 +80,59 @@ class LinearProbeHashTable {
   auto GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Resizes the table to at least twice the initial size provided. Only the new
+   * blocks are allocated here, the pairs are moved over by later operations.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
 
   /**
    * Gets the size of the hash table
-   * @return current size of the hash table
+   * @return current number of slots in the hash table
    */
   auto GetSize() -> size_t;
 
  private:
-  auto GetHeaderPage() -> HashTableHeaderPage *;
-  auto GetBlockPage(page_id_t block_page_id) -> HASH_TABLE_BLOCK_TYPE *;
-  void ResizeInsert(HashTableHeaderPage *header_page, const KeyType &key, const ValueType &value);
-  void DeleteBlockPages(HashTableHeaderPage *old_header_page);
-  void CreateNewBlockPages(HashTableHeaderPage *header_page, size_t num_blocks);
-  auto GetValueLatchFree(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
+  enum class InsertResult { INSERTED, DUPLICATE, FULL };
+
+  /** Block page_ids and slot count of one table generation, cached from its header page. */
+  struct Generation {
+    page_id_t header_page_id_{INVALID_PAGE_ID};
+    size_t size_{0};
+    std::vector<page_id_t> blocks_;
+  };
+
+  auto GetHeaderPage(page_id_t header_page_id) -> HashTableHeaderPage *;
+  auto GetBlockPage(page_id_t block_page_id) -> Page *;
+
+  /** Allocates a header page and num_blocks zeroed block pages. */
+  auto CreateGeneration(size_t num_blocks) -> Generation;
+  void DeleteBlockPages(const Generation &generation);
+
+  auto GetValueIn(const Generation &generation, const KeyType &key, std::vector<ValueType> *result) -> bool;
+  auto InsertIn(const Generation &generation, const KeyType &key, const ValueType &value) -> InsertResult;
+  auto RemoveIn(const Generation &generation, const KeyType &key, const ValueType &value) -> bool;
+
+  /** Moves the next undrained block of old_ into current_, caller holds table_latch_ shared. */
+  void MigrateStep();
+  /** Drops old_ once every block of it has been moved. */
+  void FinishResize();
+  /** Makes the table at least min_slots slots, draining a resize still in progress first. */
+  auto Grow(size_t min_slots) -> bool;
 
   // member variable
-  page_id_t header_page_id_;
+  Generation current_;
+  // the table being drained while resizing, empty otherwise
+  Generation old_;
+  std::atomic<bool> resizing_{false};
+  std::atomic<size_t> migrate_next_{0};
+  std::atomic<size_t> migrate_done_{0};
+  // live pairs over both generations
+  std::atomic<size_t> num_entries_{0};
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writer is only resize
+  // Readers includes inserts and removes, writer is only starting/finishing a resize
   ReaderWriterLatch table_latch_;
 
   // Hash function
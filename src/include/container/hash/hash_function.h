@@ -12,25 +12,41 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
-#include "murmur3/MurmurHash3.h"
+#include "common/util/fast_hash.h"
 
 namespace bustub {
 
 template <typename KeyType>
 class HashFunction {
  public:
+  HashFunction() = default;
+
+  /**
+   * @param key_length number of leading key bytes that hold data, the rest is zero padding and is not hashed;
+   * 0 means the whole key
+   * @param algorithm the hash family to use
+   */
+  explicit HashFunction(size_t key_length, HashAlgorithm algorithm = HashAlgorithm::Auto)
+      : key_length_(key_length == 0 || key_length > sizeof(KeyType) ? sizeof(KeyType) : key_length),
+        algorithm_(algorithm) {}
+
   /**
    * @param key the key to be hashed
    * @return the hashed value
    */
   virtual auto GetHash(KeyType key) -> uint64_t {
-    uint64_t hash[2];
-    murmur3::MurmurHash3_x64_128(reinterpret_cast<const void *>(&key), static_cast<int>(sizeof(KeyType)), 0,
-                                 reinterpret_cast<void *>(&hash));
-    return hash[0];
+    return FastHash::Hash(reinterpret_cast<const void *>(&key), key_length_, algorithm_);
   }
+
+  /** @return the number of key bytes that are hashed */
+  auto GetKeyLength() const -> size_t { return key_length_; }
+
+ private:
+  size_t key_length_{sizeof(KeyType)};
+  HashAlgorithm algorithm_{HashAlgorithm::Auto};
 };
 
 }  // namespace bustub
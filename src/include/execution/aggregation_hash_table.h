@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_hash_table.h
+//
+// Identification: src/include/execution/aggregation_hash_table.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/util/hash_util.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/spill_file.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * AggregationHashTable groups rows by their group-by values and keeps the
+ * running aggregates of every group.
+ *
+ * COUNT(*), COUNT, and SUM/MIN/MAX over INTEGER or BIGINT input run on
+ * int64_t accumulators without any Value arithmetic. Other aggregates keep a
+ * Value and combine it as before. Groups are split by the top bits of their
+ * hash into 2^AGG_PARTITION_BITS partitions, each a flat open-addressing table
+ * of group indexes. Tables filled by different threads are merged partition
+ * by partition, and a partition can be written out as a run of partial groups
+ * and merged back later, or split further by the next bits of the hash when
+ * it alone does not fit in memory. NULL group-by values form one group.
+ */
+class AggregationHashTable {
+ public:
+  /**
+   * @param agg_types the types of the aggregates
+   * @param key_types the types of the group-by values
+   * @param input_types the types of the aggregate inputs
+   */
+  AggregationHashTable(const std::vector<AggregationType> &agg_types, const std::vector<TypeId> &key_types,
+                       const std::vector<TypeId> &input_types);
+
+  /**
+   * Fold one input row into its group.
+   * @param keys the group-by values, column by column
+   * @param inputs the aggregate inputs, column by column
+   * @param row the row in the columns
+   */
+  void Insert(const std::vector<std::vector<Value>> &keys, const std::vector<std::vector<Value>> &inputs, size_t row);
+
+  /** Fold the groups of one partition of another table into the same partition of this one. */
+  void MergePartition(size_t partition, const AggregationHashTable &other);
+
+  /** Append the groups of a partition to a file as partial groups, rows of partial_schema_. */
+  void SpillPartition(size_t partition, SpillFile *file) const;
+
+  /**
+   * Fold partial groups read back from a spill file into a partition, until the partition takes more than budget bytes.
+   * @return `false` if it stopped early, the rows not merged yet are left in the reader
+   */
+  auto MergeSpilled(size_t partition, SpillFile::Reader *reader, size_t budget = SIZE_MAX) -> bool;
+
+  /**
+   * Append the groups of a partition as partial groups to files[SpillPartitionOf(hash, level)], splitting it by the
+   * next bits of the hash.
+   */
+  void SplitPartition(size_t partition, size_t level, const std::vector<std::unique_ptr<SpillFile>> &files) const;
+
+  /** Split the rest of the partial groups in a reader the same way as SplitPartition(). */
+  void SplitSpilled(SpillFile::Reader *reader, size_t level,
+                    const std::vector<std::unique_ptr<SpillFile>> &files) const;
+
+  /** Remove every group. */
+  void Clear();
+
+  /** Remove the groups of one partition. */
+  void ClearPartition(size_t partition) { partitions_[partition] = Partition{}; }
+
+  /** @return an estimate of the bytes the groups take, checked against the memory budget */
+  auto MemoryUsage() const -> size_t;
+
+  /** @return the number of groups in a partition */
+  auto NumGroups(size_t partition) const -> size_t { return partitions_[partition].hashes_.size(); }
+
+  /** @return the group-by values of a group followed by its aggregates */
+  auto GetGroup(size_t partition, size_t group) const -> std::vector<Value>;
+
+  /** @return the aggregates over no rows at all, the answer of an aggregation without GROUP BY on empty input */
+  auto InitialAggregates() const -> std::vector<Value>;
+
+  static constexpr size_t NUM_PARTITIONS = size_t{1} << AGG_PARTITION_BITS;
+
+  /** @return the sub-partition of a group split at a level >= 1, the SPILL_PARTITION_BITS below the previous level */
+  static auto SpillPartitionOf(hash_t hash, size_t level) -> size_t {
+    auto shift = 64 - AGG_PARTITION_BITS - level * SPILL_PARTITION_BITS;
+    return (hash >> shift) & ((size_t{1} << SPILL_PARTITION_BITS) - 1);
+  }
+
+ private:
+  struct Partition {
+    /** Slot i holds a group index + 1, 0 marks an empty slot. The size is a power of two. */
+    std::vector<uint32_t> slots_;
+    std::vector<hash_t> hashes_;
+    /** The group-by values of group g are keys_[g * num_keys_, (g + 1) * num_keys_) */
+    std::vector<Value> keys_;
+    /** The int64_t accumulators of group g, with whether each has seen a value yet */
+    std::vector<int64_t> typed_;
+    std::vector<uint8_t> valid_;
+    /** The Value accumulators of group g */
+    std::vector<Value> values_;
+    size_t bytes_{0};
+  };
+
+  /** @return the group of a key in a partition, created with initial aggregates if missing */
+  template <typename KeyAt>
+  auto FindOrCreate(Partition *partition, hash_t hash, KeyAt key_at) -> size_t;
+  void Grow(Partition *partition);
+  /** Fold input into accumulator i of a group. */
+  void Update(Partition *partition, size_t group, size_t i, const Value &input);
+  /** Fold a typed accumulator of another group into accumulator i of a group. */
+  void MergeTyped(Partition *partition, size_t group, size_t i, int64_t value, bool valid);
+  /** Fold a Value accumulator of another group into accumulator i of a group. */
+  void MergeValue(Partition *partition, size_t group, size_t i, const Value &value);
+  /** @return a group as a row of partial_schema_ */
+  auto PartialGroup(const Partition &partition, size_t group) const -> Tuple;
+  /** @return the group-by values and the hash of a row of partial_schema_ */
+  auto ReadPartial(const Tuple &tuple, std::vector<Value> *values) const -> hash_t;
+  /** @return the final Value of accumulator i of a group */
+  auto Finalize(const Partition &partition, size_t group, size_t i) const -> Value;
+
+  static auto PartitionOf(hash_t hash) -> size_t { return hash >> (64 - AGG_PARTITION_BITS); }
+
+  std::vector<AggregationType> agg_types_;
+  std::vector<TypeId> input_types_;
+  size_t num_keys_;
+  /** Whether aggregate i runs on an int64_t accumulator, and its index among the typed or the Value ones */
+  std::vector<bool> typed_;
+  std::vector<size_t> slot_of_;
+  size_t num_typed_{0};
+  size_t num_values_{0};
+  /** A spilled group: the group-by values, then a BIGINT per typed accumulator and the Value per other one */
+  Schema partial_schema_;
+  std::vector<Partition> partitions_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// exchange.h
+//
+// Identification: src/include/execution/exchange.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TupleExchange moves tuples from several producer threads to one consumer.
+ *
+ * Producers push whole chunks of tuples, so the latch is taken once per chunk
+ * rather than once per tuple. The queue is bounded: a producer that gets too
+ * far ahead of the consumer blocks in Push() until the consumer catches up.
+ */
+class TupleExchange {
+ public:
+  using Chunk = std::vector<std::pair<Tuple, RID>>;
+
+  /**
+   * @param producers the number of producers, each must call ProducerDone() exactly once
+   * @param max_chunks the number of chunks that may wait in the queue
+   */
+  TupleExchange(size_t producers, size_t max_chunks);
+
+  /**
+   * Hand a chunk to the consumer, blocking while the queue is full.
+   * @return `false` if the consumer has closed the exchange, the producer should stop
+   */
+  auto Push(Chunk &&chunk) -> bool;
+
+  /**
+   * Report that a producer has finished.
+   * @param error the exception that stopped the producer, rethrown to the consumer
+   */
+  void ProducerDone(std::exception_ptr error = nullptr);
+
+  /**
+   * Take the next chunk, blocking until one arrives. Rethrows the first producer error.
+   * @return `false` once every producer is done and the queue is drained
+   */
+  auto Pop(Chunk *chunk) -> bool;
+
+  /** Stop accepting chunks and wake up blocked producers, for a consumer that stops early. */
+  void Close();
+
+ private:
+  std::mutex latch_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<Chunk> chunks_;
+  size_t max_chunks_;
+  size_t running_producers_;
+  bool closed_{false};
+  std::exception_ptr error_;
+};
+
+/**
+ * PartitionedExchange collects the tuples that the copies of one pipeline route
+ * to a fixed number of partitions. Once that pipeline has finished, the copies
+ * of the next pipeline claim whole partitions, so each partition is read by
+ * exactly one consumer.
+ */
+class PartitionedExchange {
+ public:
+  explicit PartitionedExchange(size_t num_partitions);
+
+  /** @return the number of partitions */
+  auto NumPartitions() const -> size_t { return partitions_.size(); }
+
+  /**
+   * Append tuples to a partition.
+   * @param[in,out] tuples the tuples to append, left empty
+   */
+  void Push(size_t partition, std::vector<Tuple> *tuples);
+
+  /**
+   * Claim the next partition that no consumer has taken yet.
+   * @param[out] tuples the tuples of the partition
+   * @return `false` if every partition has been claimed
+   */
+  auto NextPartition(std::vector<Tuple> *tuples) -> bool;
+
+ private:
+  struct Partition {
+    std::mutex latch_;
+    std::vector<Tuple> tuples_;
+  };
+
+  std::vector<std::unique_ptr<Partition>> partitions_;
+  std::atomic<size_t> next_partition_{0};
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
@@ -48,12 +49,14 @@ class ExecutionEngine {
    * @param result_set The set of tuples produced by executing the plan
    * @param txn The transaction context in which the query executes
    * @param exec_ctx The executor context in which the query executes
+   * @param scan_parallelism The number of worker threads each sequential scan of the query may use
    * @return `true` if execution of the query plan succeeds, `false` otherwise
    */
   // NOLINTNEXTLINE
   auto Execute(const AbstractPlanNodeRef &plan, std::vector<Tuple> *result_set, Transaction *txn,
-               ExecutorContext *exec_ctx) -> bool {
+               ExecutorContext *exec_ctx, size_t scan_parallelism = 1) -> bool {
     BUSTUB_ASSERT((txn == exec_ctx->GetTransaction()), "Broken Invariant");
+    exec_ctx->SetScanParallelism(std::max<size_t>(scan_parallelism, 1));
 
     // Construct the executor for the abstract plan node
     auto executor = ExecutorFactory::CreateExecutor(exec_ctx, plan);
@@ -87,13 +90,26 @@ class ExecutionEngine {
 
  private:
   /**
-   * Poll the executor until exhausted, or exception escapes.
+   * Poll the executor until exhausted, or exception escapes. Batches are pulled
+   * instead of single tuples when every executor in the tree supports them.
    * @param executor The root executor
    * @param plan The plan to execute
    * @param result_set The tuple result set
    */
   static void PollExecutor(AbstractExecutor *executor, const AbstractPlanNodeRef &plan,
                            std::vector<Tuple> *result_set) {
+    if (executor->SupportsBatch()) {
+      TupleBatch batch(&plan->OutputSchema());
+      while (executor->NextBatch(&batch)) {
+        if (result_set == nullptr) {
+          continue;
+        }
+        for (size_t i = 0; i < batch.Size(); i++) {
+          result_set->push_back(batch.MaterializeTuple(batch.SelectedRow(i)));
+        }
+      }
+      return;
+    }
     RID rid{};
     Tuple tuple{};
     while (executor->Next(&tuple, &rid)) {
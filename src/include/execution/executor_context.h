@@ -12,8 +12,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <deque>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -22,10 +26,48 @@
 #include "concurrency/transaction.h"
 #include "execution/check_options.h"
 #include "execution/executors/abstract_executor.h"
+#include "fmt/format.h"
 #include "storage/page/tmp_tuple_page.h"
 
 namespace bustub {
 class AbstractExecutor;
+class AbstractPlanNode;
+class TaskScheduler;
+
+/** What an operator reports to EXPLAIN ANALYZE, summed over the parallel copies of its plan node. */
+struct OperatorStats {
+  /** Bytes and rows written to spill files */
+  std::atomic<size_t> spilled_bytes_{0};
+  std::atomic<size_t> spilled_rows_{0};
+  /** Spill partitions written, counting the ones made by repartitioning */
+  std::atomic<size_t> spill_partitions_{0};
+  /** The deepest level of recursive repartitioning, 1 if the operator spilled without repartitioning */
+  std::atomic<size_t> spill_depth_{0};
+  /** The bytes of the Bloom filter a hash join pushed into its probe-side scan, and the probe rows it dropped there */
+  std::atomic<size_t> bloom_filter_bytes_{0};
+  std::atomic<size_t> bloom_filtered_rows_{0};
+
+  void RecordSpillDepth(size_t depth) {
+    auto current = spill_depth_.load();
+    while (current < depth && !spill_depth_.compare_exchange_weak(current, depth)) {
+    }
+  }
+
+  auto ToString() const -> std::string {
+    std::vector<std::string> parts;
+    if (spill_depth_ > 0) {
+      parts.push_back(fmt::format("spilled_bytes={}, spilled_rows={}, spill_partitions={}, spill_depth={}",
+                                  spilled_bytes_.load(), spilled_rows_.load(), spill_partitions_.load(),
+                                  spill_depth_.load()));
+    }
+    if (bloom_filter_bytes_ > 0) {
+      parts.push_back(fmt::format("bloom_filter_bytes={}, bloom_filtered_rows={}", bloom_filter_bytes_.load(),
+                                  bloom_filtered_rows_.load()));
+    }
+    return fmt::format("{}", fmt::join(parts, ", "));
+  }
+};
+
 /**
  * ExecutorContext stores all the context necessary to run an executor.
  */
@@ -92,6 +134,58 @@ class ExecutorContext {
   }
   auto IsDelete() const -> bool { return is_delete_; }
 
+  /** @return the number of worker threads a sequential scan may use, 1 scans on the calling thread */
+  auto GetScanParallelism() const -> size_t { return scan_parallelism_; }
+
+  void SetScanParallelism(size_t scan_parallelism) { scan_parallelism_ = scan_parallelism; }
+
+  /** @return the scheduler that runs parallel pipelines, nullptr runs them on the calling thread */
+  auto GetTaskScheduler() const -> TaskScheduler * { return task_scheduler_; }
+
+  void SetTaskScheduler(TaskScheduler *task_scheduler) { task_scheduler_ = task_scheduler; }
+
+  /** @return the bytes of memory one operator may hold before it spills to temporary pages */
+  auto GetMemoryBudget() const -> size_t { return memory_budget_; }
+
+  void SetMemoryBudget(size_t memory_budget) { memory_budget_ = memory_budget; }
+
+  /** @return the statistics of the operators of a plan node, created on first use */
+  auto GetOperatorStats(const AbstractPlanNode *plan) -> OperatorStats * {
+    std::scoped_lock lock(shared_state_latch_);
+    auto &stats = operator_stats_[plan];
+    if (stats == nullptr) {
+      stats = std::make_unique<OperatorStats>();
+    }
+    return stats.get();
+  }
+
+  /** @return the statistics of a plan node, nullptr if its operators reported none */
+  auto FindOperatorStats(const AbstractPlanNode *plan) -> const OperatorStats * {
+    std::scoped_lock lock(shared_state_latch_);
+    auto it = operator_stats_.find(plan);
+    return it == operator_stats_.end() ? nullptr : it->second.get();
+  }
+
+  /** @return the latch that makes checking and taking a table lock atomic for the threads of this query */
+  auto GetTableLockLatch() -> std::mutex & { return table_lock_latch_; }
+
+  /**
+   * Publish the state the parallel copies of a plan node share, such as a morsel
+   * cursor or a hash table built once, replacing any earlier state of the node.
+   */
+  void SetSharedState(const AbstractPlanNode *plan, std::shared_ptr<void> state) {
+    std::scoped_lock lock(shared_state_latch_);
+    shared_states_[plan] = std::move(state);
+  }
+
+  /** @return the state shared by the parallel copies of the plan node, nullptr if the node runs serially */
+  template <typename T>
+  auto GetSharedState(const AbstractPlanNode *plan) -> std::shared_ptr<T> {
+    std::scoped_lock lock(shared_state_latch_);
+    auto it = shared_states_.find(plan);
+    return it == shared_states_.end() ? nullptr : std::static_pointer_cast<T>(it->second);
+  }
+
  private:
   /** The transaction context associated with this executor context */
   Transaction *transaction_;
@@ -108,6 +202,17 @@ class ExecutorContext {
   /** The set of check options associated with this executor context */
   std::shared_ptr<CheckOptions> check_options_;
   bool is_delete_;
+  /** The degree of parallelism of sequential scans in this query */
+  size_t scan_parallelism_{1};
+  /** The scheduler of parallel pipelines, owned by the BusTub instance */
+  TaskScheduler *task_scheduler_{nullptr};
+  /** The memory budget of each operator of this query */
+  size_t memory_budget_{OPERATOR_MEMORY_BUDGET};
+  std::mutex table_lock_latch_;
+  /** The state shared by the copies of parallel pipelines, keyed by plan node */
+  std::mutex shared_state_latch_;
+  std::unordered_map<const AbstractPlanNode *, std::shared_ptr<void>> shared_states_;
+  std::unordered_map<const AbstractPlanNode *, std::unique_ptr<OperatorStats>> operator_stats_;
 };
 
 }  // namespace bustub
@@ -13,14 +13,20 @@
 #pragma once
 
 #include "execution/executor_context.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 class ExecutorContext;
+struct JoinFilter;
 /**
  * The AbstractExecutor implements the Volcano tuple-at-a-time iterator model.
  * This is the base class from which all executors in the BustTub execution
  * engine inherit, and defines the minimal interface that all executors support.
+ *
+ * Executors may also hand out rows a batch at a time through NextBatch().
+ * Between two Init() calls a consumer uses either Next() or NextBatch(),
+ * never both.
  */
 class AbstractExecutor {
  public:
@@ -47,6 +53,32 @@ class AbstractExecutor {
    */
   virtual auto Next(Tuple *tuple, RID *rid) -> bool = 0;
 
+  /**
+   * Yield the next batch of tuples. This default adapter fills the batch by
+   * calling Next(); executors that process whole batches override it.
+   * @param[out] batch Cleared, then filled with up to batch->Capacity() rows laid out by GetOutputSchema()
+   * @return `true` if the batch holds at least one selected row, `false` if there are no more tuples
+   */
+  virtual auto NextBatch(TupleBatch *batch) -> bool {
+    batch->Reset();
+    Tuple tuple{};
+    RID rid{};
+    while (!batch->IsFull() && Next(&tuple, &rid)) {
+      batch->AppendTuple(tuple, rid);
+    }
+    return batch->Size() > 0;
+  }
+
+  /** @return `true` if this executor and all of its children implement NextBatch() natively */
+  virtual auto SupportsBatch() const -> bool { return false; }
+
+  /**
+   * Offer a join filter the rows of this executor must pass to be of any use to its consumer, an inner hash join.
+   * The filter is filled in before Init() is called and stays valid until the next Init().
+   * @return `true` if the executor took the filter and drops the rows that fail it itself
+   */
+  virtual auto PushDownJoinFilter(const JoinFilter *filter) -> bool { return false; }
+
   /** @return The schema of the tuples that this executor produces */
   virtual auto GetOutputSchema() const -> const Schema & = 0;
 
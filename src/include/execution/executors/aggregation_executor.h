@@ -13,12 +13,11 @@
 #pragma once
 
 #include <memory>
-#include <unordered_map>
+#include <mutex>  // NOLINT
 #include <utility>
 #include <vector>
 
-#include "common/util/hash_util.h"
-#include "container/hash/hash_function.h"
+#include "execution/aggregation_hash_table.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
@@ -28,143 +27,6 @@
 
 namespace bustub {
 
-/**
- * A simplified hash table that has all the necessary functionality for aggregations.
- */
-class SimpleAggregationHashTable {
- public:
-  /**
-   * Construct a new SimpleAggregationHashTable instance.
-   * @param agg_exprs the aggregation expressions
-   * @param agg_types the types of aggregations
-   */
-  SimpleAggregationHashTable(const std::vector<AbstractExpressionRef> &agg_exprs,
-                             const std::vector<AggregationType> &agg_types)
-      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {}
-
-  /** @return The initial aggregate value for this aggregation executor */
-  auto GenerateInitialAggregateValue() -> AggregateValue {
-    std::vector<Value> values{};
-    for (const auto &agg_type : agg_types_) {
-      switch (agg_type) {
-        case AggregationType::CountStarAggregate:
-          // Count start starts at zero.
-          values.emplace_back(ValueFactory::GetIntegerValue(0));
-          break;
-        case AggregationType::CountAggregate:
-        case AggregationType::SumAggregate:
-        case AggregationType::MinAggregate:
-        case AggregationType::MaxAggregate:
-          // Others starts at null.
-          values.emplace_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
-          break;
-      }
-    }
-    return {values};
-  }
-
-  /**
-   * TODO(Student)
-   *
-   * Combines the input into the aggregation result.
-   * @param[out] result The output aggregate value
-   * @param input The input value
-   */
-  void CombineAggregateValues(AggregateValue *result, const AggregateValue &input) {
-    for (uint32_t i = 0; i < agg_exprs_.size(); i++) {
-      Value &cur = result->aggregates_[i];
-      const Value &now = input.aggregates_[i];
-      if (agg_types_[i] == AggregationType::CountStarAggregate) {
-        cur = cur.Add({TypeId::INTEGER, 1});
-        continue;
-      }
-      if (now.IsNull()) {
-        continue;
-      }
-      if (cur.IsNull()) {
-        cur = agg_types_[i] == AggregationType::CountAggregate ? Value{TypeId::INTEGER, 1} : now;
-        continue;
-      }
-      switch (agg_types_[i]) {
-        case AggregationType::CountAggregate:
-          cur = cur.Add({TypeId::INTEGER, 1});
-          break;
-        case AggregationType::SumAggregate:
-          cur = cur.Add(now);
-          break;
-        case AggregationType::MinAggregate:
-          cur = cur.Min(now);
-          break;
-        case AggregationType::MaxAggregate:
-          cur = cur.Max(now);
-          break;
-        default:
-          break;
-      }
-    }
-  }
-
-  /**
-   * Inserts a value into the hash table and then combines it with the current aggregation.
-   * @param agg_key the key to be inserted
-   * @param agg_val the value to be inserted
-   */
-  void InsertCombine(const AggregateKey &agg_key, const AggregateValue &agg_val) {
-    if (ht_.count(agg_key) == 0) {
-      ht_.insert({agg_key, GenerateInitialAggregateValue()});
-    }
-    CombineAggregateValues(&ht_[agg_key], agg_val);
-  }
-
-  /**
-   * Clear the hash table
-   */
-  void Clear() { ht_.clear(); }
-
-  /** An iterator over the aggregation hash table */
-  class Iterator {
-   public:
-    /** Creates an iterator for the aggregate map. */
-    explicit Iterator(std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter) : iter_{iter} {}
-
-    /** @return The key of the iterator */
-    auto Key() -> const AggregateKey & { return iter_->first; }
-
-    /** @return The value of the iterator */
-    auto Val() -> const AggregateValue & { return iter_->second; }
-
-    /** @return The iterator before it is incremented */
-    auto operator++() -> Iterator & {
-      ++iter_;
-      return *this;
-    }
-
-    /** @return `true` if both iterators are identical */
-    auto operator==(const Iterator &other) -> bool { return this->iter_ == other.iter_; }
-
-    /** @return `true` if both iterators are different */
-    auto operator!=(const Iterator &other) -> bool { return this->iter_ != other.iter_; }
-
-   private:
-    /** Aggregates map */
-    std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter_;
-  };
-
-  /** @return Iterator to the start of the hash table */
-  auto Begin() -> Iterator { return Iterator{ht_.cbegin()}; }
-
-  /** @return Iterator to the end of the hash table */
-  auto End() -> Iterator { return Iterator{ht_.cend()}; }
-
- private:
-  /** The hash table is just a map from aggregate keys to aggregate values */
-  std::unordered_map<AggregateKey, AggregateValue> ht_{};
-  /** The aggregate expressions that we have */
-  const std::vector<AbstractExpressionRef> &agg_exprs_;
-  /** The types of aggregations that we have */
-  const std::vector<AggregationType> &agg_types_;
-};
-
 /**
  * AggregationExecutor executes an aggregation operation (e.g. COUNT, SUM, MIN, MAX)
  * over the tuples produced by a child executor.
@@ -191,6 +53,11 @@ class AggregationExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /** Emit up to a batch of groups from the aggregation hash table. */
+  auto NextBatch(TupleBatch *batch) -> bool override;
+
+  auto SupportsBatch() const -> bool override { return child_->SupportsBatch(); }
+
   /** @return The output schema for the aggregation */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
@@ -198,33 +65,62 @@ class AggregationExecutor : public AbstractExecutor {
   auto GetChildExecutor() const -> const AbstractExecutor *;
 
  private:
-  /** @return The tuple as an AggregateKey */
-  auto MakeAggregateKey(const Tuple *tuple) -> AggregateKey {
-    std::vector<Value> keys;
-    for (const auto &expr : plan_->GetGroupBys()) {
-      keys.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
-    }
-    return {keys};
-  }
+  /** The group-by values and aggregate inputs of up to a batch of rows, evaluated column by column */
+  struct Chunk {
+    std::vector<std::vector<Value>> keys_;
+    std::vector<std::vector<Value>> inputs_;
+    size_t rows_{0};
+  };
 
-  /** @return The tuple as an AggregateValue */
-  auto MakeAggregateValue(const Tuple *tuple) -> AggregateValue {
-    std::vector<Value> vals;
-    for (const auto &expr : plan_->GetAggregates()) {
-      vals.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
-    }
-    return {vals};
-  }
+  /** A partition, or a piece of it split at level_ >= 1, with the partial groups of it that were spilled */
+  struct PartitionTask {
+    size_t partition_;
+    std::unique_ptr<SpillFile> file_;
+    size_t level_;
+  };
+
+  /** Read the next rows of the child into a chunk, @return `false` once the child is exhausted */
+  auto NextChunk(Chunk *chunk) -> bool;
+  /** @return a pre-aggregation table no other worker is using, created if all are busy */
+  auto AcquireTable() -> AggregationHashTable *;
+  void ReleaseTable(AggregationHashTable *table);
+  /** Move the groups of every pre-aggregation table out to the spill files, one file per partition */
+  void SpillTables(TaskScheduler *scheduler);
+  /** Finish the spill files and queue a task per partition, aht_ starts out empty unless it can take the only table */
+  void QueuePartitions();
+  /**
+   * Free the partition emitted last and merge the next queued one into aht_, from the pre-aggregation tables and its
+   * spill file. A partition that outgrows the memory budget is split into spill files again and queued in pieces.
+   * @return `false` once no partition is left
+   */
+  auto LoadPartition() -> bool;
+  void RecordSpill(const std::vector<std::unique_ptr<SpillFile>> &files, size_t level);
+  /** @return the next output row, group-by values then aggregates */
+  auto NextGroup(std::vector<Value> *values) -> bool;
 
- private:
   /** The aggregation plan node */
   const AggregationPlanNode *plan_;
   /** The child executor that produces tuples over which the aggregation is computed */
   std::unique_ptr<AbstractExecutor> child_;
-  /** Simple aggregation hash table */
-  SimpleAggregationHashTable aht_;
-  /** Simple aggregation hash table iterator */
-  SimpleAggregationHashTable::Iterator aht_iterator_;
-  int num_of_tuples_;
+  std::vector<TypeId> key_types_;
+  std::vector<TypeId> input_types_;
+  /** The batch read from a batch-capable child */
+  std::unique_ptr<TupleBatch> batch_;
+  /** The tables the workers pre-aggregate into, each used by one worker at a time */
+  std::vector<std::unique_ptr<AggregationHashTable>> tables_;
+  std::vector<AggregationHashTable *> idle_tables_;
+  std::mutex tables_mutex_;
+  /** Partial groups moved out of memory, one file per partition of the tables */
+  std::vector<std::unique_ptr<SpillFile>> spill_files_;
+  /** The partitions left to emit, the next one at the back */
+  std::vector<PartitionTask> tasks_;
+  /** The final groups of the partition being emitted */
+  std::unique_ptr<AggregationHashTable> aht_;
+  /** The partition being emitted and the position of its next group */
+  size_t partition_{0};
+  size_t group_{0};
+  bool loaded_{false};
+  /** Whether to emit the initial aggregates, for an aggregation without GROUP BY over no rows */
+  bool emit_initial_{false};
 };
 }  // namespace bustub
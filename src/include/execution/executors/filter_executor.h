@@ -48,6 +48,16 @@ class FilterExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /** Pull child batches and narrow their selection to the rows that pass the predicate. */
+  auto NextBatch(TupleBatch *batch) -> bool override;
+
+  auto SupportsBatch() const -> bool override { return child_executor_->SupportsBatch(); }
+
+  /** A filter keeps the rows of its child as they are, so a join filter can be checked below it. */
+  auto PushDownJoinFilter(const JoinFilter *filter) -> bool override {
+    return child_executor_->PushDownJoinFilter(filter);
+  }
+
   /** @return The output schema for the filter plan */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// gather_executor.h
+//
+// Identification: src/include/execution/executors/gather_executor.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "execution/exchange.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/gather_plan.h"
+#include "execution/plans/repartition_plan.h"
+#include "execution/task_scheduler.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * The GatherExecutor runs a pipeline as parallel copies on the TaskScheduler
+ * and merges their output.
+ *
+ * On Init it publishes the state the copies share in the executor context: a
+ * morsel cursor for the scan at the bottom of the pipeline, one hash table per
+ * join, and one PartitionedExchange per Repartition. The pipeline is then run
+ * stage by stage. The copies of the part below each Repartition, bottom-up,
+ * run to completion and route their rows into its partitions. Finally the
+ * copies of the whole pipeline push their rows to this executor through a
+ * TupleExchange. Since a stage never waits for another task of the same
+ * stage, any number of worker threads can run any parallelism.
+ *
+ * Without a scheduler a single copy of the pipeline runs on the calling thread.
+ */
+class GatherExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new GatherExecutor instance. The copies of the pipeline are created on the first Init.
+   * @param exec_ctx The executor context
+   * @param plan The gather plan to be executed
+   */
+  GatherExecutor(ExecutorContext *exec_ctx, const GatherPlanNode *plan);
+
+  /** Stop the pipeline copies that are still running */
+  ~GatherExecutor() override;
+
+  /** Initialize the gather, running every stage but the last */
+  void Init() override;
+
+  /**
+   * Yield the next tuple produced by any copy of the pipeline.
+   * @param[out] tuple The next tuple
+   * @param[out] rid The next tuple RID
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema for the gather plan */
+  auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
+
+ private:
+  /** Publish fresh shared state for the nodes along the pipeline and collect its Repartitions. */
+  void PublishSharedState();
+
+  /** Run the copies of the stage below breakers_[stage] and wait for them. */
+  void RunBreakerStage(size_t stage);
+
+  /** Start the copies of the whole pipeline. */
+  void StartOutputStage();
+
+  /** Close the exchange and wait for the output copies. */
+  void StopOutputStage();
+
+  /** The body of an output task: run one copy and push its rows to the exchange. */
+  void OutputWorker(AbstractExecutor *copy);
+
+  /** The gather plan node to be executed */
+  const GatherPlanNode *plan_;
+
+  /** The number of copies of each stage */
+  size_t parallelism_;
+
+  /** The Repartition nodes of the pipeline, bottom-up, and the copies of the stage below each */
+  std::vector<const RepartitionPlanNode *> breakers_;
+  std::vector<std::vector<std::unique_ptr<AbstractExecutor>>> stage_copies_;
+
+  /** The copies of the whole pipeline, the tasks running them and the exchange they fill */
+  std::vector<std::unique_ptr<AbstractExecutor>> output_copies_;
+  std::unique_ptr<TaskGroup> output_tasks_;
+  std::unique_ptr<TupleExchange> exchange_;
+  std::atomic<bool> cancelled_{false};
+  TupleExchange::Chunk chunk_;
+  size_t chunk_pos_{0};
+};
+}  // namespace bustub
@@ -12,60 +12,44 @@
 
 #pragma once
 
-#include <functional>
 #include <memory>
-#include <unordered_map>
-#include <unordered_set>
+#include <mutex>  // NOLINT
 #include <utility>
 #include <vector>
 
-#include "common/util/hash_util.h"
-#include "container/hash/hash_function.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/join_filter.h"
+#include "execution/join_hash_table.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/spill_file.h"
 #include "storage/table/tuple.h"
-namespace bustub {
-struct HashKey {
-  /** The group-by values */
-  std::vector<Value> hash_;
 
-  /**
-   * Compares two aggregate keys for equality.
-   * @param other the other aggregate key to be compared with
-   * @return `true` if both aggregate keys have equivalent group-by expressions, `false` otherwise
-   */
-  auto operator==(const HashKey &other) const -> bool {
-    for (uint32_t i = 0; i < other.hash_.size(); i++) {
-      if (hash_[i].CompareEquals(other.hash_[i]) != CmpBool::CmpTrue) {
-        return false;
-      }
-    }
-    return true;
-  }
-};
-}  // namespace bustub
-namespace std {
-/** Implements std::hash on JoinKey */
-template <>
-struct hash<bustub::HashKey> {
-  auto operator()(const bustub::HashKey &join_key) const -> std::size_t {
-    size_t curr_hash = 0;
-    for (const auto &key : join_key.hash_) {
-      if (!key.IsNull()) {
-        curr_hash = bustub::HashUtil::CombineHashes(curr_hash, bustub::HashUtil::HashValue(&key));
-      }
-    }
-    return curr_hash;
-  }
-};
-}  // namespace std
 namespace bustub {
-struct TupleBucket {
-  std::vector<Tuple> tuple_bucket_;
+
+/** The hash table of a join inside a parallel pipeline, built once and probed by every copy of the pipeline. */
+struct HashJoinBuildState {
+  std::once_flag built_;
+  JoinHashTable table_;
+  /** The build rows by spill partition if they overflowed the memory budget, empty if table_ holds them */
+  std::vector<std::unique_ptr<SpillFile>> spilled_;
+  JoinFilter filter_;
 };
+
 /**
- * HashJoinExecutor executes a nested-loop JOIN on two tables.
+ * HashJoinExecutor executes a hash JOIN on two tables, building the hash table
+ * from the right child and probing it with the left child.
+ *
+ * When the build side outgrows the memory budget of the operator, it turns
+ * into a Grace hash join: both sides are split by key hash into spill
+ * partitions on temporary pages, and the partitions are joined one at a time.
+ * A partition that still does not fit is split again with the next bits of
+ * the hash, up to MAX_SPILL_DEPTH levels.
+ *
+ * An inner join also fills a Bloom filter with the build keys and pushes it
+ * into the left child. If the left child is a sequential scan, possibly under
+ * filters, the scan drops the probe rows that cannot match, so they are never
+ * passed up, probed or spilled.
  */
 class HashJoinExecutor : public AbstractExecutor {
  public:
@@ -90,44 +74,81 @@ class HashJoinExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /**
+   * Probe the hash table with a whole batch of left tuples, the join keys of
+   * the batch are evaluated column by column. Rows come out in the same order as Next().
+   */
+  auto NextBatch(TupleBatch *batch) -> bool override;
+
+  auto SupportsBatch() const -> bool override {
+    return left_executor_->SupportsBatch() && right_executor_->SupportsBatch();
+  }
+
   /** @return The output schema for the join */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
-  void OutputTuple(const Schema &left_table_schema, const Schema &right_table_schema, Tuple *left_tuple_,
-                   Tuple *right_tuple_, Tuple *tuple, bool matched);
-  auto InsertMap(HashKey &hash, Tuple &tuple) {
-    if (ma_.count(hash) != 0U) {
-      ma_[hash].tuple_bucket_.emplace_back(tuple);
-      return;
-    }
-    ma_[hash] = TupleBucket{{tuple}};
-  }
-  auto FindHash(HashKey &hash) -> std::optional<std::vector<Tuple>> {
-    if (ma_.count(hash) != 0U) {
-      return ma_[hash].tuple_bucket_;
-    }
-    return std::nullopt;
-  }
-  auto GetHashKey(const HashJoinPlanNode *plan, const std::vector<AbstractExpressionRef> &res, Tuple &tuple)
-      -> HashKey {
-    HashKey tmpp;
-    for (auto &x : res) {
-      auto key = x->Evaluate(&tuple, plan->OutputSchema());
-      tmpp.hash_.emplace_back(key);
-    }
-    return tmpp;
-  }
+  /**
+   * Drain the right child into ht_ and build it, or into spill partitions if it does not fit. An inner join fills
+   * the join filter with the hashes of the build keys as well.
+   */
+  void BuildHashTable();
+  void OutputTuple(const Schema &left_table_schema, const Schema &right_table_schema, const Tuple *left_tuple,
+                   const Tuple *right_tuple, Tuple *tuple, bool matched);
 
  private:
+  /** A build spill partition and the probe rows that hash to it, joined once the probe side is partitioned */
+  struct SpillTask {
+    const SpillFile *build_;
+    const SpillFile *probe_;
+    size_t level_;
+  };
+
+  /** @return the next probe row, from the left child, or from the spill partitions one after another */
+  auto NextLeft(Tuple *tuple) -> bool;
+  /** Write the whole left child to spill partitions and queue a task per partition. */
+  void PartitionProbeSide();
+  /** Load the build rows of the next queued partition into spill_table_, splitting it if it does not fit. */
+  auto LoadSpillPartition() -> bool;
+  void Repartition(const SpillTask &task);
+  void MakeSpillFiles(std::vector<std::unique_ptr<SpillFile>> *files);
+  void RecordSpill(const std::vector<std::unique_ptr<SpillFile>> &files, size_t level, bool build_side);
+  static auto JoinKey(const std::vector<AbstractExpressionRef> &exprs, const Tuple &tuple, const Schema &schema)
+      -> std::vector<Value>;
+
   /** The NestedLoopJoin plan node to be executed. */
   const HashJoinPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> left_executor_;
   std::unique_ptr<AbstractExecutor> right_executor_;
-  std::unordered_map<HashKey, TupleBucket> ma_;
-  int cur_size_ = 0;
-  bool flag_ = false;
-  Tuple tuplee_;
-  std::optional<std::vector<Tuple>> tmp_;
+  JoinHashTable own_table_;
+  /** The table probed, own_table_, the table shared by the copies of a parallel pipeline, or spill_table_ */
+  JoinHashTable *ht_{&own_table_};
+  std::vector<std::unique_ptr<SpillFile>> own_spilled_;
+  /** The build spill partitions, own_spilled_ or those shared by the copies of a parallel pipeline */
+  std::vector<std::unique_ptr<SpillFile>> *spilled_{&own_spilled_};
+  JoinFilter own_filter_;
+  /** The filter pushed into the left child, own_filter_ or the one shared by the copies of a parallel pipeline */
+  JoinFilter *filter_{&own_filter_};
+
+  /** Spilled mode: the partitions left to join, the files this executor wrote and the partition being probed */
+  std::vector<SpillTask> spill_tasks_;
+  std::vector<std::unique_ptr<SpillFile>> spill_files_;
+  JoinHashTable spill_table_;
+  std::unique_ptr<SpillFile::Reader> probe_reader_;
+  bool probe_partitioned_{false};
+
+  /** Tuple mode: the current left tuple, its join key and the build rows left to match it with */
   Tuple left_;
+  std::vector<Value> left_key_;
+  JoinHashTable::Matches matches_;
+  bool has_left_{false};
+  bool left_matched_{false};
+
+  /** Batch mode: the current left batch, its join keys and how far it has been probed */
+  std::unique_ptr<TupleBatch> left_batch_;
+  std::vector<std::vector<Value>> left_keys_;
+  size_t left_pos_{0};
+  bool probed_{false};
+  /** The next match of the current left row, not yet output because the batch filled up */
+  const Tuple *pending_{nullptr};
 };
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #include "common/rid.h"
@@ -42,10 +43,41 @@ class IndexScanExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  /**
+   * Build the index key for a bound on the first key column. The remaining key
+   * columns are filled with the highest encoding when pad_max is set and the
+   * lowest otherwise, so that keys with NULLs in those columns stay in range.
+   */
+  auto MakeBoundKey(const Value &value, bool pad_max) const -> IntegerKeyType;
+
+  /** Build the output tuple of an index-only scan from the key the current RID came from. */
+  auto MakeIndexOnlyTuple() const -> Tuple;
+
+  /** Take the table lock the scan needs: IX under update/delete, otherwise IS unless the isolation level is RU. */
+  void LockTable();
+
+  /**
+   * Lock a row before reading it, X under update/delete, otherwise S unless the isolation level is RU.
+   * @return `true` if the lock was taken here, `false` if it was not needed or the transaction already held it
+   */
+  auto LockRow(RID rid) -> bool;
+
+  void UnlockRow(RID rid, bool force);
+
+  /** @return `true` if the row the current RID points to is not deleted and passes the residual predicate */
+  auto ReadRow(RID rid, Tuple *tuple) -> bool;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
   BPlusTreeIndexIteratorForTwoIntegerColumn tree_iter_;
-  BPlusTreeIndexIteratorForTwoIntegerColumn tree_end_iter_;
+  /** Equality on a single-column index, answered by one ScanKey in Init(). */
+  bool point_lookup_{false};
+  /** RIDs being returned, the point lookup result or one leaf at a time from tree_iter_. */
+  std::vector<RID> rids_;
+  size_t rid_pos_{0};
+  std::vector<std::pair<IntegerKeyType, IntegerValueType>> leaf_;
+  /** For index-only scans, the position of every table column in the index key, -1 if it is not a key column. */
+  std::vector<int> key_col_of_;
   IndexInfo *index_info_;
   TableInfo *table_info_;
 };
@@ -45,6 +45,11 @@ class LimitExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /** Pass child batches through, cutting the selection off at the limit. */
+  auto NextBatch(TupleBatch *batch) -> bool override;
+
+  auto SupportsBatch() const -> bool override { return child_->SupportsBatch(); }
+
   /** @return The output schema for the limit */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
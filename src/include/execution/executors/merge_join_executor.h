@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_executor.h
+//
+// Identification: src/include/execution/executors/merge_join_executor.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/merge_join_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * MergeJoinExecutor joins two children that are both ordered ascending on
+ * their join keys by walking them side by side.
+ *
+ * Only the right rows sharing the key of the current left row are buffered,
+ * so memory is bounded by the largest run of duplicate right keys. Rows with
+ * a NULL key match nothing.
+ */
+class MergeJoinExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new MergeJoinExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The MergeJoin join plan to be executed
+   * @param left_child The child executor that produces tuples for the left side of join
+   * @param right_child The child executor that produces tuples for the right side of join
+   */
+  MergeJoinExecutor(ExecutorContext *exec_ctx, const MergeJoinPlanNode *plan,
+                    std::unique_ptr<AbstractExecutor> &&left_child, std::unique_ptr<AbstractExecutor> &&right_child);
+
+  /** Initialize the join */
+  void Init() override;
+
+  /**
+   * Yield the next tuple from the join.
+   * @param[out] tuple The next tuple produced by the join
+   * @param[out] rid The next tuple RID produced by the join
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema for the join */
+  auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
+
+ private:
+  /** @return the join keys of a tuple, `false` if one of them is NULL */
+  static auto MakeKeys(const Tuple &tuple, const Schema &schema, const std::vector<AbstractExpressionRef> &exprs,
+                       std::vector<Value> *keys) -> bool;
+  /** @return <0, 0 or >0 as a is ordered before, with or after b */
+  static auto CompareKeys(const std::vector<Value> &a, const std::vector<Value> &b) -> int;
+  /** Read the next right row with non-NULL keys into the lookahead. */
+  void AdvanceRight();
+  /** Replace the buffered group with the next run of right rows sharing a key, @return `false` past the last one */
+  auto LoadGroup() -> bool;
+  /** @return the output row of a left tuple and a right tuple, or NULLs for a missing right tuple */
+  auto MakeOutput(const Tuple &left, const Tuple *right) const -> Tuple;
+
+  /** The MergeJoin plan node to be executed. */
+  const MergeJoinPlanNode *plan_;
+  std::unique_ptr<AbstractExecutor> left_child_;
+  std::unique_ptr<AbstractExecutor> right_child_;
+
+  /** The current left row, valid while has_left_ */
+  Tuple left_;
+  std::vector<Value> left_keys_;
+  bool has_left_{false};
+  /** Whether the current left row is being joined with group_, and the next row of group_ to join it with */
+  bool joining_{false};
+  size_t group_pos_{0};
+
+  /** The right rows sharing group_keys_ */
+  std::vector<Tuple> group_;
+  std::vector<Value> group_keys_;
+  /** The first right row past group_, valid while has_right_ */
+  Tuple right_;
+  std::vector<Value> right_keys_;
+  bool has_right_{false};
+};
+
+}  // namespace bustub
@@ -13,11 +13,13 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/morsel.h"
 #include "execution/plans/mock_scan_plan.h"
 #include "storage/table/tuple.h"
 
@@ -25,6 +27,7 @@ namespace bustub {
 
 extern const char *mock_table_list[];
 auto GetMockTableSchemaOf(const std::string &table) -> Schema;
+auto GetSizeOf(const MockScanPlanNode *plan) -> size_t;
 
 /**
  * The MockScanExecutor executor executes a sequential table scan for tests.
@@ -79,6 +82,10 @@ class MockScanExecutor : public AbstractExecutor {
 
   /** The shuffled output */
   std::vector<size_t> shuffled_idx_;
+
+  /** Pipeline mode: the row cursor shared with the other copies of the pipeline, and the end of the current morsel */
+  std::shared_ptr<RowMorselCursor> shared_cursor_;
+  std::size_t morsel_end_{0};
 };
 
 }  // namespace bustub
@@ -14,10 +14,10 @@
 
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "catalog/catalog.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
@@ -29,6 +29,10 @@ namespace bustub {
 
 /**
  * IndexJoinExecutor executes index join operations.
+ *
+ * Outer tuples are buffered a batch at a time and their keys probed with one
+ * Index::ScanKeys call, which sorts the keys and walks the B+ tree once, so
+ * probes that land on the same leaf reuse the pages already latched.
  */
 class NestIndexJoinExecutor : public AbstractExecutor {
  public:
@@ -48,7 +52,30 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  /** Buffer the next batch of outer tuples and probe the index for all of them, @return `false` past the last one */
+  auto ProbeBatch() -> bool;
+  /** Take IS on the inner table unless the isolation level is RU or the transaction holds a lock on it already */
+  void LockInnerTable();
+  /**
+   * Read an inner tuple the index pointed to, S-locking it by isolation level like SeqScanExecutor does.
+   * @return `false` if the tuple is deleted, its lock is then released again
+   */
+  auto ReadInner(RID rid, Tuple *inner) -> bool;
+  /** @return the output row of an outer tuple and an inner tuple, or NULLs for a missing inner tuple */
+  auto MakeOutput(const Tuple &outer, const Tuple *inner) const -> Tuple;
+
   /** The nested index join plan node. */
   const NestedIndexJoinPlanNode *plan_;
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  const IndexInfo *index_info_{nullptr};
+  const TableInfo *table_info_{nullptr};
+  /** The buffered outer tuples and, for each, the RIDs of its matching inner tuples */
+  std::vector<Tuple> outer_;
+  std::vector<std::vector<RID>> matches_;
+  /** The outer tuple being joined, and the next of its matches */
+  size_t outer_pos_{0};
+  size_t match_pos_{0};
+  /** Whether the current outer tuple produced a row yet, for LEFT joins */
+  bool matched_{false};
 };
 }  // namespace bustub
@@ -47,6 +47,11 @@ class ProjectionExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /** Evaluate every output expression over a whole child batch at once. */
+  auto NextBatch(TupleBatch *batch) -> bool override;
+
+  auto SupportsBatch() const -> bool override { return child_executor_->SupportsBatch(); }
+
   /** @return The output schema for the projection plan */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
@@ -56,5 +61,8 @@ class ProjectionExecutor : public AbstractExecutor {
 
   /** The child executor from which tuples are obtained */
   std::unique_ptr<AbstractExecutor> child_executor_;
+
+  /** Rows pulled from the child in batch mode */
+  std::unique_ptr<TupleBatch> child_batch_;
 };
 }  // namespace bustub
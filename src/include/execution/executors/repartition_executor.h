@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// repartition_executor.h
+//
+// Identification: src/include/execution/executors/repartition_executor.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "execution/exchange.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/repartition_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * The RepartitionExecutor is the consuming end of a Repartition exchange.
+ *
+ * Inside a parallel pipeline the Gather has already routed the child's rows
+ * into a PartitionedExchange, and the executor yields the rows of the
+ * partitions it claims. Outside of one it passes its child's rows through.
+ */
+class RepartitionExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new RepartitionExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The repartition plan to be executed
+   * @param child_executor The child executor, nullptr when a Gather fills the partitions
+   */
+  RepartitionExecutor(ExecutorContext *exec_ctx, const RepartitionPlanNode *plan,
+                      std::unique_ptr<AbstractExecutor> &&child_executor);
+
+  /** Initialize the repartition */
+  void Init() override;
+
+  /**
+   * Yield the next tuple of the claimed partitions.
+   * @param[out] tuple The next tuple
+   * @param[out] rid The next tuple RID
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema for the repartition plan */
+  auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
+
+ private:
+  /** The repartition plan node to be executed */
+  const RepartitionPlanNode *plan_;
+
+  /** The child executor from which tuples are obtained */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+
+  /** The partitions filled by the Gather, and the position in the claimed partition */
+  std::shared_ptr<PartitionedExchange> exchange_;
+  std::vector<Tuple> tuples_;
+  size_t pos_{0};
+};
+}  // namespace bustub
@@ -13,11 +13,14 @@
 #pragma once
 
 #include <memory>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "catalog/schema.h"
 #include "execution/executor_context.h"
+#include "execution/exchange.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/morsel.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "storage/table/tuple.h"
 
@@ -25,6 +28,15 @@ namespace bustub {
 
 /**
  * The SeqScanExecutor executor executes a sequential table scan.
+ *
+ * When the query allows more than one scan thread, the table is read by a
+ * pool of workers instead: each worker claims a morsel of SCAN_MORSEL_PAGES
+ * pages at a time, evaluates the pushed-down predicate on its own, and passes
+ * the surviving tuples to this executor through a TupleExchange. Rows then
+ * come out in no particular order.
+ *
+ * Inside a parallel pipeline, a Gather publishes a TableMorselCursor for the
+ * scan and every copy of the pipeline claims morsels from it on its own thread.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -35,6 +47,9 @@ class SeqScanExecutor : public AbstractExecutor {
    */
   SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan);
 
+  /** Stop the scan workers, if any */
+  ~SeqScanExecutor() override;
+
   /** Initialize the sequential scan */
   void Init() override;
 
@@ -46,15 +61,87 @@ class SeqScanExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /**
+   * Fill the batch with the next visible tuples of the scan. The serial and pipeline scans decode the rows into the
+   * columns straight from the table page, one page fetch per run of rows. A scan is driven either by Next() or by
+   * NextBatch(), never both.
+   */
+  auto NextBatch(TupleBatch *batch) -> bool override;
+
+  auto SupportsBatch() const -> bool override { return true; }
+
+  /** Check the join filter right after the pushed-down predicate, before a row leaves the scan. */
+  auto PushDownJoinFilter(const JoinFilter *filter) -> bool override;
+
   /** @return The output schema for the sequential scan */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
  private:
+  /** Advance to the next tuple visible to the transaction. */
+  auto ScanNext(Tuple *tuple, RID *rid) -> bool;
+
+  /** Advance to the next visible tuple of the morsels claimed from the shared cursor. */
+  auto MorselNext(Tuple *tuple, RID *rid) -> bool;
+
+  /** Move to the next page of the claimed morsels, claiming a new morsel if needed. @return `false` at the end */
+  auto NextMorselPage() -> bool;
+
+  /** Take the row lock the isolation level asks for before a row is read. */
+  void LockRowForRead(RID rid);
+
+  /** Lock the slots [begin, end) of a page and append the ones not deleted to the batch. */
+  void AppendPageRun(page_id_t page_id, uint32_t begin, uint32_t end, TupleBatch *batch);
+
+  /** Apply the pushed-down predicate and the join filter to a freshly filled batch and release the row locks. */
+  void SelectBatch(TupleBatch *batch);
+
+  /**
+   * Read one slot of the table, taking the row locks the isolation level asks for.
+   * @param[out] eliminated incremented if the row is dropped by the join filter
+   * @return `true` if the tuple is visible and passes the pushed-down predicate and join filter
+   */
+  auto ReadRow(RID rid, Tuple *tuple, size_t *eliminated) -> bool;
+
+  /** Start scan_parallelism workers over the pages that exist now. */
+  void StartWorkers(size_t scan_parallelism);
+
+  /** Add the rows the join filter eliminated so far to the stats of the join. */
+  void RecordEliminated();
+
+  /** Close the exchange and join the workers. */
+  void StopWorkers();
+
+  /** The body of a worker: claim morsels and read them until the table is exhausted. */
+  void ScanWorker();
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
 
   TableInfo *tbl_info_;
 
+  /** The join filter pushed down by a hash join above, and the rows it dropped here not yet added to the join's stats */
+  const JoinFilter *join_filter_{nullptr};
+  OperatorStats *join_filter_stats_{nullptr};
+  size_t eliminated_{0};
+
   std::unique_ptr<TableIterator> tbl_it_;
+  /** Serial mode under NextBatch(): the next slot to read, its page is invalid at the end of the table */
+  RID batch_rid_;
+
+  /** Parallel mode: the workers and the exchange they fill */
+  std::vector<std::thread> workers_;
+  std::unique_ptr<TupleExchange> exchange_;
+  TupleExchange::Chunk chunk_;
+  size_t chunk_pos_{0};
+
+  /** Parallel mode: the morsel cursor the workers share */
+  std::unique_ptr<TableMorselCursor> cursor_;
+
+  /** Pipeline mode: the cursor shared with the other copies of the pipeline, and the position in the current morsel */
+  std::shared_ptr<TableMorselCursor> shared_cursor_;
+  std::vector<page_id_t> morsel_pages_;
+  size_t morsel_page_idx_{0};
+  uint32_t morsel_slot_{0};
+  uint32_t morsel_num_slots_{0};
 };
 }  // namespace bustub
@@ -13,19 +13,29 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/loser_tree.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/sort_plan.h"
+#include "execution/spill_file.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
  * The SortExecutor executor executes a sort.
+ *
+ * The ORDER BY values of a row are encoded once into a normalized binary key
+ * (see AppendSortKey), and rows are ordered by memcmp on the keys. The input
+ * is cut into runs of half the memory budget; while the next run is being
+ * read, the full one is sorted and written to a SpillFile by a task on the
+ * scheduler. The spilled runs and the last run, kept in memory, are merged
+ * through a loser tree, at most SORT_MERGE_FAN_IN runs at a time.
  */
 class SortExecutor : public AbstractExecutor {
  public:
@@ -51,10 +61,45 @@ class SortExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
  private:
+  struct SortEntry {
+    std::string key_;
+    Tuple tuple_;
+    RID rid_;
+  };
+
+  /** One input of a merge: a spilled run, or the run left in memory, and its current head */
+  struct MergeSource {
+    /** nullptr when the source is run_ */
+    std::unique_ptr<SpillFile::Reader> reader_;
+    size_t pos_{0};
+    bool done_{false};
+    SortEntry head_;
+  };
+
+  /** Orders merge sources by their heads, exhausted sources last */
+  struct SourceLess {
+    const std::vector<MergeSource> *sources_;
+    auto operator()(size_t a, size_t b) const -> bool;
+  };
+
+  auto MakeKey(const Tuple &tuple) const -> std::string;
+  static void SortRun(std::vector<SortEntry> *run);
+  /** Merge runs until at most SORT_MERGE_FAN_IN - 1 are left, so they and run_ fit in one final merge. */
+  void ReduceRuns(size_t *depth);
+  /** Set up sources_ and tree_ over the given runs, and run_ when `with_memory_run` is set. */
+  void OpenMerge(size_t begin, size_t end, bool with_memory_run);
+  /** Move a source to its next row. */
+  void Advance(MergeSource *source);
+
   /** The sort plan node to be executed */
   const SortPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_;
-  std::vector<std::pair<Tuple, RID>> ve_;
-  int cur_ = 0;
+  /** The run kept in memory, all of the input if nothing spilled */
+  std::vector<SortEntry> run_;
+  size_t cur_{0};
+  /** The sorted runs written to temporary pages, in input order */
+  std::vector<std::unique_ptr<SpillFile>> runs_;
+  std::vector<MergeSource> sources_;
+  std::unique_ptr<LoserTree<SourceLess>> tree_;
 };
 }  // namespace bustub
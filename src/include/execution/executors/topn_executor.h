@@ -63,7 +63,7 @@ class TopNExecutor : public AbstractExecutor {
   const TopNPlanNode *plan_;
   /** The child executor from which tuples are obtained */
   std::unique_ptr<AbstractExecutor> child_executor_;
-  bool sorted_;
+  bool sorted_{false};
   std::vector<std::pair<Tuple, RID>> heap_;
   size_t cur_;
 };
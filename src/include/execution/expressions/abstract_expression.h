@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "execution/tuple_batch.h"
 #include "fmt/format.h"
 #include "storage/table/tuple.h"
 
@@ -65,6 +66,22 @@ class AbstractExpression {
   virtual auto EvaluateJoin(const Tuple *left_tuple, const Schema &left_schema, const Tuple *right_tuple,
                             const Schema &right_schema) const -> Value = 0;
 
+  /**
+   * Evaluate the expression on every selected row of a batch. The default
+   * materializes each row and calls Evaluate(); expressions that can work on
+   * whole columns override it.
+   * @param batch the input rows, laid out by the batch schema
+   * @param[out] result one value per selected row, in selection order
+   */
+  virtual void EvaluateBatch(const TupleBatch &batch, std::vector<Value> *result) const {
+    result->clear();
+    result->reserve(batch.Size());
+    for (size_t i = 0; i < batch.Size(); i++) {
+      auto tuple = batch.MaterializeTuple(batch.SelectedRow(i));
+      result->push_back(Evaluate(&tuple, *batch.GetSchema()));
+    }
+  }
+
   /** @return the child_idx'th child of this expression */
   auto GetChildAt(uint32_t child_idx) const -> const AbstractExpressionRef & { return children_[child_idx]; }
 
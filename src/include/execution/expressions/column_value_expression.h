@@ -45,6 +45,15 @@ class ColumnValueExpression : public AbstractExpression {
                            : right_tuple->GetValue(&right_schema, col_idx_);
   }
 
+  void EvaluateBatch(const TupleBatch &batch, std::vector<Value> *result) const override {
+    const auto &column = batch.GetColumn(col_idx_);
+    result->clear();
+    result->reserve(batch.Size());
+    for (size_t i = 0; i < batch.Size(); i++) {
+      result->push_back(column[batch.SelectedRow(i)]);
+    }
+  }
+
   auto GetTupleIdx() const -> uint32_t { return tuple_idx_; }
   auto GetColIdx() const -> uint32_t { return col_idx_; }
 
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_filter.h
+//
+// Identification: src/include/execution/join_filter.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/util/hash_util.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+struct OperatorStats;
+
+/**
+ * BloomFilter is a split block Bloom filter over 64-bit hashes.
+ *
+ * The filter is an array of 32-byte blocks of eight 32-bit words. A hash
+ * picks one block with its upper half and sets one bit in each word of the
+ * block with its lower half, so an insert or a lookup touches a single cache
+ * line. It never answers `false` for a hash that was inserted.
+ */
+class BloomFilter {
+ public:
+  /** Size the filter for num_keys hashes, BLOOM_FILTER_BITS_PER_KEY bits each, and clear it. */
+  void Reset(size_t num_keys);
+
+  void Insert(hash_t hash) {
+    auto &block = blocks_[BlockOf(hash)];
+    for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+      block.words_[i] |= BitOf(hash, i);
+    }
+  }
+
+  /** @return `false` if the hash was surely never inserted */
+  auto MayContain(hash_t hash) const -> bool {
+    const auto &block = blocks_[BlockOf(hash)];
+    for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+      if ((block.words_[i] & BitOf(hash, i)) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** @return the bytes the bit array takes */
+  auto MemoryUsage() const -> size_t { return blocks_.size() * sizeof(Block); }
+
+ private:
+  static constexpr size_t WORDS_PER_BLOCK = 8;
+  /** Odd multipliers that spread the lower half of a hash to a different bit of every word */
+  static constexpr uint32_t SALT[WORDS_PER_BLOCK] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                     0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+  struct alignas(32) Block {
+    uint32_t words_[WORDS_PER_BLOCK];
+  };
+
+  auto BlockOf(hash_t hash) const -> size_t { return (hash >> 32) & block_mask_; }
+
+  static auto BitOf(hash_t hash, size_t i) -> uint32_t {
+    return uint32_t{1} << ((static_cast<uint32_t>(hash) * SALT[i]) >> 27);
+  }
+
+  std::vector<Block> blocks_ = std::vector<Block>(1);
+  /** The number of blocks is a power of two */
+  size_t block_mask_{0};
+};
+
+/**
+ * JoinFilter is the Bloom filter an inner hash join builds over the keys of
+ * its build side and pushes down into the scan under its probe side, which
+ * then drops the rows that cannot find a match before they travel up the plan.
+ */
+struct JoinFilter {
+  /**
+   * @return `false` if the join keys of a probe row match no build row: a key is NULL or the filter rules the
+   * row out. Such a row is counted in *eliminated.
+   */
+  auto Pass(const Tuple &tuple, const Schema &schema, size_t *eliminated) const -> bool;
+
+  /** Pass() over the selected rows of a batch: shrink the selection to the rows that may match. */
+  void PassBatch(TupleBatch *batch, size_t *eliminated) const;
+
+  /** The probe-side join key expressions, evaluated on the rows of the executor the filter is pushed into */
+  const std::vector<AbstractExpressionRef> *keys_{nullptr};
+  BloomFilter bloom_;
+  /** The statistics of the join the filter belongs to, where the scan adds up the rows it eliminated */
+  OperatorStats *stats_{nullptr};
+};
+
+}  // namespace bustub
@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table.h
+//
+// Identification: src/include/execution/join_hash_table.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+#include "common/util/hash_util.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+class TaskScheduler;
+
+/**
+ * JoinHashTable holds the build side of a hash join.
+ *
+ * Rows are appended with their join keys, then Build() radix-partitions them
+ * by the top bits of the key hash into partitions of about
+ * HASH_JOIN_PARTITION_ROWS rows, and gives each partition a flat
+ * open-addressing table of row indexes. The partitions are built in parallel
+ * on the task scheduler. The table is read-only once built, so any number of
+ * threads may probe it at the same time.
+ */
+class JoinHashTable {
+ public:
+  /** The rows matching one probe key, walked without copying them. */
+  class Matches {
+   public:
+    Matches() = default;
+
+    /** @return the next matching build row, or `nullptr` when there are no more */
+    auto Next() -> const Tuple *;
+
+   private:
+    friend class JoinHashTable;
+
+    Matches(const JoinHashTable *table, const std::vector<Value> *keys, hash_t hash, uint32_t partition);
+
+    const JoinHashTable *table_{nullptr};
+    const std::vector<Value> *keys_{nullptr};
+    hash_t hash_{0};
+    uint32_t partition_{0};
+    /** The next slot to look at, in the partition's slot array */
+    size_t slot_{0};
+  };
+
+  /**
+   * Append a build row. A row with a NULL key never matches and is dropped.
+   * Only valid before Build().
+   */
+  void Insert(std::vector<Value> &&keys, Tuple &&tuple);
+
+  /**
+   * Partition the rows and build the slot arrays.
+   * @param scheduler the pool the partitions are built on, `nullptr` builds them on this thread
+   */
+  void Build(TaskScheduler *scheduler);
+
+  /** Remove every row, so the table can be filled again. */
+  void Clear();
+
+  /** @return the number of build rows stored */
+  auto Size() const -> size_t { return rows_.size(); }
+
+  /** @return an estimate of the bytes the rows, keys and slots take, checked against the memory budget */
+  auto MemoryUsage() const -> size_t { return bytes_; }
+
+  /** @return the i-th build row, in insertion order */
+  auto GetRow(size_t i) const -> const Tuple & { return rows_[i]; }
+
+  /** @return the key hash of the i-th build row */
+  auto GetHash(size_t i) const -> hash_t { return hashes_[i]; }
+
+  /** @return the number of radix partitions, valid after Build() */
+  auto NumPartitions() const -> size_t { return partitions_.size(); }
+
+  /**
+   * Look up a probe key. The key vector must outlive the returned cursor.
+   * @return the cursor over the build rows whose keys equal `keys`
+   */
+  auto Find(const std::vector<Value> &keys) const -> Matches;
+
+  /** @return the hash of a join key, the same on the build and the probe side */
+  static auto HashKeys(const std::vector<Value> &keys) -> hash_t;
+
+  /**
+   * @return the spill partition of a key hash at a level of recursive repartitioning. Each level takes the next
+   * SPILL_PARTITION_BITS bits of the middle of the hash, which neither the radix partitions (top bits) nor the
+   * slots (low bits) of the table built from a spill partition use.
+   */
+  static auto SpillPartitionOf(hash_t hash, size_t level) -> size_t {
+    return (hash >> (SPILL_HASH_SHIFT + level * SPILL_PARTITION_BITS)) & ((size_t{1} << SPILL_PARTITION_BITS) - 1);
+  }
+
+ private:
+  static constexpr size_t SPILL_HASH_SHIFT = 24;
+
+  struct Partition {
+    /** Slot i holds a row index + 1, 0 marks an empty slot. The size is a power of two. */
+    std::vector<uint32_t> slots_;
+  };
+
+  void BuildPartition(size_t partition, const std::vector<uint32_t> &order, size_t begin, size_t end);
+
+  auto PartitionOf(hash_t hash) const -> uint32_t {
+    return partition_bits_ == 0 ? 0 : static_cast<uint32_t>(hash >> (64 - partition_bits_));
+  }
+
+  std::vector<Tuple> rows_;
+  /** The keys of row i are keys_[i * num_keys_, (i + 1) * num_keys_) */
+  std::vector<Value> keys_;
+  size_t num_keys_{0};
+  std::vector<hash_t> hashes_;
+  std::vector<Partition> partitions_;
+  int partition_bits_{0};
+  size_t bytes_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// loser_tree.h
+//
+// Identification: src/include/execution/loser_tree.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * LoserTree picks the smallest head among k sorted sources in a k-way merge.
+ *
+ * Each inner node keeps the loser of the match played below it and the winner
+ * moves up, so after the winning source advances only the log(k) matches on
+ * its path to the root are replayed. `Less(a, b)` compares the current heads
+ * of sources a and b; an exhausted source must compare greater than any other.
+ * Equal heads are won by the source with the smaller index, which keeps the
+ * merge stable when the sources are runs in input order.
+ */
+template <typename Less>
+class LoserTree {
+ public:
+  LoserTree(size_t size, Less less) : size_(size), less_(std::move(less)), tree_(size, NONE) {
+    BUSTUB_ASSERT(size > 0, "a loser tree needs at least one source");
+    // 内部节点先填一个谁都赢不了的哨兵，每放进一个叶子就把一个哨兵挤出根
+    for (size_t source = size_; source-- > 0;) {
+      Replay(source);
+    }
+  }
+
+  /** @return the index of the source whose head is the smallest */
+  auto Top() const -> size_t { return tree_[0]; }
+
+  /** Replay the matches of a source after its head changed, normally the top one after it advanced. */
+  void Replay(size_t source) {
+    size_t winner = source;
+    for (size_t node = (source + size_) / 2; node > 0; node /= 2) {
+      if (Beats(tree_[node], winner)) {
+        std::swap(tree_[node], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+
+ private:
+  /** Marks an inner node not played yet while the tree is built */
+  static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  auto Beats(size_t a, size_t b) -> bool {
+    if (a == NONE || b == NONE) {
+      return a == NONE;
+    }
+    if (less_(a, b)) {
+      return true;
+    }
+    return !less_(b, a) && a < b;
+  }
+
+  size_t size_;
+  Less less_;
+  /** tree_[0] is the winner, tree_[1, size) the losers of the inner nodes; leaf i sits at virtual node size + i */
+  std::vector<size_t> tree_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// morsel.h
+//
+// Identification: src/include/execution/morsel.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/**
+ * TableMorselCursor hands out the pages of a table heap in morsels of
+ * SCAN_MORSEL_PAGES pages to the threads that scan it together.
+ *
+ * The end of the table is fixed when the cursor is created, so tuples
+ * inserted later (for example by INSERT ... SELECT on the same table) are not
+ * scanned.
+ */
+class TableMorselCursor {
+ public:
+  TableMorselCursor(BufferPoolManager *bpm, TableHeap *table);
+
+  /**
+   * Claim the next morsel.
+   * @param[out] pages the pages of the morsel, in chain order
+   * @return `false` if every page has been claimed
+   */
+  auto Next(std::vector<page_id_t> *pages) -> bool;
+
+  /** @return the number of slots of the page that belong to the scan */
+  auto NumSlots(page_id_t page_id) -> uint32_t;
+
+ private:
+  BufferPoolManager *bpm_;
+  /** The heap pages are linked by next pointers only, the cursor is a position in the chain */
+  std::mutex latch_;
+  page_id_t next_page_id_;
+  page_id_t stop_page_id_;
+  uint32_t stop_slot_;
+};
+
+/** RowMorselCursor hands out the row numbers [0, size) of a generated table in morsels. */
+class RowMorselCursor {
+ public:
+  explicit RowMorselCursor(size_t size) : size_(size) {}
+
+  /**
+   * Claim the next morsel, the rows [*begin, *end).
+   * @return `false` if every row has been claimed
+   */
+  auto Next(size_t *begin, size_t *end) -> bool {
+    *begin = next_.fetch_add(BUSTUB_BATCH_SIZE);
+    if (*begin >= size_) {
+      return false;
+    }
+    *end = std::min(*begin + BUSTUB_BATCH_SIZE, size_);
+    return true;
+  }
+
+ private:
+  std::atomic<size_t> next_{0};
+  size_t size_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -42,13 +43,16 @@ enum class PlanType {
   NestedLoopJoin,
   NestedIndexJoin,
   HashJoin,
+  MergeJoin,
   Filter,
   Values,
   Projection,
   Sort,
   TopN,
   MockScan,
-  InitCheck
+  InitCheck,
+  Gather,
+  Repartition
 };
 
 class AbstractPlanNode;
@@ -93,6 +97,12 @@ class AbstractPlanNode {
     return fmt::format("{}{}", PlanNodeToString(), ChildrenToString(2, with_schema));
   }
 
+  /**
+   * @return the plan tree without schemas, each node's line followed by what `annotate` says about the node,
+   * used by EXPLAIN ANALYZE to show the runtime statistics of the operators
+   */
+  auto ToString(const std::function<std::string(const AbstractPlanNode &)> &annotate) const -> std::string;
+
   /** @return the cloned plan node with new children */
   virtual auto CloneWithChildren(std::vector<AbstractPlanNodeRef> children) const
       -> std::unique_ptr<AbstractPlanNode> = 0;
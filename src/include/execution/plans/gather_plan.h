@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// gather_plan.h
+//
+// Identification: src/include/execution/plans/gather_plan.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include "execution/plans/abstract_plan.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+/**
+ * The GatherPlanNode runs its child pipeline as several parallel copies and
+ * merges their output into a single stream, in no particular order.
+ *
+ * The copies split the table scanned at the bottom of the pipeline into
+ * morsels. Repartition nodes inside the pipeline are pipeline breakers: the
+ * part below each one runs to completion before the part above it starts.
+ */
+class GatherPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Construct a new GatherPlanNode instance.
+   * @param output The output schema, the same as the child's
+   * @param child The pipeline to run in parallel
+   * @param parallelism The number of copies of the pipeline
+   */
+  GatherPlanNode(SchemaRef output, AbstractPlanNodeRef child, size_t parallelism)
+      : AbstractPlanNode(std::move(output), {std::move(child)}), parallelism_{parallelism} {}
+
+  /** @return The type of the plan node */
+  auto GetType() const -> PlanType override { return PlanType::Gather; }
+
+  /** @return The number of copies of the pipeline */
+  auto GetParallelism() const -> size_t { return parallelism_; }
+
+  /** @return The child plan node */
+  auto GetChildPlan() const -> AbstractPlanNodeRef {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Gather should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+  BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(GatherPlanNode);
+
+  /** The number of copies of the pipeline */
+  size_t parallelism_;
+
+ protected:
+  auto PlanNodeToString() const -> std::string override;
+};
+
+}  // namespace bustub
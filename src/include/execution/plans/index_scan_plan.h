@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -42,6 +43,25 @@ class IndexScanPlanNode : public AbstractPlanNode {
         predicate_(std::move(predicate)),
         single_search_(single_search) {}
 
+  /**
+   * Creates a range index scan on the first key column.
+   * @param predicate the full filter, still evaluated on every tuple the range returns
+   * @param lower lower bound of the first key column, unbounded when nullopt
+   * @param upper upper bound of the first key column, unbounded when nullopt
+   * @param descending scan from the largest key downwards
+   */
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, AbstractExpressionRef predicate, std::optional<Value> lower,
+                    bool lower_inclusive, std::optional<Value> upper, bool upper_inclusive, bool descending)
+      : AbstractPlanNode(std::move(output), {}),
+        index_oid_(index_oid),
+        predicate_(std::move(predicate)),
+        single_search_(false),
+        lower_(std::move(lower)),
+        lower_inclusive_(lower_inclusive),
+        upper_(std::move(upper)),
+        upper_inclusive_(upper_inclusive),
+        descending_(descending) {}
+
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
   /** @return the identifier of the table that should be scanned */
@@ -60,10 +80,32 @@ class IndexScanPlanNode : public AbstractPlanNode {
   bool single_search_;
 
   // Add anything you want here for index lookup
+  /** Bounds on the first key column, nullopt means unbounded. */
+  std::optional<Value> lower_;
+  bool lower_inclusive_{true};
+  std::optional<Value> upper_;
+  bool upper_inclusive_{true};
+  /** Walk the leaves from right to left, used for ORDER BY ... DESC. */
+  bool descending_{false};
+  /**
+   * Build output tuples from the index keys alone and never read the table tuples. Only set when the predicate
+   * and every operator above read nothing but key columns; the other columns come out as NULL. Except under
+   * READ_UNCOMMITTED the executor still S-locks each RID and checks its tuple meta, since index entries of
+   * uncommitted inserts and updates are already in the index.
+   */
+  bool index_only_{false};
 
  protected:
   auto PlanNodeToString() const -> std::string override {
-    return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    std::string index_only = index_only_ ? ", index_only=true, non_key_columns=NULL" : "";
+    if (!lower_.has_value() && !upper_.has_value() && !descending_) {
+      return fmt::format("IndexScan {{ index_oid={}{} }}", index_oid_, index_only);
+    }
+    std::string range = fmt::format("{}{}, {}{}", lower_inclusive_ ? "[" : "(",
+                                    lower_.has_value() ? lower_->ToString() : "-inf",
+                                    upper_.has_value() ? upper_->ToString() : "+inf", upper_inclusive_ ? "]" : ")");
+    return fmt::format("IndexScan {{ index_oid={}, range={}, descending={}{} }}", index_oid_, range, descending_,
+                       index_only);
   }
 };
 
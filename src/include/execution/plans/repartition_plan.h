@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// repartition_plan.h
+//
+// Identification: src/include/execution/plans/repartition_plan.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+/**
+ * The RepartitionPlanNode redistributes the rows of a parallel pipeline by the
+ * hash of its keys, so that every copy of the pipeline above it sees all rows
+ * of the keys it owns. It only appears inside a Gather, which fills the
+ * partitions before the copies above the node start.
+ */
+class RepartitionPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Construct a new RepartitionPlanNode instance.
+   * @param output The output schema, the same as the child's
+   * @param child The pipeline whose rows are redistributed
+   * @param keys The expressions evaluated on the child's rows to pick a partition
+   * @param num_partitions The number of partitions
+   */
+  RepartitionPlanNode(SchemaRef output, AbstractPlanNodeRef child, std::vector<AbstractExpressionRef> keys,
+                      size_t num_partitions)
+      : AbstractPlanNode(std::move(output), {std::move(child)}),
+        keys_{std::move(keys)},
+        num_partitions_{num_partitions} {}
+
+  /** @return The type of the plan node */
+  auto GetType() const -> PlanType override { return PlanType::Repartition; }
+
+  /** @return The partitioning keys */
+  auto GetKeys() const -> const std::vector<AbstractExpressionRef> & { return keys_; }
+
+  /** @return The number of partitions */
+  auto GetNumPartitions() const -> size_t { return num_partitions_; }
+
+  /** @return The child plan node */
+  auto GetChildPlan() const -> AbstractPlanNodeRef {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Repartition should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+  BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(RepartitionPlanNode);
+
+  /** The partitioning keys */
+  std::vector<AbstractExpressionRef> keys_;
+
+  /** The number of partitions */
+  size_t num_partitions_;
+
+ protected:
+  auto PlanNodeToString() const -> std::string override;
+};
+
+}  // namespace bustub
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.h
+//
+// Identification: src/include/execution/sort_key.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <string>
+
+#include "storage/index/generic_key.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * Append the normalized form of a value to a binary sort key, so that memcmp
+ * on two keys built from the same columns orders them like the values.
+ *
+ * Each column starts with a byte that puts NULL before every other value.
+ * Fixed-size values follow in the index key normalization (big-endian, sign
+ * bit flipped). Varchars follow byte by byte with 0x00 escaped as 0x00 0xff
+ * and end with 0x00 0x00, so a prefix sorts before the longer string. A
+ * descending column is the same bytes inverted.
+ */
+inline void AppendSortKey(std::string *key, const Value &value, bool descending) {
+  auto begin = key->size();
+  if (value.IsNull()) {
+    key->push_back('\0');
+  } else {
+    key->push_back('\1');
+    auto type = value.GetTypeId();
+    if (IsNormalizedKeyType(type)) {
+      char buf[sizeof(uint64_t)];
+      value.SerializeTo(buf);
+      NormalizeKeyColumn(buf, type, true);
+      key->append(buf, Type::GetTypeSize(type));
+    } else {
+      // varchar 的长度算上了结尾的 '\0'
+      const char *data = value.GetData();
+      uint32_t length = value.GetLength() - 1;
+      for (uint32_t i = 0; i < length; i++) {
+        key->push_back(data[i]);
+        if (data[i] == '\0') {
+          key->push_back('\xff');
+        }
+      }
+      key->append(2, '\0');
+    }
+  }
+  if (descending) {
+    for (auto i = begin; i < key->size(); i++) {
+      (*key)[i] = static_cast<char>(~(*key)[i]);
+    }
+  }
+}
+
+/** @return memcmp order of two sort keys, a shorter key that is a prefix of the other comes first */
+inline auto CompareSortKeys(const std::string &a, const std::string &b) -> int {
+  auto cmp = memcmp(a.data(), b.data(), std::min(a.size(), b.size()));
+  if (cmp != 0) {
+    return cmp;
+  }
+  return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+}  // namespace bustub
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// spill_file.h
+//
+// Identification: src/include/execution/spill_file.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/tmp_tuple_page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SpillFile holds the rows an operator moved out of memory, in a chain of
+ * TmpTuplePages allocated from the buffer pool. Only the page being written
+ * stays pinned, so the pool evicts the rest to disk as it needs frames.
+ *
+ * A file is appended to by one thread, then finished and read back in
+ * insertion order by any number of readers. Its pages are deleted with it.
+ */
+class SpillFile {
+ public:
+  explicit SpillFile(BufferPoolManager *bpm) : bpm_(bpm) {}
+
+  ~SpillFile();
+
+  DISALLOW_COPY_AND_MOVE(SpillFile);
+
+  /** Append a tuple, its RID is not kept. Only valid before Finish(). */
+  void Append(const Tuple &tuple);
+
+  /** Unpin the page being written. The file is read-only afterwards. */
+  void Finish();
+
+  /** @return the number of tuples appended */
+  auto Rows() const -> size_t { return rows_; }
+
+  /** @return the bytes written to the pages, tuple data and size fields */
+  auto Bytes() const -> size_t { return bytes_; }
+
+  /** Reader walks a finished file in insertion order, pinning one page at a time. */
+  class Reader {
+   public:
+    explicit Reader(const SpillFile *file) : file_(file) {}
+
+    ~Reader();
+
+    DISALLOW_COPY_AND_MOVE(Reader);
+
+    /**
+     * Read the next tuple.
+     * @return `false` past the last tuple
+     */
+    auto Next(Tuple *tuple) -> bool;
+
+   private:
+    const SpillFile *file_;
+    /** The index of the next page to read in file_->pages_ */
+    size_t next_page_{0};
+    TmpTuplePage *page_{nullptr};
+    /** The tuples of the pinned page, last inserted first, so reading pops from the back */
+    std::vector<size_t> offsets_;
+  };
+
+ private:
+  BufferPoolManager *bpm_;
+  std::vector<page_id_t> pages_;
+  /** The pinned page being appended to, nullptr once finished */
+  TmpTuplePage *tail_{nullptr};
+  size_t rows_{0};
+  size_t bytes_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// task_scheduler.h
+//
+// Identification: src/include/execution/task_scheduler.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TaskScheduler runs the tasks of parallel query pipelines on a fixed pool of
+ * worker threads shared by every query of a BustubInstance.
+ *
+ * Each worker owns a deque. A task submitted by a worker goes to the back of
+ * its own deque, other tasks are dealt round-robin. A worker runs its own
+ * tasks newest first and steals the oldest task of another worker when its
+ * deque is empty. The threads are started by the first Submit().
+ */
+class TaskScheduler {
+ public:
+  using Task = std::function<void()>;
+
+  /** @param num_workers the number of worker threads, at least one */
+  explicit TaskScheduler(size_t num_workers);
+
+  /** Run the tasks still queued, then join the workers. */
+  ~TaskScheduler();
+
+  DISALLOW_COPY_AND_MOVE(TaskScheduler);
+
+  /** Queue a task. The task must not let an exception escape. */
+  void Submit(Task task);
+
+  /** @return the number of worker threads */
+  auto NumWorkers() const -> size_t { return queues_.size(); }
+
+ private:
+  struct WorkerQueue {
+    std::mutex latch_;
+    std::deque<Task> tasks_;
+  };
+
+  void WorkerLoop(size_t index);
+
+  /** Take a task from the worker's own deque, or steal one from another worker. */
+  auto TakeTask(size_t index, Task *task) -> bool;
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> workers_;
+  std::once_flag start_flag_;
+  std::atomic<size_t> next_queue_{0};
+
+  /** Guards pending_ and stop_, idle workers sleep on wake_ */
+  std::mutex sleep_latch_;
+  std::condition_variable wake_;
+  /** The number of queued tasks no worker has claimed yet */
+  size_t pending_{0};
+  bool stop_{false};
+};
+
+/**
+ * TaskGroup tracks a set of tasks spawned on a TaskScheduler so that their
+ * owner can wait for all of them. Without a scheduler the tasks run inline.
+ *
+ * A waiting owner runs the tasks of its group that no worker has started yet,
+ * so a task running on a worker may spawn and wait for subtasks without
+ * tying up the pool.
+ */
+class TaskGroup {
+ public:
+  explicit TaskGroup(TaskScheduler *scheduler) : scheduler_(scheduler), state_(std::make_shared<State>()) {}
+
+  /** Wait for the tasks that are still running. */
+  ~TaskGroup() { Wait(); }
+
+  DISALLOW_COPY_AND_MOVE(TaskGroup);
+
+  /** Run a task on the scheduler. An exception it throws is kept for RethrowError(). */
+  void Spawn(std::function<void()> task);
+
+  /** Block until every spawned task has finished. */
+  void Wait();
+
+  /** Rethrow the first exception thrown by a task, if any. */
+  void RethrowError();
+
+ private:
+  /** Shared with the queued runners, which may outlive the group after their task was run by Wait() */
+  struct State {
+    std::mutex latch_;
+    std::condition_variable done_;
+    std::deque<std::function<void()>> queued_;
+    size_t running_{0};
+    std::exception_ptr error_;
+  };
+
+  /** Run one task of the group that has not started yet. @return `false` if there is none */
+  static auto RunQueued(State *state) -> bool;
+
+  TaskScheduler *scheduler_;
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace bustub
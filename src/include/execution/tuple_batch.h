@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_batch.h
+//
+// Identification: src/include/execution/tuple_batch.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * A batch of rows passed between executors by AbstractExecutor::NextBatch().
+ *
+ * Rows are stored column by column: column i of every row sits in one vector,
+ * so an expression can run over a whole column in a tight loop. A selection
+ * vector lists the rows that are still alive, in output order; filtering a
+ * batch only shrinks the selection and never moves column data.
+ */
+class TupleBatch {
+ public:
+  /**
+   * @param schema the schema of the rows in the batch, it must outlive the batch
+   * @param capacity the maximum number of rows the batch holds
+   */
+  explicit TupleBatch(const Schema *schema, size_t capacity = BUSTUB_BATCH_SIZE);
+
+  /** Drop every row, the column vectors keep their memory. */
+  void Reset();
+
+  /** @return the schema of the rows in the batch */
+  auto GetSchema() const -> const Schema * { return schema_; }
+
+  /** @return the maximum number of rows the batch holds */
+  auto Capacity() const -> size_t { return capacity_; }
+
+  /** @return the number of rows stored, selected or not */
+  auto NumRows() const -> size_t { return rids_.size(); }
+
+  /** @return true if no more rows can be appended */
+  auto IsFull() const -> bool { return rids_.size() >= capacity_; }
+
+  /** @return the number of selected rows */
+  auto Size() const -> size_t { return sel_.size(); }
+
+  /** @return the row index of the i-th selected row */
+  auto SelectedRow(size_t i) const -> uint32_t { return sel_[i]; }
+
+  /** @return the selection vector, callers may shrink it to filter rows */
+  auto GetSelection() -> std::vector<uint32_t> & { return sel_; }
+
+  /** @return all values of a column, indexed by row (not by selection position) */
+  auto GetColumn(uint32_t col_idx) const -> const std::vector<Value> & { return columns_[col_idx]; }
+
+  /** @return the value of a column in a row */
+  auto GetValue(uint32_t col_idx, uint32_t row) const -> const Value & { return columns_[col_idx][row]; }
+
+  /** @return the RID of a row, default constructed if the producer has none */
+  auto GetRid(uint32_t row) const -> RID { return rids_[row]; }
+
+  /** Append a row and select it. */
+  void Append(std::vector<Value> values, RID rid = RID{});
+
+  /** Decode a tuple laid out by the batch schema into a new, selected row. */
+  void AppendTuple(const Tuple &tuple, RID rid);
+
+  /** Decode a tuple laid out by the batch schema and serialized at data, e.g. in place on a table page, into a new,
+   * selected row. */
+  void AppendTuple(const char *data, RID rid);
+
+  /**
+   * Replace the content with whole columns, every row is selected.
+   * @param columns one vector per schema column, all of the same length
+   * @param rids the RIDs of the rows, may be empty
+   */
+  void SetColumns(std::vector<std::vector<Value>> &&columns, std::vector<RID> &&rids = {});
+
+  /** @return the values of a row */
+  auto GetRow(uint32_t row) const -> std::vector<Value>;
+
+  /** @return a row serialized with the batch schema, for consumers that need a Tuple */
+  auto MaterializeTuple(uint32_t row) const -> Tuple;
+
+ private:
+  const Schema *schema_;
+  size_t capacity_;
+  std::vector<std::vector<Value>> columns_;
+  std::vector<RID> rids_;
+  std::vector<uint32_t> sel_;
+};
+
+}  // namespace bustub
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -20,8 +21,11 @@ namespace bustub {
  */
 class Optimizer {
  public:
-  explicit Optimizer(const Catalog &catalog, bool force_starter_rule)
-      : catalog_(catalog), force_starter_rule_(force_starter_rule) {}
+  /**
+   * @param parallelism the number of copies a pipeline of the query may run as, 1 plans serial execution
+   */
+  explicit Optimizer(const Catalog &catalog, bool force_starter_rule, size_t parallelism = 1)
+      : catalog_(catalog), force_starter_rule_(force_starter_rule), parallelism_(parallelism) {}
 
   auto Optimize(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
@@ -55,6 +59,15 @@ class Optimizer {
    */
   auto OptimizeNLJAsIndexJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief optimize nested loop join on column equalities into merge join when both children already come out
+   * ordered ascending on the join keys, e.g. from an index scan or a sort
+   */
+  auto OptimizeNLJAsMergeJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
+  /** @return the output columns plan is ordered ascending on, most significant first, empty if unknown */
+  auto ProvidedOrder(const AbstractPlanNode &plan) -> std::vector<uint32_t>;
+
   /**
    * @brief eliminate always true filter
    */
@@ -85,6 +98,26 @@ class Optimizer {
    */
   auto OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief turn a filter on the first key column of an index into a range index scan
+   * @param point_only only rewrite equality lookups on single-column indexes, used below update/delete
+   */
+  auto OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan, bool point_only = false) -> AbstractPlanNodeRef;
+
+  /**
+   * @brief mark index scans whose predicate and consumers only read key columns as index-only
+   * @param required the columns of plan's output its parent reads, nullopt if unknown
+   */
+  auto OptimizeIndexOnlyScan(const AbstractPlanNodeRef &plan,
+                             const std::optional<std::vector<uint32_t>> &required = std::nullopt)
+      -> AbstractPlanNodeRef;
+
+  /**
+   * @brief run every pipeline that starts with a table scan as parallel copies under a Gather, with a Repartition
+   * below each group-by aggregation of the pipeline
+   */
+  auto OptimizeParallelPipelines(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /** @brief check if the index can be matched */
   auto MatchIndex(const std::string &table_name, uint32_t index_key_idx)
       -> std::optional<std::tuple<index_oid_t, std::string>>;
@@ -109,6 +142,9 @@ class Optimizer {
   const Catalog &catalog_;
 
   const bool force_starter_rule_;
+
+  /** The number of copies a parallel pipeline runs as */
+  const size_t parallelism_;
 };
 
 }  // namespace bustub
@@ -83,6 +83,9 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of pages the database file holds, 0 for a new or in-memory database */
+  auto GetNumPages() -> page_id_t;
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
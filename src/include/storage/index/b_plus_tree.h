@@ -3,7 +3,7 @@
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique by default, SetUnique(false) keeps a posting list per key
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
@@ -15,6 +15,7 @@
 #include <iostream>
 #include <optional>
 #include <queue>
+#include <set>
 #include <shared_mutex>
 #include <string>
 #include <vector>
@@ -26,6 +27,7 @@
 #include "storage/page/b_plus_tree_header_page.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 #include "storage/page/page_guard.h"
 
 namespace bustub {
@@ -56,6 +58,24 @@ class Context {
   auto IsRootPage(page_id_t page_id) -> bool { return page_id == root_page_id_; }
 };
 
+/** Page layout summary of a B+ tree, see BPlusTree::GetStats(). */
+struct BPlusTreeStats {
+  /** Number of levels, 0 for an empty tree */
+  size_t height_{0};
+  size_t leaf_pages_{0};
+  size_t internal_pages_{0};
+  /** Overflow pages holding the RIDs of duplicated keys */
+  size_t posting_pages_{0};
+  /** Distinct keys in the leaves */
+  size_t key_count_{0};
+  /** Key/RID pairs, key_count_ plus the extra RIDs of duplicated keys */
+  size_t value_count_{0};
+  /** Average fill factor (0..1) of the pages on each level, root first */
+  std::vector<double> level_fill_;
+  /** Share (0..1) of neighbouring leaves whose page ids are not consecutive, a range scan seeks at each of them */
+  double fragmentation_{0};
+};
+
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
 // Main class providing the API for the Interactive B+ Tree.
@@ -63,29 +83,44 @@ INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  // Iterators copy leaves under mtx_ and re-descend through FindLeafPageId once smo_count_ moved
+  friend class IndexIterator<KeyType, ValueType, KeyComparator>;
 
  public:
+  // create == false reopens the tree whose root header_page_id already records instead of starting empty
   explicit BPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager,
                      const KeyComparator &comparator, int leaf_max_size = LEAF_PAGE_SIZE,
-                     int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int internal_max_size = INTERNAL_PAGE_SIZE, bool create = true);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *txn = nullptr) -> bool;
 
-  // Remove a key and its value from this B+ tree.
+  // Remove a key and all of its values from this B+ tree.
   void Remove(const KeyType &key, Transaction *txn);
 
+  // Remove one value of key; in unique mode the value is ignored and the key goes away.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *txn);
+
   // Return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn = nullptr) -> bool;
 
+  // Look up a batch of keys with one shared descent; (*result)[i] gets the values of keys[i].
+  // Return the number of keys that were found
+  auto GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *result,
+                 Transaction *txn = nullptr) -> size_t;
+
   void Leafspilt(page_id_t pageid);
   void Internalspilt(page_id_t pageid, page_id_t son, KeyType &key);
   void Leafmerge(page_id_t pageid, KeyType keyy);
   void Internalmerge(page_id_t pageid, KeyType keyy);
   void Updatezero(page_id_t pageid, KeyType key, int ch);
   void SetFather(page_id_t page);
+  // Return the page id of the leaf that should hold key
+  auto FindLeafPageId(const KeyType &key) -> page_id_t;
+  // Return the page id of the leftmost / rightmost leaf
+  auto FindEdgeLeafPageId(bool rightmost) -> page_id_t;
   // Return the page id of the root node
   auto GetRootPageId() -> page_id_t;
   void SetRootPageId(page_id_t tmp);
@@ -96,6 +131,36 @@ class BPlusTree {
 
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
 
+  // Range scan between lower and upper, a missing bound is unbounded
+  auto Range(const std::optional<KeyType> &lower, bool lower_inclusive, const std::optional<KeyType> &upper,
+             bool upper_inclusive) -> INDEXITERATOR_TYPE;
+
+  // Range scan from upper down to lower
+  auto ReverseRange(const std::optional<KeyType> &lower, bool lower_inclusive, const std::optional<KeyType> &upper,
+                    bool upper_inclusive) -> INDEXITERATOR_TYPE;
+
+  // Relaxed underflow: Remove leaves under-full leaves alone (empty ones are still unlinked) and
+  // remembers them for Compact() instead of merging or borrowing right away
+  void SetLazyMerge(bool lazy_merge);
+
+  // Merge the under-full leaves that Remove deferred in lazy merge mode
+  void Compact();
+
+  // Non-unique mode: Insert accepts duplicate keys and keeps every value of a key, in its leaf while there are
+  // few of them and in a posting list after that. Must be set while the tree is empty
+  void SetUnique(bool unique);
+  auto IsUnique() -> bool;
+
+  // Return the page that records the root, enough to reopen the tree
+  auto GetHeaderPageId() const -> page_id_t { return header_page_id_; }
+
+  // Number of splits, merges, borrows and unlinked empty leaves done so far
+  auto GetStructureModificationCount() -> size_t;
+
+  // Height, page counts and fill factors; reads every page once but only looks at page headers and posting lists.
+  // Holds mtx_ for one page at a time, so the counts may mix pages from before and after concurrent inserts
+  auto GetStats() -> BPlusTreeStats;
+
   // Print the B+ tree
   void Print(BufferPoolManager *bpm);
 
@@ -135,6 +200,18 @@ class BPlusTree {
    */
   auto ToPrintableBPlusTree(page_id_t root_id) -> PrintableBPlusTree;
 
+  // Remove key and free its posting list, the caller holds mtx_
+  void RemoveKey(const KeyType &key);
+  // Add value to the values of key, which is in leaf leaf_id; return false if it is already there
+  auto AppendValue(page_id_t leaf_id, const KeyType &key, const ValueType &value) -> bool;
+  // Replace every posting RID in values[from, end) by the RIDs of its list
+  void ExpandPostings(std::vector<ValueType> *values, size_t from = 0);
+  // One GetStats walk, locking mtx_ per page unless the caller holds it; false if the structure changed midway
+  auto WalkStats(BPlusTreeStats *stats, bool locked) -> bool;
+
+  // GetStats walks that may lose to concurrent splits and merges before one holds mtx_ throughout
+  static constexpr int STATS_MAX_RETRIES = 3;
+
   // member variable
   std::string index_name_;
   BufferPoolManager *bpm_;
@@ -144,6 +221,11 @@ class BPlusTree {
   int internal_max_size_;
   page_id_t header_page_id_;
   std::shared_mutex mtx_;
+  bool lazy_merge_{false};
+  bool unique_{true};
+  // 延迟合并的叶子，Compact 时再检查是否还需要合并
+  std::set<page_id_t> deferred_leaves_;
+  size_t smo_count_{0};
 };
 
 /**
@@ -13,11 +13,13 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "container/hash/hash_function.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/index_lookup_cache.h"
 #include "storage/index/index.h"
 
 namespace bustub {
@@ -27,7 +29,12 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+  /**
+   * @param unique false lets several RIDs share one key
+   * @param header_page_id header page of a tree already in the database file to reopen, INVALID_PAGE_ID makes a new one
+   */
+  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                 bool unique = true, page_id_t header_page_id = INVALID_PAGE_ID);
 
   auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool override;
 
@@ -35,17 +42,50 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                Transaction *transaction) override;
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  /**
+   * Iterate the entries whose key lies between lower and upper. A missing bound
+   * (nullopt) leaves that side open; the returned iterator reaches
+   * GetEndIterator() by itself once it walks past the far bound.
+   * @param reverse walk from upper down to lower instead
+   */
+  auto ScanRange(const std::optional<KeyType> &lower, bool lower_inclusive, const std::optional<KeyType> &upper,
+                 bool upper_inclusive, bool reverse = false) -> INDEXITERATOR_TYPE;
+
+  /**
+   * Put a cache of capacity slots in front of ScanKey/ScanKeys, 0 removes it.
+   * Must not run concurrently with other operations on the index.
+   */
+  void SetLookupCacheCapacity(size_t capacity);
+
+  /** @return the page recording the root of the tree, the catalog keeps it to reopen the index */
+  auto GetHeaderPageId() const -> page_id_t { return container_->GetHeaderPageId(); }
+
+  /** @return false if several RIDs may share one key */
+  auto IsUnique() -> bool { return container_->IsUnique(); }
+
+  /** @return height, page counts and fill factors of the underlying tree */
+  auto GetStats() -> BPlusTreeStats;
+
+  /** @return number of point lookups answered by / missed in the lookup cache */
+  auto GetLookupCacheHits() const -> uint64_t;
+  auto GetLookupCacheMisses() const -> uint64_t;
+
  protected:
   // comparator for key
   KeyComparator comparator_;
   // container
   std::shared_ptr<BPlusTree<KeyType, ValueType, KeyComparator>> container_;
+  // hot key cache for point lookups, nullptr when disabled
+  std::unique_ptr<IndexLookupCache<KeyType>> lookup_cache_;
 };
 
 /** We only support index table with one integer key for now in BusTub. Hardcode everything here. */
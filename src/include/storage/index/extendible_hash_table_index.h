@@ -28,8 +28,9 @@ namespace bustub {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTableIndex : public Index {
  public:
+  /** @param directory_page_id directory of a hash table already in the database file to reopen */
   ExtendibleHashTableIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
-                           const HashFunction<KeyType> &hash_fn);
+                           const HashFunction<KeyType> &hash_fn, page_id_t directory_page_id = INVALID_PAGE_ID);
 
   ~ExtendibleHashTableIndex() override = default;
 
@@ -39,6 +40,9 @@ class ExtendibleHashTableIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /** @return the directory page of the hash table, the catalog keeps it to reopen the index */
+  auto GetDirectoryPageId() const -> page_id_t { return container_.GetDirectoryPageId(); }
+
  protected:
   // comparator for key
   KeyComparator comparator_;
@@ -14,11 +14,101 @@
 
 #include <cstring>
 
+#include "catalog/schema.h"
 #include "storage/table/tuple.h"
+#include "type/type.h"
 #include "type/value.h"
 
 namespace bustub {
 
+/**
+ * Fixed-size columns are stored in index keys in a normalized form: big-endian,
+ * with the sign bit of signed integers flipped and decimals mapped so that their
+ * bit pattern orders like the number. memcmp on such bytes orders them like the
+ * values. Varchar columns stay in tuple format and are compared through Value.
+ */
+inline auto IsNormalizedKeyType(TypeId type) -> bool {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+    case TypeId::TIMESTAMP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** Convert one column at data from tuple format to the normalized form, or back when normalize is false. */
+inline void NormalizeKeyColumn(char *data, TypeId type, bool normalize) {
+  auto size = Type::GetTypeSize(type);
+  uint64_t top_bit = uint64_t{1} << (size * 8 - 1);
+  uint64_t bits = 0;
+  if (normalize) {
+    switch (size) {
+      case 1: {
+        uint8_t v;
+        memcpy(&v, data, 1);
+        bits = v;
+        break;
+      }
+      case 2: {
+        uint16_t v;
+        memcpy(&v, data, 2);
+        bits = v;
+        break;
+      }
+      case 4: {
+        uint32_t v;
+        memcpy(&v, data, 4);
+        bits = v;
+        break;
+      }
+      default:
+        memcpy(&bits, data, 8);
+    }
+    if (type == TypeId::DECIMAL) {
+      bits = (bits & top_bit) != 0 ? ~bits : bits ^ top_bit;
+    } else if (type != TypeId::TIMESTAMP) {
+      bits ^= top_bit;
+    }
+    for (uint64_t i = 0; i < size; i++) {
+      data[i] = static_cast<char>(bits >> ((size - 1 - i) * 8));
+    }
+    return;
+  }
+  for (uint64_t i = 0; i < size; i++) {
+    bits = (bits << 8) | static_cast<uint8_t>(data[i]);
+  }
+  if (type == TypeId::DECIMAL) {
+    bits = (bits & top_bit) != 0 ? bits ^ top_bit : ~bits;
+  } else if (type != TypeId::TIMESTAMP) {
+    bits ^= top_bit;
+  }
+  switch (size) {
+    case 1: {
+      auto v = static_cast<uint8_t>(bits);
+      memcpy(data, &v, 1);
+      break;
+    }
+    case 2: {
+      auto v = static_cast<uint16_t>(bits);
+      memcpy(data, &v, 2);
+      break;
+    }
+    case 4: {
+      auto v = static_cast<uint32_t>(bits);
+      memcpy(data, &v, 4);
+      break;
+    }
+    default:
+      memcpy(data, &bits, 8);
+  }
+}
+
 /**
  * Generic key is used for indexing with opaque data.
  *
@@ -29,16 +119,22 @@ namespace bustub {
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
+  inline void SetFromKey(const Tuple &tuple, const Schema &key_schema) {
     // intialize to 0
     memset(data_, 0, KeySize);
     memcpy(data_, tuple.GetData(), tuple.GetLength());
+    for (const auto &col : key_schema.GetColumns()) {
+      if (col.IsInlined() && IsNormalizedKeyType(col.GetType())) {
+        NormalizeKeyColumn(data_ + col.GetOffset(), col.GetType(), true);
+      }
+    }
   }
 
-  // NOTE: for test purpose only
+  // NOTE: for test purpose only, the key schema is a single bigint
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
     memcpy(data_, &key, sizeof(int64_t));
+    NormalizeKeyColumn(data_, TypeId::BIGINT, true);
   }
 
   inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
@@ -52,12 +148,25 @@ class GenericKey {
       int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
       data_ptr = (data_ + offset);
     }
+    if (is_inlined && IsNormalizedKeyType(column_type)) {
+      char buf[sizeof(int64_t)];
+      memcpy(buf, data_ptr, Type::GetTypeSize(column_type));
+      NormalizeKeyColumn(buf, column_type, false);
+      return Value::DeserializeFrom(buf, column_type);
+    }
     return Value::DeserializeFrom(data_ptr, column_type);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline auto ToString() const -> int64_t { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // interpret the first 8 bytes as a normalized int64_t from data vector
+  inline auto ToString() const -> int64_t {
+    char buf[sizeof(int64_t)];
+    memcpy(buf, data_, sizeof(int64_t));
+    NormalizeKeyColumn(buf, TypeId::BIGINT, false);
+    int64_t key;
+    memcpy(&key, buf, sizeof(int64_t));
+    return key;
+  }
 
   // NOTE: for test purpose only
   // interpret the first 8 bytes as int64_t from data vector
@@ -72,14 +181,23 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * The leading run of normalized columns is compared with a single memcmp; only
+ * the columns after the first varchar are decoded into Values.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
+    if (memcmp_length_ > 0) {
+      int res = memcmp(lhs.data_, rhs.data_, memcmp_length_);
+      if (res != 0) {
+        return res < 0 ? -1 : 1;
+      }
+    }
     uint32_t column_count = key_schema_->GetColumnCount();
 
-    for (uint32_t i = 0; i < column_count; i++) {
+    for (uint32_t i = value_column_start_; i < column_count; i++) {
       Value lhs_value = (lhs.ToValue(key_schema_, i));
       Value rhs_value = (rhs.ToValue(key_schema_, i));
 
@@ -94,13 +212,34 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_},
+        memcmp_length_{other.memcmp_length_},
+        value_column_start_{other.value_column_start_} {}
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {
+    value_column_start_ = key_schema_->GetColumnCount();
+    for (uint32_t i = 0; i < key_schema_->GetColumnCount(); i++) {
+      const auto &col = key_schema_->GetColumn(i);
+      if (!col.IsInlined() || !IsNormalizedKeyType(col.GetType())) {
+        value_column_start_ = i;
+        break;
+      }
+      memcmp_length_ = col.GetOffset() + col.GetFixedLength();
+    }
+    if (memcmp_length_ > KeySize) {
+      // 放不进 key 的 schema 只能逐列比较
+      memcmp_length_ = 0;
+      value_column_start_ = 0;
+    }
+  }
 
  private:
   Schema *key_schema_;
+  // 前 memcmp_length_ 字节是规范化后的定长列，直接 memcmp
+  uint32_t memcmp_length_{0};
+  uint32_t value_column_start_{0};
 };
 
 }  // namespace bustub
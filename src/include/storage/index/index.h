@@ -176,6 +176,21 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for a batch of keys. Indexes that can share work between
+   * probes override this; the default issues one ScanKey per key.
+   * @param keys The index keys
+   * @param result Populated so that (*result)[i] holds the RIDs found for keys[i]
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                        Transaction *transaction) {
+    result->assign(keys.size(), std::vector<RID>{});
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*result)[i], transaction);
+    }
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
@@ -13,17 +13,35 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <optional>
+#include <vector>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree;
+
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
  public:
   // you may define your own constructor based on your member variables
-  IndexIterator(BufferPoolManager *bpm, page_id_t page, int tmp);
+  // tree: re-descended when leaves split or merge between two leaf copies, must outlive the iterator
+  IndexIterator(BufferPoolManager *bpm, page_id_t page, int tmp,
+                BPlusTree<KeyType, ValueType, KeyComparator> *tree = nullptr);
+  /**
+   * Bounded iterator, it becomes End() once the current key passes stop.
+   * @param tree tree being scanned, its comparator checks the stop key, must outlive the iterator
+   * @param stop key to stop at, unbounded when nullopt
+   * @param stop_inclusive whether an entry equal to stop is still returned
+   * @param reverse walk towards smaller keys through GetPrvPageId
+   */
+  IndexIterator(BufferPoolManager *bpm, page_id_t page, int tmp, BPlusTree<KeyType, ValueType, KeyComparator> *tree,
+                std::optional<KeyType> stop, bool stop_inclusive, bool reverse);
   IndexIterator();
   ~IndexIterator();  // NOLINT
 
@@ -33,16 +51,39 @@ class IndexIterator {
 
   auto operator++() -> IndexIterator &;
 
+  /**
+   * Hand out the rest of the current leaf at once and move on to the next leaf.
+   * @param out the entries are appended here
+   * @return number of entries appended, 0 once the iterator is at the end
+   */
+  auto NextBatch(std::vector<MappingType> *out) -> size_t;
+
   auto operator==(const IndexIterator &itr) const -> bool { return (page_ == itr.page_ && size_ == itr.size_); }
 
   auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
+  auto PastStop(const KeyType &key) const -> bool;
+  auto PastLast(const KeyType &key) const -> bool;
+  void LoadLeaf(int start);
+  void NextLeaf();
+  void SetEnd();
+
   // add your own private member variables here
   BufferPoolManager *bpm_;
   page_id_t page_;
   int size_ = 0;
-  MappingType item_;
+  // 当前叶子从 size_ 开始、按扫描方向排好的条目，一次读出来后就不再持有页
+  std::vector<MappingType> entries_;
+  size_t pos_{0};
+  page_id_t neighbor_{INVALID_PAGE_ID};
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_{nullptr};
+  // 最后拷出来的 key 和拷的时候树的 smo 计数；计数变了，neighbor_ 可能已被合并掉，要按 last_ 重新下降
+  std::optional<KeyType> last_;
+  size_t version_{0};
+  std::optional<KeyType> stop_;
+  bool stop_inclusive_{true};
+  bool reverse_{false};
 };
 
 }  // namespace bustub
@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_lookup_cache.h
+//
+// Identification: src/include/storage/index/index_lookup_cache.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT
+#include <type_traits>
+
+#include "common/rid.h"
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * Direct-mapped cache from (normalized) index keys to the RID they point to, put
+ * in front of point lookups for skewed workloads.
+ *
+ * Every slot is a seqlock: readers never block, they copy the slot and count a
+ * version change during the copy as a miss. Writers take the slot by moving its
+ * version to an odd number. The key and RID of a slot are kept in relaxed atomic
+ * words, so a copy that races with a writer is torn but never a data race. A lookup that misses records the slot version before
+ * going to the index and only fills the slot if nothing touched it in between, so
+ * an invalidation that races with the lookup cannot be overwritten by a stale RID.
+ */
+template <typename KeyType>
+class IndexLookupCache {
+ public:
+  /** @param capacity number of slots, rounded up to a power of two */
+  explicit IndexLookupCache(size_t capacity) {
+    size_t size = 2;
+    shift_ = 63;
+    while (size < capacity) {
+      size <<= 1;
+      shift_--;
+    }
+    slots_ = std::make_unique<Slot[]>(size);
+    size_ = size;
+  }
+
+  /** @return true and the cached RID if key is in the cache */
+  auto Lookup(const KeyType &key, RID *rid) -> bool {
+    auto &slot = SlotOf(key);
+    uint64_t version = slot.version_.load(std::memory_order_acquire);
+    if ((version & 1) == 0) {
+      bool valid = slot.valid_.load(std::memory_order_relaxed);
+      Payload payload;
+      slot.Load(&payload);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (valid && slot.version_.load(std::memory_order_relaxed) == version &&
+          memcmp(&payload.key_, &key, sizeof(KeyType)) == 0) {
+        *rid = payload.rid_;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  /** @return the version to hand to Fill() once the index lookup for key is done */
+  auto BeginFill(const KeyType &key) -> uint64_t { return SlotOf(key).version_.load(std::memory_order_acquire); }
+
+  /** Cache key -> rid unless the slot changed since BeginFill() returned version. */
+  void Fill(const KeyType &key, const RID &rid, uint64_t version) {
+    auto &slot = SlotOf(key);
+    if ((version & 1) != 0 ||
+        !slot.version_.compare_exchange_strong(version, version + 1, std::memory_order_acquire)) {
+      return;
+    }
+    Payload payload;
+    payload.key_ = key;
+    payload.rid_ = rid;
+    slot.Store(payload);
+    slot.valid_.store(true, std::memory_order_relaxed);
+    slot.version_.store(version + 2, std::memory_order_release);
+  }
+
+  /** Drop key from the cache, must be called after the index itself changed. */
+  void Invalidate(const KeyType &key) {
+    auto &slot = SlotOf(key);
+    uint64_t version = slot.version_.load(std::memory_order_relaxed);
+    while ((version & 1) != 0 ||
+           !slot.version_.compare_exchange_weak(version, version + 1, std::memory_order_acquire)) {
+      std::this_thread::yield();
+      version = slot.version_.load(std::memory_order_relaxed);
+    }
+    // 即使是别的 key 也要推进版本，这样同一槽位上进行中的 Fill 都会放弃
+    Payload payload;
+    slot.Load(&payload);
+    if (slot.valid_.load(std::memory_order_relaxed) && memcmp(&payload.key_, &key, sizeof(KeyType)) == 0) {
+      slot.valid_.store(false, std::memory_order_relaxed);
+    }
+    slot.version_.store(version + 2, std::memory_order_release);
+  }
+
+  auto GetCapacity() const -> size_t { return size_; }
+
+  auto GetHits() const -> uint64_t { return hits_.load(std::memory_order_relaxed); }
+
+  auto GetMisses() const -> uint64_t { return misses_.load(std::memory_order_relaxed); }
+
+ private:
+  static_assert(std::is_trivially_copyable_v<KeyType> && std::is_trivially_copyable_v<RID>);
+
+  struct Payload {
+    KeyType key_;
+    RID rid_;
+  };
+
+  static constexpr size_t PAYLOAD_WORDS = (sizeof(Payload) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  struct Slot {
+    std::atomic<uint64_t> version_{0};
+    std::atomic<bool> valid_{false};
+    /** The Payload, copied word by word */
+    std::atomic<uint64_t> words_[PAYLOAD_WORDS]{};
+
+    void Load(Payload *payload) const {
+      uint64_t words[PAYLOAD_WORDS];
+      for (size_t i = 0; i < PAYLOAD_WORDS; i++) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      memcpy(payload, words, sizeof(Payload));
+    }
+
+    void Store(const Payload &payload) {
+      uint64_t words[PAYLOAD_WORDS]{};
+      memcpy(words, &payload, sizeof(Payload));
+      for (size_t i = 0; i < PAYLOAD_WORDS; i++) {
+        words_[i].store(words[i], std::memory_order_relaxed);
+      }
+    }
+  };
+
+  auto SlotOf(const KeyType &key) -> Slot & {
+    // HashBytes 的低位分布不均，乘一下再取高位
+    uint64_t hash = HashUtil::HashBytes(reinterpret_cast<const char *>(&key), sizeof(KeyType));
+    return slots_[(hash * 0x9E3779B97F4A7C15ULL) >> shift_];
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t size_;
+  uint32_t shift_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace bustub
@@ -28,6 +28,10 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
+ * Separators are whole keys, neither prefix compressed nor suffix truncated:
+ * the separator of a child is always that child's first key, and the tree
+ * finds the separator to update or delete by comparing it with that key.
+ *
  * Internal page format (keys are stored in increasing order):
  *  --------------------------------------------------------------------------
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
@@ -74,6 +78,8 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   auto ValueIndex(const ValueType &value) const -> int;
 
   auto Searchkey(const KeyType &value, KeyComparator &cmp) const -> int;
+  // slot of the child that covers value, Searchkey returns that child's page id
+  auto SearchIndex(const KeyType &value, KeyComparator &cmp) const -> int;
   /**
    *
    * @param index the index
@@ -20,25 +20,42 @@ namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
 #define LEAF_PAGE_HEADER_SIZE 32
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_SLOT_SPACE (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - sizeof(KeyType))
+// upper bound on entries per leaf: every key differs from its neighbours in at least one byte
+#define LEAF_PAGE_SIZE (LEAF_PAGE_SLOT_SPACE / (sizeof(ValueType) + 1))
+// values a non-unique key keeps inline before they move to posting pages; a list takes at most 1/16 of a leaf
+#define LEAF_PAGE_INLINE_LIST_MAX ((LEAF_PAGE_SLOT_SPACE / 16 - sizeof(uint32_t)) / sizeof(ValueType))
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
+ * page. Keys are unique within the tree.
+ *
+ * Keys are prefix/suffix compressed: the first KeyHead bytes and the last
+ * KeyTail bytes are identical for every key on the page, so they are stored
+ * once in TEMPLATE and each slot only keeps the bytes in between. The slot
+ * width therefore depends on the keys actually living on the page, and the
+ * page is full when the slot area runs out of bytes rather than when it hits
+ * a fixed entry count.
+ *
+ * A non-unique key with a few values keeps them in a list at the end of the
+ * slot area, growing towards the slots; its slot then holds a marker RID
+ * (offset of the list, slot UINT32_MAX - 1). Lists are not kept in any order
+ * and are rewritten whenever one of them changes. Longer lists live on posting
+ * pages, see BPlusTreePostingPage.
  *
  * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ *  ----------------------------------------------------------------------------------------------
+ * | HEADER | TEMPLATE KEY | MID(1) + RID(1) | ... | MID(n) + RID(n) | FREE | ... | COUNT + RIDS |
+ *  ----------------------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 16 bytes in total):
+ *  Header format (size in byte, 32 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | CurrentSize (4) | MaxSize (4) | NextPageId (4) |
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * |  NextPageId (4)
- *  -----------------------------------------------
+ * | PrvPageId (4) | Father (4) | KeyHead (2) | KeyTail (2) | ListBytes (4)
+ *  ---------------------------------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
@@ -61,7 +78,20 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void SetPrvPageId(page_id_t prv_page_id);
   void Setarray(const KeyType &key, const ValueType &value);
   auto KeyAt(int index) const -> KeyType;
+  /** @return the value stored in the slot, the marker of an inline list if the key has one */
   auto ValueAt(int index) const -> ValueType;
+  void SetValueAt(int index, const ValueType &value);
+  /** Append every value of the key at index to out, expanding its inline list. */
+  void ValuesAt(int index, std::vector<ValueType> *out) const;
+  /**
+   * Replace the values of the key at index, keeping two or more in an inline list.
+   * @return false, leaving the page unchanged, if they do not fit
+   */
+  auto SetValuesAt(int index, const std::vector<ValueType> &values) -> bool;
+  /** @return bytes taken by the inline list of the key at index, 0 if it has none */
+  auto ListBytesAt(int index) const -> int;
+  /** Insert the entry at other_index of other at index, inline list included. Throws if it does not fit. */
+  void InsertFrom(const BPlusTreeLeafPage *other, int other_index, int index);
   auto Searchkey(const KeyType &value, KeyComparator &cmp, std::vector<ValueType> *result) const -> bool;
   void Insert(const KeyType &key, const ValueType &value, KeyComparator &cmp);
   auto Spilt(BPlusTreeLeafPage *leaf) -> KeyType;
@@ -71,6 +101,17 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   auto GetFather() const -> page_id_t;
   auto SearchKkey(const KeyType &value, KeyComparator &cmp) -> int;
 
+  /** @return whether key, with an inline list of list_bytes, can be inserted without running out of slot space */
+  auto CanInsert(const KeyType &key, int list_bytes = 0) const -> bool;
+  /** @return whether every entry of other can be appended to this page */
+  auto CanAbsorb(const BPlusTreeLeafPage *other) const -> bool;
+  /** @return true when the page should be split after an insertion */
+  auto IsFull() const -> bool;
+  /** @return true when the page is both below min size and less than half used */
+  auto IsUnderflow() const -> bool;
+  /** @return bytes taken by slots and inline lists, excluding header and template key */
+  auto UsedBytes() const -> int;
+
   /**
    * @brief for test only return a string representing all keys in
    * this leaf page formatted as "(key1,key2,key3,...)"
@@ -97,10 +138,33 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   }
 
  private:
+  auto KeyWidth() const -> int { return static_cast<int>(sizeof(KeyType)) - key_head_ - key_tail_; }
+  auto SlotSize() const -> int { return KeyWidth() + static_cast<int>(sizeof(ValueType)); }
+  auto SlotAt(int index) -> char * { return data_ + sizeof(KeyType) + index * SlotSize(); }
+  auto SlotAt(int index) const -> const char * { return data_ + sizeof(KeyType) + index * SlotSize(); }
+  static auto ListSize(size_t count) -> int { return static_cast<int>(sizeof(uint32_t) + count * sizeof(ValueType)); }
+  static auto IsListMarker(const ValueType &value) -> bool { return value.GetSlotNum() == LIST_SLOT; }
+  void WriteValue(int index, const ValueType &value);
+  auto LoadLists() const -> std::vector<std::vector<ValueType>>;
+  void StoreLists(const std::vector<std::vector<ValueType>> &lists);
+  static void Overlap(const char *lhs, int lhs_head, int lhs_tail, const char *rhs, int rhs_head, int rhs_tail,
+                      int *head, int *tail);
+  void SharedBytes(const KeyType &key, int *head, int *tail) const;
+  void Relayout(int head, int tail);
+  void Compact();
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  void RemoveAt(int index);
+
+  // 表页的槽号和倒排链的标记都用不到这个值，用它标记叶子内的倒排表
+  static constexpr uint32_t LIST_SLOT = UINT32_MAX - 1;
+
   page_id_t next_page_id_;
   page_id_t prv_page_id_;
   page_id_t father_;
-  // Flexible array member for page data.
-  MappingType array_[0];
+  uint16_t key_head_;
+  uint16_t key_tail_;
+  uint32_t list_bytes_;
+  // Flexible array member for page data: template key followed by the slots, inline lists at the end.
+  char data_[0];
 };
 }  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_posting_page.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+#define POSTING_PAGE_HEADER_SIZE 8
+#define POSTING_PAGE_SIZE ((BUSTUB_PAGE_SIZE - POSTING_PAGE_HEADER_SIZE) / sizeof(RID))
+
+/**
+ * Overflow page holding the RIDs of one duplicated key in a non-unique B+ tree.
+ *
+ * A key keeps its RIDs inline in the leaf, up to LEAF_PAGE_INLINE_LIST_MAX of
+ * them. Once the list outgrows that the leaf value is replaced by a posting
+ * RID (see MakePostingRid) naming the head of a chain of these pages; new RIDs
+ * go to the head, a full head gets a fresh page pushed in front of it. The
+ * RIDs of a key are not kept in any order.
+ *
+ * Posting page format:
+ *  ----------------------------------------------------------
+ * | NextPageId (4) | Size (4) | RID(1) | RID(2) | ... | RID(n)
+ *  ----------------------------------------------------------
+ */
+class BPlusTreePostingPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  BPlusTreePostingPage() = delete;
+  BPlusTreePostingPage(const BPlusTreePostingPage &other) = delete;
+
+  void Init(page_id_t next_page_id = INVALID_PAGE_ID);
+
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+  auto GetSize() const -> int { return size_; }
+  auto IsFull() const -> bool { return size_ == static_cast<int>(POSTING_PAGE_SIZE); }
+  auto RidAt(int index) const -> RID { return rids_[index]; }
+
+  void Append(const RID &rid);
+  /** @return the slot of rid on this page, -1 if it is not here */
+  auto Find(const RID &rid) const -> int;
+  /** Remove the RID at index, the last RID takes its place. */
+  void RemoveAt(int index);
+
+  /** @return the leaf value standing for the posting list that starts at page_id */
+  static auto MakePostingRid(page_id_t page_id) -> RID { return {page_id, POSTING_SLOT}; }
+  /** @return true if a leaf value is a posting list rather than a table RID */
+  static auto IsPostingRid(const RID &rid) -> bool { return rid.GetSlotNum() == POSTING_SLOT; }
+
+  /** Append every RID of the posting list starting at head to out. */
+  static void CollectRids(BufferPoolManager *bpm, page_id_t head, std::vector<RID> *out);
+
+  /** Delete every page of the posting list starting at head. */
+  static void FreeList(BufferPoolManager *bpm, page_id_t head);
+
+ private:
+  // 表页里的槽号不可能到这么大，用它标记叶子里的值其实是一条倒排链
+  static constexpr uint32_t POSTING_SLOT = UINT32_MAX;
+
+  page_id_t next_page_id_;
+  int size_;
+  RID rids_[0];
+};
+
+}  // namespace bustub
@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// catalog_page.h
+//
+// Identification: src/include/storage/page/catalog_page.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "common/config.h"
+
+namespace bustub {
+
+#define CATALOG_PAGE_HEADER_SIZE 8
+#define CATALOG_PAGE_DATA_SIZE (BUSTUB_PAGE_SIZE - CATALOG_PAGE_HEADER_SIZE)
+
+/**
+ * One page of the serialized catalog of a database file.
+ *
+ * The catalog is a byte string written across a chain of these pages. The
+ * chain always starts at HEADER_PAGE_ID, so the catalog can be found in a
+ * database file without knowing anything else about it.
+ *
+ * Catalog page format:
+ *  ---------------------------------------------------
+ * | NextPageId (4) | Size (4) | Data (Size bytes) ...
+ *  ---------------------------------------------------
+ */
+class CatalogPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  CatalogPage() = delete;
+  CatalogPage(const CatalogPage &other) = delete;
+
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+  auto GetSize() const -> uint32_t { return size_; }
+  auto GetData() const -> const char * { return data_; }
+
+  /** Overwrite the data of this page with size bytes at src, size must not exceed CATALOG_PAGE_DATA_SIZE. */
+  void SetData(const char *src, uint32_t size) {
+    memcpy(data_, src, size);
+    size_ = size;
+  }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t size_;
+  char data_[0];
+};
+
+}  // namespace bustub
@@ -59,13 +59,14 @@ class HashTableBlockPage {
    * Attempts to insert a key and value into an index in the block.
    * The insert is thread safe. It uses compare and swap to claim the index,
    * and then writes the key and value into the index, and then marks the
-   * index as readable.
+   * index as readable. A tombstone is reused, which is only safe while the
+   * caller holds the block's write latch.
    *
    * @param bucket_ind index to write the key and value to
    * @param key key to insert
    * @param value value to insert
    * @return If the value is inserted successfully, it returns true. If the
-   * index is marked as occupied before the key and value can be inserted,
+   * index holds a readable pair or is claimed by another insert first,
    * Insert returns false.
    */
   auto Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) -> bool;
@@ -93,6 +94,17 @@ class HashTableBlockPage {
    */
   auto IsReadable(slot_offset_t bucket_ind) const -> bool;
 
+  /**
+   * Returns 64 occupied flags starting at slot 64 * word_ind, bit i being slot 64 * word_ind + i.
+   * Slots past the end of the block read as not occupied.
+   */
+  auto OccupiedWord(size_t word_ind) const -> uint64_t;
+
+  /**
+   * Returns 64 readable flags starting at slot 64 * word_ind, same layout as OccupiedWord().
+   */
+  auto ReadableWord(size_t word_ind) const -> uint64_t;
+
   /**
    * Scan the bucket and collect values that have the matching key
    *
@@ -139,6 +151,8 @@ class HashTableBlockPage {
   void PrintBucket();
 
  private:
+  static auto LoadWord(const std::atomic_char *bitmap, size_t word_ind) -> uint64_t;
+
   std::atomic_char occupied_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
 
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
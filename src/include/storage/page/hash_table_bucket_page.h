@@ -33,6 +33,9 @@ namespace bustub {
  *  The above format omits the space required for the occupied_ and
  *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
  *
+ *  A bucket whose pairs all hash alike cannot be split, so it grows a chain of
+ *  overflow pages of the same format instead, linked through overflow_page_id_.
+ *
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBucketPage {
@@ -40,6 +43,21 @@ class HashTableBucketPage {
   // Delete all constructor / destructor to ensure memory safety
   HashTableBucketPage() = delete;
 
+  /**
+   * Empties the bucket and unlinks its overflow pages. Must be called on a newly allocated bucket page.
+   */
+  void Init();
+
+  /**
+   * @return the page id of the next page in the bucket's overflow chain, INVALID_PAGE_ID at the end of the chain
+   */
+  auto GetOverflowPageId() const -> page_id_t { return overflow_page_id_; }
+
+  /**
+   * @param overflow_page_id the page to link as the next page in the bucket's overflow chain
+   */
+  void SetOverflowPageId(page_id_t overflow_page_id) { overflow_page_id_ = overflow_page_id; }
+
   /**
    * Scan the bucket and collect values that have the matching key
    *
@@ -64,6 +82,11 @@ class HashTableBucketPage {
    */
   auto Remove(KeyType key, ValueType value, KeyComparator cmp) -> bool;
 
+  /**
+   * @return true if the bucket holds the key and value pair
+   */
+  auto Contains(KeyType key, ValueType value, KeyComparator cmp) const -> bool;
+
   /**
    * Gets the key at an index in the bucket.
    *
@@ -138,6 +161,7 @@ class HashTableBucketPage {
   void PrintBucket();
 
  private:
+  page_id_t overflow_page_id_;
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
   char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
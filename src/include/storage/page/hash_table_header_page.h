@@ -89,13 +89,18 @@ class HashTableHeaderPage {
    */
   auto NumBlocks() -> size_t;
 
+  /**
+   * @return the number of block page_ids that fit in the header page
+   */
+  static auto MaxBlocks() -> size_t;
+
  private:
-  __attribute__((unused)) lsn_t lsn_;
-  __attribute__((unused)) size_t size_;
-  __attribute__((unused)) page_id_t page_id_;
-  __attribute__((unused)) size_t next_ind_;
+  lsn_t lsn_;
+  size_t size_;
+  page_id_t page_id_;
+  size_t next_ind_;
   // Flexible array member for page data.
-  __attribute__((unused)) page_id_t block_page_ids_[1];
+  page_id_t block_page_ids_[1];
 };
 
 }  // namespace bustub
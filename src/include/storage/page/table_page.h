@@ -85,6 +85,11 @@ class TablePage {
    */
   auto GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple>;
 
+  /**
+   * Read a tuple in place: its meta and the address of its data on the page, valid while the page stays latched.
+   */
+  auto GetTupleData(const RID &rid) const -> std::pair<TupleMeta, const char *>;
+
   /**
    * Read a tuple meta from a table.
    */
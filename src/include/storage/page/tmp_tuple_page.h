@@ -6,10 +6,6 @@
 
 namespace bustub {
 
-// To pass the test cases for this class, you must follow the existing TmpTuplePage format and implement the
-// existing functions exactly as they are! It may be helpful to look at TablePage.
-// Remember that this task is optional, you get full credit if you finish the next task.
-
 /**
  * TmpTuplePage format:
  *
@@ -17,20 +13,55 @@ namespace bustub {
  * | PageId (4) | LSN (4) | FreeSpace (4) | (free space) | TupleSize2 | TupleData2 | TupleSize1 | TupleData1 |
  *
  * We choose this format because DeserializeExpression expects to read Size followed by Data.
+ * Tuples grow from the end of the page towards the header, FreeSpace is the offset of the last one inserted.
+ * Operators that run out of memory spill their rows to chains of these pages, see SpillFile.
  */
 class TmpTuplePage : public Page {
  public:
   void Init(page_id_t page_id, uint32_t page_size) {
     memcpy(GetData(), &page_id, sizeof(page_id_t));
-    memcpy(GetData() + sizeof(page_id_t), &page_size, sizeof(uint32_t));
+    SetFreeSpacePointer(page_size);
+  }
+
+  auto GetTablePageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /**
+   * Append a tuple to the page.
+   * @param tuple the tuple to copy in, its RID is not kept
+   * @param[out] out where the tuple went
+   * @return false if the page has no room left for the tuple
+   */
+  auto Insert(const Tuple &tuple, TmpTuple *out) -> bool {
+    uint32_t size = sizeof(uint32_t) + tuple.GetLength();
+    if (GetFreeSpacePointer() < HEADER_SIZE + size) {
+      return false;
+    }
+    uint32_t offset = GetFreeSpacePointer() - size;
+    tuple.SerializeTo(GetData() + offset);
+    SetFreeSpacePointer(offset);
+    *out = TmpTuple(GetTablePageId(), offset);
+    return true;
   }
 
-  auto GetTablePageId() -> page_id_t { return INVALID_PAGE_ID; }
+  /** Read back the tuple stored at `offset`, as returned by Insert(). */
+  void Get(size_t offset, Tuple *tuple) { tuple->DeserializeFrom(GetData() + offset); }
 
-  auto Insert(const Tuple &tuple, TmpTuple *out) -> bool { return false; }
+  /** @return the offset of the most recently inserted tuple, the page size if the page is empty */
+  auto GetFreeSpacePointer() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
+
+  /** @return the offset of the tuple inserted before the one at `offset`, or the page size past the first one */
+  auto NextOffset(size_t offset) -> size_t {
+    return offset + sizeof(uint32_t) + *reinterpret_cast<uint32_t *>(GetData() + offset);
+  }
 
  private:
   static_assert(sizeof(page_id_t) == 4);
+  static constexpr size_t OFFSET_FREE_SPACE = sizeof(page_id_t) + sizeof(lsn_t);
+  static constexpr size_t HEADER_SIZE = OFFSET_FREE_SPACE + sizeof(uint32_t);
+
+  void SetFreeSpacePointer(uint32_t free_space_pointer) {
+    memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
+  }
 };
 
 }  // namespace bustub
@@ -44,6 +44,14 @@ class TableHeap {
    */
   explicit TableHeap(BufferPoolManager *bpm);
 
+  /**
+   * Open a table heap that already lives in the buffer pool's database file.
+   * @param bpm the buffer pool manager
+   * @param first_page_id the id of the first page
+   * @param last_page_id the last page as of when it was recorded, pages appended after that are followed from it
+   */
+  TableHeap(BufferPoolManager *bpm, page_id_t first_page_id, page_id_t last_page_id);
+
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return std::nullopt.
    * @param meta tuple meta
@@ -84,6 +92,9 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the id of the page new tuples are appended to */
+  auto GetLastPageId() -> page_id_t;
+
   /**
    * Update a tuple in place. SHOULD NOT BE USED UNLESS YOU WANT TO OPTIMIZE FOR PROJECT 4.
    * @param meta new tuple meta
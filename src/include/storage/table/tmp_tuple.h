@@ -4,8 +4,7 @@
 
 namespace bustub {
 
-// Document this class! What does it represent?
-
+/** TmpTuple locates a tuple in a TmpTuplePage: the page and the byte offset of the tuple's size field. */
 class TmpTuple {
  public:
   TmpTuple(page_id_t page_id, size_t offset) : page_id_(page_id), offset_(offset) {}
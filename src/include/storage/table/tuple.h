@@ -93,6 +93,9 @@ class Tuple {
   // checks the schema to see how to return the Value.
   auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
 
+  // Get the value of a specified column of a tuple serialized at data, e.g. in place on a table page
+  static auto GetValue(const char *data, const Schema *schema, uint32_t column_idx) -> Value;
+
   // Generates a key tuple given schemas and attributes
   auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) -> Tuple;
 
@@ -106,7 +109,7 @@ class Tuple {
 
  private:
   // Get the starting storage address of specific column
-  auto GetDataPtr(const Schema *schema, uint32_t column_idx) const -> const char *;
+  static auto GetDataPtr(const char *data, const Schema *schema, uint32_t column_idx) -> const char *;
 
   RID rid_{};  // if pointing to the table heap, the rid is valid
   std::vector<char> data_;
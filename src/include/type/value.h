@@ -42,6 +42,7 @@ class Value {
   friend class TimestampType;
   friend class BooleanType;
   friend class VarlenType;
+  friend class HashUtil;
 
  public:
   explicit Value(const TypeId type) : manage_data_(false), type_id_(type) { size_.len_ = BUSTUB_VALUE_NULL; }
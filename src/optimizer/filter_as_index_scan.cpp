@@ -0,0 +1,189 @@
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "catalog/schema.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Range on one column collected from the conjuncts of a filter. */
+struct ColumnRange {
+  std::optional<Value> lower_;
+  bool lower_inclusive_{true};
+  std::optional<Value> upper_;
+  bool upper_inclusive_{true};
+};
+
+/** Split an AND tree into its comparisons. Other terms are skipped, the full predicate is re-checked anyway. */
+void CollectConjuncts(const AbstractExpressionRef &expr, std::vector<const ComparisonExpression *> *out) {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(expr.get()); logic != nullptr) {
+    if (logic->logic_type_ == LogicType::And) {
+      CollectConjuncts(logic->GetChildAt(0), out);
+      CollectConjuncts(logic->GetChildAt(1), out);
+    }
+    return;
+  }
+  if (const auto *cmp = dynamic_cast<const ComparisonExpression *>(expr.get()); cmp != nullptr) {
+    out->push_back(cmp);
+  }
+}
+
+/** Swap the operator of `const cmp col` so that the column is always on the left. */
+auto FlipComparison(ComparisonType type) -> ComparisonType {
+  switch (type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return type;
+  }
+}
+
+void TightenLower(ColumnRange *range, const Value &val, bool inclusive) {
+  if (!range->lower_.has_value() || val.CompareGreaterThan(*range->lower_) == CmpBool::CmpTrue) {
+    range->lower_ = val;
+    range->lower_inclusive_ = inclusive;
+  } else if (val.CompareEquals(*range->lower_) == CmpBool::CmpTrue) {
+    range->lower_inclusive_ = range->lower_inclusive_ && inclusive;
+  }
+}
+
+void TightenUpper(ColumnRange *range, const Value &val, bool inclusive) {
+  if (!range->upper_.has_value() || val.CompareLessThan(*range->upper_) == CmpBool::CmpTrue) {
+    range->upper_ = val;
+    range->upper_inclusive_ = inclusive;
+  } else if (val.CompareEquals(*range->upper_) == CmpBool::CmpTrue) {
+    range->upper_inclusive_ = range->upper_inclusive_ && inclusive;
+  }
+}
+
+/** @return the range the filter puts on column col_idx, nullopt if it puts none */
+auto ExtractRange(const std::vector<const ComparisonExpression *> &conjuncts, uint32_t col_idx, TypeId col_type)
+    -> std::optional<ColumnRange> {
+  ColumnRange range;
+  bool found = false;
+  for (const auto *cmp : conjuncts) {
+    const auto *col = dynamic_cast<const ColumnValueExpression *>(cmp->GetChildAt(0).get());
+    const auto *val = dynamic_cast<const ConstantValueExpression *>(cmp->GetChildAt(1).get());
+    auto type = cmp->comp_type_;
+    if (col == nullptr || val == nullptr) {
+      col = dynamic_cast<const ColumnValueExpression *>(cmp->GetChildAt(1).get());
+      val = dynamic_cast<const ConstantValueExpression *>(cmp->GetChildAt(0).get());
+      type = FlipComparison(type);
+    }
+    if (col == nullptr || val == nullptr || col->GetColIdx() != col_idx || val->val_.GetTypeId() != col_type ||
+        val->val_.IsNull()) {
+      continue;
+    }
+    switch (type) {
+      case ComparisonType::Equal:
+        TightenLower(&range, val->val_, true);
+        TightenUpper(&range, val->val_, true);
+        break;
+      case ComparisonType::GreaterThan:
+        TightenLower(&range, val->val_, false);
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        TightenLower(&range, val->val_, true);
+        break;
+      case ComparisonType::LessThan:
+        TightenUpper(&range, val->val_, false);
+        break;
+      case ComparisonType::LessThanOrEqual:
+        TightenUpper(&range, val->val_, true);
+        break;
+      default:
+        continue;
+    }
+    found = true;
+  }
+  if (!found) {
+    return std::nullopt;
+  }
+  return range;
+}
+
+auto IsPoint(const ColumnRange &range) -> bool {
+  return range.lower_.has_value() && range.upper_.has_value() && range.lower_inclusive_ && range.upper_inclusive_ &&
+         range.lower_->CompareEquals(*range.upper_) == CmpBool::CmpTrue;
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan, bool point_only) -> AbstractPlanNodeRef {
+  // 在 update/delete 下面边扫索引边改索引不安全，只允许单列索引上的点查（结果在 Init 里一次取完）
+  if (plan->GetType() == PlanType::Update || plan->GetType() == PlanType::Delete) {
+    point_only = true;
+  }
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeFilterAsIndexScan(child, point_only));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  const SeqScanPlanNode *seq_scan = nullptr;
+  AbstractExpressionRef predicate;
+  if (optimized_plan->GetType() == PlanType::Filter) {
+    const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*optimized_plan);
+    if (filter_plan.GetChildPlan()->GetType() == PlanType::SeqScan) {
+      seq_scan = dynamic_cast<const SeqScanPlanNode *>(filter_plan.GetChildPlan().get());
+      if (seq_scan->filter_predicate_ == nullptr) {
+        predicate = filter_plan.GetPredicate();
+      }
+    }
+  } else if (optimized_plan->GetType() == PlanType::SeqScan) {
+    seq_scan = dynamic_cast<const SeqScanPlanNode *>(optimized_plan.get());
+    predicate = seq_scan->filter_predicate_;
+  }
+  if (seq_scan == nullptr || predicate == nullptr) {
+    return optimized_plan;
+  }
+
+  std::vector<const ComparisonExpression *> conjuncts;
+  CollectConjuncts(predicate, &conjuncts);
+  const auto *table_info = catalog_.GetTable(seq_scan->GetTableOid());
+  AbstractPlanNodeRef index_scan;
+  for (const auto *index_info : catalog_.GetTableIndexes(table_info->name_)) {
+    // only the first key column is globally ordered in the index
+    auto first_col = index_info->index_->GetKeyAttrs()[0];
+    auto range = ExtractRange(conjuncts, first_col, table_info->schema_.GetColumn(first_col).GetType());
+    // 哈希索引只能回答单列上的等值查询
+    bool is_hash = index_info->index_type_ == IndexType::HashTableIndex;
+    if (!range.has_value() || ((point_only || is_hash) &&
+                               (index_info->index_->GetKeyAttrs().size() != 1 || !IsPoint(*range)))) {
+      continue;
+    }
+    // 能用哈希索引点查就不走 B+ 树
+    if (index_scan == nullptr || is_hash) {
+      index_scan = std::make_shared<IndexScanPlanNode>(seq_scan->output_schema_, index_info->index_oid_, predicate,
+                                                       range->lower_, range->lower_inclusive_, range->upper_,
+                                                       range->upper_inclusive_, false);
+    }
+    if (is_hash) {
+      break;
+    }
+  }
+  if (index_scan != nullptr) {
+    return index_scan;
+  }
+  return optimized_plan;
+}
+
+}  // namespace bustub
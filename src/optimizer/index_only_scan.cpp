@@ -0,0 +1,114 @@
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Append the child columns expr reads to cols. */
+void CollectColumns(const AbstractExpressionRef &expr, std::vector<uint32_t> *cols) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (const auto *col = dynamic_cast<const ColumnValueExpression *>(expr.get()); col != nullptr) {
+    cols->push_back(col->GetColIdx());
+  }
+  for (const auto &child : expr->GetChildren()) {
+    CollectColumns(child, cols);
+  }
+}
+
+/** @return the columns the only child of plan has to produce, nullopt if plan is not understood here */
+auto RequiredOfChild(const AbstractPlanNode &plan, const std::optional<std::vector<uint32_t>> &required)
+    -> std::optional<std::vector<uint32_t>> {
+  std::vector<uint32_t> cols;
+  switch (plan.GetType()) {
+    case PlanType::Projection:
+      for (const auto &expr : dynamic_cast<const ProjectionPlanNode &>(plan).GetExpressions()) {
+        CollectColumns(expr, &cols);
+      }
+      return cols;
+    case PlanType::Aggregation: {
+      const auto &agg = dynamic_cast<const AggregationPlanNode &>(plan);
+      for (const auto &expr : agg.GetGroupBys()) {
+        CollectColumns(expr, &cols);
+      }
+      for (const auto &expr : agg.GetAggregates()) {
+        CollectColumns(expr, &cols);
+      }
+      return cols;
+    }
+    default:
+      break;
+  }
+  // 下面这几种原样输出子节点的列，父节点要的列它们也要
+  if (!required.has_value()) {
+    return std::nullopt;
+  }
+  cols = *required;
+  switch (plan.GetType()) {
+    case PlanType::Limit:
+      return cols;
+    case PlanType::Filter:
+      CollectColumns(dynamic_cast<const FilterPlanNode &>(plan).GetPredicate(), &cols);
+      return cols;
+    case PlanType::Sort:
+      for (const auto &[type, expr] : dynamic_cast<const SortPlanNode &>(plan).GetOrderBy()) {
+        CollectColumns(expr, &cols);
+      }
+      return cols;
+    case PlanType::TopN:
+      for (const auto &[type, expr] : dynamic_cast<const TopNPlanNode &>(plan).GetOrderBy()) {
+        CollectColumns(expr, &cols);
+      }
+      return cols;
+    default:
+      return std::nullopt;
+  }
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeIndexOnlyScan(const AbstractPlanNodeRef &plan,
+                                      const std::optional<std::vector<uint32_t>> &required) -> AbstractPlanNodeRef {
+  if (plan->GetType() == PlanType::IndexScan) {
+    const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(*plan);
+    if (!required.has_value()) {
+      return plan;
+    }
+    auto cols = *required;
+    CollectColumns(index_scan.predicate_, &cols);
+    if (!catalog_.GetIndex(index_scan.GetIndexOid())->CoversColumns(cols)) {
+      return plan;
+    }
+    auto index_only = std::make_shared<IndexScanPlanNode>(index_scan);
+    index_only->index_only_ = true;
+    return index_only;
+  }
+
+  // update/delete 等其它节点下面一律按需要所有列处理，不会走 index-only
+  std::optional<std::vector<uint32_t>> child_required;
+  if (plan->GetChildren().size() == 1) {
+    child_required = RequiredOfChild(*plan, required);
+  }
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeIndexOnlyScan(child, child_required));
+  }
+  return plan->CloneWithChildren(std::move(children));
+}
+
+}  // namespace bustub
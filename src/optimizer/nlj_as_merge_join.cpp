@@ -0,0 +1,143 @@
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "binder/bound_order_by.h"
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/merge_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** A `<left column> = <right column>` condition of a join, columns as indexes into each child's output */
+struct EquiKey {
+  const ColumnValueExpression *left_;
+  const ColumnValueExpression *right_;
+};
+
+/** @return `false` unless expr is a conjunction of equalities between a left and a right column */
+auto CollectEquiKeys(const AbstractExpression *expr, std::vector<EquiKey> *keys) -> bool {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(expr); logic != nullptr) {
+    return logic->logic_type_ == LogicType::And && CollectEquiKeys(logic->children_[0].get(), keys) &&
+           CollectEquiKeys(logic->children_[1].get(), keys);
+  }
+  const auto *cmp = dynamic_cast<const ComparisonExpression *>(expr);
+  if (cmp == nullptr || cmp->comp_type_ != ComparisonType::Equal) {
+    return false;
+  }
+  const auto *a = dynamic_cast<const ColumnValueExpression *>(cmp->children_[0].get());
+  const auto *b = dynamic_cast<const ColumnValueExpression *>(cmp->children_[1].get());
+  if (a == nullptr || b == nullptr || a->GetTupleIdx() == b->GetTupleIdx()) {
+    return false;
+  }
+  keys->push_back(a->GetTupleIdx() == 0 ? EquiKey{a, b} : EquiKey{b, a});
+  return true;
+}
+
+}  // namespace
+
+auto Optimizer::ProvidedOrder(const AbstractPlanNode &plan) -> std::vector<uint32_t> {
+  std::vector<uint32_t> order;
+  switch (plan.GetType()) {
+    case PlanType::IndexScan: {
+      const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(plan);
+      const auto *index = catalog_.GetIndex(index_scan.GetIndexOid());
+      if (index->index_type_ == IndexType::BPlusTreeIndex && !index_scan.descending_) {
+        order = index->index_->GetKeyAttrs();
+      }
+      return order;
+    }
+    case PlanType::Sort:
+      for (const auto &[type, expr] : dynamic_cast<const SortPlanNode &>(plan).GetOrderBy()) {
+        const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get());
+        if ((type != OrderByType::ASC && type != OrderByType::DEFAULT) || column == nullptr) {
+          break;
+        }
+        order.push_back(column->GetColIdx());
+      }
+      return order;
+    case PlanType::Projection: {
+      // 投影把子节点的列挪了位置，顺序跟着映射过来，断在第一个没被原样输出的列
+      const auto &exprs = dynamic_cast<const ProjectionPlanNode &>(plan).GetExpressions();
+      for (auto col : ProvidedOrder(*plan.GetChildAt(0))) {
+        bool found = false;
+        for (uint32_t i = 0; i < exprs.size() && !found; i++) {
+          const auto *column = dynamic_cast<const ColumnValueExpression *>(exprs[i].get());
+          if (column != nullptr && column->GetColIdx() == col) {
+            order.push_back(i);
+            found = true;
+          }
+        }
+        if (!found) {
+          break;
+        }
+      }
+      return order;
+    }
+    case PlanType::Filter:
+    case PlanType::Limit:
+    case PlanType::MergeJoin:
+      // merge join 按左侧的顺序输出，左侧的列排在最前面
+      return ProvidedOrder(*plan.GetChildAt(0));
+    default:
+      return order;
+  }
+}
+
+auto Optimizer::OptimizeNLJAsMergeJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeNLJAsMergeJoin(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() != PlanType::NestedLoopJoin) {
+    return optimized_plan;
+  }
+  const auto &nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*optimized_plan);
+  if (nlj_plan.GetJoinType() != JoinType::INNER && nlj_plan.GetJoinType() != JoinType::LEFT) {
+    return optimized_plan;
+  }
+  std::vector<EquiKey> keys;
+  if (!CollectEquiKeys(nlj_plan.Predicate().get(), &keys)) {
+    return optimized_plan;
+  }
+
+  // 两侧都要按连接键升序输出，而且键的先后在两侧一致
+  auto left_order = ProvidedOrder(*nlj_plan.GetLeftPlan());
+  auto right_order = ProvidedOrder(*nlj_plan.GetRightPlan());
+  if (left_order.size() < keys.size() || right_order.size() < keys.size()) {
+    return optimized_plan;
+  }
+  std::vector<AbstractExpressionRef> left_exprs;
+  std::vector<AbstractExpressionRef> right_exprs;
+  for (size_t i = 0; i < keys.size(); i++) {
+    const EquiKey *match = nullptr;
+    for (const auto &key : keys) {
+      if (key.left_->GetColIdx() == left_order[i] && key.right_->GetColIdx() == right_order[i]) {
+        match = &key;
+      }
+    }
+    if (match == nullptr) {
+      return optimized_plan;
+    }
+    left_exprs.push_back(
+        std::make_shared<ColumnValueExpression>(0, match->left_->GetColIdx(), match->left_->GetReturnType()));
+    right_exprs.push_back(
+        std::make_shared<ColumnValueExpression>(0, match->right_->GetColIdx(), match->right_->GetReturnType()));
+  }
+  return std::make_shared<MergeJoinPlanNode>(nlj_plan.output_schema_, nlj_plan.GetLeftPlan(), nlj_plan.GetRightPlan(),
+                                             std::move(left_exprs), std::move(right_exprs), nlj_plan.GetJoinType());
+}
+
+}  // namespace bustub
@@ -11,9 +11,14 @@ auto Optimizer::OptimizeCustom(const AbstractPlanNodeRef &plan) -> AbstractPlanN
   auto p = plan;
   p = OptimizeMergeProjection(p);
   p = OptimizeMergeFilterNLJ(p);
-  p = OptimizeNLJAsHashJoin(p);
+  // 排序先换成索引扫描，两侧都已经有序的连接就不用再建哈希表
   p = OptimizeOrderByAsIndexScan(p);
+  p = OptimizeNLJAsMergeJoin(p);
+  p = OptimizeNLJAsHashJoin(p);
+  p = OptimizeFilterAsIndexScan(p);
   p = OptimizeSortLimitAsTopN(p);
+  p = OptimizeIndexOnlyScan(p);
+  p = OptimizeParallelPipelines(p);
   return p;
 }
 
@@ -33,9 +33,11 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
     const auto &order_bys = sort_plan.GetOrderBy();
 
     std::vector<uint32_t> order_by_column_ids;
+    // All order-bys are desc, the index is then walked backwards
+    bool descending = !order_bys.empty() && order_bys[0].first == OrderByType::DESC;
     for (const auto &[order_type, expr] : order_bys) {
-      // Order type is asc or default
-      if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT)) {
+      // Order type is asc or default, or desc for every column
+      if ((order_type == OrderByType::DESC) != descending || order_type == OrderByType::INVALID) {
         return optimized_plan;
       }
 
@@ -50,7 +52,22 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
 
     // Has exactly one child
     BUSTUB_ENSURE(optimized_plan->children_.size() == 1, "Sort with multiple children?? Impossible!");
-    const auto &child_plan = optimized_plan->children_[0];
+    auto child_plan = optimized_plan->children_[0];
+
+    // SELECT v1 FROM t ORDER BY v1 排在投影上面，投影只是挑列的话把排序列映射回表的列
+    const ProjectionPlanNode *projection = nullptr;
+    if (child_plan->GetType() == PlanType::Projection) {
+      projection = dynamic_cast<const ProjectionPlanNode *>(child_plan.get());
+      for (auto &col_id : order_by_column_ids) {
+        const auto *column_value_expr =
+            dynamic_cast<const ColumnValueExpression *>(projection->GetExpressions()[col_id].get());
+        if (column_value_expr == nullptr) {
+          return optimized_plan;
+        }
+        col_id = column_value_expr->GetColIdx();
+      }
+      child_plan = projection->GetChildPlan();
+    }
 
     if (child_plan->GetType() == PlanType::SeqScan) {
       const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*child_plan);
@@ -58,6 +75,9 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
       const auto indices = catalog_.GetTableIndexes(table_info->name_);
 
       for (const auto *index : indices) {
+        if (index->index_type_ != IndexType::BPlusTreeIndex) {
+          continue;  // 哈希索引没有顺序
+        }
         const auto &columns = index->key_schema_.GetColumns();
         // check index key schema == order by columns
         bool valid = true;
@@ -69,7 +89,13 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
             }
           }
           if (valid) {
-            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_);
+            AbstractPlanNodeRef index_scan =
+                std::make_shared<IndexScanPlanNode>(child_plan->output_schema_, index->index_oid_, seq_scan.filter_predicate_,
+                                                    std::nullopt, true, std::nullopt, true, descending);
+            if (projection != nullptr) {
+              return projection->CloneWithChildren({index_scan});
+            }
+            return index_scan;
           }
         }
       }
@@ -0,0 +1,81 @@
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/gather_plan.h"
+#include "execution/plans/repartition_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return `true` if several copies of plan, each scanning part of the bottom table, produce its output together */
+auto IsParallelPipeline(const AbstractPlanNode &plan) -> bool {
+  switch (plan.GetType()) {
+    case PlanType::SeqScan:
+    case PlanType::MockScan:
+      return true;
+    case PlanType::Aggregation:
+      // 没有 group by 时整张表只有一组，拆不开
+      if (dynamic_cast<const AggregationPlanNode &>(plan).GetGroupBys().empty()) {
+        return false;
+      }
+      return IsParallelPipeline(*plan.GetChildAt(0));
+    case PlanType::Filter:
+    case PlanType::Projection:
+    case PlanType::HashJoin:
+    case PlanType::NestedLoopJoin:
+      // join 只拆左侧（探测侧），右侧整体执行一次
+      return IsParallelPipeline(*plan.GetChildAt(0));
+    default:
+      return false;
+  }
+}
+
+/** Put a Repartition on the group-by keys below every aggregation along the left spine of plan. */
+auto AddRepartitions(const AbstractPlanNodeRef &plan, size_t num_partitions) -> AbstractPlanNodeRef {
+  if (plan->GetChildren().empty()) {
+    return plan;
+  }
+  auto children = plan->GetChildren();
+  children[0] = AddRepartitions(children[0], num_partitions);
+  if (plan->GetType() == PlanType::Aggregation) {
+    const auto &agg_plan = dynamic_cast<const AggregationPlanNode &>(*plan);
+    children[0] = std::make_shared<RepartitionPlanNode>(children[0]->output_schema_, children[0],
+                                                        agg_plan.GetGroupBys(), num_partitions);
+  }
+  return plan->CloneWithChildren(std::move(children));
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeParallelPipelines(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  if (parallelism_ <= 1) {
+    return plan;
+  }
+  // update/delete 的扫描要逐行加 X 锁并和写交替进行，保持单线程
+  if (plan->GetType() == PlanType::Update || plan->GetType() == PlanType::Delete) {
+    return plan;
+  }
+  if (IsParallelPipeline(*plan)) {
+    return std::make_shared<GatherPlanNode>(plan->output_schema_,
+                                            AddRepartitions(plan, parallelism_ * REPARTITION_FANOUT), parallelism_);
+  }
+
+  std::vector<AbstractPlanNodeRef> children;
+  for (size_t i = 0; i < plan->GetChildren().size(); i++) {
+    const auto &child = plan->GetChildAt(i);
+    // NLJ 的右侧每来一个左侧元组就要重新 Init，不值得每次都起一组任务
+    if (plan->GetType() == PlanType::NestedLoopJoin && i == 1) {
+      children.emplace_back(child);
+      continue;
+    }
+    children.emplace_back(OptimizeParallelPipelines(child));
+  }
+  return plan->CloneWithChildren(std::move(children));
+}
+
+}  // namespace bustub
@@ -28,7 +28,7 @@ auto Optimizer::MatchTwoKeysIndex(const std::string &table_name, const std::vect
   const auto &key_attrs = index_key_idxs;
   for (const auto *index_info : catalog_.GetTableIndexes(table_name)) {
     // key_attrs相同即可（key_attrs是关键字的列的编号）
-    if (key_attrs == index_info->index_->GetKeyAttrs()) {
+    if (index_info->index_type_ == IndexType::BPlusTreeIndex && key_attrs == index_info->index_->GetKeyAttrs()) {
       return std::make_optional(std::make_tuple(index_info->index_oid_, index_info->name_));
     }
   }
@@ -194,6 +194,18 @@ auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
  */
 auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
 
+/**
+ * Returns the number of whole pages in the db file
+ */
+auto DiskManager::GetNumPages() -> page_id_t {
+  if (file_name_.empty()) {
+    return 0;
+  }
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  int size = GetFileSize(file_name_);
+  return size < 0 ? 0 : size / BUSTUB_PAGE_SIZE;
+}
+
 /**
  * Returns true if the log is currently being flushed
  */
@@ -1,3 +1,4 @@
+#include <numeric>
 #include <sstream>
 #include <string>
 
@@ -10,7 +11,7 @@ namespace bustub {
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager,
-                          const KeyComparator &comparator, int leaf_max_size, int internal_max_size)
+                          const KeyComparator &comparator, int leaf_max_size, int internal_max_size, bool create)
     : index_name_(std::move(name)),
       bpm_(buffer_pool_manager),
       comparator_(std::move(comparator)),
@@ -23,6 +24,9 @@ BPLUSTREE_TYPE::BPlusTree(std::string name, page_id_t header_page_id, BufferPool
   if (internal_max_size_ > static_cast<int>(INTERNAL_PAGE_SIZE)) {
     internal_max_size_ = INTERNAL_PAGE_SIZE;
   }
+  if (!create) {
+    return;
+  }
   WritePageGuard guard = bpm_->FetchPageWrite(header_page_id_);
   auto root_page = guard.AsMut<BPlusTreeHeaderPage>();
   root_page->root_page_id_ = INVALID_PAGE_ID;
@@ -65,10 +69,89 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   }
   auto kp = bpm_->FetchPageRead(tmp);
   auto page = kp.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+  size_t from = result->size();
   bool res = page->Searchkey(key, comparator_, result);
+  ExpandPostings(result, from);
   return res;
 }
 
+/*
+ * Batched point query. The probe keys are visited in sorted order and the
+ * root-to-leaf path of the previous key is kept pinned, so the next key only
+ * climbs back to the lowest node whose subtree still covers it instead of
+ * descending from the root again. Keys landing in the same leaf share it.
+ * @return : number of keys that exist
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *result,
+                               Transaction *txn) -> size_t {
+  std::shared_lock<std::shared_mutex> lock(mtx_);
+  result->assign(keys.size(), std::vector<ValueType>{});
+  page_id_t root = GetRootPageId();
+  if (root == INVALID_PAGE_ID || keys.empty()) {
+    return 0;
+  }
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [this, &keys](size_t a, size_t b) { return comparator_(keys[a], keys[b]) < 0; });
+  // path[i] 是第 i 层当前停留的节点，bound[i] 是它覆盖范围的右边界（不含），nullopt 表示一直到最右
+  std::vector<ReadPageGuard> path;
+  std::vector<std::optional<KeyType>> bound;
+  size_t found = 0;
+  for (auto i : order) {
+    const auto &key = keys[i];
+    while (!path.empty() && bound.back().has_value() && comparator_(key, *bound.back()) >= 0) {
+      path.pop_back();
+      bound.pop_back();
+    }
+    if (path.empty()) {
+      path.emplace_back(bpm_->FetchPageRead(root));
+      bound.emplace_back(std::nullopt);
+    }
+    while (true) {
+      auto page = path.back().template As<InternalPage>();
+      if (page->IsLeafPage()) {
+        break;
+      }
+      int index = page->SearchIndex(key, comparator_);
+      std::optional<KeyType> child_bound = bound.back();
+      if (index + 1 < page->GetSize()) {
+        child_bound = page->KeyAt(index + 1);
+      }
+      page_id_t child = page->ValueAt(index);
+      path.emplace_back(bpm_->FetchPageRead(child));
+      bound.emplace_back(child_bound);
+    }
+    auto leaf_page = path.back().template As<LeafPage>();
+    if (leaf_page->Searchkey(key, comparator_, &(*result)[i])) {
+      ExpandPostings(&(*result)[i]);
+      found++;
+    }
+  }
+  return found;
+}
+
+/*
+ * A non-unique key whose values outgrew its inline list stores a posting RID
+ * in its leaf slot; swap it for the RIDs on the posting pages.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ExpandPostings(std::vector<ValueType> *values, size_t from) {
+  for (size_t i = from; i < values->size(); i++) {
+    if (!BPlusTreePostingPage::IsPostingRid((*values)[i])) {
+      continue;
+    }
+    page_id_t head = (*values)[i].GetPageId();
+    std::vector<ValueType> rids;
+    BPlusTreePostingPage::CollectRids(bpm_, head, &rids);
+    values->erase(values->begin() + i);
+    values->insert(values->begin() + i, rids.begin(), rids.end());
+    // 跳过刚放进来的 RID，它们不会再是倒排链
+    i = i + rids.size() - 1;
+  }
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -112,32 +195,128 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
   auto page1 = kp1.AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
   page_id_t ress = page1->SearchKkey(key, comparator_);
   if (comparator_(key, page1->KeyAt(ress)) == 0) {
-    return false;
+    // 非唯一索引：key 已经在了就把 value 挂到它的倒排表上
+    kp1.Drop();
+    return !unique_ && AppendValue(tmp, key, value);
   }
   kp1.Drop();
-  tmp = GetRootPageId();
-  while (true) {
-    auto kp = bpm_->FetchPageWrite(tmp);
-    auto page = kp.AsMut<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
-    if (page->IsLeafPage()) {
-      break;
-    }
-    page_id_t res = page->Searchkey(key, comparator_);
-    tmp = res;
-  }
+  tmp = FindLeafPageId(key);
   auto x = bpm_->FetchPageWrite(tmp);
   auto leaf_page = x.AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+  // 压缩后的叶子按字节判断是否放得下，放不下就先分裂再重新定位
+  while (!leaf_page->CanInsert(key)) {
+    x.Drop();
+    Leafspilt(tmp);
+    tmp = FindLeafPageId(key);
+    x = bpm_->FetchPageWrite(tmp);
+    leaf_page = x.AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+  }
   auto key_1 = leaf_page->KeyAt(0);
   leaf_page->Insert(key, value, comparator_);
-  int a = leaf_page->GetSize();
-  int b = leaf_page->GetMaxSize();
+  bool full = leaf_page->IsFull();
   x.Drop();
   Updatezero(tmp, key_1, 0);
-  if (a == b) {
+  if (full) {
     Leafspilt(tmp);
   }
   return true;
 }
+
+/*
+ * A key keeps up to LEAF_PAGE_INLINE_LIST_MAX values in a list inside its
+ * leaf; a leaf without room for the list to grow is split first. The list
+ * that outgrows the limit moves to a posting page. From then on new values go
+ * to the head page of the posting list and a full head gets a new page pushed
+ * in front of it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::AppendValue(page_id_t leaf_id, const KeyType &key, const ValueType &value) -> bool {
+  while (true) {
+    auto leaf_guard = bpm_->FetchPageWrite(leaf_id);
+    auto leaf = leaf_guard.AsMut<LeafPage>();
+    int index = leaf->SearchKkey(key, comparator_);
+    std::vector<ValueType> values;
+    leaf->ValuesAt(index, &values);
+    page_id_t head = INVALID_PAGE_ID;
+    if (BPlusTreePostingPage::IsPostingRid(values[0])) {
+      head = values[0].GetPageId();
+      for (page_id_t cur = head; cur != INVALID_PAGE_ID;) {
+        auto guard = bpm_->FetchPageRead(cur);
+        auto posting_page = guard.As<BPlusTreePostingPage>();
+        if (posting_page->Find(value) >= 0) {
+          return false;
+        }
+        cur = posting_page->GetNextPageId();
+      }
+      auto guard = bpm_->FetchPageWrite(head);
+      auto posting_page = guard.AsMut<BPlusTreePostingPage>();
+      if (!posting_page->IsFull()) {
+        posting_page->Append(value);
+        return true;
+      }
+      values.clear();
+    } else {
+      if (std::find(values.begin(), values.end(), value) != values.end()) {
+        return false;
+      }
+      values.push_back(value);
+      if (values.size() <= LEAF_PAGE_INLINE_LIST_MAX) {
+        if (leaf->SetValuesAt(index, values)) {
+          return true;
+        }
+        // 一个 key 的表总放得进只有它一个 key 的叶子
+        if (leaf->GetSize() > 1) {
+          leaf_guard.Drop();
+          Leafspilt(leaf_id);
+          leaf_id = FindLeafPageId(key);
+          continue;
+        }
+      }
+    }
+    page_id_t page_id;
+    auto guard = bpm_->NewPageGuarded(&page_id);
+    if (page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    auto posting_page = guard.AsMut<BPlusTreePostingPage>();
+    posting_page->Init(head);
+    for (const auto &rid : values) {
+      posting_page->Append(rid);
+    }
+    if (head != INVALID_PAGE_ID) {
+      posting_page->Append(value);
+    }
+    leaf->SetValueAt(index, BPlusTreePostingPage::MakePostingRid(page_id));
+    return true;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageId(const KeyType &key) -> page_id_t {
+  page_id_t tmp = GetRootPageId();
+  while (tmp != INVALID_PAGE_ID) {
+    auto kp = bpm_->FetchPageRead(tmp);
+    auto page = kp.As<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
+    if (page->IsLeafPage()) {
+      break;
+    }
+    tmp = page->Searchkey(key, comparator_);
+  }
+  return tmp;
+}
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindEdgeLeafPageId(bool rightmost) -> page_id_t {
+  page_id_t tmp = GetRootPageId();
+  while (tmp != INVALID_PAGE_ID) {
+    auto kp = bpm_->FetchPageRead(tmp);
+    auto page = kp.As<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
+    if (page->IsLeafPage()) {
+      break;
+    }
+    tmp = page->ValueAt(rightmost ? page->GetSize() - 1 : 0);
+  }
+  return tmp;
+}
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Updatezero(bustub::page_id_t pageid, KeyType key, int ch) {
   auto x = bpm_->FetchPageWrite(pageid);
@@ -189,6 +368,7 @@ void BPLUSTREE_TYPE::SetFather(bustub::page_id_t page) {
 }
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Leafspilt(page_id_t pageid) {
+  smo_count_++;
   auto x = bpm_->FetchPageWrite(pageid);
   auto leaf_page = x.AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
   page_id_t t = 0;
@@ -237,6 +417,7 @@ void BPLUSTREE_TYPE::Internalspilt(page_id_t pageid, page_id_t son, KeyType &key
   auto x = bpm_->FetchPageWrite(pageid);
   auto leaf_page = x.AsMut<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
   if (leaf_page->GetSize() == leaf_page->GetMaxSize()) {
+    smo_count_++;
     page_id_t t = 0;
     auto res = bpm_->NewPageGuarded(&t);
     auto internal_page1 = res.AsMut<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
@@ -304,7 +485,95 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
   // Declaration of context instance.
   std::unique_lock<std::shared_mutex> lock(mtx_);
-  // std::cout << 222 << std::endl;
+  RemoveKey(key);
+}
+
+/*
+ * Remove a single value of a non-unique key. The key itself only leaves the
+ * tree with its last value. Posting pages that run empty are freed, and a
+ * posting list down to a single page of at most half the inline limit moves
+ * back into the leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *txn) {
+  std::unique_lock<std::shared_mutex> lock(mtx_);
+  if (unique_) {
+    RemoveKey(key);
+    return;
+  }
+  page_id_t leaf_id = FindLeafPageId(key);
+  if (leaf_id == INVALID_PAGE_ID) {
+    return;
+  }
+  auto leaf_guard = bpm_->FetchPageWrite(leaf_id);
+  auto leaf = leaf_guard.AsMut<LeafPage>();
+  int index = leaf->SearchKkey(key, comparator_);
+  if (leaf->GetSize() == 0 || comparator_(key, leaf->KeyAt(index)) != 0) {
+    return;
+  }
+  std::vector<ValueType> values;
+  leaf->ValuesAt(index, &values);
+  if (!BPlusTreePostingPage::IsPostingRid(values[0])) {
+    auto it = std::find(values.begin(), values.end(), value);
+    if (it == values.end()) {
+      return;
+    }
+    values.erase(it);
+    if (!values.empty()) {
+      // 表只会变短，一定放得下
+      leaf->SetValuesAt(index, values);
+      return;
+    }
+    leaf_guard.Drop();
+    RemoveKey(key);
+    return;
+  }
+  page_id_t head = values[0].GetPageId();
+  page_id_t prev = INVALID_PAGE_ID;
+  page_id_t cur = head;
+  while (cur != INVALID_PAGE_ID) {
+    auto guard = bpm_->FetchPageWrite(cur);
+    auto posting_page = guard.AsMut<BPlusTreePostingPage>();
+    int slot = posting_page->Find(value);
+    if (slot < 0) {
+      prev = cur;
+      cur = posting_page->GetNextPageId();
+      continue;
+    }
+    posting_page->RemoveAt(slot);
+    if (posting_page->GetSize() > 0) {
+      break;
+    }
+    // 这一页空了，从链上摘掉再删
+    page_id_t next = posting_page->GetNextPageId();
+    guard.Drop();
+    if (prev == INVALID_PAGE_ID) {
+      head = next;
+      leaf->SetValueAt(index, BPlusTreePostingPage::MakePostingRid(head));
+    } else {
+      auto prev_guard = bpm_->FetchPageWrite(prev);
+      prev_guard.AsMut<BPlusTreePostingPage>()->SetNextPageId(next);
+    }
+    bpm_->DeletePage(cur);
+    break;
+  }
+  // 链短到只剩半个内联上限时放回叶子里，留出余量免得插删交替时来回搬
+  std::vector<ValueType> rids;
+  {
+    auto guard = bpm_->FetchPageRead(head);
+    auto posting_page = guard.As<BPlusTreePostingPage>();
+    if (posting_page->GetNextPageId() == INVALID_PAGE_ID &&
+        posting_page->GetSize() <= static_cast<int>(LEAF_PAGE_INLINE_LIST_MAX / 2)) {
+      BPlusTreePostingPage::CollectRids(bpm_, head, &rids);
+    }
+  }
+  if (!rids.empty() && leaf->SetValuesAt(index, rids)) {
+    bpm_->DeletePage(head);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveKey(const KeyType &key) {
   page_id_t tmp = GetRootPageId();
   if (tmp == INVALID_PAGE_ID) {
     return;
@@ -324,7 +593,11 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
   if (comparator_(key, page1->KeyAt(ress)) != 0) {
     return;
   }
+  auto value = page1->ValueAt(ress);
   kp1.Drop();
+  if (BPlusTreePostingPage::IsPostingRid(value)) {
+    BPlusTreePostingPage::FreeList(bpm_, value.GetPageId());
+  }
   tmp = GetRootPageId();
   while (true) {
     auto kp = bpm_->FetchPageRead(tmp);
@@ -348,6 +621,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
     return;
   }
   if (page->GetSize() == 0) {
+    smo_count_++;
     {
       auto ipage = page->GetNextPageId();
       if (ipage != -1) {
@@ -374,16 +648,18 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
     int b = in_page->GetMinSize();
     inter.Drop();
     Updatezero(ipage, key1, 1);
-    if (a < b) {
+    // 延迟模式下内部节点只在剩一个孩子时才合并
+    if (a < (lazy_merge_ ? 2 : b)) {
       Internalmerge(ipage, key2);
     }
   } else {
     auto key1 = page->KeyAt(0);
-    int a = page->GetSize();
-    int b = page->GetMinSize();
+    bool underflow = page->IsUnderflow();
     kp.Drop();
     Updatezero(tmp, keyy, 0);
-    if (a < b) {
+    if (underflow && lazy_merge_) {
+      deferred_leaves_.insert(tmp);
+    } else if (underflow) {
       Leafmerge(tmp, key1);
     }
   }
@@ -393,6 +669,7 @@ void BPLUSTREE_TYPE::Leafmerge(page_id_t pageid, KeyType keyy) {
   if (pageid == GetRootPageId()) {
     return;
   }
+  smo_count_++;
   auto kp = bpm_->FetchPageWrite(pageid);
   auto page = kp.AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
   page_id_t next = page->GetNextPageId();
@@ -401,19 +678,23 @@ void BPLUSTREE_TYPE::Leafmerge(page_id_t pageid, KeyType keyy) {
     auto page1 = leaf.AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
     if (page1->GetSize() > page1->GetMinSize()) {
       auto key = page1->KeyAt(0);
-      auto value = page1->ValueAt(0);
+      if (!page->CanInsert(key, page1->ListBytesAt(0))) {
+        return;
+      }
+      page->InsertFrom(page1, 0, page->GetSize());
       page1->Delete(key, comparator_);
       leaf.Drop();
-      page->Setpoint(key, value, page->GetSize());
       Updatezero(next, key, 0);
       kp.Drop();
       return;
     }
+    // 合并后放不下就保留这个不满的叶子
+    if (!page->CanAbsorb(page1)) {
+      return;
+    }
     auto key = page1->KeyAt(0);
     for (int i = 0; i < page1->GetSize(); i++) {
-      auto key1 = page1->KeyAt(i);
-      auto value = page1->ValueAt(i);
-      page->Setpoint(key1, value, page->GetSize());
+      page->InsertFrom(page1, i, page->GetSize());
     }
     auto k = page1->GetNextPageId();
     if (k != -1) {
@@ -445,19 +726,22 @@ void BPLUSTREE_TYPE::Leafmerge(page_id_t pageid, KeyType keyy) {
     auto page1 = leaf.AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
     if (page1->GetSize() > page1->GetMinSize()) {
       auto key = page1->KeyAt(page1->GetSize() - 1);
-      auto value = page1->ValueAt(page1->GetSize() - 1);
+      if (!page->CanInsert(key, page1->ListBytesAt(page1->GetSize() - 1))) {
+        return;
+      }
       auto key1 = page->KeyAt(0);
+      page->InsertFrom(page1, page1->GetSize() - 1, 0);
       page1->Delete(key, comparator_);
-      page->Insert(key, value, comparator_);
       kp.Drop();
       Updatezero(pageid, key1, 0);
       // Set_Father(page_id);
       return;
     }
+    if (!page1->CanAbsorb(page)) {
+      return;
+    }
     for (int i = 0; i < page->GetSize(); i++) {
-      auto key1 = page->KeyAt(i);
-      auto value = page->ValueAt(i);
-      page1->Setpoint(key1, value, page1->GetSize());
+      page1->InsertFrom(page, i, page1->GetSize());
     }
     auto k = page->GetNextPageId();
     if (k != -1) {
@@ -503,6 +787,7 @@ void BPLUSTREE_TYPE::Internalmerge(bustub::page_id_t pageid, KeyType keyy) {
     }
     return;
   }
+  smo_count_++;
   page_id_t next = page->GetPrvPageId();
   if (next != INVALID_PAGE_ID) {
     auto leaf = bpm_->FetchPageWrite(next);
@@ -595,6 +880,170 @@ void BPLUSTREE_TYPE::Internalmerge(bustub::page_id_t pageid, KeyType keyy) {
     return;
   }
 }
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetLazyMerge(bool lazy_merge) {
+  std::unique_lock<std::shared_mutex> lock(mtx_);
+  lazy_merge_ = lazy_merge;
+}
+
+/*
+ * Background pass for lazy merge mode. A deferred leaf may have been merged
+ * into a neighbour or emptied since it was recorded, so it is only merged if
+ * a search for its first key still ends on it and it is still under-full.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Compact() {
+  std::unique_lock<std::shared_mutex> lock(mtx_);
+  auto leaves = std::move(deferred_leaves_);
+  deferred_leaves_.clear();
+  for (auto pageid : leaves) {
+    KeyType first_key;
+    {
+      auto guard = bpm_->FetchPageRead(pageid);
+      auto leaf_page = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+      if (!leaf_page->IsLeafPage() || leaf_page->GetSize() == 0 || !leaf_page->IsUnderflow()) {
+        continue;
+      }
+      first_key = leaf_page->KeyAt(0);
+    }
+    if (FindLeafPageId(first_key) != pageid) {
+      continue;
+    }
+    Leafmerge(pageid, first_key);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetUnique(bool unique) {
+  std::unique_lock<std::shared_mutex> lock(mtx_);
+  unique_ = unique;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsUnique() -> bool {
+  std::shared_lock<std::shared_mutex> lock(mtx_);
+  return unique_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetStructureModificationCount() -> size_t {
+  std::shared_lock<std::shared_mutex> lock(mtx_);
+  return smo_count_;
+}
+
+/*
+ * Walk the tree level by level. Children of an internal page are queued in
+ * key order, so the last level lists the leaves in scan order and the
+ * fragmentation can be read off their page ids without following the sibling
+ * links.
+ *
+ * Each page, with its posting lists, is read under its own shared hold of
+ * mtx_, so writers only wait for one page at a time. A split, merge or new
+ * root between two pages makes the queued page ids stale, the walk then
+ * starts over. After STATS_MAX_RETRIES walks lost that race, the last one
+ * holds mtx_ throughout.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetStats() -> BPlusTreeStats {
+  for (int attempt = 0;; attempt++) {
+    BPlusTreeStats stats;
+    std::shared_lock<std::shared_mutex> hold(mtx_, std::defer_lock);
+    if (attempt == STATS_MAX_RETRIES) {
+      hold.lock();
+    }
+    if (WalkStats(&stats, hold.owns_lock())) {
+      return stats;
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::WalkStats(BPlusTreeStats *stats, bool locked) -> bool {
+  page_id_t root = INVALID_PAGE_ID;
+  size_t version = 0;
+  // 每读一页单独拿一次锁，结构变过就放弃这一遍
+  auto step = [&](auto &&read) -> bool {
+    std::shared_lock<std::shared_mutex> lock(mtx_, std::defer_lock);
+    if (!locked) {
+      lock.lock();
+      if (version != smo_count_ || root != GetRootPageId()) {
+        return false;
+      }
+    }
+    read();
+    return true;
+  };
+  {
+    std::shared_lock<std::shared_mutex> lock(mtx_, std::defer_lock);
+    if (!locked) {
+      lock.lock();
+    }
+    root = GetRootPageId();
+    version = smo_count_;
+  }
+  if (root == INVALID_PAGE_ID) {
+    return true;
+  }
+  std::vector<page_id_t> level{root};
+  std::vector<page_id_t> leaves;
+  while (!level.empty()) {
+    std::vector<page_id_t> next;
+    double fill = 0;
+    for (auto page_id : level) {
+      bool read = step([&] {
+        auto guard = bpm_->FetchPageRead(page_id);
+        if (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+          auto page = guard.As<InternalPage>();
+          stats->internal_pages_++;
+          fill += static_cast<double>(page->GetSize()) / page->GetMaxSize();
+          for (int i = 0; i < page->GetSize(); i++) {
+            next.push_back(page->ValueAt(i));
+          }
+          return;
+        }
+        auto page = guard.As<LeafPage>();
+        stats->leaf_pages_++;
+        stats->key_count_ += page->GetSize();
+        // 压缩后的叶子按字节满，取两者较大的
+        fill += std::max(static_cast<double>(page->GetSize()) / page->GetMaxSize(),
+                         static_cast<double>(page->UsedBytes()) / LEAF_PAGE_SLOT_SPACE);
+        for (int i = 0; i < page->GetSize(); i++) {
+          std::vector<ValueType> values;
+          page->ValuesAt(i, &values);
+          if (!BPlusTreePostingPage::IsPostingRid(values[0])) {
+            stats->value_count_ += values.size();
+            continue;
+          }
+          for (page_id_t posting = values[0].GetPageId(); posting != INVALID_PAGE_ID;) {
+            auto posting_guard = bpm_->FetchPageRead(posting);
+            auto posting_page = posting_guard.As<BPlusTreePostingPage>();
+            stats->posting_pages_++;
+            stats->value_count_ += posting_page->GetSize();
+            posting = posting_page->GetNextPageId();
+          }
+        }
+        leaves.push_back(page_id);
+      });
+      if (!read) {
+        return false;
+      }
+    }
+    stats->level_fill_.push_back(fill / level.size());
+    level = std::move(next);
+  }
+  stats->height_ = stats->level_fill_.size();
+  if (leaves.size() > 1) {
+    size_t jumps = 0;
+    for (size_t i = 1; i < leaves.size(); i++) {
+      if (leaves[i] != leaves[i - 1] + 1) {
+        jumps++;
+      }
+    }
+    stats->fragmentation_ = static_cast<double>(jumps) / (leaves.size() - 1);
+  }
+  return true;
+}
+
 /*****************************************************************************
  * INDEX ITERATOR
  *****************************************************************************/
@@ -623,7 +1072,7 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
     page_id_t res = page->Searchkey(key, comparator_);
     tmp = res;
   }
-  return INDEXITERATOR_TYPE(bpm_, tmp, 0);
+  return INDEXITERATOR_TYPE(bpm_, tmp, 0, this);
 }
 
 /*
@@ -656,7 +1105,78 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
       break;
     }
   }
-  return INDEXITERATOR_TYPE(bpm_, tmp, ans);
+  return INDEXITERATOR_TYPE(bpm_, tmp, ans, this);
+}
+
+/*
+ * Forward iterator over the keys between lower and upper, either bound may be
+ * missing (nullopt) or exclusive. The iterator stops by itself at upper.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Range(const std::optional<KeyType> &lower, bool lower_inclusive,
+                           const std::optional<KeyType> &upper, bool upper_inclusive) -> INDEXITERATOR_TYPE {
+  std::shared_lock<std::shared_mutex> lock(mtx_);
+  page_id_t tmp = lower.has_value() ? FindLeafPageId(*lower) : FindEdgeLeafPageId(false);
+  if (tmp == INVALID_PAGE_ID) {
+    return End();
+  }
+  auto guard = bpm_->FetchPageRead(tmp);
+  auto leaf_page = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+  int index = 0;
+  if (lower.has_value()) {
+    // 找到第一个 >= lower（不含等号时 > lower）的位置
+    while (index < leaf_page->GetSize()) {
+      int res = comparator_(leaf_page->KeyAt(index), *lower);
+      if (res > 0 || (res == 0 && lower_inclusive)) {
+        break;
+      }
+      index++;
+    }
+  }
+  if (index == leaf_page->GetSize()) {
+    tmp = leaf_page->GetNextPageId();
+    index = 0;
+    if (tmp == INVALID_PAGE_ID) {
+      return End();
+    }
+  }
+  guard.Drop();
+  return INDEXITERATOR_TYPE(bpm_, tmp, index, this, upper, upper_inclusive, false);
+}
+
+/*
+ * Same range as Range(), walked from upper down to lower through the prv links.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::ReverseRange(const std::optional<KeyType> &lower, bool lower_inclusive,
+                                  const std::optional<KeyType> &upper, bool upper_inclusive) -> INDEXITERATOR_TYPE {
+  std::shared_lock<std::shared_mutex> lock(mtx_);
+  page_id_t tmp = upper.has_value() ? FindLeafPageId(*upper) : FindEdgeLeafPageId(true);
+  if (tmp == INVALID_PAGE_ID) {
+    return End();
+  }
+  auto guard = bpm_->FetchPageRead(tmp);
+  auto leaf_page = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+  int index = leaf_page->GetSize() - 1;
+  if (upper.has_value()) {
+    while (index >= 0) {
+      int res = comparator_(leaf_page->KeyAt(index), *upper);
+      if (res < 0 || (res == 0 && upper_inclusive)) {
+        break;
+      }
+      index--;
+    }
+  }
+  if (index < 0) {
+    tmp = leaf_page->GetPrvPageId();
+    if (tmp == INVALID_PAGE_ID) {
+      return End();
+    }
+    guard = bpm_->FetchPageRead(tmp);
+    index = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>()->GetSize() - 1;
+  }
+  guard.Drop();
+  return INDEXITERATOR_TYPE(bpm_, tmp, index, this, lower, lower_inclusive, true);
 }
 
 /*
@@ -16,39 +16,106 @@ namespace bustub {
  * Constructor
  */
 INDEX_TEMPLATE_ARGUMENTS
-BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
+BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                                     bool unique, page_id_t header_page_id)
     : Index(std::move(metadata)), comparator_(GetMetadata()->GetKeySchema()) {
-  page_id_t header_page_id;
-  buffer_pool_manager->NewPage(&header_page_id);
-  container_ = std::make_shared<BPlusTree<KeyType, ValueType, KeyComparator>>(GetMetadata()->GetName(), header_page_id,
-                                                                              buffer_pool_manager, comparator_);
+  bool create = header_page_id == INVALID_PAGE_ID;
+  if (create) {
+    buffer_pool_manager->NewPage(&header_page_id);
+  }
+  container_ = std::make_shared<BPlusTree<KeyType, ValueType, KeyComparator>>(
+      GetMetadata()->GetName(), header_page_id, buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE,
+      create);
+  container_->SetUnique(unique);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
-  return container_->Insert(index_key, rid, transaction);
+  bool inserted = container_->Insert(index_key, rid, transaction);
+  if (lookup_cache_ != nullptr) {
+    lookup_cache_->Invalidate(index_key);
+  }
+  return inserted;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
-  container_->Remove(index_key, transaction);
+  container_->Remove(index_key, rid, transaction);
+  if (lookup_cache_ != nullptr) {
+    lookup_cache_->Invalidate(index_key);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
+  if (lookup_cache_ == nullptr) {
+    container_->GetValue(index_key, result, transaction);
+    return;
+  }
+  RID rid;
+  if (lookup_cache_->Lookup(index_key, &rid)) {
+    result->push_back(rid);
+    return;
+  }
+  auto version = lookup_cache_->BeginFill(index_key);
+  auto found = result->size();
   container_->GetValue(index_key, result, transaction);
+  if (result->size() == found + 1) {
+    lookup_cache_->Fill(index_key, result->back(), version);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                                    Transaction *transaction) {
+  // construct scan index keys, the tree sorts them and walks down once
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i], *GetKeySchema());
+  }
+
+  if (lookup_cache_ == nullptr) {
+    container_->GetValues(index_keys, result, transaction);
+    return;
+  }
+  // 命中缓存的直接填，剩下的再一起查树
+  result->assign(keys.size(), std::vector<RID>{});
+  std::vector<size_t> miss_slots;
+  std::vector<KeyType> miss_keys;
+  std::vector<uint64_t> versions;
+  for (size_t i = 0; i < keys.size(); i++) {
+    RID rid;
+    if (lookup_cache_->Lookup(index_keys[i], &rid)) {
+      (*result)[i].push_back(rid);
+      continue;
+    }
+    miss_slots.push_back(i);
+    miss_keys.push_back(index_keys[i]);
+    versions.push_back(lookup_cache_->BeginFill(index_keys[i]));
+  }
+  if (miss_keys.empty()) {
+    return;
+  }
+  std::vector<std::vector<RID>> miss_result;
+  container_->GetValues(miss_keys, &miss_result, transaction);
+  for (size_t i = 0; i < miss_slots.size(); i++) {
+    if (miss_result[i].size() == 1) {
+      lookup_cache_->Fill(miss_keys[i], miss_result[i][0], versions[i]);
+    }
+    (*result)[miss_slots[i]] = std::move(miss_result[i]);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -60,6 +127,40 @@ auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) -> INDEXITERATOR
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetEndIterator() -> INDEXITERATOR_TYPE { return container_->End(); }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::ScanRange(const std::optional<KeyType> &lower, bool lower_inclusive,
+                                     const std::optional<KeyType> &upper, bool upper_inclusive, bool reverse)
+    -> INDEXITERATOR_TYPE {
+  if (reverse) {
+    return container_->ReverseRange(lower, lower_inclusive, upper, upper_inclusive);
+  }
+  return container_->Range(lower, lower_inclusive, upper, upper_inclusive);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetStats() -> BPlusTreeStats {
+  return container_->GetStats();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::SetLookupCacheCapacity(size_t capacity) {
+  if (capacity == 0) {
+    lookup_cache_ = nullptr;
+    return;
+  }
+  lookup_cache_ = std::make_unique<IndexLookupCache<KeyType>>(capacity);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetLookupCacheHits() const -> uint64_t {
+  return lookup_cache_ == nullptr ? 0 : lookup_cache_->GetHits();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetLookupCacheMisses() const -> uint64_t {
+  return lookup_cache_ == nullptr ? 0 : lookup_cache_->GetMisses();
+}
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
@@ -2,7 +2,9 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <shared_mutex>
 
+#include "storage/index/b_plus_tree.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
@@ -12,14 +14,29 @@ namespace bustub {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, page_id_t page, int tmp) {
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, page_id_t page, int tmp,
+                                  BPlusTree<KeyType, ValueType, KeyComparator> *tree) {
   bpm_ = bpm;
   page_ = page;
   size_ = tmp;
+  tree_ = tree;
   if (page_ != -1) {
-    auto leaf = bpm_->FetchPageRead(page_);
-    auto leaf_page = leaf.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
-    item_ = MappingType(leaf_page->KeyAt(size_), leaf_page->ValueAt(size_));
+    LoadLeaf(size_);
+  }
+}
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, page_id_t page, int tmp,
+                                  BPlusTree<KeyType, ValueType, KeyComparator> *tree, std::optional<KeyType> stop,
+                                  bool stop_inclusive, bool reverse)
+    : bpm_(bpm),
+      page_(page),
+      size_(tmp),
+      tree_(tree),
+      stop_(std::move(stop)),
+      stop_inclusive_(stop_inclusive),
+      reverse_(reverse) {
+  if (page_ != -1) {
+    LoadLeaf(size_);
   }
 }
 INDEX_TEMPLATE_ARGUMENTS
@@ -31,32 +48,165 @@ INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::IsEnd() -> bool { return page_ == -1; }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { return this->item_; }
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { return entries_[pos_]; }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
-  auto leaf = bpm_->FetchPageRead(page_);
-  auto leaf_page = leaf.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
-  size_++;
-  if (size_ == leaf_page->GetSize()) {
-    auto next_id = leaf_page->GetNextPageId();
-    if (next_id != -1) {
-      size_ = 0;
-      page_ = next_id;
-      auto guard = bpm_->FetchPageRead(page_);
-      auto leaf1 = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
-      item_ = {leaf1->KeyAt(size_), leaf1->ValueAt(size_)};
-    } else {
-      page_ = -1;
-      size_ = -1;
-      item_ = {};
+auto INDEXITERATOR_TYPE::PastStop(const KeyType &key) const -> bool {
+  if (!stop_.has_value()) {
+    return false;
+  }
+  int res = tree_->comparator_(key, *stop_);
+  if (reverse_) {
+    res = -res;
+  }
+  return res > 0 || (res == 0 && !stop_inclusive_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::PastLast(const KeyType &key) const -> bool {
+  if (!last_.has_value()) {
+    return true;
+  }
+  int res = tree_->comparator_(key, *last_);
+  return reverse_ ? res < 0 : res > 0;
+}
+
+/*
+ * Copy leaf page_ from slot start on (start < 0: from the first slot in scan
+ * direction) under a single read latch and cut it at the stop key. Leaves
+ * with nothing left to return are skipped. The leaf after it is hinted to the
+ * buffer pool so that its read overlaps with the caller consuming this one.
+ * The caller holds the tree latch.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::LoadLeaf(int start) {
+  if (tree_ != nullptr) {
+    version_ = tree_->smo_count_;
+  }
+  while (true) {
+    entries_.clear();
+    pos_ = 0;
+    {
+      auto leaf = bpm_->FetchPageRead(page_);
+      auto leaf_page = leaf.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+      neighbor_ = reverse_ ? leaf_page->GetPrvPageId() : leaf_page->GetNextPageId();
+      // 非唯一 key 的倒排表在这里展开，每个 RID 一个条目
+      auto append = [&](int i) {
+        std::vector<RID> rids;
+        leaf_page->ValuesAt(i, &rids);
+        if (BPlusTreePostingPage::IsPostingRid(rids[0])) {
+          page_id_t head = rids[0].GetPageId();
+          rids.clear();
+          BPlusTreePostingPage::CollectRids(bpm_, head, &rids);
+        }
+        auto key = leaf_page->KeyAt(i);
+        for (const auto &rid : rids) {
+          entries_.emplace_back(key, rid);
+        }
+      };
+      if (reverse_) {
+        if (start < 0) {
+          start = leaf_page->GetSize() - 1;
+        }
+        for (int i = start; i >= 0; i--) {
+          append(i);
+        }
+      } else {
+        if (start < 0) {
+          start = 0;
+        }
+        for (int i = start; i < leaf_page->GetSize(); i++) {
+          append(i);
+        }
+      }
+    }
+    size_ = start;
+    // 重新下降后的叶子里可能还有已经交出去的 key
+    size_t skip = 0;
+    while (skip < entries_.size() && !PastLast(entries_[skip].first)) {
+      skip++;
+    }
+    entries_.erase(entries_.begin(), entries_.begin() + skip);
+    size_ += reverse_ ? -static_cast<int>(skip) : static_cast<int>(skip);
+    for (size_t i = 0; i < entries_.size(); i++) {
+      if (PastStop(entries_[i].first)) {
+        entries_.erase(entries_.begin() + i, entries_.end());
+        neighbor_ = INVALID_PAGE_ID;
+        break;
+      }
+    }
+    if (!entries_.empty()) {
+      if (tree_ != nullptr) {
+        last_ = entries_.back().first;
+      }
+      bpm_->PrefetchPage(neighbor_);
+      return;
+    }
+    if (neighbor_ == INVALID_PAGE_ID) {
+      SetEnd();
+      return;
     }
-  } else {
-    item_ = {leaf_page->KeyAt(size_), leaf_page->ValueAt(size_)};
+    page_ = neighbor_;
+    start = -1;
+  }
+}
+
+/*
+ * Move onto the next leaf under the tree latch in shared mode. If the tree
+ * split, merged or borrowed since the previous copy, neighbor_ may be gone or
+ * may have handed keys to the leaf already copied, so the scan re-descends to
+ * the key it copied last and goes on past it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::NextLeaf() {
+  std::shared_lock<std::shared_mutex> lock;
+  if (tree_ != nullptr) {
+    lock = std::shared_lock<std::shared_mutex>(tree_->mtx_);
+    if (last_.has_value() && version_ != tree_->smo_count_) {
+      neighbor_ = tree_->FindLeafPageId(*last_);
+    }
+  }
+  if (neighbor_ == INVALID_PAGE_ID) {
+    SetEnd();
+    return;
+  }
+  page_ = neighbor_;
+  LoadLeaf(-1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SetEnd() {
+  page_ = -1;
+  size_ = -1;
+  entries_.clear();
+  pos_ = 0;
+  neighbor_ = INVALID_PAGE_ID;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  if (page_ == -1) {
+    return *this;
+  }
+  pos_++;
+  size_ += reverse_ ? -1 : 1;
+  if (pos_ == entries_.size()) {
+    NextLeaf();
   }
   return *this;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::NextBatch(std::vector<MappingType> *out) -> size_t {
+  if (page_ == -1) {
+    return 0;
+  }
+  size_t count = entries_.size() - pos_;
+  out->insert(out->end(), entries_.begin() + pos_, entries_.end());
+  NextLeaf();
+  return count;
+}
+
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
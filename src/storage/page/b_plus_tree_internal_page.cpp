@@ -120,6 +120,10 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const ->
 }
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Searchkey(const KeyType &value, KeyComparator &cmp) const -> int {
+  return array_[SearchIndex(value, cmp)].second;
+}
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::SearchIndex(const KeyType &value, KeyComparator &cmp) const -> int {
   int l = 0;
   int r = GetSize() - 1;
   while (l <= r) {
@@ -133,7 +137,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Searchkey(const KeyType &value, KeyComparat
   if (r == -1) {
     r = 0;
   }
-  return array_[r].second;
+  return r;
 }
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Spilt(BPlusTreeInternalPage *leaf) -> KeyType {
@@ -9,9 +9,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstring>
 #include <sstream>
 
 #include "common/exception.h"
+#include "common/macros.h"
 #include "common/rid.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
@@ -27,12 +29,18 @@ namespace bustub {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(int max_size) {
+  static_assert(sizeof(BPlusTreeLeafPage) + sizeof(KeyType) + LEAF_PAGE_SLOT_SPACE <= BUSTUB_PAGE_SIZE,
+                "leaf page header outgrew LEAF_PAGE_HEADER_SIZE");
+  static_assert(LEAF_PAGE_INLINE_LIST_MAX >= 2, "leaf page too small for inline lists");
   SetMaxSize(max_size);
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
   SetNextPageId(-1);
   SetPrvPageId(-1);
   SetFather(-1);
+  key_head_ = sizeof(KeyType);
+  key_tail_ = 0;
+  list_bytes_ = 0;
 }
 
 /**
@@ -50,23 +58,89 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::SetPrvPageId(bustub::page_id_t prv_page_id) { prv_page_id_ = prv_page_id; }
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::Setpoint(KeyType &key, ValueType &value, int index) {
-  array_[index].first = key;
-  array_[index].second = value;
-  IncreaseSize(1);
+  InsertAt(index, key, value);
 }
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::SetFather(bustub::page_id_t page) { father_ = page; }
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetFather() const -> page_id_t { return father_; }
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType { return array_[index].second; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  ValueType value;
+  memcpy(reinterpret_cast<char *>(&value), SlotAt(index) + KeyWidth(), sizeof(ValueType));
+  return value;
+}
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  if (!IsListMarker(ValueAt(index))) {
+    WriteValue(index, value);
+    return;
+  }
+  // 换成单个值只会腾出空间
+  SetValuesAt(index, {value});
+}
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::ValuesAt(int index, std::vector<ValueType> *out) const {
+  auto value = ValueAt(index);
+  if (!IsListMarker(value)) {
+    out->push_back(value);
+    return;
+  }
+  const char *list = SlotAt(0) + value.GetPageId();
+  uint32_t count;
+  memcpy(&count, list, sizeof(uint32_t));
+  size_t from = out->size();
+  out->resize(from + count);
+  memcpy(reinterpret_cast<char *>(out->data() + from), list + sizeof(uint32_t), count * sizeof(ValueType));
+}
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::SetValuesAt(int index, const std::vector<ValueType> &values) -> bool {
+  BUSTUB_ASSERT(!values.empty(), "a leaf entry needs a value");
+  int list_bytes = values.size() > 1 ? ListSize(values.size()) : 0;
+  if (GetSize() * SlotSize() + static_cast<int>(list_bytes_) - ListBytesAt(index) + list_bytes >
+      static_cast<int>(LEAF_PAGE_SLOT_SPACE)) {
+    return false;
+  }
+  auto lists = LoadLists();
+  if (values.size() > 1) {
+    lists[index] = values;
+  } else {
+    lists[index].clear();
+    WriteValue(index, values[0]);
+  }
+  StoreLists(lists);
+  return true;
+}
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ListBytesAt(int index) const -> int {
+  auto value = ValueAt(index);
+  if (!IsListMarker(value)) {
+    return 0;
+  }
+  uint32_t count;
+  memcpy(&count, SlotAt(0) + value.GetPageId(), sizeof(uint32_t));
+  return ListSize(count);
+}
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertFrom(const BPlusTreeLeafPage *other, int other_index, int index) {
+  auto key = other->KeyAt(other_index);
+  if (!CanInsert(key, other->ListBytesAt(other_index))) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "leaf page overflow");
+  }
+  std::vector<ValueType> values;
+  other->ValuesAt(other_index, &values);
+  InsertAt(index, key, values[0]);
+  if (values.size() > 1) {
+    SetValuesAt(index, values);
+  }
+}
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::SearchKkey(const KeyType &value, KeyComparator &cmp) -> int {
   int l = 0;
   int r = GetSize() - 1;
   while (l <= r) {
     int mid = (l + r) >> 1;
-    if (cmp(value, array_[mid].first) >= 0) {
+    if (cmp(value, KeyAt(mid)) >= 0) {
       l = mid + 1;
     } else {
       r = mid - 1;
@@ -80,11 +154,14 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::SearchKkey(const KeyType &value, KeyComparator
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Searchkey(const KeyType &value, KeyComparator &cmp,
                                            std::vector<ValueType> *result) const -> bool {
+  if (GetSize() == 0) {
+    return false;
+  }
   int l = 0;
   int r = GetSize() - 1;
   while (l <= r) {
     int mid = (l + r) >> 1;
-    if (cmp(value, array_[mid].first) >= 0) {
+    if (cmp(value, KeyAt(mid)) >= 0) {
       l = mid + 1;
     } else {
       r = mid - 1;
@@ -93,16 +170,17 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Searchkey(const KeyType &value, KeyComparator &
   if (r == -1) {
     r = 0;
   }
-  if (cmp(value, array_[r].first) == 0) {
-    result->push_back(array_[r].second);
+  if (cmp(value, KeyAt(r)) == 0) {
+    ValuesAt(r, result);
     return true;
   }
   return false;
 }
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::Setarray(const KeyType &key, const ValueType &value) {
-  array_[GetSize()].first = key;
-  array_[GetSize()].second = value;
+  // 只写入槽位，size 由调用者自己增加
+  InsertAt(GetSize(), key, value);
+  IncreaseSize(-1);
 }
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, KeyComparator &cmp) {
@@ -110,30 +188,32 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &val
   int r = GetSize() - 1;
   while (l <= r) {
     int mid = (l + r) >> 1;
-    if (cmp(key, array_[mid].first) > 0) {
+    if (cmp(key, KeyAt(mid)) > 0) {
       l = mid + 1;
     } else {
       r = mid - 1;
     }
   }
-  r++;
-  for (int i = GetSize(); i > r; i--) {
-    array_[i] = array_[i - 1];
-  }
-  array_[r].first = key;
-  array_[r].second = value;
-  IncreaseSize(1);
+  InsertAt(r + 1, key, value);
 }
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Spilt(BPlusTreeLeafPage *leaf) -> KeyType {
-  int mid = (this->GetMaxSize()) / 2;
+  int mid = GetSize() / 2;
   leaf->SetMaxSize(this->GetMaxSize());
-  leaf->SetSize(this->GetSize() - mid);
+  leaf->SetSize(0);
+  leaf->key_head_ = sizeof(KeyType);
+  leaf->key_tail_ = 0;
+  leaf->list_bytes_ = 0;
   for (int i = mid; i < GetSize(); i++) {
-    leaf->array_[i - mid] = this->array_[i];
+    leaf->InsertFrom(this, i, i - mid);
   }
+  auto lists = LoadLists();
+  lists.resize(mid);
   this->SetSize(mid);
-  return leaf->array_[0].first;
+  StoreLists(lists);
+  // the lower half usually shares more bytes than the whole page did
+  Compact();
+  return leaf->KeyAt(0);
 }
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::Delete(const KeyType &key, KeyComparator &cmp) {
@@ -141,17 +221,14 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Delete(const KeyType &key, KeyComparator &cmp)
   int r = GetSize() - 1;
   while (l <= r) {
     int mid = (l + r) >> 1;
-    if (cmp(key, array_[mid].first) >= 0) {
+    if (cmp(key, KeyAt(mid)) >= 0) {
       l = mid + 1;
     } else {
       r = mid - 1;
     }
   }
-  if (cmp(key, array_[r].first) == 0) {
-    for (int i = r; i < GetSize(); i++) {
-      array_[i] = array_[i + 1];
-    }
-    IncreaseSize(-1);
+  if (r >= 0 && cmp(key, KeyAt(r)) == 0) {
+    RemoveAt(r);
   }
 }
 /*
@@ -160,11 +237,221 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Delete(const KeyType &key, KeyComparator &cmp)
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  KeyType key = array_[index].first;
+  KeyType key;
+  auto *raw = reinterpret_cast<char *>(&key);
+  memcpy(raw, data_, sizeof(KeyType));
+  memcpy(raw + key_head_, SlotAt(index), KeyWidth());
   return key;
 }
 
+/*****************************************************************************
+ * INLINE LISTS
+ *****************************************************************************/
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::WriteValue(int index, const ValueType &value) {
+  memcpy(SlotAt(index) + KeyWidth(), reinterpret_cast<const char *>(&value), sizeof(ValueType));
+}
+
+/*
+ * The inline list of every slot, empty for slots holding a single value.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::LoadLists() const -> std::vector<std::vector<ValueType>> {
+  std::vector<std::vector<ValueType>> lists(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    if (IsListMarker(ValueAt(i))) {
+      ValuesAt(i, &lists[i]);
+    }
+  }
+  return lists;
+}
+
+/*
+ * Pack the non-empty lists against the end of the slot area and point their
+ * slots at them. The caller has checked that they fit next to the slots.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::StoreLists(const std::vector<std::vector<ValueType>> &lists) {
+  int end = LEAF_PAGE_SLOT_SPACE;
+  for (int i = 0; i < GetSize(); i++) {
+    if (lists[i].empty()) {
+      continue;
+    }
+    auto count = static_cast<uint32_t>(lists[i].size());
+    end -= ListSize(count);
+    char *list = SlotAt(0) + end;
+    memcpy(list, &count, sizeof(uint32_t));
+    memcpy(list + sizeof(uint32_t), reinterpret_cast<const char *>(lists[i].data()), count * sizeof(ValueType));
+    WriteValue(i, ValueType(end, LIST_SLOT));
+  }
+  list_bytes_ = LEAF_PAGE_SLOT_SPACE - end;
+  BUSTUB_ASSERT(GetSize() * SlotSize() <= end, "leaf page overflow");
+}
+
+/*****************************************************************************
+ * PREFIX COMPRESSION
+ *****************************************************************************/
+
+/*
+ * Shared leading/trailing bytes of two key sets, each given as a template key plus
+ * the head/tail length already shared inside that set. A single key shares all of
+ * its bytes with itself. A byte that used to belong to the head may end up in the
+ * tail once a new key cuts the head short.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Overlap(const char *lhs, int lhs_head, int lhs_tail, const char *rhs, int rhs_head,
+                                         int rhs_tail, int *head, int *tail) {
+  constexpr int key_size = sizeof(KeyType);
+  auto shared = [&](int pos) {
+    return (pos < lhs_head || pos >= key_size - lhs_tail) && (pos < rhs_head || pos >= key_size - rhs_tail) &&
+           lhs[pos] == rhs[pos];
+  };
+  int h = 0;
+  while (h < key_size && shared(h)) {
+    h++;
+  }
+  int t = 0;
+  while (t < key_size - h && shared(key_size - 1 - t)) {
+    t++;
+  }
+  *head = h;
+  *tail = t;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SharedBytes(const KeyType &key, int *head, int *tail) const {
+  constexpr int key_size = sizeof(KeyType);
+  if (GetSize() == 0) {
+    *head = key_size;
+    *tail = 0;
+    return;
+  }
+  Overlap(data_, key_head_, key_tail_, reinterpret_cast<const char *>(&key), key_size, 0, head, tail);
+}
+
+/*
+ * Widen every slot so that only head/tail bytes are shared. The template key is
+ * left untouched, shrinking the shared region never invalidates it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Relayout(int head, int tail) {
+  std::vector<MappingType> entries;
+  entries.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    entries.emplace_back(KeyAt(i), ValueAt(i));
+  }
+  key_head_ = head;
+  key_tail_ = tail;
+  for (int i = 0; i < GetSize(); i++) {
+    char *slot = SlotAt(i);
+    memcpy(slot, reinterpret_cast<const char *>(&entries[i].first) + key_head_, KeyWidth());
+    memcpy(slot + KeyWidth(), reinterpret_cast<const char *>(&entries[i].second), sizeof(ValueType));
+  }
+}
+
+/*
+ * Recompute the shared bytes from scratch, used after entries left the page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Compact() {
+  constexpr int key_size = sizeof(KeyType);
+  if (GetSize() == 0) {
+    key_head_ = key_size;
+    key_tail_ = 0;
+    return;
+  }
+  std::vector<MappingType> entries;
+  entries.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    entries.emplace_back(KeyAt(i), ValueAt(i));
+  }
+  int size = GetSize();
+  SetSize(0);
+  for (int i = 0; i < size; i++) {
+    InsertAt(i, entries[i].first, entries[i].second);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) {
+  int head;
+  int tail;
+  SharedBytes(key, &head, &tail);
+  // 先按新的槽宽算够不够，Relayout 会直接改写槽区
+  int slot_size = static_cast<int>(sizeof(KeyType) + sizeof(ValueType)) - head - tail;
+  if ((GetSize() + 1) * slot_size + static_cast<int>(list_bytes_) > static_cast<int>(LEAF_PAGE_SLOT_SPACE)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "leaf page overflow");
+  }
+  if (GetSize() == 0) {
+    memcpy(data_, reinterpret_cast<const char *>(&key), sizeof(KeyType));
+    key_head_ = head;
+    key_tail_ = tail;
+  } else if (head != key_head_ || tail != key_tail_) {
+    Relayout(head, tail);
+  }
+  memmove(SlotAt(index + 1), SlotAt(index), (GetSize() - index) * SlotSize());
+  char *slot = SlotAt(index);
+  memcpy(slot, reinterpret_cast<const char *>(&key) + key_head_, KeyWidth());
+  memcpy(slot + KeyWidth(), reinterpret_cast<const char *>(&value), sizeof(ValueType));
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAt(int index) {
+  if (!IsListMarker(ValueAt(index))) {
+    memmove(SlotAt(index), SlotAt(index + 1), (GetSize() - index - 1) * SlotSize());
+    IncreaseSize(-1);
+    return;
+  }
+  // 连同它的倒排表一起去掉，其余的表重新排紧
+  auto lists = LoadLists();
+  lists.erase(lists.begin() + index);
+  memmove(SlotAt(index), SlotAt(index + 1), (GetSize() - index - 1) * SlotSize());
+  IncreaseSize(-1);
+  StoreLists(lists);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::CanInsert(const KeyType &key, int list_bytes) const -> bool {
+  int head;
+  int tail;
+  SharedBytes(key, &head, &tail);
+  int slot_size = static_cast<int>(sizeof(KeyType) + sizeof(ValueType)) - head - tail;
+  return (GetSize() + 1) * slot_size + static_cast<int>(list_bytes_) + list_bytes <=
+         static_cast<int>(LEAF_PAGE_SLOT_SPACE);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::CanAbsorb(const BPlusTreeLeafPage *other) const -> bool {
+  if (other->GetSize() == 0) {
+    return true;
+  }
+  if (GetSize() == 0) {
+    return other->UsedBytes() <= static_cast<int>(LEAF_PAGE_SLOT_SPACE);
+  }
+  int h;
+  int t;
+  Overlap(data_, key_head_, key_tail_, other->data_, other->key_head_, other->key_tail_, &h, &t);
+  int slot_size = static_cast<int>(sizeof(KeyType) + sizeof(ValueType)) - h - t;
+  return (GetSize() + other->GetSize()) * slot_size + static_cast<int>(list_bytes_ + other->list_bytes_) <=
+         static_cast<int>(LEAF_PAGE_SLOT_SPACE);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::IsFull() const -> bool {
+  return GetSize() >= GetMaxSize() ||
+         (GetSize() + 1) * SlotSize() + static_cast<int>(list_bytes_) > static_cast<int>(LEAF_PAGE_SLOT_SPACE);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::IsUnderflow() const -> bool {
+  return GetSize() < GetMinSize() && UsedBytes() * 2 < static_cast<int>(LEAF_PAGE_SLOT_SPACE);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::UsedBytes() const -> int { return GetSize() * SlotSize() + static_cast<int>(list_bytes_); }
+
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeLeafPage<GenericKey<16>, RID, GenericComparator<16>>;
@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_posting_page.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_posting_page.h"
+
+#include "common/macros.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+void BPlusTreePostingPage::Init(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+  size_ = 0;
+}
+
+void BPlusTreePostingPage::Append(const RID &rid) {
+  BUSTUB_ASSERT(!IsFull(), "posting page is full");
+  rids_[size_++] = rid;
+}
+
+auto BPlusTreePostingPage::Find(const RID &rid) const -> int {
+  for (int i = 0; i < size_; i++) {
+    if (rids_[i] == rid) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void BPlusTreePostingPage::RemoveAt(int index) {
+  rids_[index] = rids_[size_ - 1];
+  size_--;
+}
+
+void BPlusTreePostingPage::CollectRids(BufferPoolManager *bpm, page_id_t head, std::vector<RID> *out) {
+  while (head != INVALID_PAGE_ID) {
+    auto guard = bpm->FetchPageRead(head);
+    auto page = guard.As<BPlusTreePostingPage>();
+    out->insert(out->end(), page->rids_, page->rids_ + page->size_);
+    head = page->next_page_id_;
+  }
+}
+
+void BPlusTreePostingPage::FreeList(BufferPoolManager *bpm, page_id_t head) {
+  while (head != INVALID_PAGE_ID) {
+    page_id_t next;
+    {
+      auto guard = bpm->FetchPageRead(head);
+      next = guard.As<BPlusTreePostingPage>()->next_page_id_;
+    }
+    bpm->DeletePage(head);
+    head = next;
+  }
+}
+
+}  // namespace bustub
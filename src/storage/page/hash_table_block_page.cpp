@@ -17,30 +17,82 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::KeyAt(slot_offset_t bucket_ind) const -> KeyType {
-  return {};
+  return array_[bucket_ind].first;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::ValueAt(slot_offset_t bucket_ind) const -> ValueType {
-  return {};
+  return array_[bucket_ind].second;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  auto mask = static_cast<char>(1 << (bucket_ind % 8));
+  if (IsReadable(bucket_ind)) {
+    return false;
+  }
+  // 墓碑直接复用；全新的槽位用 fetch_or 抢，抢输了说明别人先占了
+  if (!IsOccupied(bucket_ind) && (occupied_[bucket_ind / 8].fetch_or(mask) & mask) != 0) {
+    return false;
+  }
+  array_[bucket_ind] = MappingType(key, value);
+  readable_[bucket_ind / 8].fetch_or(mask);
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {}
+void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {
+  readable_[bucket_ind / 8].fetch_and(static_cast<char>(~(1 << (bucket_ind % 8))));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::IsOccupied(slot_offset_t bucket_ind) const -> bool {
-  return false;
+  return (occupied_[bucket_ind / 8].load(std::memory_order_relaxed) & (1 << (bucket_ind % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const -> bool {
-  return false;
+  return (readable_[bucket_ind / 8].load(std::memory_order_acquire) & (1 << (bucket_ind % 8))) != 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::LoadWord(const std::atomic_char *bitmap, size_t word_ind) -> uint64_t {
+  constexpr size_t bitmap_bytes = (BLOCK_ARRAY_SIZE - 1) / 8 + 1;
+  uint64_t word = 0;
+  for (size_t i = 0; i < 8 && word_ind * 8 + i < bitmap_bytes; i++) {
+    auto byte = static_cast<unsigned char>(bitmap[word_ind * 8 + i].load(std::memory_order_acquire));
+    word |= static_cast<uint64_t>(byte) << (i * 8);
+  }
+  return word;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::OccupiedWord(size_t word_ind) const -> uint64_t {
+  return LoadWord(occupied_, word_ind);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::ReadableWord(size_t word_ind) const -> uint64_t {
+  return LoadWord(readable_, word_ind);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::NumReadable() -> uint32_t {
+  uint32_t count = 0;
+  for (size_t w = 0; w * 64 < BLOCK_ARRAY_SIZE; w++) {
+    count += __builtin_popcountll(ReadableWord(w));
+  }
+  return count;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::IsFull() -> bool {
+  return NumReadable() == BLOCK_ARRAY_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::IsEmpty() -> bool {
+  return NumReadable() == 0;
 }
 
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
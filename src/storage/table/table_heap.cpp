@@ -36,6 +36,24 @@ TableHeap::TableHeap(BufferPoolManager *bpm) : bpm_(bpm) {
   first_page->Init();
 }
 
+TableHeap::TableHeap(BufferPoolManager *bpm, page_id_t first_page_id, page_id_t last_page_id)
+    : bpm_(bpm), first_page_id_(first_page_id), last_page_id_(last_page_id) {
+  // 记下的尾页之后可能又挂了新页，顺着链走到真正的尾页
+  while (true) {
+    auto guard = bpm_->FetchPageRead(last_page_id_);
+    auto next_page_id = guard.As<TablePage>()->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    last_page_id_ = next_page_id;
+  }
+}
+
+auto TableHeap::GetLastPageId() -> page_id_t {
+  std::scoped_lock<std::mutex> guard(latch_);
+  return last_page_id_;
+}
+
 auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
                             table_oid_t oid) -> std::optional<RID> {
   std::unique_lock<std::mutex> guard(latch_);
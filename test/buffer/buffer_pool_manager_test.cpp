@@ -15,8 +15,11 @@
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -144,4 +147,48 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Pages read ahead by the prefetch thread, evicting dirty pages of a small pool, keep their content
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const size_t buffer_pool_size = 4;
+  const int num_pages = 32;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2);
+
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // 每个线程一边提示预读，一边取页、检查内容、原样写回弄脏它
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 2; t++) {
+    threads.emplace_back([&bpm, t] {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<int> dist(0, num_pages - 1);
+      for (int round = 0; round < 2000; round++) {
+        bpm->PrefetchPage(dist(rng));
+        auto page_id = dist(rng);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        auto expected = "page " + std::to_string(page_id);
+        page->WLatch();
+        EXPECT_EQ(expected, std::string(page->GetData()));
+        snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+        page->WUnlatch();
+        EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// catalog_persistence_test.cpp
+//
+// Identification: test/common/catalog_persistence_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "common/bustub_instance.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+const char *const DB_FILE = "catalog_persistence_test.db";
+const char *const LOG_FILE = "catalog_persistence_test.log";
+
+auto Query(BustubInstance *db, const std::string &sql) -> std::string {
+  std::stringstream ss;
+  auto writer = SimpleStreamWriter(ss, true, ",");
+  EXPECT_TRUE(db->ExecuteSql(sql, writer)) << sql;
+  return ss.str();
+}
+
+auto Lookup(BustubInstance *db, const std::string &index_name, int v) -> std::vector<RID> {
+  auto *index_info = db->catalog_->GetIndex(index_name, "t1");
+  std::vector<RID> rids;
+  Tuple key({ValueFactory::GetIntegerValue(v)}, &index_info->key_schema_);
+  index_info->index_->ScanKey(key, &rids, nullptr);
+  return rids;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(CatalogPersistenceTest, ReopenTest) {
+  std::remove(DB_FILE);
+  std::remove(LOG_FILE);
+
+  // 多插一些，让表和索引都跨好几页
+  const int rows = 2000;
+  page_id_t tree_header_page_id;
+  {
+    auto db = std::make_unique<BustubInstance>(DB_FILE);
+    Query(db.get(), "CREATE TABLE t1(v1 int, v2 int, v3 varchar(16));");
+    std::string values;
+    for (int i = 0; i < rows; i++) {
+      values += fmt::format("{}({}, {}, 'row{}')", i == 0 ? "" : ", ", i, i % 10, i);
+    }
+    Query(db.get(), fmt::format("INSERT INTO t1 VALUES {};", values));
+    Query(db.get(), "CREATE UNIQUE INDEX t1v1 ON t1(v1);");
+    Query(db.get(), "CREATE INDEX t1v2 ON t1(v2);");
+    Query(db.get(), "CREATE INDEX t1hash ON t1 USING hash (v1);");
+    auto *tree = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(db->catalog_->GetIndex("t1v1", "t1")->index_.get());
+    ASSERT_NE(tree, nullptr);
+    tree_header_page_id = tree->GetHeaderPageId();
+  }
+
+  {
+    auto db = std::make_unique<BustubInstance>(DB_FILE);
+    auto *table_info = db->catalog_->GetTable("t1");
+    ASSERT_NE(table_info, nullptr);
+    EXPECT_EQ(table_info->schema_.ToString(), "(v1:INTEGER, v2:INTEGER, v3:VARCHAR)");
+    EXPECT_EQ(Query(db.get(), "SELECT count(*), sum(v1) FROM t1;"),
+              fmt::format("{},{},\n", rows, rows * (rows - 1) / 2));
+    EXPECT_EQ(Query(db.get(), "SELECT v3 FROM t1 WHERE v1 = 1234;"), "row1234,\n");
+
+    // 索引挂回原来的页，没有重建
+    ASSERT_EQ(db->catalog_->GetTableIndexes("t1").size(), 3);
+    auto *tree = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(db->catalog_->GetIndex("t1v1", "t1")->index_.get());
+    ASSERT_NE(tree, nullptr);
+    EXPECT_EQ(tree->GetHeaderPageId(), tree_header_page_id);
+    EXPECT_TRUE(tree->IsUnique());
+    EXPECT_EQ(Lookup(db.get(), "t1v1", 777).size(), 1);
+    EXPECT_EQ(Lookup(db.get(), "t1hash", 777), Lookup(db.get(), "t1v1", 777));
+    EXPECT_EQ(Lookup(db.get(), "t1v2", 3).size(), rows / 10);
+
+    // 新写的数据进表也进索引，新页不能和旧页撞上
+    Query(db.get(), "INSERT INTO t1 VALUES (-1, 3, 'new');");
+    Query(db.get(), "CREATE TABLE t2(v1 int);");
+    Query(db.get(), "INSERT INTO t2 VALUES (1), (2);");
+    EXPECT_EQ(Lookup(db.get(), "t1v2", 3).size(), rows / 10 + 1);
+  }
+
+  {
+    auto db = std::make_unique<BustubInstance>(DB_FILE);
+    EXPECT_EQ(Query(db.get(), "SELECT count(*) FROM t1;"), fmt::format("{},\n", rows + 1));
+    EXPECT_EQ(Query(db.get(), "SELECT v3 FROM t1 WHERE v1 = -1;"), "new,\n");
+    EXPECT_EQ(Query(db.get(), "SELECT count(*) FROM t2;"), "2,\n");
+    EXPECT_EQ(Lookup(db.get(), "t1hash", -1).size(), 1);
+    EXPECT_EQ(Lookup(db.get(), "t1v2", 3).size(), rows / 10 + 1);
+    // OID 接着往后分配
+    EXPECT_GT(db->catalog_->GetTable("t2")->oid_, db->catalog_->GetTable("t1")->oid_);
+  }
+
+  std::remove(DB_FILE);
+  std::remove(LOG_FILE);
+}
+
+}  // namespace bustub
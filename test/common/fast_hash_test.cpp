@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fast_hash_test.cpp
+//
+// Identification: test/common/fast_hash_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common/util/fast_hash.h"
+#include "common/util/hash_util.h"
+#include "container/hash/hash_function.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FastHashTest, Crc32cTest) {
+  // CRC32C 的标准校验值
+  const std::string check = "123456789";
+  uint32_t crc = 0xFFFFFFFF;
+  for (char c : check) {
+    crc = FastHash::SwCrc32c(crc, static_cast<uint8_t>(c), 1);
+  }
+  EXPECT_EQ(crc ^ 0xFFFFFFFF, 0xE3069283);
+
+  // 硬件指令和软件表算出来的必须一样，否则换机器哈希值就变了
+  std::mt19937_64 gen(15445);
+  for (int i = 0; i < 10000; i++) {
+    uint64_t data = gen();
+    auto seed = static_cast<uint32_t>(gen());
+    EXPECT_EQ(FastHash::Crc32cU64(seed, data), FastHash::SwCrc32c(seed, data, 8));
+    EXPECT_EQ(FastHash::Crc32cU32(seed, static_cast<uint32_t>(data)), FastHash::SwCrc32c(seed, data, 4));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FastHashTest, AlgorithmTest) {
+  std::mt19937_64 gen(15445);
+  std::vector<char> buf(128);
+  for (auto &c : buf) {
+    c = static_cast<char>(gen());
+  }
+  for (auto algorithm : {HashAlgorithm::Auto, HashAlgorithm::Murmur3, HashAlgorithm::Crc32c, HashAlgorithm::Xxh3}) {
+    std::set<uint64_t> hashes;
+    for (size_t len = 0; len <= 100; len++) {
+      auto hash = FastHash::Hash(buf.data(), len, algorithm);
+      // 同样的输入同样的结果，且只读 [0, len)
+      std::vector<char> copy(buf.begin(), buf.begin() + len);
+      EXPECT_EQ(hash, FastHash::Hash(copy.data(), len, algorithm));
+      hashes.insert(hash);
+    }
+    EXPECT_EQ(hashes.size(), 101);
+
+    // 翻转任意一位都要改变哈希值
+    for (size_t bit = 0; bit < 64 * 8; bit++) {
+      auto before = FastHash::Hash(buf.data(), 64, algorithm);
+      buf[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+      EXPECT_NE(before, FastHash::Hash(buf.data(), 64, algorithm));
+      buf[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FastHashTest, DistributionTest) {
+  // 连续整数的低位要均匀，哈希表都是拿低位选桶
+  const int buckets = 256;
+  const int keys = buckets * 100;
+  for (auto algorithm : {HashAlgorithm::Auto, HashAlgorithm::Crc32c, HashAlgorithm::Xxh3}) {
+    std::vector<int> count(buckets);
+    for (int64_t key = 0; key < keys; key++) {
+      count[FastHash::Hash(&key, sizeof(key), algorithm) % buckets]++;
+    }
+    for (int c : count) {
+      EXPECT_GT(c, 50);
+      EXPECT_LT(c, 150);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FastHashTest, HashFunctionKeyLengthTest) {
+  GenericKey<64> a;
+  GenericKey<64> b;
+  memset(a.data_, 0, sizeof(a.data_));
+  memset(b.data_, 0, sizeof(b.data_));
+  a.SetFromInteger(42);
+  b.SetFromInteger(42);
+  b.data_[40] = 1;
+
+  // 只看前 8 个字节，后面的内容不影响结果
+  HashFunction<GenericKey<64>> used(8);
+  EXPECT_EQ(used.GetKeyLength(), 8);
+  EXPECT_EQ(used.GetHash(a), used.GetHash(b));
+
+  HashFunction<GenericKey<64>> full;
+  EXPECT_EQ(full.GetKeyLength(), 64);
+  EXPECT_NE(full.GetHash(a), full.GetHash(b));
+  EXPECT_EQ(HashFunction<GenericKey<64>>(0).GetKeyLength(), 64);
+  EXPECT_EQ(HashFunction<GenericKey<64>>(1000).GetKeyLength(), 64);
+}
+
+// NOLINTNEXTLINE
+TEST(FastHashTest, HashValueTest) {
+  // 不同宽度的整数只要值相等哈希就相等
+  auto tiny = ValueFactory::GetTinyIntValue(7);
+  auto integer = ValueFactory::GetIntegerValue(7);
+  auto big = ValueFactory::GetBigIntValue(7);
+  EXPECT_EQ(HashUtil::HashValue(&tiny), HashUtil::HashValue(&integer));
+  EXPECT_EQ(HashUtil::HashValue(&integer), HashUtil::HashValue(&big));
+  auto other = ValueFactory::GetIntegerValue(8);
+  EXPECT_NE(HashUtil::HashValue(&integer), HashUtil::HashValue(&other));
+
+  std::string s1 = "hello world";
+  std::string s2 = "hello world";
+  auto v1 = ValueFactory::GetVarcharValue(s1);
+  auto v2 = ValueFactory::GetVarcharValue(s2);
+  auto v3 = ValueFactory::GetVarcharValue("hello worle");
+  EXPECT_EQ(HashUtil::HashValue(&v1), HashUtil::HashValue(&v2));
+  EXPECT_NE(HashUtil::HashValue(&v1), HashUtil::HashValue(&v3));
+
+  auto h1 = HashUtil::HashValue(&v1);
+  auto h2 = HashUtil::HashValue(&integer);
+  EXPECT_NE(HashUtil::CombineHashes(h1, h2), HashUtil::CombineHashes(h2, h1));
+}
+
+}  // namespace bustub
@@ -0,0 +1,192 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// online_index_build_test.cpp
+//
+// Identification: test/concurrency/online_index_build_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <set>
+#include <string>
+#include <thread>  //NOLINT
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "common/bustub_instance.h"
+#include "concurrency/transaction_manager.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto Execute(BustubInstance *db, const std::string &sql) -> bool {
+  NoopWriter writer;
+  return db->ExecuteSql(sql, writer);
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(OnlineIndexBuildTest, ConcurrentInsertDeleteTest) {
+  auto db = std::make_unique<BustubInstance>();
+  ASSERT_TRUE(Execute(db.get(), "CREATE TABLE t1(v1 int, v2 int);"));
+
+  // 先放一批数据，让建索引的扫描有活干
+  const int initial = 2000;
+  std::set<int> live;
+  std::string values;
+  for (int i = 0; i < initial; i++) {
+    values += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i, i % 7);
+    live.insert(i);
+  }
+  ASSERT_TRUE(Execute(db.get(), fmt::format("INSERT INTO t1 VALUES {};", values)));
+
+  const int writers = 4;
+  const int inserts_per_writer = 100;
+  std::atomic<bool> start{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < writers; t++) {
+    threads.emplace_back([&, t]() {
+      while (!start.load()) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < inserts_per_writer; i++) {
+        int v1 = 100000 + t * inserts_per_writer + i;
+        EXPECT_TRUE(Execute(db.get(), fmt::format("INSERT INTO t1 VALUES ({}, {});", v1, t)));
+      }
+    });
+  }
+  // 删掉一部分初始数据，删的时候索引可能还在建
+  std::vector<int> deleted;
+  for (int i = 0; i < initial; i += 97) {
+    deleted.push_back(i);
+  }
+  threads.emplace_back([&]() {
+    while (!start.load()) {
+      std::this_thread::yield();
+    }
+    for (int v1 : deleted) {
+      EXPECT_TRUE(Execute(db.get(), fmt::format("DELETE FROM t1 WHERE v1 = {};", v1)));
+    }
+  });
+
+  start.store(true);
+  ASSERT_TRUE(Execute(db.get(), "CREATE INDEX t1v1 ON t1(v1);"));
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < writers; t++) {
+    for (int i = 0; i < inserts_per_writer; i++) {
+      live.insert(100000 + t * inserts_per_writer + i);
+    }
+  }
+  for (int v1 : deleted) {
+    live.erase(v1);
+  }
+
+  auto *index_info = db->catalog_->GetIndex("t1v1", "t1");
+  ASSERT_NE(index_info, nullptr);
+  EXPECT_FALSE(index_info->IsBuilding());
+  EXPECT_EQ(db->catalog_->GetTableIndexes("t1").size(), 1);
+
+  auto *table_info = db->catalog_->GetTable("t1");
+  const auto &key_schema = index_info->key_schema_;
+  for (int v1 = 0; v1 < 100000 + writers * inserts_per_writer; v1++) {
+    if (v1 == initial) {
+      v1 = 100000;
+    }
+    std::vector<RID> rids;
+    Tuple key({ValueFactory::GetIntegerValue(v1)}, &key_schema);
+    index_info->index_->ScanKey(key, &rids, nullptr);
+    if (live.count(v1) == 0) {
+      EXPECT_TRUE(rids.empty()) << "deleted row " << v1 << " is still in the index";
+      continue;
+    }
+    ASSERT_EQ(rids.size(), 1) << "row " << v1 << " is missing from the index";
+    auto [meta, tuple] = table_info->table_->GetTuple(rids[0]);
+    EXPECT_FALSE(meta.is_deleted_);
+    EXPECT_EQ(tuple.GetValue(&table_info->schema_, 0).GetAs<int32_t>(), v1);
+  }
+
+  // 索引里不能有多余的条目
+  auto *tree = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info->index_.get());
+  ASSERT_NE(tree, nullptr);
+  size_t entries = 0;
+  for (auto iter = tree->GetBeginIterator(); !iter.IsEnd(); ++iter) {
+    entries++;
+  }
+  EXPECT_EQ(entries, live.size());
+
+  // 发布之后的写直接进索引
+  ASSERT_TRUE(Execute(db.get(), "INSERT INTO t1 VALUES (-1, 0);"));
+  std::vector<RID> rids;
+  index_info->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(-1)}, &key_schema), &rids, nullptr);
+  EXPECT_EQ(rids.size(), 1);
+}
+
+// NOLINTNEXTLINE
+TEST(OnlineIndexBuildTest, CallerTransactionTest) {
+  auto db = std::make_unique<BustubInstance>();
+  ASSERT_TRUE(Execute(db.get(), "CREATE TABLE t1(v1 int, v2 int);"));
+  auto *table_info = db->catalog_->GetTable("t1");
+
+  // 建索引的事务自己持有 IX：等写者不能升级、释放它的锁，也不能让它进入 SHRINKING
+  auto *txn = db->txn_manager_->Begin(nullptr, IsolationLevel::REPEATABLE_READ);
+  NoopWriter writer;
+  ASSERT_TRUE(db->ExecuteSqlTxn("INSERT INTO t1 VALUES (1, 1), (2, 2);", writer, txn));
+  ASSERT_TRUE(db->ExecuteSqlTxn("CREATE INDEX t1v1 ON t1(v1);", writer, txn));
+  EXPECT_EQ(txn->GetState(), TransactionState::GROWING);
+  EXPECT_EQ(txn->GetIntentionExclusiveTableLockSet()->count(table_info->oid_), 1);
+  EXPECT_EQ(txn->GetSharedTableLockSet()->count(table_info->oid_), 0);
+  ASSERT_TRUE(db->ExecuteSqlTxn("INSERT INTO t1 VALUES (3, 3);", writer, txn));
+  db->txn_manager_->Commit(txn);
+  delete txn;
+
+  auto *index_info = db->catalog_->GetIndex("t1v1", "t1");
+  ASSERT_NE(index_info, nullptr);
+  for (int v1 = 1; v1 <= 3; v1++) {
+    std::vector<RID> rids;
+    index_info->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(v1)}, &index_info->key_schema_), &rids, nullptr);
+    EXPECT_EQ(rids.size(), 1) << "row " << v1 << " is missing from the index";
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(OnlineIndexBuildTest, WaitForWriterTest) {
+  auto db = std::make_unique<BustubInstance>();
+  ASSERT_TRUE(Execute(db.get(), "CREATE TABLE t1(v1 int, v2 int);"));
+
+  // 索引登记之前就开始写的事务提交了，建索引才能开始扫描
+  auto *writer_txn = db->txn_manager_->Begin(nullptr, IsolationLevel::REPEATABLE_READ);
+  NoopWriter writer;
+  ASSERT_TRUE(db->ExecuteSqlTxn("INSERT INTO t1 VALUES (1, 1);", writer, writer_txn));
+  std::atomic<bool> built{false};
+  std::thread builder([&]() {
+    EXPECT_TRUE(Execute(db.get(), "CREATE INDEX t1v1 ON t1(v1);"));
+    built.store(true);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_FALSE(built.load());
+  db->txn_manager_->Commit(writer_txn);
+  delete writer_txn;
+  builder.join();
+  EXPECT_TRUE(built.load());
+
+  auto *index_info = db->catalog_->GetIndex("t1v1", "t1");
+  ASSERT_NE(index_info, nullptr);
+  std::vector<RID> rids;
+  index_info->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(1)}, &index_info->key_schema_), &rids, nullptr);
+  EXPECT_EQ(rids.size(), 1);
+}
+
+}  // namespace bustub
@@ -55,4 +55,92 @@ TEST(IsolationLevelTest, InsertTestA) {
                ExpectedOutcome::DirtyRead);
 }
 
+void IndexedReadTest(IsolationLevel read_txn_level, const std::string &sql, bool expect_block,
+                     const std::string &expected = "233,1,\n", bool commit_writer = true,
+                     const std::string &setup = "", const std::string &plan_node = "IndexScan") {
+  auto db = std::make_unique<BustubInstance>();
+  auto writer = bustub::SimpleStreamWriter(std::cout, true);
+  db->ExecuteSql("CREATE TABLE t1(v1 int, v2 int);", writer);
+  db->ExecuteSql("INSERT INTO t1 VALUES (1, 2), (2, 3);", writer);
+  db->ExecuteSql("CREATE INDEX t1v1 ON t1(v1);", writer);
+  if (!setup.empty()) {
+    db->ExecuteSql(setup, writer);
+  }
+  std::stringstream plan;
+  auto plan_writer = bustub::SimpleStreamWriter(plan, true);
+  db->ExecuteSql("EXPLAIN " + sql, plan_writer);
+  ASSERT_NE(plan.str().find(plan_node), std::string::npos) << plan.str();
+
+  // 写事务插入的行还没提交，带索引条件的读要和 seq scan 一样按隔离级别加锁
+  auto txn_w = Begin(*db, IsolationLevel::REPEATABLE_READ);
+  ASSERT_TRUE(db->ExecuteSqlTxn("INSERT INTO t1 VALUES (233, 1);", writer, txn_w));
+
+  std::atomic<bool> done{false};
+  std::stringstream result;
+  std::thread reader([&] {
+    auto txn_r = Begin(*db, read_txn_level);
+    auto result_writer = bustub::SimpleStreamWriter(result, true, ",");
+    db->ExecuteSqlTxn(sql, result_writer, txn_r);
+    done = true;
+    Commit(*db, txn_r);
+  });
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  EXPECT_EQ(done.load(), !expect_block);
+  if (commit_writer) {
+    Commit(*db, txn_w);
+  } else {
+    Abort(*db, txn_w);
+  }
+  reader.join();
+  EXPECT_TRUE(ExpectResult(result.str(), expected)) << result.str();
+}
+
+// NOLINTNEXTLINE
+TEST(IsolationLevelTest, IndexScanTest) {
+  IndexedReadTest(IsolationLevel::READ_UNCOMMITTED, "SELECT * FROM t1 WHERE v1 = 233;", false);
+  IndexedReadTest(IsolationLevel::READ_COMMITTED, "SELECT * FROM t1 WHERE v1 = 233;", true);
+  IndexedReadTest(IsolationLevel::REPEATABLE_READ, "SELECT * FROM t1 WHERE v1 >= 100;", true);
+}
+
+// NOLINTNEXTLINE
+TEST(IsolationLevelTest, IndexOnlyScanTest) {
+  // 只读 key 列的查询不读元组，但未提交插入的索引项已经在索引里了
+  IndexedReadTest(IsolationLevel::READ_COMMITTED, "SELECT v1 FROM t1 WHERE v1 = 233;", true, "233,\n");
+  IndexedReadTest(IsolationLevel::REPEATABLE_READ, "SELECT v1 FROM t1 WHERE v1 >= 100;", true, "233,\n");
+  // 写事务回滚后索引项被撤掉，等到锁的读者也不能再返回它
+  IndexedReadTest(IsolationLevel::REPEATABLE_READ, "SELECT v1 FROM t1 WHERE v1 >= 100;", true, "", false);
+}
+
+// NOLINTNEXTLINE
+TEST(IsolationLevelTest, IndexJoinTest) {
+  // 内表 t1 由索引探测，未提交插入的内表行也要等写事务结束
+  const std::string setup =
+      "set force_optimizer_starter_rule=yes; CREATE TABLE t2(v1 int); INSERT INTO t2 VALUES (2), (233);";
+  const std::string sql = "SELECT * FROM t2 INNER JOIN t1 ON t2.v1 = t1.v1;";
+  IndexedReadTest(IsolationLevel::READ_UNCOMMITTED, sql, false, "2,2,3,\n233,233,1,\n", true, setup,
+                  "NestedIndexJoin");
+  IndexedReadTest(IsolationLevel::READ_COMMITTED, sql, true, "2,2,3,\n233,233,1,\n", true, setup, "NestedIndexJoin");
+  IndexedReadTest(IsolationLevel::REPEATABLE_READ, sql, true, "2,2,3,\n", false, setup, "NestedIndexJoin");
+}
+
+// NOLINTNEXTLINE
+TEST(IndexScanLockTest, ResidualPredicateTest) {
+  auto db = std::make_unique<BustubInstance>();
+  auto writer = bustub::SimpleStreamWriter(std::cout, true);
+  db->ExecuteSql("CREATE TABLE t1(v1 int, v2 int);", writer);
+  db->ExecuteSql("INSERT INTO t1 VALUES (1, 1), (2, 2), (2, 3), (2, 4);", writer);
+  db->ExecuteSql("CREATE INDEX t1v1 ON t1(v1);", writer);
+  auto oid = db->catalog_->GetTable("t1")->oid_;
+
+  // 索引点查拿到 v1 = 2 的三行，剩下的条件只留一行；筛掉的两行不能一直锁到提交
+  auto txn = Begin(*db, IsolationLevel::REPEATABLE_READ);
+  std::stringstream ss;
+  auto delete_writer = bustub::SimpleStreamWriter(ss, true, ",");
+  ASSERT_TRUE(db->ExecuteSqlTxn("DELETE FROM t1 WHERE v1 = 2 AND v2 = 3;", delete_writer, txn));
+  ASSERT_EQ(ss.str(), "1,\n");
+  ASSERT_EQ((*txn->GetExclusiveRowLockSet())[oid].size(), 1);
+
+  Commit(*db, txn);
+}
+
 }  // namespace bustub
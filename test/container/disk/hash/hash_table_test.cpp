@@ -18,13 +18,14 @@
 #include "container/disk/hash/disk_extendible_hash_table.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 
 // NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(50, disk_manager);
   DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
@@ -117,4 +118,162 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowShrinkTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 10000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_GT(ht.GetGlobalDepth(), 0);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+  }
+
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  // every bucket emptied and merged back into its split image
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 0, &res));
+
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, DuplicateKeyOverflowTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // several buckets' worth of one key: no split can separate them, they go to overflow pages
+  const int num_values = 2000;
+  for (int i = 0; i < num_values; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, 1, i));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 1, num_values - 1));
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i + 2, i));
+  }
+  ht.VerifyIntegrity();
+  std::vector<int> res;
+  ht.GetValue(nullptr, 1, &res);
+  ASSERT_EQ(num_values, res.size());
+  for (int i = 0; i < 100; i++) {
+    res.clear();
+    ht.GetValue(nullptr, i + 2, &res);
+    ASSERT_EQ(1, res.size());
+  }
+
+  for (int i = 0; i < num_values; i += 2) {
+    ASSERT_TRUE(ht.Remove(nullptr, 1, i));
+  }
+  res.clear();
+  ht.GetValue(nullptr, 1, &res);
+  EXPECT_EQ(num_values / 2, res.size());
+  for (int i = 1; i < num_values; i += 2) {
+    ASSERT_TRUE(ht.Remove(nullptr, 1, i));
+  }
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i + 2, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  res.clear();
+  EXPECT_FALSE(ht.GetValue(nullptr, 1, &res));
+
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, FullDirectoryTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // more pairs than DIRECTORY_ARRAY_SIZE buckets of 496 hold, the rest go to overflow pages
+  const int num_keys = 260000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(9, ht.GetGlobalDepth());
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+  }
+
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentInsertTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_threads = 4;
+  const int keys_per_thread = 3000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_threads * keys_per_thread; i += num_threads) {
+        ASSERT_TRUE(ht.Insert(nullptr, i, i));
+        // a key stays visible while other threads keep splitting buckets
+        std::vector<int> res;
+        ht.GetValue(nullptr, i, &res);
+        ASSERT_EQ(1, res.size());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+
+  threads.clear();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_threads * keys_per_thread; i += num_threads) {
+        if (i % 2 == 0) {
+          ASSERT_TRUE(ht.Remove(nullptr, i, i));
+        } else {
+          std::vector<int> res;
+          ht.GetValue(nullptr, i, &res);
+          ASSERT_EQ(1, res.size());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 2 == 0 ? 0 : 1, res.size());
+  }
+
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/disk/hash/linear_probe_hash_table_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "container/disk/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, SampleTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i + 1));
+  }
+  // duplicate pairs are rejected, same key with another value is not
+  EXPECT_FALSE(ht.Insert(nullptr, 3, 3));
+  for (int i = 0; i < 5; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(2, res.size());
+  }
+
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 20, &res));
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(2 * i + 1, res[0]);
+  }
+  // tombstones are reused instead of growing the table
+  size_t size = ht.GetSize();
+  EXPECT_GE(size, 1000);
+  for (int round = 0; round < 10000; round++) {
+    EXPECT_TRUE(ht.Insert(nullptr, 7, round));
+    EXPECT_TRUE(ht.Remove(nullptr, 7, round));
+  }
+  EXPECT_EQ(size, ht.GetSize());
+
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, GrowTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+  size_t initial_size = ht.GetSize();
+
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    // pairs stay visible while they are being moved to the larger table
+    if (i % 97 == 0) {
+      for (int j = 0; j <= i; j += 13) {
+        std::vector<int> res;
+        ht.GetValue(nullptr, j, &res);
+        ASSERT_EQ(1, res.size()) << "lost " << j << " after inserting " << i;
+        ASSERT_EQ(j, res[0]);
+      }
+    }
+  }
+  EXPECT_GE(ht.GetSize(), num_keys);
+  EXPECT_GT(ht.GetSize(), initial_size);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, i));
+    }
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 2 == 0 ? 0 : 1, res.size());
+  }
+
+  // an explicit resize only allocates, later operations move the pairs
+  size_t size = ht.GetSize();
+  ht.Resize(size);
+  EXPECT_GE(ht.GetSize(), 2 * size);
+  for (int i = 1; i < num_keys; i += 2) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size());
+  }
+
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 100, HashFunction<int>());
+
+  const int num_threads = 4;
+  const int keys_per_thread = 4000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_threads * keys_per_thread; i += num_threads) {
+        ASSERT_TRUE(ht.Insert(nullptr, i, i));
+        std::vector<int> res;
+        ht.GetValue(nullptr, i, &res);
+        ASSERT_EQ(1, res.size());
+        if (i % 3 == 0) {
+          ASSERT_TRUE(ht.Remove(nullptr, i, i));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 3 == 0 ? 0 : 1, res.size());
+  }
+
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentDuplicateTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 8000, HashFunction<int>());
+
+  // 几个线程插入同一批键值对，另一个线程不停插入删除别的键，在探测链上留下墓碑
+  const int num_keys = 2000;
+  const int num_threads = 3;
+  std::atomic<int> inserted{0};
+  std::atomic<bool> done{false};
+  std::thread churn([&ht, &done] {
+    for (int round = 0; !done; round++) {
+      for (int i = 0; i < 200; i++) {
+        ht.Insert(nullptr, num_keys + i, round);
+      }
+      for (int i = 0; i < 200; i++) {
+        ht.Remove(nullptr, num_keys + i, round);
+      }
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, &inserted] {
+      for (int i = 0; i < num_keys; i++) {
+        if (ht.Insert(nullptr, i, i)) {
+          inserted++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  churn.join();
+
+  EXPECT_EQ(num_keys, inserted);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(1, res.size()) << i;
+  }
+
+  delete bpm;
+}
+
+}  // namespace bustub
@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_hash_table_test.cpp
+//
+// Identification: test/execution/aggregation_hash_table_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
+#include "execution/aggregation_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** One row of input per call: group key a, then b as the input of every aggregate but the last, s for the last */
+void InsertRow(AggregationHashTable *table, const Value &a, const Value &b, const Value &s) {
+  std::vector<std::vector<Value>> keys{{a}};
+  std::vector<std::vector<Value>> inputs{{b}, {b}, {b}, {b}, {b}, {s}};
+  table->Insert(keys, inputs, 0);
+}
+
+const std::vector<AggregationType> AGG_TYPES{
+    AggregationType::CountStarAggregate, AggregationType::CountAggregate, AggregationType::SumAggregate,
+    AggregationType::MinAggregate,       AggregationType::MaxAggregate,   AggregationType::MinAggregate};
+const std::vector<TypeId> INPUT_TYPES{TypeId::INTEGER, TypeId::INTEGER, TypeId::INTEGER,
+                                      TypeId::INTEGER, TypeId::INTEGER, TypeId::VARCHAR};
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(AggregationHashTableTest, MergeAndSpillTest) {
+  auto disk_manager = std::make_shared<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_shared<BufferPoolManager>(32, disk_manager.get(), 2);
+
+  // 三张局部表分别吃一部分行，第三张整个写出去再读回来
+  std::vector<std::unique_ptr<AggregationHashTable>> tables;
+  for (int t = 0; t < 3; t++) {
+    tables.push_back(std::make_unique<AggregationHashTable>(AGG_TYPES, std::vector{TypeId::INTEGER}, INPUT_TYPES));
+  }
+  struct Expected {
+    int count_star_{0};
+    int count_{0};
+    int sum_{0};
+    int min_{0};
+    int max_{0};
+    std::string min_s_;
+  };
+  // key -1 代表 NULL，NULL 的行聚成一组
+  std::map<int, Expected> expected;
+  const int rows = 20000;
+  for (int i = 0; i < rows; i++) {
+    int key = i % 1001 == 0 ? -1 : i % 997;
+    bool null_b = i % 5 == 0;
+    int b = (i * 7919) % 1000 - 500;
+    auto s = std::to_string(i % 89);
+    auto a = key == -1 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(key);
+    InsertRow(tables[i % 3].get(), a,
+              null_b ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(b),
+              ValueFactory::GetVarcharValue(s));
+    auto &e = expected[key];
+    if (e.count_star_ == 0 || s < e.min_s_) {
+      e.min_s_ = s;
+    }
+    e.count_star_++;
+    if (!null_b) {
+      e.min_ = e.count_ == 0 ? b : std::min(e.min_, b);
+      e.max_ = e.count_ == 0 ? b : std::max(e.max_, b);
+      e.sum_ += b;
+      e.count_++;
+    }
+  }
+
+  std::vector<std::unique_ptr<SpillFile>> files;
+  for (size_t p = 0; p < AggregationHashTable::NUM_PARTITIONS; p++) {
+    files.push_back(std::make_unique<SpillFile>(bpm.get()));
+    tables[2]->SpillPartition(p, files.back().get());
+    files.back()->Finish();
+  }
+  tables[2]->Clear();
+  ASSERT_EQ(tables[2]->MemoryUsage(), 0);
+
+  // 每个分区都超出预算，并到一半拆成小块，再一块块并回来
+  AggregationHashTable merged(AGG_TYPES, std::vector{TypeId::INTEGER}, INPUT_TYPES);
+  for (size_t p = 0; p < AggregationHashTable::NUM_PARTITIONS; p++) {
+    merged.MergePartition(p, *tables[0]);
+    merged.MergePartition(p, *tables[1]);
+    SpillFile::Reader reader(files[p].get());
+    ASSERT_FALSE(merged.MergeSpilled(p, &reader, 0));
+    std::vector<std::unique_ptr<SpillFile>> pieces;
+    for (size_t i = 0; i < (size_t{1} << SPILL_PARTITION_BITS); i++) {
+      pieces.push_back(std::make_unique<SpillFile>(bpm.get()));
+    }
+    merged.SplitPartition(p, 1, pieces);
+    merged.ClearPartition(p);
+    merged.SplitSpilled(&reader, 1, pieces);
+    for (auto &piece : pieces) {
+      piece->Finish();
+      SpillFile::Reader piece_reader(piece.get());
+      ASSERT_TRUE(merged.MergeSpilled(p, &piece_reader));
+    }
+  }
+
+  size_t groups = 0;
+  for (size_t p = 0; p < AggregationHashTable::NUM_PARTITIONS; p++) {
+    for (size_t g = 0; g < merged.NumGroups(p); g++) {
+      auto values = merged.GetGroup(p, g);
+      ASSERT_EQ(values.size(), 7);
+      int key = values[0].IsNull() ? -1 : values[0].GetAs<int32_t>();
+      ASSERT_EQ(expected.count(key), 1) << key;
+      const auto &e = expected[key];
+      groups++;
+      ASSERT_EQ(values[1].GetAs<int32_t>(), e.count_star_);
+      ASSERT_EQ(values[6].ToString(), e.min_s_);
+      if (e.count_ == 0) {
+        ASSERT_TRUE(values[2].IsNull());
+        ASSERT_TRUE(values[3].IsNull());
+        continue;
+      }
+      ASSERT_EQ(values[2].GetAs<int32_t>(), e.count_);
+      ASSERT_EQ(values[3].GetAs<int32_t>(), e.sum_);
+      ASSERT_EQ(values[4].GetAs<int32_t>(), e.min_);
+      ASSERT_EQ(values[5].GetAs<int32_t>(), e.max_);
+    }
+  }
+  ASSERT_EQ(groups, expected.size());
+}
+
+// NOLINTNEXTLINE
+TEST(AggregationHashTableTest, OverflowTest) {
+  std::vector<AggregationType> agg_types{AggregationType::SumAggregate};
+  auto max_int = ValueFactory::GetIntegerValue(BUSTUB_INT32_MAX);
+  std::vector<std::vector<Value>> keys;
+
+  // INTEGER 的和在 int64_t 里累加，到输出时才检查范围
+  AggregationHashTable ints(agg_types, {}, {TypeId::INTEGER});
+  std::vector<std::vector<Value>> inputs{{max_int}};
+  ints.Insert(keys, inputs, 0);
+  ASSERT_EQ(ints.GetGroup(0, 0)[0].GetAs<int32_t>(), BUSTUB_INT32_MAX);
+  ints.Insert(keys, inputs, 0);
+  ASSERT_THROW(ints.GetGroup(0, 0), Exception);
+
+  AggregationHashTable bigints(agg_types, {}, {TypeId::BIGINT});
+  inputs = {{ValueFactory::GetBigIntValue(BUSTUB_INT64_MAX)}};
+  bigints.Insert(keys, inputs, 0);
+  ASSERT_EQ(bigints.GetGroup(0, 0)[0].GetAs<int64_t>(), BUSTUB_INT64_MAX);
+  ASSERT_THROW(bigints.Insert(keys, inputs, 0), Exception);
+}
+
+}  // namespace bustub
@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_filter_test.cpp
+//
+// Identification: test/execution/join_filter_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/join_filter.h"
+#include "execution/join_hash_table.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto KeyHash(int key) -> hash_t { return JoinHashTable::HashKeys({ValueFactory::GetIntegerValue(key)}); }
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(JoinFilterTest, BloomFilterNoFalseNegativesTest) {
+  BloomFilter filter;
+  for (size_t num_keys : {0, 1, 100, 10000, 100000}) {
+    filter.Reset(num_keys);
+    for (size_t i = 0; i < num_keys; i++) {
+      filter.Insert(KeyHash(static_cast<int>(i * 2)));
+    }
+    for (size_t i = 0; i < num_keys; i++) {
+      ASSERT_TRUE(filter.MayContain(KeyHash(static_cast<int>(i * 2)))) << num_keys << " " << i;
+    }
+    // 每个键至少 BLOOM_FILTER_BITS_PER_KEY 位，误判率应在 1% 以下
+    size_t false_positives = 0;
+    size_t probes = 100000;
+    for (size_t i = 0; i < probes; i++) {
+      false_positives += filter.MayContain(KeyHash(static_cast<int>(i * 2 + 1))) ? 1 : 0;
+    }
+    EXPECT_LT(false_positives, probes / 100) << num_keys;
+    EXPECT_GE(filter.MemoryUsage() * 8, num_keys * BLOOM_FILTER_BITS_PER_KEY);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(JoinFilterTest, PassTest) {
+  Schema schema{std::vector{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::INTEGER}}};
+  std::vector<AbstractExpressionRef> keys{std::make_shared<ColumnValueExpression>(0, 1, TypeId::INTEGER)};
+  JoinFilter filter;
+  filter.keys_ = &keys;
+  filter.bloom_.Reset(10);
+  for (int key = 0; key < 10; key++) {
+    filter.bloom_.Insert(KeyHash(key * 10));
+  }
+
+  size_t eliminated = 0;
+  for (int key = 0; key < 10; key++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(-1), ValueFactory::GetIntegerValue(key * 10)}, &schema};
+    ASSERT_TRUE(filter.Pass(tuple, schema, &eliminated));
+  }
+  ASSERT_EQ(eliminated, 0);
+  // 建表侧没有 NULL 键，NULL 键的探测行一定被丢掉
+  Tuple null_key{{ValueFactory::GetIntegerValue(0), ValueFactory::GetNullValueByType(TypeId::INTEGER)}, &schema};
+  ASSERT_FALSE(filter.Pass(null_key, schema, &eliminated));
+  ASSERT_EQ(eliminated, 1);
+
+  size_t passed = 0;
+  for (int key = 1000; key < 2000; key++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(0), ValueFactory::GetIntegerValue(key)}, &schema};
+    passed += filter.Pass(tuple, schema, &eliminated) ? 1 : 0;
+  }
+  EXPECT_EQ(passed + eliminated, 1001);
+  EXPECT_LT(passed, 20);
+}
+
+// NOLINTNEXTLINE
+TEST(JoinFilterTest, PassBatchTest) {
+  Schema schema{std::vector{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::INTEGER}}};
+  std::vector<AbstractExpressionRef> keys{std::make_shared<ColumnValueExpression>(0, 1, TypeId::INTEGER)};
+  JoinFilter filter;
+  filter.keys_ = &keys;
+  filter.bloom_.Reset(10);
+  for (int key = 0; key < 10; key++) {
+    filter.bloom_.Insert(KeyHash(key * 10));
+  }
+
+  // 批量和逐行给出同样的结果，留下的行保持原来的顺序
+  TupleBatch batch{&schema, 64};
+  for (int row = 0; row < 60; row++) {
+    auto key = row % 3 == 0 ? ValueFactory::GetIntegerValue(row / 3 * 10)
+                            : (row % 3 == 1 ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                            : ValueFactory::GetIntegerValue(1000 + row));
+    batch.Append({ValueFactory::GetIntegerValue(row), key});
+  }
+  // 已经被筛掉的行不再计入
+  auto &sel = batch.GetSelection();
+  sel.erase(sel.begin());
+  std::vector<uint32_t> expected;
+  size_t eliminated = 0;
+  for (size_t i = 0; i < batch.Size(); i++) {
+    if (filter.Pass(batch.MaterializeTuple(batch.SelectedRow(i)), schema, &eliminated)) {
+      expected.push_back(batch.SelectedRow(i));
+    }
+  }
+  size_t batch_eliminated = 0;
+  filter.PassBatch(&batch, &batch_eliminated);
+  EXPECT_EQ(batch.GetSelection(), expected);
+  EXPECT_EQ(batch_eliminated, eliminated);
+  EXPECT_GE(batch_eliminated, 20 + 19);
+}
+
+}  // namespace bustub
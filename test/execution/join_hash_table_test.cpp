@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table_test.cpp
+//
+// Identification: test/execution/join_hash_table_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "execution/join_hash_table.h"
+#include "execution/task_scheduler.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** Fill a table with rows (key, payload) where key = i % num_keys, so every key appears rows / num_keys times */
+void Fill(JoinHashTable *table, const Schema &schema, int rows, int num_keys) {
+  for (int i = 0; i < rows; i++) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i % num_keys), ValueFactory::GetIntegerValue(i)};
+    table->Insert({ValueFactory::GetIntegerValue(i % num_keys)}, Tuple{values, &schema});
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(JoinHashTableTest, DuplicatesAndMissesTest) {
+  Schema schema{std::vector{Column{"k", TypeId::INTEGER}, Column{"v", TypeId::INTEGER}}};
+  JoinHashTable table;
+  Fill(&table, schema, 100, 10);
+  // NULL 键永远匹配不上，不进表
+  table.Insert({ValueFactory::GetNullValueByType(TypeId::INTEGER)},
+               Tuple{{ValueFactory::GetNullValueByType(TypeId::INTEGER), ValueFactory::GetIntegerValue(-1)}, &schema});
+  table.Build(nullptr);
+  ASSERT_EQ(table.Size(), 100);
+  ASSERT_EQ(table.NumPartitions(), 1);
+
+  for (int key = 0; key < 10; key++) {
+    std::vector<Value> probe{ValueFactory::GetIntegerValue(key)};
+    auto matches = table.Find(probe);
+    // 同一个键的行按插入顺序出来
+    int expected = key;
+    while (const auto *row = matches.Next()) {
+      EXPECT_EQ(row->GetValue(&schema, 0).GetAs<int32_t>(), key);
+      EXPECT_EQ(row->GetValue(&schema, 1).GetAs<int32_t>(), expected);
+      expected += 10;
+    }
+    EXPECT_EQ(expected, key + 100);
+  }
+
+  std::vector<Value> missing{ValueFactory::GetIntegerValue(10)};
+  EXPECT_EQ(table.Find(missing).Next(), nullptr);
+  std::vector<Value> null_key{ValueFactory::GetNullValueByType(TypeId::INTEGER)};
+  EXPECT_EQ(table.Find(null_key).Next(), nullptr);
+}
+
+// NOLINTNEXTLINE
+TEST(JoinHashTableTest, PartitionedParallelBuildTest) {
+  Schema schema{std::vector{Column{"k", TypeId::INTEGER}, Column{"v", TypeId::INTEGER}}};
+  const int rows = HASH_JOIN_PARTITION_ROWS * 20;
+  const int num_keys = rows / 4;
+  TaskScheduler scheduler(4);
+  JoinHashTable table;
+  Fill(&table, schema, rows, num_keys);
+  table.Build(&scheduler);
+  ASSERT_EQ(table.Size(), rows);
+  ASSERT_EQ(table.NumPartitions(), 32);
+
+  for (int key = 0; key < num_keys; key++) {
+    std::vector<Value> probe{ValueFactory::GetIntegerValue(key)};
+    auto matches = table.Find(probe);
+    int count = 0;
+    while (const auto *row = matches.Next()) {
+      EXPECT_EQ(row->GetValue(&schema, 1).GetAs<int32_t>() % num_keys, key);
+      count++;
+    }
+    ASSERT_EQ(count, 4);
+  }
+
+  // 清空后可以重新装
+  table.Clear();
+  Fill(&table, schema, 10, 5);
+  table.Build(&scheduler);
+  EXPECT_EQ(table.Size(), 10);
+  EXPECT_EQ(table.NumPartitions(), 1);
+}
+
+}  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key_test.cpp
+//
+// Identification: test/execution/sort_key_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "execution/loser_tree.h"
+#include "execution/sort_key.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto KeyOf(const std::vector<Value> &values, bool descending = false) -> std::string {
+  std::string key;
+  for (const auto &value : values) {
+    AppendSortKey(&key, value, descending);
+  }
+  return key;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(SortKeyTest, OrderLikeValuesTest) {
+  auto null_int = ValueFactory::GetNullValueByType(TypeId::INTEGER);
+  std::vector<std::vector<Value>> ordered{
+      {null_int},
+      {ValueFactory::GetIntegerValue(-100000)},
+      {ValueFactory::GetIntegerValue(-1)},
+      {ValueFactory::GetIntegerValue(0)},
+      {ValueFactory::GetIntegerValue(1)},
+      {ValueFactory::GetIntegerValue(256)},
+      {ValueFactory::GetIntegerValue(100000)},
+  };
+  for (size_t i = 0; i + 1 < ordered.size(); i++) {
+    EXPECT_LT(CompareSortKeys(KeyOf(ordered[i]), KeyOf(ordered[i + 1])), 0);
+    // 降序整个反过来，NULL 排到最后
+    EXPECT_GT(CompareSortKeys(KeyOf(ordered[i], true), KeyOf(ordered[i + 1], true)), 0);
+  }
+  EXPECT_EQ(CompareSortKeys(KeyOf({ValueFactory::GetIntegerValue(7)}), KeyOf({ValueFactory::GetIntegerValue(7)})), 0);
+
+  // 前缀排在更长的串前面，第一列相等才看第二列
+  auto a = KeyOf({ValueFactory::GetVarcharValue("ab"), ValueFactory::GetIntegerValue(9)});
+  auto b = KeyOf({ValueFactory::GetVarcharValue("abc"), ValueFactory::GetIntegerValue(1)});
+  auto c = KeyOf({ValueFactory::GetVarcharValue("abc"), ValueFactory::GetIntegerValue(2)});
+  auto d = KeyOf({ValueFactory::GetVarcharValue("b"), ValueFactory::GetIntegerValue(0)});
+  EXPECT_LT(CompareSortKeys(a, b), 0);
+  EXPECT_LT(CompareSortKeys(b, c), 0);
+  EXPECT_LT(CompareSortKeys(c, d), 0);
+
+  EXPECT_LT(CompareSortKeys(KeyOf({ValueFactory::GetBigIntValue(-5)}), KeyOf({ValueFactory::GetBigIntValue(3)})), 0);
+  EXPECT_LT(CompareSortKeys(KeyOf({ValueFactory::GetDecimalValue(-2.5)}), KeyOf({ValueFactory::GetDecimalValue(-1.5)})),
+            0);
+  EXPECT_LT(CompareSortKeys(KeyOf({ValueFactory::GetDecimalValue(-0.5)}), KeyOf({ValueFactory::GetDecimalValue(0.25)})),
+            0);
+}
+
+// NOLINTNEXTLINE
+TEST(LoserTreeTest, MergeIsSortedAndStableTest) {
+  std::mt19937 gen(15445);
+  for (size_t num_runs : {1, 2, 3, 7, 16}) {
+    // 每个元素是 (值, 所在 run)，值的范围小，run 之间有很多相等的值
+    std::vector<std::vector<std::pair<int, size_t>>> runs(num_runs);
+    std::vector<size_t> pos(num_runs, 0);
+    for (size_t r = 0; r < num_runs; r++) {
+      auto size = gen() % 50;
+      for (size_t i = 0; i < size; i++) {
+        runs[r].emplace_back(static_cast<int>(gen() % 20), r);
+      }
+      std::sort(runs[r].begin(), runs[r].end());
+    }
+    auto less = [&](size_t a, size_t b) {
+      if (pos[a] == runs[a].size() || pos[b] == runs[b].size()) {
+        return pos[a] != runs[a].size();
+      }
+      return runs[a][pos[a]].first < runs[b][pos[b]].first;
+    };
+    LoserTree<decltype(less)> tree(num_runs, less);
+    std::vector<std::pair<int, size_t>> merged;
+    while (true) {
+      auto top = tree.Top();
+      if (pos[top] == runs[top].size()) {
+        break;
+      }
+      merged.push_back(runs[top][pos[top]++]);
+      tree.Replay(top);
+    }
+    std::vector<std::pair<int, size_t>> expected;
+    for (const auto &run : runs) {
+      expected.insert(expected.end(), run.begin(), run.end());
+    }
+    // 值相等时 run 号小的在前
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(merged, expected);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// spill_file_test.cpp
+//
+// Identification: test/execution/spill_file_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "execution/spill_file.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(SpillFileTest, ReadBackInOrderTest) {
+  // 缓冲池只有 5 帧，写出去的页大多要被换到磁盘上再读回来
+  auto disk_manager = std::make_shared<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_shared<BufferPoolManager>(5, disk_manager.get(), 2);
+  Schema schema{std::vector{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32}}};
+
+  const int rows = 5000;
+  SpillFile file(bpm.get());
+  size_t bytes = 0;
+  for (int i = 0; i < rows; i++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(i % 17, 'x'))}, &schema};
+    bytes += sizeof(uint32_t) + tuple.GetLength();
+    file.Append(tuple);
+  }
+  file.Finish();
+  ASSERT_EQ(file.Rows(), rows);
+  ASSERT_EQ(file.Bytes(), bytes);
+  ASSERT_GT(bytes, 5 * BUSTUB_PAGE_SIZE);
+
+  // 两个读者交错着读，互不影响
+  SpillFile::Reader first(&file);
+  SpillFile::Reader second(&file);
+  Tuple tuple;
+  for (int i = 0; i < rows; i++) {
+    ASSERT_TRUE(first.Next(&tuple));
+    ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+    ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string(i % 17, 'x'));
+    if (i % 2 == 0) {
+      ASSERT_TRUE(second.Next(&tuple));
+      ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i / 2);
+    }
+  }
+  ASSERT_FALSE(first.Next(&tuple));
+}
+
+// NOLINTNEXTLINE
+TEST(SpillFileTest, EmptyFileTest) {
+  auto disk_manager = std::make_shared<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_shared<BufferPoolManager>(5, disk_manager.get(), 2);
+  SpillFile file(bpm.get());
+  file.Finish();
+  EXPECT_EQ(file.Rows(), 0);
+  SpillFile::Reader reader(&file);
+  Tuple tuple;
+  EXPECT_FALSE(reader.Next(&tuple));
+}
+
+}  // namespace bustub
@@ -145,4 +145,94 @@ TEST(BPlusTreeTests, DeleteTest2) {
   delete transaction;
   delete bpm;
 }
+
+TEST(BPlusTreeTests, LazyMergeTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t eager_header;
+  page_id_t lazy_header;
+  bpm->NewPage(&eager_header);
+  bpm->NewPage(&lazy_header);
+  // create b+ trees, one per merge mode
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> eager("eager", eager_header, bpm, comparator, 4, 4);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> lazy("lazy", lazy_header, bpm, comparator, 4, 4);
+  lazy.SetLazyMerge(true);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  auto check = [&](BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree, bool odd_present) {
+    std::vector<RID> rids;
+    for (int64_t key = 1; key <= 200; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      bool expect = key % 2 == 0 || odd_present;
+      EXPECT_EQ(tree->GetValue(index_key, &rids), expect) << "key " << key;
+    }
+    int64_t expected = odd_present ? 1 : 2;
+    for (auto iter = tree->Begin(); iter != tree->End(); ++iter) {
+      EXPECT_EQ((*iter).second.GetSlotNum(), expected);
+      expected += odd_present ? 1 : 2;
+    }
+    EXPECT_EQ(expected, 201 + (odd_present ? 0 : 1));
+  };
+
+  for (auto *tree : {&eager, &lazy}) {
+    for (int64_t key = 1; key <= 200; key++) {
+      rid.Set(0, key);
+      index_key.SetFromInteger(key);
+      tree->Insert(index_key, rid, transaction);
+    }
+  }
+  auto eager_before = eager.GetStructureModificationCount();
+  auto lazy_before = lazy.GetStructureModificationCount();
+
+  // delete and reinsert the odd keys a few times
+  for (int round = 0; round < 3; round++) {
+    for (auto *tree : {&eager, &lazy}) {
+      for (int64_t key = 1; key <= 200; key += 2) {
+        index_key.SetFromInteger(key);
+        tree->Remove(index_key, transaction);
+      }
+      check(tree, false);
+      for (int64_t key = 1; key <= 200; key += 2) {
+        rid.Set(0, key);
+        index_key.SetFromInteger(key);
+        tree->Insert(index_key, rid, transaction);
+      }
+      check(tree, true);
+    }
+  }
+  EXPECT_LT(lazy.GetStructureModificationCount() - lazy_before, eager.GetStructureModificationCount() - eager_before);
+
+  // deferred merges are done by Compact, and the tree stays usable afterwards
+  for (int64_t key = 1; key <= 200; key += 2) {
+    index_key.SetFromInteger(key);
+    lazy.Remove(index_key, transaction);
+  }
+  auto before_compact = lazy.GetStructureModificationCount();
+  lazy.Compact();
+  EXPECT_GT(lazy.GetStructureModificationCount(), before_compact);
+  check(&lazy, false);
+  lazy.Compact();
+  check(&lazy, false);
+
+  for (int64_t key = 2; key <= 200; key += 2) {
+    index_key.SetFromInteger(key);
+    lazy.Remove(index_key, transaction);
+  }
+  lazy.Compact();
+  EXPECT_TRUE(lazy.IsEmpty());
+
+  bpm->UnpinPage(eager_header, true);
+  bpm->UnpinPage(lazy_header, true);
+  delete transaction;
+  delete bpm;
+}
 }  // namespace bustub
@@ -0,0 +1,241 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_duplicate_test.cpp
+//
+// Identification: test/storage/b_plus_tree_duplicate_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using bustub::DiskManagerUnlimitedMemory;
+
+namespace {
+
+auto MakeKey(int64_t key) -> GenericKey<8> {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+auto Sorted(std::vector<RID> rids) -> std::vector<RID> {
+  std::sort(rids.begin(), rids.end(), [](const RID &a, const RID &b) { return a.Get() < b.Get(); });
+  return rids;
+}
+
+}  // namespace
+
+TEST(BPlusTreeTests, DuplicateKeyTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 3);
+  auto *transaction = new Transaction(0);
+
+  // 默认还是唯一索引
+  EXPECT_TRUE(tree.Insert(MakeKey(1), RID(1, 0), transaction));
+  EXPECT_FALSE(tree.Insert(MakeKey(1), RID(1, 1), transaction));
+  tree.Remove(MakeKey(1), transaction);
+  tree.SetUnique(false);
+
+  // key i 有 i + 1 个 RID，key 7 是热点，要占好几页倒排链
+  const int hot_count = static_cast<int>(POSTING_PAGE_SIZE) * 3 + 17;
+  std::vector<std::vector<RID>> expected(10);
+  for (int64_t key = 0; key < 10; key++) {
+    int count = key == 7 ? hot_count : static_cast<int>(key) + 1;
+    for (int i = 0; i < count; i++) {
+      RID rid(static_cast<page_id_t>(key), i);
+      EXPECT_TRUE(tree.Insert(MakeKey(key), rid, transaction));
+      expected[key].push_back(rid);
+    }
+  }
+  // 同一个 (key, rid) 不管存在叶子里还是倒排链里都会被拒绝
+  EXPECT_FALSE(tree.Insert(MakeKey(0), RID(0, 0), transaction));
+  EXPECT_FALSE(tree.Insert(MakeKey(5), RID(5, 3), transaction));
+  EXPECT_FALSE(tree.Insert(MakeKey(7), RID(7, 0), transaction));
+  EXPECT_FALSE(tree.Insert(MakeKey(7), RID(7, hot_count - 1), transaction));
+  // 只有热点 key 用到了倒排页
+  auto stats = tree.GetStats();
+  EXPECT_EQ(stats.value_count_, 47 + hot_count);
+  EXPECT_EQ(stats.posting_pages_, 4);
+
+  std::vector<RID> result;
+  for (int64_t key = 0; key < 10; key++) {
+    result.clear();
+    EXPECT_TRUE(tree.GetValue(MakeKey(key), &result));
+    EXPECT_EQ(Sorted(result), expected[key]);
+  }
+  result.clear();
+  EXPECT_FALSE(tree.GetValue(MakeKey(10), &result));
+
+  std::vector<GenericKey<8>> keys = {MakeKey(7), MakeKey(3), MakeKey(42)};
+  std::vector<std::vector<RID>> results;
+  EXPECT_EQ(tree.GetValues(keys, &results), 2);
+  EXPECT_EQ(Sorted(results[0]), expected[7]);
+  EXPECT_EQ(Sorted(results[1]), expected[3]);
+  EXPECT_TRUE(results[2].empty());
+
+  // 范围扫描每个 RID 出一条，key 不减
+  for (bool reverse : {false, true}) {
+    auto iterator = reverse ? tree.ReverseRange(MakeKey(2), true, MakeKey(8), false)
+                            : tree.Range(MakeKey(2), true, MakeKey(8), false);
+    std::vector<std::vector<RID>> scanned(10);
+    int64_t last = reverse ? 8 : 2;
+    for (; iterator != tree.End(); ++iterator) {
+      int64_t key = (*iterator).second.GetPageId();
+      EXPECT_TRUE(reverse ? key <= last : key >= last);
+      last = key;
+      scanned[key].push_back((*iterator).second);
+    }
+    for (int64_t key = 0; key < 10; key++) {
+      EXPECT_EQ(Sorted(scanned[key]), key >= 2 && key < 8 ? expected[key] : std::vector<RID>{});
+    }
+  }
+
+  // 一个个删掉热点 key 的 RID，空页要释放，最后 key 也跟着消失
+  for (int i = 0; i < hot_count; i += 2) {
+    tree.Remove(MakeKey(7), RID(7, i), transaction);
+  }
+  result.clear();
+  tree.GetValue(MakeKey(7), &result);
+  EXPECT_EQ(result.size(), hot_count / 2);
+  for (const auto &rid : result) {
+    EXPECT_EQ(rid.GetSlotNum() % 2, 1);
+  }
+  // 删不存在的 RID 什么都不做
+  tree.Remove(MakeKey(7), RID(7, 0), transaction);
+  tree.Remove(MakeKey(7), RID(8, 1), transaction);
+  result.clear();
+  tree.GetValue(MakeKey(7), &result);
+  EXPECT_EQ(result.size(), hot_count / 2);
+  // 链变短后搬回叶子，剩下的值一个不少
+  for (int i = 1; i < hot_count - 10; i += 2) {
+    tree.Remove(MakeKey(7), RID(7, i), transaction);
+  }
+  EXPECT_EQ(tree.GetStats().posting_pages_, 0);
+  result.clear();
+  tree.GetValue(MakeKey(7), &result);
+  std::vector<RID> rest;
+  for (int i = hot_count - 9; i < hot_count; i += 2) {
+    rest.push_back(RID(7, i));
+  }
+  EXPECT_EQ(Sorted(result), rest);
+  for (int i = hot_count - 9; i < hot_count; i += 2) {
+    tree.Remove(MakeKey(7), RID(7, i), transaction);
+  }
+  result.clear();
+  EXPECT_FALSE(tree.GetValue(MakeKey(7), &result));
+
+  // 剩一个值时直接存在槽里，再插又变回叶子里的表
+  tree.Remove(MakeKey(2), RID(2, 0), transaction);
+  tree.Remove(MakeKey(2), RID(2, 2), transaction);
+  result.clear();
+  EXPECT_TRUE(tree.GetValue(MakeKey(2), &result));
+  EXPECT_EQ(result, std::vector<RID>{RID(2, 1)});
+  EXPECT_TRUE(tree.Insert(MakeKey(2), RID(2, 5), transaction));
+  result.clear();
+  tree.GetValue(MakeKey(2), &result);
+  EXPECT_EQ(Sorted(result), (std::vector<RID>{RID(2, 1), RID(2, 5)}));
+
+  // 只按 key 删会连倒排链一起删掉
+  tree.Remove(MakeKey(9), transaction);
+  result.clear();
+  EXPECT_FALSE(tree.GetValue(MakeKey(9), &result));
+
+  // 反复建、删热点链，不能漏 pin（缓冲池只有 50 帧）
+  for (int round = 0; round < 20; round++) {
+    for (int i = 0; i < static_cast<int>(POSTING_PAGE_SIZE) * 2; i++) {
+      tree.Insert(MakeKey(100), RID(100, i), transaction);
+    }
+    tree.Remove(MakeKey(100), transaction);
+  }
+  result.clear();
+  EXPECT_TRUE(tree.GetValue(MakeKey(8), &result));
+  EXPECT_EQ(Sorted(result), expected[8]);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, InlineListSplitMergeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator);
+  tree.SetUnique(false);
+  auto *transaction = new Transaction(0);
+
+  // 轮流给每个 key 加值，叶子按字节写满，内联表长大时要先分裂叶子
+  const int64_t key_count = 2000;
+  auto count_of = [](int64_t key) { return static_cast<int>(key % 20) + 1; };
+  for (int i = 0; i < 20; i++) {
+    for (int64_t key = 0; key < key_count; key++) {
+      if (i < count_of(key)) {
+        EXPECT_TRUE(tree.Insert(MakeKey(key), RID(static_cast<page_id_t>(key), i), transaction));
+      }
+    }
+  }
+  auto stats = tree.GetStats();
+  EXPECT_EQ(stats.key_count_, key_count);
+  EXPECT_EQ(stats.posting_pages_, 0);
+  EXPECT_GT(stats.leaf_pages_, 1);
+
+  // 删掉一半的值，每三个 key 删光一个，叶子合并和借位时要带着内联表走
+  for (int64_t key = 0; key < key_count; key++) {
+    int count = count_of(key);
+    for (int i = 0; i < count; i++) {
+      if (key % 3 == 0 || i % 2 == 0) {
+        tree.Remove(MakeKey(key), RID(static_cast<page_id_t>(key), i), transaction);
+      }
+    }
+  }
+  std::vector<RID> result;
+  int64_t values = 0;
+  for (int64_t key = 0; key < key_count; key++) {
+    std::vector<RID> expected;
+    if (key % 3 != 0) {
+      for (int i = 1; i < count_of(key); i += 2) {
+        expected.emplace_back(static_cast<page_id_t>(key), i);
+      }
+    }
+    result.clear();
+    EXPECT_EQ(tree.GetValue(MakeKey(key), &result), !expected.empty());
+    EXPECT_EQ(Sorted(result), expected);
+    values += static_cast<int64_t>(expected.size());
+  }
+  int64_t scanned = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    scanned++;
+  }
+  EXPECT_EQ(scanned, values);
+  EXPECT_EQ(tree.GetStats().value_count_, values);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+}  // namespace bustub
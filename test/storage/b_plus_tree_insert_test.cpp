@@ -187,4 +187,172 @@ TEST(BPlusTreeTests, InsertTest3) {
   delete transaction;
   delete bpm;
 }
+
+TEST(BPlusTreeTests, PrefixCompressionTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  // create b+ tree with default page sizes
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", header_page->GetPageId(), bpm, comparator);
+  GenericKey<64> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  // an uncompressed leaf holds (4096 - 32) / 72 = 56 entries, the padding is shared and truncated away
+  int64_t size = 200;
+  for (int64_t key = 1; key <= size; key++) {
+    rid.Set(static_cast<int32_t>(key >> 32), static_cast<int>(key & 0xFFFFFFFF));
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  auto root_page_id = tree.GetRootPageId();
+  auto root_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(root_page_id)->GetData());
+  ASSERT_TRUE(root_page->IsLeafPage());
+  ASSERT_EQ(root_page->GetSize(), size);
+  bpm->UnpinPage(root_page_id, false);
+
+  // widening the shared bytes must keep every key intact and force splits once the page fills up
+  for (int64_t key = size + 1; key <= 20 * size; key++) {
+    rid.Set(static_cast<int32_t>(key >> 32), static_cast<int>(key & 0xFFFFFFFF));
+    index_key.SetFromInteger(key << 24);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 20 * size; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key <= size ? key : key << 24);
+    tree.GetValue(index_key, &rids);
+    ASSERT_EQ(rids.size(), 1);
+    ASSERT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  int64_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    ASSERT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, 20 * size + 1);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, LeafOverflowTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto guard = bpm->NewPageGuarded(&page_id);
+  auto leaf = guard.AsMut<BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>>();
+  leaf->Init();
+
+  // 小 key 只差最后一个字节，叶子能放很多
+  GenericKey<64> index_key;
+  int64_t size = 0;
+  while (true) {
+    index_key.SetFromInteger(size + 1);
+    if (!leaf->CanInsert(index_key)) {
+      break;
+    }
+    leaf->Insert(index_key, RID(0, static_cast<uint32_t>(size + 1)), comparator);
+    size++;
+  }
+  ASSERT_GT(size, 56);
+
+  // 一个把槽撑宽的 key 放不下，要在改写槽区之前就拒绝，原有的 key 不能坏
+  index_key.SetFromInteger(int64_t{1} << 40);
+  ASSERT_FALSE(leaf->CanInsert(index_key));
+  EXPECT_THROW(leaf->Insert(index_key, RID(0, 0), comparator), Exception);
+  ASSERT_EQ(leaf->GetSize(), size);
+  for (int64_t key = 1; key <= size; key++) {
+    EXPECT_EQ(leaf->KeyAt(static_cast<int>(key - 1)).ToString(), key);
+    EXPECT_EQ(leaf->ValueAt(static_cast<int>(key - 1)).GetSlotNum(), key);
+  }
+
+  guard.Drop();
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, BatchedGetValuesTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  std::vector<std::vector<RID>> results;
+  std::vector<GenericKey<8>> probes(1);
+  probes[0].SetFromInteger(1);
+  EXPECT_EQ(tree.GetValues(probes, &results), 0);
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_TRUE(results[0].empty());
+
+  // multiples of 3 in 3..300
+  for (int64_t key = 3; key <= 300; key += 3) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  // unsorted probes with duplicates, misses and keys outside the tree
+  std::vector<int64_t> probe_keys = {300, 0, 42, 7, 3, 42, 301, 150, 151, 99, 3};
+  probes.resize(probe_keys.size());
+  for (size_t i = 0; i < probe_keys.size(); i++) {
+    probes[i].SetFromInteger(probe_keys[i]);
+  }
+  size_t expected_found = 0;
+  for (auto key : probe_keys) {
+    expected_found += (key >= 3 && key <= 300 && key % 3 == 0) ? 1 : 0;
+  }
+  EXPECT_EQ(tree.GetValues(probes, &results, transaction), expected_found);
+  ASSERT_EQ(results.size(), probe_keys.size());
+  for (size_t i = 0; i < probe_keys.size(); i++) {
+    std::vector<RID> rids;
+    tree.GetValue(probes[i], &rids);
+    ASSERT_EQ(results[i].size(), rids.size()) << "probe " << probe_keys[i];
+    if (!rids.empty()) {
+      EXPECT_EQ(results[i][0].GetSlotNum(), probe_keys[i]);
+    }
+  }
+
+  // every key in the tree in one batch
+  probe_keys.clear();
+  for (int64_t key = 300; key >= 1; key--) {
+    probe_keys.push_back(key);
+  }
+  probes.resize(probe_keys.size());
+  for (size_t i = 0; i < probe_keys.size(); i++) {
+    probes[i].SetFromInteger(probe_keys[i]);
+  }
+  EXPECT_EQ(tree.GetValues(probes, &results, transaction), 100);
+  for (size_t i = 0; i < probe_keys.size(); i++) {
+    EXPECT_EQ(results[i].size(), probe_keys[i] % 3 == 0 ? 1 : 0);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
 }  // namespace bustub
@@ -0,0 +1,251 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_range_scan_test.cpp
+//
+// Identification: test/storage/b_plus_tree_range_scan_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using bustub::DiskManagerUnlimitedMemory;
+
+namespace {
+
+auto MakeKey(int64_t key) -> GenericKey<8> {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+auto Collect(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree, std::optional<int64_t> lower,
+             bool lower_inclusive, std::optional<int64_t> upper, bool upper_inclusive, bool reverse)
+    -> std::vector<int64_t> {
+  std::optional<GenericKey<8>> lower_key;
+  std::optional<GenericKey<8>> upper_key;
+  if (lower.has_value()) {
+    lower_key = MakeKey(*lower);
+  }
+  if (upper.has_value()) {
+    upper_key = MakeKey(*upper);
+  }
+  auto iterator = reverse ? tree->ReverseRange(lower_key, lower_inclusive, upper_key, upper_inclusive)
+                          : tree->Range(lower_key, lower_inclusive, upper_key, upper_inclusive);
+  std::vector<int64_t> keys;
+  for (; iterator != tree->End(); ++iterator) {
+    keys.push_back((*iterator).second.GetSlotNum());
+  }
+  return keys;
+}
+
+}  // namespace
+
+TEST(BPlusTreeTests, RangeScanTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  // small pages so that every scan crosses several leaves
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 3);
+  auto *transaction = new Transaction(0);
+
+  EXPECT_TRUE(Collect(&tree, std::nullopt, true, std::nullopt, true, false).empty());
+  EXPECT_TRUE(Collect(&tree, std::nullopt, true, std::nullopt, true, true).empty());
+
+  // even keys 2..40
+  for (int64_t key = 2; key <= 40; key += 2) {
+    RID rid;
+    rid.Set(0, key);
+    tree.Insert(MakeKey(key), rid, transaction);
+  }
+
+  EXPECT_EQ(Collect(&tree, 10, true, 16, true, false), (std::vector<int64_t>{10, 12, 14, 16}));
+  EXPECT_EQ(Collect(&tree, 10, false, 16, false, false), (std::vector<int64_t>{12, 14}));
+  // bounds that fall between keys
+  EXPECT_EQ(Collect(&tree, 9, false, 15, true, false), (std::vector<int64_t>{10, 12, 14}));
+  EXPECT_EQ(Collect(&tree, std::nullopt, true, 5, true, false), (std::vector<int64_t>{2, 4}));
+  EXPECT_EQ(Collect(&tree, 37, true, std::nullopt, true, false), (std::vector<int64_t>{38, 40}));
+  EXPECT_TRUE(Collect(&tree, 40, false, std::nullopt, true, false).empty());
+  EXPECT_TRUE(Collect(&tree, 13, true, 13, true, false).empty());
+
+  EXPECT_EQ(Collect(&tree, 10, true, 16, true, true), (std::vector<int64_t>{16, 14, 12, 10}));
+  EXPECT_EQ(Collect(&tree, 10, false, 16, false, true), (std::vector<int64_t>{14, 12}));
+  EXPECT_EQ(Collect(&tree, std::nullopt, true, 5, true, true), (std::vector<int64_t>{4, 2}));
+  EXPECT_EQ(Collect(&tree, 35, true, std::nullopt, true, true), (std::vector<int64_t>{40, 38, 36}));
+  EXPECT_TRUE(Collect(&tree, std::nullopt, true, 2, false, true).empty());
+
+  auto all = Collect(&tree, std::nullopt, true, std::nullopt, true, true);
+  ASSERT_EQ(all.size(), 20);
+  for (size_t i = 0; i < all.size(); i++) {
+    EXPECT_EQ(all[i], 40 - 2 * static_cast<int64_t>(i));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, RangeScanBatchTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 4, 3);
+  auto *transaction = new Transaction(0);
+
+  for (int64_t key = 1; key <= 100; key++) {
+    RID rid;
+    rid.Set(0, key);
+    tree.Insert(MakeKey(key), rid, transaction);
+  }
+
+  // batches hand out whole leaves and stop at the bound, mixing ++ and batches is fine
+  for (bool reverse : {false, true}) {
+    auto iterator = reverse ? tree.ReverseRange(MakeKey(11), true, MakeKey(90), false)
+                            : tree.Range(MakeKey(11), true, MakeKey(90), false);
+    std::vector<std::pair<GenericKey<8>, RID>> batch;
+    std::vector<int64_t> keys;
+    keys.push_back((*iterator).second.GetSlotNum());
+    ++iterator;
+    size_t batches = 0;
+    while (true) {
+      batch.clear();
+      auto count = iterator.NextBatch(&batch);
+      if (count == 0) {
+        break;
+      }
+      EXPECT_EQ(count, batch.size());
+      EXPECT_LE(count, 4);
+      batches++;
+      for (const auto &entry : batch) {
+        keys.push_back(entry.second.GetSlotNum());
+      }
+    }
+    EXPECT_TRUE(iterator == tree.End());
+    EXPECT_GT(batches, 1);
+    ASSERT_EQ(keys.size(), 79);
+    for (size_t i = 0; i < keys.size(); i++) {
+      EXPECT_EQ(keys[i], reverse ? 89 - static_cast<int64_t>(i) : 11 + static_cast<int64_t>(i));
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, RangeScanSplitMergeBetweenBatchesTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  for (bool reverse : {false, true}) {
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    // 叶子比缓冲池多，换叶子时要靠预读把下一片叶子读进来
+    auto *bpm = new BufferPoolManager(50, disk_manager.get());
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 4,
+                                                             3);
+    auto *transaction = new Transaction(0);
+    // 扫描前插入偶数 key，扫描中只插入奇数 key；removed 记下每个 key 在第几轮被删，重新插入后就不算了
+    std::map<int64_t, size_t> removed;
+    auto insert = [&](int64_t key) {
+      RID rid;
+      rid.Set(0, key);
+      tree.Insert(MakeKey(key), rid, transaction);
+      removed.erase(key);
+    };
+    for (int64_t key = 2; key <= 400; key += 2) {
+      insert(key);
+    }
+
+    auto iterator = reverse ? tree.ReverseRange(std::nullopt, true, std::nullopt, true)
+                            : tree.Range(std::nullopt, true, std::nullopt, true);
+    int64_t dir = reverse ? -1 : 1;
+    std::vector<std::pair<GenericKey<8>, RID>> batch;
+    std::vector<int64_t> keys;
+    for (size_t round = 1;; round++) {
+      batch.clear();
+      if (iterator.NextBatch(&batch) == 0) {
+        break;
+      }
+      for (const auto &entry : batch) {
+        int64_t key = entry.second.GetSlotNum();
+        // 这一批是上一轮调用时拷出来的，只能含上一轮才删掉的 key
+        auto it = removed.find(key);
+        EXPECT_TRUE(it == removed.end() || it->second + 1 >= round) << key;
+        if (!keys.empty()) {
+          EXPECT_GT((key - keys.back()) * dir, 0) << key;
+        }
+        keys.push_back(key);
+      }
+      // 迭代器手里拷着游标后面那片叶子：删掉其中几个 key 让它向下一片叶子借 key 或者合并，
+      // 再往更前面插入和删除，让那里的叶子分裂、合并，游标后面的叶子也删掉一些
+      int64_t cursor = keys.back();
+      auto remove = [&](int64_t key) {
+        if (removed.count(key) == 0) {
+          tree.Remove(MakeKey(key), transaction);
+          removed[key] = round;
+        }
+      };
+      for (int64_t i = 1; i <= 4; i++) {
+        remove(cursor + i * dir);
+      }
+      for (int64_t i = 21; i <= 30; i++) {
+        int64_t key = cursor + i * dir;
+        // 只插在原来的 key 范围里，不然扫描永远追不上新插入的 key
+        if (key % 2 != 0 && key > 0 && key < 400) {
+          insert(key);
+        }
+      }
+      for (int64_t i = 32; i <= 44; i += 2) {
+        remove(cursor + i * dir);
+      }
+      for (int64_t i = 1; i <= 16; i++) {
+        remove(cursor - i * dir);
+      }
+    }
+    EXPECT_TRUE(iterator == tree.End());
+    EXPECT_GT(tree.GetStructureModificationCount(), 0);
+    std::set<int64_t> seen(keys.begin(), keys.end());
+    EXPECT_EQ(seen.size(), keys.size());
+    for (int64_t key = 2; key <= 400; key += 2) {
+      if (removed.count(key) == 0) {
+        EXPECT_EQ(seen.count(key), 1) << key;
+      }
+    }
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete transaction;
+    delete bpm;
+  }
+}
+}  // namespace bustub
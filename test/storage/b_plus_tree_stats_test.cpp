@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_stats_test.cpp
+//
+// Identification: test/storage/b_plus_tree_stats_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/bustub_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using bustub::DiskManagerUnlimitedMemory;
+
+TEST(BPlusTreeTests, StatsTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 4, 4);
+  auto *transaction = new Transaction(0);
+
+  auto stats = tree.GetStats();
+  EXPECT_EQ(stats.height_, 0);
+  EXPECT_EQ(stats.leaf_pages_, 0);
+  EXPECT_TRUE(stats.level_fill_.empty());
+
+  GenericKey<8> index_key;
+  const int64_t n = 500;
+  for (int64_t key = 1; key <= n; key++) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(static_cast<page_id_t>(key), 0), transaction);
+  }
+
+  // 顺着叶子链数一遍，和统计对上
+  size_t leaves = 0;
+  size_t keys = 0;
+  for (page_id_t leaf = tree.FindEdgeLeafPageId(false); leaf != INVALID_PAGE_ID;) {
+    auto guard = bpm->FetchPageRead(leaf);
+    auto leaf_page = guard.As<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>>();
+    leaves++;
+    keys += leaf_page->GetSize();
+    leaf = leaf_page->GetNextPageId();
+  }
+  stats = tree.GetStats();
+  EXPECT_EQ(stats.leaf_pages_, leaves);
+  EXPECT_EQ(stats.key_count_, n);
+  EXPECT_EQ(stats.value_count_, n);
+  EXPECT_EQ(keys, n);
+  EXPECT_GE(stats.height_, 4);
+  EXPECT_EQ(stats.level_fill_.size(), stats.height_);
+  EXPECT_GT(stats.internal_pages_, 0);
+  EXPECT_LT(stats.internal_pages_, stats.leaf_pages_);
+  for (double fill : stats.level_fill_) {
+    EXPECT_GT(fill, 0);
+    EXPECT_LE(fill, 1);
+  }
+  EXPECT_GE(stats.fragmentation_, 0);
+  EXPECT_LE(stats.fragmentation_, 1);
+  EXPECT_EQ(stats.posting_pages_, 0);
+
+  // 延迟合并下删掉大部分 key，叶子留着不满，Compact 之后填充率回升
+  auto before = stats.level_fill_.back();
+  tree.SetLazyMerge(true);
+  for (int64_t key = 1; key <= n; key++) {
+    if (key % 4 != 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+  }
+  stats = tree.GetStats();
+  EXPECT_EQ(stats.key_count_, n / 4);
+  EXPECT_LT(stats.level_fill_.back(), before);
+  tree.Compact();
+  auto compacted = tree.GetStats();
+  EXPECT_EQ(compacted.key_count_, n / 4);
+  EXPECT_LT(compacted.leaf_pages_, stats.leaf_pages_);
+  EXPECT_GT(compacted.level_fill_.back(), stats.level_fill_.back());
+
+  // 重复 key 的值也算进去，少的留在叶子里，多了才用倒排链
+  tree.SetUnique(false);
+  index_key.SetFromInteger(4);
+  for (int i = 1; i <= 10; i++) {
+    tree.Insert(index_key, RID(4, i), transaction);
+  }
+  stats = tree.GetStats();
+  EXPECT_EQ(stats.key_count_, n / 4);
+  EXPECT_EQ(stats.value_count_, n / 4 + 10);
+  EXPECT_EQ(stats.posting_pages_, 0);
+  for (int i = 11; i <= 100; i++) {
+    tree.Insert(index_key, RID(4, i), transaction);
+  }
+  stats = tree.GetStats();
+  EXPECT_EQ(stats.value_count_, n / 4 + 100);
+  EXPECT_EQ(stats.posting_pages_, 1);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, ConcurrentStatsTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 4, 4);
+
+  // 统计和插入、删除并发，每一遍都得是一棵完整的树
+  const int64_t n = 2000;
+  std::thread writer([&tree] {
+    GenericKey<8> index_key;
+    for (int64_t key = 1; key <= n; key++) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(static_cast<page_id_t>(key), 0));
+      if (key % 3 == 0) {
+        index_key.SetFromInteger(key - 1);
+        tree.Remove(index_key, nullptr);
+      }
+    }
+  });
+  for (int i = 0; i < 50; i++) {
+    auto stats = tree.GetStats();
+    EXPECT_EQ(stats.level_fill_.size(), stats.height_);
+    EXPECT_EQ(stats.key_count_, stats.value_count_);
+    EXPECT_LE(stats.key_count_, n);
+  }
+  writer.join();
+
+  auto stats = tree.GetStats();
+  EXPECT_EQ(stats.key_count_, n - n / 3);
+  EXPECT_EQ(stats.value_count_, n - n / 3);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, IndexStatsCommandTest) {
+  auto db = std::make_unique<BustubInstance>();
+  NoopWriter noop;
+  db->ExecuteSql("CREATE TABLE t1(v1 int, v2 int);", noop);
+  db->ExecuteSql("INSERT INTO t1 VALUES (1, 1), (2, 1), (3, 2);", noop);
+  db->ExecuteSql("CREATE INDEX t1v1 ON t1(v1);", noop);
+  db->ExecuteSql("CREATE INDEX t1v2 ON t1(v2);", noop);
+
+  std::stringstream ss;
+  auto writer = SimpleStreamWriter(ss, true, ",");
+  db->ExecuteSql("\\indexstats", writer);
+  auto output = ss.str();
+  // table, index, height, internal, leaf, posting, keys, values, fill, fragmentation
+  EXPECT_NE(output.find("t1,t1v1,1,0,1,0,3,3,"), std::string::npos) << output;
+  EXPECT_NE(output.find("t1,t1v2,1,0,1,0,2,3,"), std::string::npos) << output;
+}
+
+}  // namespace bustub
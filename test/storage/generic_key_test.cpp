@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key_test.cpp
+//
+// Identification: test/storage/generic_key_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+namespace {
+
+/** Compare two rows column by column through Value, the order the comparator must reproduce. */
+auto CompareRows(const std::vector<Value> &lhs, const std::vector<Value> &rhs) -> int {
+  for (size_t i = 0; i < lhs.size(); i++) {
+    if (lhs[i].CompareLessThan(rhs[i]) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (lhs[i].CompareGreaterThan(rhs[i]) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+template <size_t KeySize>
+void CheckOrder(const std::string &create, const std::vector<std::vector<Value>> &rows) {
+  auto key_schema = ParseCreateStatement(create);
+  GenericComparator<KeySize> comparator(key_schema.get());
+  std::vector<GenericKey<KeySize>> keys(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    keys[i].SetFromKey(Tuple(rows[i], key_schema.get()), *key_schema);
+    // the normalized bytes decode back to the original values
+    for (uint32_t col = 0; col < key_schema->GetColumnCount(); col++) {
+      EXPECT_EQ(keys[i].ToValue(key_schema.get(), col).CompareEquals(rows[i][col]), CmpBool::CmpTrue) << create;
+    }
+  }
+  for (size_t i = 0; i < rows.size(); i++) {
+    for (size_t j = 0; j < rows.size(); j++) {
+      EXPECT_EQ(comparator(keys[i], keys[j]), CompareRows(rows[i], rows[j])) << create << " rows " << i << ", " << j;
+    }
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, NormalizedIntegerOrderTest) {
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<int64_t> big(BUSTUB_INT64_MIN + 1, BUSTUB_INT64_MAX);
+  std::uniform_int_distribution<int32_t> small(-40000, 40000);
+
+  std::vector<std::vector<Value>> rows;
+  for (int64_t v : {int64_t{0}, int64_t{1}, int64_t{-1}, int64_t{255}, int64_t{256}, BUSTUB_INT64_MAX,
+                    BUSTUB_INT64_MIN + 1}) {
+    rows.push_back({ValueFactory::GetBigIntValue(v)});
+  }
+  for (int i = 0; i < 30; i++) {
+    rows.push_back({ValueFactory::GetBigIntValue(big(gen))});
+  }
+  CheckOrder<8>("a bigint", rows);
+
+  rows.clear();
+  for (int i = 0; i < 40; i++) {
+    rows.push_back({ValueFactory::GetIntegerValue(small(gen) % 5), ValueFactory::GetIntegerValue(small(gen))});
+  }
+  CheckOrder<8>("a integer,b integer", rows);
+
+  rows.clear();
+  for (int i = 0; i < 40; i++) {
+    rows.push_back({ValueFactory::GetSmallIntValue(static_cast<int16_t>(small(gen) % 3)),
+                    ValueFactory::GetTinyIntValue(static_cast<int8_t>(small(gen) % 100)),
+                    ValueFactory::GetBooleanValue(small(gen) > 0)});
+  }
+  CheckOrder<8>("a smallint,b tinyint,c boolean", rows);
+}
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, NormalizedDecimalAndVarcharTest) {
+  std::vector<std::vector<Value>> rows;
+  for (double v : {0.0, -0.5, 0.5, -1e10, 1e10, 3.25, -3.25, 1e-9, -1e-9}) {
+    rows.push_back({ValueFactory::GetDecimalValue(v)});
+  }
+  CheckOrder<8>("a double", rows);
+
+  // columns after a varchar are still compared through Value
+  rows.clear();
+  for (int a : {-2, 7}) {
+    for (const char *b : {"", "a", "ab", "b"}) {
+      for (int c : {-1, 1}) {
+        rows.push_back({ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(b),
+                        ValueFactory::GetIntegerValue(c)});
+      }
+    }
+  }
+  CheckOrder<32>("a integer,b varchar(4),c integer", rows);
+
+  // the test-only integer helpers agree with SetFromKey
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericKey<8> from_integer;
+  GenericKey<8> from_tuple;
+  from_integer.SetFromInteger(-42);
+  from_tuple.SetFromKey(Tuple({ValueFactory::GetBigIntValue(-42)}, key_schema.get()), *key_schema);
+  EXPECT_EQ(memcmp(from_integer.data_, from_tuple.data_, 8), 0);
+  EXPECT_EQ(from_integer.ToString(), -42);
+}
+
+}  // namespace bustub
@@ -0,0 +1,134 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_lookup_cache_test.cpp
+//
+// Identification: test/storage/index_lookup_cache_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/generic_key.h"
+#include "storage/index/index_lookup_cache.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(IndexLookupCacheTest, FillAndInvalidateTest) {
+  IndexLookupCache<GenericKey<8>> cache(100);
+  EXPECT_EQ(cache.GetCapacity(), 128);
+
+  GenericKey<8> key;
+  key.SetFromInteger(42);
+  RID rid;
+  EXPECT_FALSE(cache.Lookup(key, &rid));
+
+  cache.Fill(key, RID(1, 2), cache.BeginFill(key));
+  ASSERT_TRUE(cache.Lookup(key, &rid));
+  EXPECT_EQ(rid, RID(1, 2));
+
+  // a different key never hits, even if it lands in the same slot
+  GenericKey<8> other;
+  other.SetFromInteger(43);
+  EXPECT_FALSE(cache.Lookup(other, &rid));
+
+  cache.Invalidate(key);
+  EXPECT_FALSE(cache.Lookup(key, &rid));
+
+  // an invalidation between BeginFill and Fill wins over the (possibly stale) fill
+  auto version = cache.BeginFill(key);
+  cache.Invalidate(key);
+  cache.Fill(key, RID(3, 4), version);
+  EXPECT_FALSE(cache.Lookup(key, &rid));
+
+  EXPECT_EQ(cache.GetHits(), 1);
+  EXPECT_EQ(cache.GetMisses(), 4);
+}
+
+// NOLINTNEXTLINE
+TEST(IndexLookupCacheTest, IndexScanKeyTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  auto key_schema = ParseCreateStatement("a integer");
+  auto *metadata = new IndexMetadata("idx", "tbl", key_schema.get(), {0});
+  BPlusTreeIndexForTwoIntegerColumn index(std::unique_ptr<IndexMetadata>(metadata), bpm);
+  index.SetLookupCacheCapacity(16);
+
+  auto make_key = [&](int v) { return Tuple({ValueFactory::GetIntegerValue(v)}, key_schema.get()); };
+  for (int i = 0; i < 100; i++) {
+    index.InsertEntry(make_key(i), RID(i, i), nullptr);
+  }
+
+  std::vector<RID> result;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 4; i++) {
+      result.clear();
+      index.ScanKey(make_key(i), &result, nullptr);
+      ASSERT_EQ(result.size(), 1);
+      EXPECT_EQ(result[0], RID(i, i));
+    }
+  }
+  EXPECT_GT(index.GetLookupCacheHits(), 0);
+
+  // deletes and reinserts are seen through the cache
+  index.DeleteEntry(make_key(1), RID(1, 1), nullptr);
+  result.clear();
+  index.ScanKey(make_key(1), &result, nullptr);
+  EXPECT_TRUE(result.empty());
+  index.InsertEntry(make_key(1), RID(7, 7), nullptr);
+  result.clear();
+  index.ScanKey(make_key(1), &result, nullptr);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_EQ(result[0], RID(7, 7));
+
+  // batched lookups mix cache hits and tree probes
+  std::vector<Tuple> keys{make_key(0), make_key(50), make_key(1), make_key(1000)};
+  std::vector<std::vector<RID>> results;
+  index.ScanKeys(keys, &results, nullptr);
+  ASSERT_EQ(results.size(), 4);
+  EXPECT_EQ(results[0], std::vector<RID>{RID(0, 0)});
+  EXPECT_EQ(results[1], std::vector<RID>{RID(50, 50)});
+  EXPECT_EQ(results[2], std::vector<RID>{RID(7, 7)});
+  EXPECT_TRUE(results[3].empty());
+
+  // readers racing with a writer that keeps moving one key never see a RID it does not have
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 2; t++) {
+    threads.emplace_back([&] {
+      std::vector<RID> rids;
+      for (int i = 0; i < 2000; i++) {
+        rids.clear();
+        index.ScanKey(make_key(2), &rids, nullptr);
+        for (const auto &rid : rids) {
+          EXPECT_EQ(rid.GetPageId(), rid.GetSlotNum());
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 500; i++) {
+    index.DeleteEntry(make_key(2), RID(), nullptr);
+    index.InsertEntry(make_key(2), RID(i, i), nullptr);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  result.clear();
+  index.ScanKey(make_key(2), &result, nullptr);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_EQ(result[0], RID(499, 499));
+
+  delete bpm;
+}
+
+}  // namespace bustub
@@ -19,11 +19,7 @@
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(TmpTuplePageTest, DISABLED_BasicTest) {
-  // There are many ways to do this assignment, and this is only one of them.
-  // If you don't like the TmpTuplePage idea, please feel free to delete this test case entirely.
-  // You will get full credit as long as you are correctly using a linear probe hash table.
-
+TEST(TmpTuplePageTest, BasicTest) {
   TmpTuplePage page{};
   page_id_t page_id = 15445;
   page.Init(page_id, BUSTUB_PAGE_SIZE);
@@ -41,11 +37,25 @@ TEST(TmpTuplePageTest, DISABLED_BasicTest) {
 
   Tuple tuple(values, &schema);
   TmpTuple tmp_tuple(INVALID_PAGE_ID, 0);
-  page.Insert(tuple, &tmp_tuple);
+  ASSERT_TRUE(page.Insert(tuple, &tmp_tuple));
+  ASSERT_EQ(tmp_tuple.GetPageId(), page_id);
+  ASSERT_EQ(tmp_tuple.GetOffset(), BUSTUB_PAGE_SIZE - 8);
 
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + sizeof(page_id_t) + sizeof(lsn_t)), BUSTUB_PAGE_SIZE - 8);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + BUSTUB_PAGE_SIZE - 8), 4);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + BUSTUB_PAGE_SIZE - 4), 123);
+
+  Tuple read_back;
+  page.Get(tmp_tuple.GetOffset(), &read_back);
+  ASSERT_EQ(read_back.GetValue(&schema, 0).GetAs<int32_t>(), 123);
+  ASSERT_EQ(page.NextOffset(tmp_tuple.GetOffset()), BUSTUB_PAGE_SIZE);
+
+  // 页满了就拒绝插入
+  size_t inserted = 1;
+  while (page.Insert(tuple, &tmp_tuple)) {
+    inserted++;
+  }
+  ASSERT_EQ(inserted, (BUSTUB_PAGE_SIZE - 12) / 8);
 }
 
 }  // namespace bustub
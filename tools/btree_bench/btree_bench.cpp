@@ -38,6 +38,7 @@ static const size_t LRU_K_SIZE = 4;
 static const size_t BUSTUB_BPM_SIZE = 256;
 static const size_t TOTAL_KEYS = 100000;
 static const size_t KEY_MODIFY_RANGE = 2048;
+static const size_t COMPACT_INTERVAL_MS = 1000;
 
 struct BTreeTotalMetrics {
   uint64_t write_cnt_{0};
@@ -119,6 +120,10 @@ auto main(int argc, char **argv) -> int {
 
   argparse::ArgumentParser program("bustub-btree-bench");
   program.add_argument("--duration").help("run btree bench for n milliseconds");
+  program.add_argument("--lazy-merge")
+      .help("defer merges of under-full leaves to a background compaction thread")
+      .default_value(false)
+      .implicit_value(true);
 
   try {
     program.parse_args(argc, argv);
@@ -132,12 +137,13 @@ auto main(int argc, char **argv) -> int {
   if (program.present("--duration")) {
     duration_ms = std::stoi(program.get("--duration"));
   }
+  auto lazy_merge = program.get<bool>("--lazy-merge");
 
   auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
   auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
 
-  fmt::print(stderr, "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}\n", TOTAL_KEYS, duration_ms,
-             LRU_K_SIZE, BUSTUB_BPM_SIZE);
+  fmt::print(stderr, "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}, lazy_merge={}\n", TOTAL_KEYS,
+             duration_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE, lazy_merge);
 
   auto key_schema = bustub::ParseCreateStatement("a bigint");
   bustub::GenericComparator<8> comparator(key_schema.get());
@@ -157,6 +163,9 @@ auto main(int argc, char **argv) -> int {
     index.Insert(index_key, rid, nullptr);
   }
 
+  index.SetLazyMerge(lazy_merge);
+  auto smo_before = index.GetStructureModificationCount();
+
   fmt::print(stderr, "[info] benchmark start\n");
 
   BTreeTotalMetrics total_metrics;
@@ -257,10 +266,22 @@ auto main(int argc, char **argv) -> int {
     }));
   }
 
+  if (lazy_merge) {
+    threads.emplace_back(std::thread([&index, duration_ms] {
+      auto start = ClockMs();
+      while (ClockMs() - start < duration_ms) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(COMPACT_INTERVAL_MS));
+        index.Compact();
+      }
+    }));
+  }
+
   for (auto &thread : threads) {
     thread.join();
   }
 
+  fmt::print(stderr, "[info] structure modifications={}\n", index.GetStructureModificationCount() - smo_before);
+
   total_metrics.Report();
 
   return 0;
@@ -0,0 +1,106 @@
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/util/fast_hash.h"
+#include "common/util/hash_util.h"
+#include "fmt/format.h"
+#include "type/value_factory.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+// 轮流哈希这么多个不同的 key，数据都在 L1 里，测的是哈希本身
+static const size_t NUM_KEYS = 1024;
+
+/** Calls hash on key i % NUM_KEYS for duration_ms, returns hashes per second. */
+auto RunHashes(const std::function<uint64_t(size_t)> &hash, uint64_t duration_ms) -> double {
+  uint64_t cnt = 0;
+  uint64_t sink = 0;
+  auto start = ClockMs();
+  while (ClockMs() - start < duration_ms) {
+    for (size_t i = 0; i < NUM_KEYS; i++) {
+      sink ^= hash(i);
+    }
+    cnt += NUM_KEYS;
+  }
+  // 防止整个循环被优化掉
+  if (sink == 42) {
+    fmt::print(stderr, "[info] sink={}\n", sink);
+  }
+  return cnt / static_cast<double>(ClockMs() - start) * 1000;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  using bustub::FastHash;
+  using bustub::HashAlgorithm;
+
+  argparse::ArgumentParser program("bustub-hash-bench");
+  program.add_argument("--duration").help("run each hash/key length for n milliseconds");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 1000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  fmt::print(stderr, "[info] num_keys={}, duration_ms={}\n", NUM_KEYS, duration_ms);
+
+  std::default_random_engine gen(0);
+  std::uniform_int_distribution<char> dis;
+  const size_t max_len = 64;
+  std::vector<char> keys(NUM_KEYS * max_len);
+  for (auto &c : keys) {
+    c = dis(gen);
+  }
+
+  std::vector<std::pair<std::string, HashAlgorithm>> algorithms = {{"murmur3", HashAlgorithm::Murmur3},
+                                                                   {"crc32c", HashAlgorithm::Crc32c},
+                                                                   {"xxh3", HashAlgorithm::Xxh3},
+                                                                   {"auto", HashAlgorithm::Auto}};
+
+  std::vector<bustub::Value> ints;
+  std::vector<bustub::Value> strings;
+  for (size_t i = 0; i < NUM_KEYS; i++) {
+    ints.push_back(bustub::ValueFactory::GetIntegerValue(static_cast<int32_t>(i * 7919)));
+    strings.push_back(bustub::ValueFactory::GetVarcharValue(fmt::format("customer#{:09}", i)));
+  }
+
+  fmt::print("<<< BEGIN\n");
+  for (size_t len : {4, 8, 16, 64}) {
+    for (const auto &[name, algorithm] : algorithms) {
+      auto rate = RunHashes(
+          [&keys, len, algorithm = algorithm](size_t i) {
+            return FastHash::Hash(keys.data() + i * max_len, len, algorithm);
+          },
+          duration_ms);
+      fmt::print("{} len={}: {:.0f}\n", name, len, rate);
+    }
+  }
+  // 执行器里 hash join / aggregation 用的路径
+  fmt::print("value integer: {:.0f}\n",
+             RunHashes([&ints](size_t i) { return bustub::HashUtil::HashValue(&ints[i]); }, duration_ms));
+  fmt::print("value varchar: {:.0f}\n",
+             RunHashes([&strings](size_t i) { return bustub::HashUtil::HashValue(&strings[i]); }, duration_ms));
+  fmt::print(">>> END\n");
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "container/disk/hash/disk_extendible_hash_table.h"
+#include "container/disk/hash/linear_probe_hash_table.h"
+#include "fmt/format.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/generic_key.h"
+#include "test_util.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+static const size_t LRU_K_SIZE = 4;
+static const size_t BUSTUB_BPM_SIZE = 1024;
+// the extendible hash directory is a single page, keep the keys well below what it can address
+static const size_t TOTAL_KEYS = 50000;
+
+using KeyType = bustub::GenericKey<8>;
+using ComparatorType = bustub::GenericComparator<8>;
+using LookupFn = std::function<void(const KeyType &, std::vector<bustub::RID> *)>;
+
+/** Runs num_threads threads doing random point lookups for duration_ms, returns lookups per second. */
+auto RunLookups(const LookupFn &lookup, size_t num_threads, uint64_t duration_ms) -> double {
+  std::atomic<uint64_t> total{0};
+  std::vector<std::thread> threads;
+  auto start = ClockMs();
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&lookup, &total, start, duration_ms] {
+      std::random_device r;
+      std::default_random_engine gen(r());
+      std::uniform_int_distribution<size_t> dis(0, TOTAL_KEYS - 1);
+      KeyType index_key;
+      std::vector<bustub::RID> rids;
+      uint64_t cnt = 0;
+      while (ClockMs() - start < duration_ms) {
+        // 每 64 次看一次时钟
+        for (int i = 0; i < 64; i++) {
+          auto key = dis(gen);
+          rids.clear();
+          index_key.SetFromInteger(key);
+          lookup(index_key, &rids);
+          if (rids.size() != 1 || static_cast<size_t>(rids[0].GetPageId()) != key) {
+            throw std::runtime_error(fmt::format("key not found: {}", key));
+          }
+        }
+        cnt += 64;
+      }
+      total += cnt;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return total / static_cast<double>(ClockMs() - start) * 1000;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  using bustub::BufferPoolManager;
+  using bustub::DiskManagerUnlimitedMemory;
+  using bustub::page_id_t;
+
+  argparse::ArgumentParser program("bustub-index-bench");
+  program.add_argument("--duration").help("run each index/thread count for n milliseconds");
+  program.add_argument("--threads").help("largest number of lookup threads, doubled from 1");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 2000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+  size_t max_threads = 32;
+  if (program.present("--threads")) {
+    max_threads = std::stoi(program.get("--threads"));
+  }
+
+  fmt::print(stderr, "[info] total_keys={}, duration_ms={}, max_threads={}, lru_k_size={}, bpm_size={}\n", TOTAL_KEYS,
+             duration_ms, max_threads, LRU_K_SIZE, BUSTUB_BPM_SIZE);
+
+  auto key_schema = bustub::ParseCreateStatement("a bigint");
+  ComparatorType comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+
+  page_id_t header_page_id;
+  bpm->NewPageGuarded(&header_page_id);
+  bustub::BPlusTree<KeyType, bustub::RID, ComparatorType> btree("btree", header_page_id, bpm.get(), comparator);
+  bustub::DiskExtendibleHashTable<KeyType, bustub::RID, ComparatorType> extendible(
+      "extendible", bpm.get(), comparator, bustub::HashFunction<KeyType>());
+  // 从很小开始，装载的过程中也会走几次扩容
+  bustub::LinearProbeHashTable<KeyType, bustub::RID, ComparatorType> linear_probe(
+      "linear_probe", bpm.get(), comparator, 1024, bustub::HashFunction<KeyType>());
+
+  for (size_t key = 0; key < TOTAL_KEYS; key++) {
+    KeyType index_key;
+    bustub::RID rid;
+    uint32_t value = key;
+    rid.Set(value, value);
+    index_key.SetFromInteger(key);
+    if (!btree.Insert(index_key, rid, nullptr) || !extendible.Insert(nullptr, index_key, rid) ||
+        !linear_probe.Insert(nullptr, index_key, rid)) {
+      throw std::runtime_error(fmt::format("failed to insert key {}", key));
+    }
+  }
+  fmt::print(stderr, "[info] extendible global depth={}, linear probe slots={}\n", extendible.GetGlobalDepth(),
+             linear_probe.GetSize());
+
+  std::vector<std::pair<std::string, LookupFn>> indexes;
+  indexes.emplace_back("btree", [&btree](const KeyType &key, std::vector<bustub::RID> *rids) {
+    btree.GetValue(key, rids);
+  });
+  indexes.emplace_back("extendible", [&extendible](const KeyType &key, std::vector<bustub::RID> *rids) {
+    extendible.GetValue(nullptr, key, rids);
+  });
+  indexes.emplace_back("linear_probe", [&linear_probe](const KeyType &key, std::vector<bustub::RID> *rids) {
+    linear_probe.GetValue(nullptr, key, rids);
+  });
+
+  fmt::print("<<< BEGIN\n");
+  for (const auto &[name, lookup] : indexes) {
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+      fmt::print("{} threads={}: {:.0f}\n", name, num_threads, RunLookups(lookup, num_threads, duration_ms));
+    }
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/bustub_instance.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/format.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+/** The rows of __mock_t1, whose column z counts from 0 */
+static const size_t MOCK_TABLE_ROWS = 1000000;
+
+/** Keeps the first cell of the result, the count(*) of the bench query. */
+class FirstCellWriter : public bustub::ResultWriter {
+ public:
+  void WriteCell(const std::string &cell) override {
+    if (cell_.empty()) {
+      cell_ = cell;
+    }
+  }
+  void WriteHeaderCell(const std::string &cell) override {}
+  void BeginHeader() override {}
+  void EndHeader() override {}
+  void BeginRow() override {}
+  void EndRow() override {}
+  void BeginTable(bool simplified_output) override {}
+  void EndTable() override {}
+
+  std::string cell_;
+};
+
+/** Run one statement in its own READ UNCOMMITTED transaction, so row locks stay out of the measurement. */
+auto Execute(bustub::BustubInstance *bustub, const std::string &sql) -> std::string {
+  FirstCellWriter writer;
+  auto *txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::READ_UNCOMMITTED);
+  if (!bustub->ExecuteSqlTxn(sql, writer, txn)) {
+    bustub->txn_manager_->Abort(txn);
+    delete txn;
+    throw std::runtime_error(fmt::format("failed to execute: {}", sql));
+  }
+  bustub->txn_manager_->Commit(txn);
+  delete txn;
+  return writer.cell_;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-join-bench");
+  program.add_argument("--rows").help("rows of the joined table, each v1 is unique");
+  program.add_argument("--threads").help("largest parallelism, doubled from 1");
+  program.add_argument("--repeat").help("runs of the query per parallelism, the fastest is reported");
+  program.add_argument("--probes").help("about how many outer rows the index join against hash join comparison has");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  size_t rows = 1000000;
+  if (program.present("--rows")) {
+    rows = std::stoul(program.get("--rows"));
+  }
+  size_t max_threads = 8;
+  if (program.present("--threads")) {
+    max_threads = std::stoul(program.get("--threads"));
+  }
+  size_t repeat = 3;
+  if (program.present("--repeat")) {
+    repeat = std::stoul(program.get("--repeat"));
+  }
+
+  size_t probes = std::max<size_t>(rows / 100, 1);
+  if (program.present("--probes")) {
+    probes = std::stoul(program.get("--probes"));
+  }
+
+  fmt::print(stderr, "[info] rows={}, max_threads={}, repeat={}, probes={}\n", rows, max_threads, repeat, probes);
+
+  auto bustub = std::make_unique<bustub::BustubInstance>();
+  bustub->GenerateMockTable();
+  Execute(bustub.get(), "create table t1(v1 int);");
+  // 一个 mock 表最多一百万行，更多的行分几次插，每次整体偏移一百万
+  auto start = ClockMs();
+  for (size_t loaded = 0; loaded < rows; loaded += MOCK_TABLE_ROWS) {
+    auto batch = std::min(MOCK_TABLE_ROWS, rows - loaded);
+    Execute(bustub.get(), fmt::format("insert into t1 select z + {} from __mock_t1 where z < {};", loaded, batch));
+  }
+  fmt::print(stderr, "[info] loaded in {} ms\n", ClockMs() - start);
+
+  // p3.15-multi-way-hash-join 的查询，两次 hash join 的建表侧都是整张 t1
+  const std::string query =
+      "select count(*) from (t1 a inner join t1 b on a.v1 = b.v1) inner join t1 c on a.v1 = c.v1;";
+  fmt::print("<<< BEGIN\n");
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    Execute(bustub.get(), fmt::format("set parallelism = {};", threads));
+    uint64_t best = UINT64_MAX;
+    for (size_t i = 0; i < repeat; i++) {
+      start = ClockMs();
+      auto count = Execute(bustub.get(), query);
+      best = std::min(best, ClockMs() - start);
+      if (count != std::to_string(rows)) {
+        throw std::runtime_error(fmt::format("wrong join result: {}", count));
+      }
+    }
+    fmt::print("multi_way_hash_join rows={} threads={}: {} ms\n", rows, threads, best);
+  }
+
+  // 外表很小、内表有索引时，index join 只碰到内表的一小部分，hash join 要把整张 t1 建成表。
+  // 外表的键取 mock 表里 y（= z % 10000）较小的行，散在整个 t1 上，倒序插入
+  auto mock_rows = std::min(rows, MOCK_TABLE_ROWS);
+  auto per_block = std::clamp<size_t>(probes * 10000 / mock_rows, 1, 10000);
+  Execute(bustub.get(), "set parallelism = 1;");
+  Execute(bustub.get(), "create table p(v1 int);");
+  Execute(bustub.get(), fmt::format("insert into p select {} - z from __mock_t1 where z < {} and y < {};",
+                                    mock_rows - 1, mock_rows, per_block));
+  probes = std::stoul(Execute(bustub.get(), "select count(*) from p;"));
+  // 建索引要拿表上的 S 锁，READ UNCOMMITTED 下拿不了，走默认的隔离级别
+  FirstCellWriter writer;
+  bustub->ExecuteSql("create index t1_v1 on t1(v1);", writer);
+  const std::string probe_query = "select count(*) from p inner join t1 on p.v1 = t1.v1;";
+  // starter 规则会先把 NLJ 换成 index join，默认规则换成 hash join
+  for (const auto &[name, starter] : {std::pair{"hash_join", "no"}, std::pair{"index_join", "yes"}}) {
+    Execute(bustub.get(), fmt::format("set force_optimizer_starter_rule = {};", starter));
+    uint64_t best = UINT64_MAX;
+    for (size_t i = 0; i < repeat; i++) {
+      start = ClockMs();
+      auto count = Execute(bustub.get(), probe_query);
+      best = std::min(best, ClockMs() - start);
+      if (count != std::to_string(probes)) {
+        throw std::runtime_error(fmt::format("wrong join result: {}", count));
+      }
+    }
+    fmt::print("{} rows={} probes={}: {} ms\n", name, rows, probes, best);
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <fstream>
 #include <ios>
 #include <iostream>
@@ -75,6 +76,11 @@ auto ProcessExtraOptions(const std::string &sql, bustub::BustubInstance &instanc
           fmt::print("IndexScan not found\n");
           return false;
         }
+      } else if (opt == "ensure:index_only_scan") {
+        if (!bustub::StringUtil::Contains(result.str(), "index_only=true")) {
+          fmt::print("index-only IndexScan not found\n");
+          return false;
+        }
       } else if (opt == "ensure:hash_join") {
         if (bustub::StringUtil::Split(result.str(), "HashJoin").size() != 2 &&
             !bustub::StringUtil::Contains(result.str(), "Filter")) {
@@ -110,6 +116,37 @@ auto ProcessExtraOptions(const std::string &sql, bustub::BustubInstance &instanc
           fmt::print("NestedIndexJoin not found\n");
           return false;
         }
+      } else if (opt == "ensure:merge_join") {
+        if (!bustub::StringUtil::Contains(result.str(), "MergeJoin")) {
+          fmt::print("MergeJoin not found\n");
+          return false;
+        }
+      } else if (opt == "ensure:gather") {
+        if (!bustub::StringUtil::Contains(result.str(), "Gather")) {
+          fmt::print("Gather not found\n");
+          return false;
+        }
+      } else if (opt == "ensure:repartition") {
+        if (!bustub::StringUtil::Contains(result.str(), "Repartition")) {
+          fmt::print("Repartition not found\n");
+          return false;
+        }
+      } else if (opt == "ensure:spill") {
+        std::stringstream analyzed;
+        auto analyze_writer = bustub::SimpleStreamWriter(analyzed);
+        instance.ExecuteSql("explain analyze " + sql, analyze_writer);
+        if (!bustub::StringUtil::Contains(analyzed.str(), "spilled_bytes=")) {
+          fmt::print("no operator spilled\n");
+          return false;
+        }
+      } else if (opt == "ensure:bloom_filter") {
+        std::stringstream analyzed;
+        auto analyze_writer = bustub::SimpleStreamWriter(analyzed);
+        instance.ExecuteSql("explain analyze " + sql, analyze_writer);
+        if (!bustub::StringUtil::Contains(analyzed.str(), "bloom_filtered_rows=")) {
+          fmt::print("no join filter pushed into a scan\n");
+          return false;
+        }
       } else if (opt == "ensure:nlj_init_check") {
         if (!bustub::StringUtil::Contains(result.str(), "NestedLoopJoin")) {
           fmt::print("NestedLoopJoin not found\n");
@@ -175,6 +212,9 @@ auto main(int argc, char **argv) -> int {  // NOLINT
   program.add_argument("--verbose").help("increase output verbosity").default_value(false).implicit_value(true);
   program.add_argument("-d", "--diff").help("write diff file").default_value(false).implicit_value(true);
   program.add_argument("--in-memory").help("use in-memory backend").default_value(false).implicit_value(true);
+  program.add_argument("--parallelism")
+      .help("run query pipelines as this many parallel copies")
+      .default_value(std::string("1"));
 
   try {
     program.parse_args(argc, argv);
@@ -204,11 +244,18 @@ auto main(int argc, char **argv) -> int {  // NOLINT
   if (program.get<bool>("--in-memory")) {
     bustub = std::make_unique<bustub::BustubInstance>();
   } else {
+    // test.db keeps its tables across runs now, every script starts from an empty database
+    std::remove("test.db");
     bustub = std::make_unique<bustub::BustubInstance>("test.db");
   }
 
   bustub->GenerateMockTable();
 
+  if (auto parallelism = program.get<std::string>("--parallelism"); parallelism != "1") {
+    auto writer = bustub::NoopWriter();
+    bustub->ExecuteSql(fmt::format("set parallelism = {}", parallelism), writer);
+  }
+
   if (bustub->buffer_pool_manager_ != nullptr) {
     bustub->GenerateTestTable();
   }
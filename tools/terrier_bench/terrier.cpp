@@ -1,4 +1,5 @@
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -17,6 +18,7 @@
 #include "concurrency/transaction_manager.h"
 #include "fmt/core.h"
 #include "fmt/std.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "terrier_bench_config.h"
 
 #include <sys/time.h>
@@ -37,6 +39,9 @@ struct TerrierTotalMetrics {
   uint64_t committed_update_txn_cnt_{0};
   uint64_t aborted_verify_txn_cnt_{0};
   uint64_t committed_verify_txn_cnt_{0};
+  uint64_t aborted_lookup_txn_cnt_{0};
+  uint64_t committed_lookup_txn_cnt_{0};
+  bool lookup_enabled_{false};
   uint64_t start_time_{0};
   std::mutex mutex_;
 
@@ -60,6 +65,12 @@ struct TerrierTotalMetrics {
     committed_update_txn_cnt_ += committed_cnt;
   }
 
+  void ReportLookup(uint64_t aborted_cnt, uint64_t committed_cnt) {
+    std::unique_lock<std::mutex> l(mutex_);
+    aborted_lookup_txn_cnt_ += aborted_cnt;
+    committed_lookup_txn_cnt_ += committed_cnt;
+  }
+
   void Report() {
     auto now = ClockMs();
     auto elsped = now - start_time_;
@@ -73,6 +84,9 @@ struct TerrierTotalMetrics {
     fmt::print("update: {}\n", update_txn_per_sec);
     fmt::print("count: {}\n", count_txn_per_sec);
     fmt::print("verify: {}\n", verify_txn_per_sec);
+    if (lookup_enabled_) {
+      fmt::print("lookup: {}\n", committed_lookup_txn_cnt_ / static_cast<double>(elsped) * 1000);
+    }
 
     fmt::print(">>> END\n");
   }
@@ -141,6 +155,9 @@ auto main(int argc, char **argv) -> int {
   program.add_argument("--force-create-index").help("create index in terrier bench");
   program.add_argument("--force-enable-update").help("use update statement in terrier bench");
   program.add_argument("--nft").help("number of NFTs in the bench");
+  program.add_argument("--index-cache").help("number of slots in the lookup cache of the nft index, 0 disables it");
+  program.add_argument("--lookup-threads").help("number of threads running Zipfian point lookups by id, 0 by default");
+  program.add_argument("--zipf").help("skew of the point lookups, 0 is uniform, 0.99 by default");
 
   size_t bustub_nft_num = 10;
 
@@ -176,10 +193,18 @@ auto main(int argc, char **argv) -> int {
     bustub_nft_num = std::stoi(program.get("--nft"));
   }
 
+  bustub::BPlusTreeIndexForTwoIntegerColumn *nft_index = nullptr;
   if (enable_index) {
     auto schema = "CREATE INDEX nftid on nft(id);";
     std::cerr << "x: create index" << std::endl;
     bustub->ExecuteSql(schema, writer);
+    nft_index = dynamic_cast<bustub::BPlusTreeIndexForTwoIntegerColumn *>(
+        bustub->catalog_->GetIndex("nftid", "nft")->index_.get());
+    if (program.present("--index-cache")) {
+      auto capacity = std::stoi(program.get("--index-cache"));
+      std::cerr << "x: index lookup cache capacity=" << capacity << std::endl;
+      nft_index->SetLookupCacheCapacity(capacity);
+    }
   } else {
     std::cerr << "x: create index disabled" << std::endl;
   }
@@ -205,6 +230,15 @@ auto main(int argc, char **argv) -> int {
     duration_ms = std::stoi(program.get("--duration"));
   }
 
+  size_t lookup_threads = 0;
+  double zipf = 0.99;
+  if (program.present("--lookup-threads")) {
+    lookup_threads = std::stoi(program.get("--lookup-threads"));
+  }
+  if (program.present("--zipf")) {
+    zipf = std::stod(program.get("--zipf"));
+  }
+
   std::cerr << "x: benchmark for " << duration_ms << "ms" << std::endl;
   std::cerr << "x: nft_num=" << bustub_nft_num << std::endl;
 
@@ -241,6 +275,7 @@ auto main(int argc, char **argv) -> int {
 
   bool verbose = false;
 
+  total_metrics.lookup_enabled_ = lookup_threads > 0;
   total_metrics.Begin();
 
   for (size_t thread_id = 0; thread_id < BUSTUB_TERRIER_THREAD; thread_id++) {
@@ -379,6 +414,57 @@ auto main(int argc, char **argv) -> int {
     }));
   }
 
+  // nft i is looked up with probability proportional to 1 / (i + 1)^zipf, so a few ids take most of the lookups
+  std::vector<double> lookup_weights(bustub_nft_num);
+  for (size_t i = 0; i < bustub_nft_num; i++) {
+    lookup_weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), zipf);
+  }
+
+  for (size_t thread_id = 0; thread_id < lookup_threads; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, &bustub, duration_ms, &total_metrics, &lookup_weights] {
+      std::random_device r;
+      std::default_random_engine gen(r());
+      std::discrete_distribution<int> nft_zipf_dist(lookup_weights.begin(), lookup_weights.end());
+
+      TerrierMetrics metrics(fmt::format("Lookup {}", thread_id), duration_ms);
+      metrics.Begin();
+
+      while (!metrics.ShouldFinish()) {
+        std::stringstream ss;
+        auto writer = bustub::SimpleStreamWriter(ss, true);
+        auto nft_id = nft_zipf_dist(gen);
+
+        auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+        bool txn_success = true;
+
+        std::string query = fmt::format("SELECT id FROM nft WHERE id = {}", nft_id);
+        if (!bustub->ExecuteSqlTxn(query, writer, txn)) {
+          txn_success = false;
+        }
+
+        // the row is deleted and reinserted by the update threads, an insert + delete txn may hide it for a moment
+        if (txn_success && ss.str() != fmt::format("{}\t\n", nft_id) && !ss.str().empty()) {
+          fmt::print("unexpected result \"{}\" when looking up nft {}\n", ss.str(), nft_id);
+          exit(1);
+        }
+
+        if (txn_success) {
+          CheckTableLock(txn);
+          bustub->txn_manager_->Commit(txn);
+          metrics.TxnCommitted();
+        } else {
+          bustub->txn_manager_->Abort(txn);
+          metrics.TxnAborted();
+        }
+        delete txn;
+
+        metrics.Report();
+      }
+
+      total_metrics.ReportLookup(metrics.aborted_txn_cnt_, metrics.committed_txn_cnt_);
+    }));
+  }
+
   threads.emplace_back(std::thread([&bustub, duration_ms, &total_metrics, bustub_nft_num] {
     std::random_device r;
     std::default_random_engine gen(r());
@@ -517,6 +603,11 @@ auto main(int argc, char **argv) -> int {
 
   total_metrics.Report();
 
+  if (nft_index != nullptr) {
+    std::cerr << "x: index lookup cache hits=" << nft_index->GetLookupCacheHits()
+              << " misses=" << nft_index->GetLookupCacheMisses() << std::endl;
+  }
+
   if (total_metrics.committed_verify_txn_cnt_ <= 3 || total_metrics.committed_update_txn_cnt_ < 3 ||
       total_metrics.committed_count_txn_cnt_ < 3) {
     fmt::print("too many txn are aborted");